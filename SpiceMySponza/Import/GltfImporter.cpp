@@ -0,0 +1,790 @@
+#include "Importer.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+
+// Engine headers.
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+#include <Import/Json.h>
+#include <Utility/MappedFile.h>
+#include <Utility/Maths.h>
+#include <Utility/Parallel.h>
+
+
+
+namespace
+{
+    #pragma region Constants
+
+    // The magic numbers of a binary glTF container.
+    const uint32_t  glbMagic            = 0x46546C67;
+    const uint32_t  glbJsonChunk        = 0x4E4F534A;
+    const uint32_t  glbBinaryChunk      = 0x004E4942;
+
+    // The component types of an accessor.
+    const int       componentByte       = 5121;
+    const int       componentShort      = 5123;
+    const int       componentInt        = 5125;
+    const int       componentFloat      = 5126;
+
+    // The primitive mode for triangle lists.
+    const int       modeTriangles       = 4;
+
+    #pragma endregion
+
+
+    #pragma region Data types
+
+    /// <summary> A block of binary data referenced by buffer views. </summary>
+    struct Buffer final
+    {
+        const unsigned char*    data    { nullptr };
+        size_t                  size    { 0 };
+    };
+
+
+    /// <summary> A typed, strided view of binary data, resolved from an accessor and its buffer view. </summary>
+    struct Accessor final
+    {
+        const unsigned char*    data            { nullptr };
+        size_t                  count           { 0 };
+        size_t                  stride          { 0 };
+        int                     componentType   { 0 };
+        int                     components      { 0 };
+        bool                    normalized      { false };
+
+        /// <summary> Reads up to the given number of components of an element as floats. </summary>
+        void readFloats (const size_t index, float* const output, const int wanted) const
+        {
+            const auto element  = data + index * stride;
+            const auto count    = std::min (wanted, components);
+
+            for (int i = 0; i < count; ++i)
+            {
+                switch (componentType)
+                {
+                    case componentFloat:
+                        std::memcpy (&output[i], element + i * sizeof (float), sizeof (float));
+                        break;
+
+                    case componentShort:
+                    {
+                        uint16_t value { 0 };
+                        std::memcpy (&value, element + i * sizeof (uint16_t), sizeof (uint16_t));
+                        output[i] = normalized ? value / 65535.f : static_cast<float> (value);
+                        break;
+                    }
+
+                    case componentByte:
+                        output[i] = normalized ? element[i] / 255.f : static_cast<float> (element[i]);
+                        break;
+
+                    default:
+                        output[i] = 0.f;
+                        break;
+                }
+            }
+        }
+
+        /// <summary> Reads an element as an unsigned integer index. </summary>
+        unsigned int readIndex (const size_t index) const
+        {
+            const auto element = data + index * stride;
+
+            switch (componentType)
+            {
+                case componentInt:
+                {
+                    uint32_t value { 0 };
+                    std::memcpy (&value, element, sizeof (uint32_t));
+                    return value;
+                }
+
+                case componentShort:
+                {
+                    uint16_t value { 0 };
+                    std::memcpy (&value, element, sizeof (uint16_t));
+                    return value;
+                }
+
+                case componentByte:
+                    return *element;
+
+                default:
+                    return 0;
+            }
+        }
+    };
+
+
+    /// <summary> A glTF primitive, which becomes a single mesh in the imported scene. </summary>
+    struct Primitive final
+    {
+        long long   position    { -1 };
+        long long   normal      { -1 };
+        long long   texture     { -1 };
+        long long   indices     { -1 };
+        long long   material    { -1 };
+        size_t      vertexCount { 0 };
+        size_t      elementCount{ 0 };
+    };
+
+    #pragma endregion
+
+
+    #pragma region Helpers
+
+    size_t componentSize (const int componentType)
+    {
+        switch (componentType)
+        {
+            case componentByte:     return 1;
+            case componentShort:    return 2;
+            case componentInt:      return 4;
+            case componentFloat:    return 4;
+            default:                throw std::runtime_error ("unsupported accessor component type");
+        }
+    }
+
+
+    int componentCount (const std::string& type)
+    {
+        if (type == "SCALAR")   return 1;
+        if (type == "VEC2")     return 2;
+        if (type == "VEC3")     return 3;
+        if (type == "VEC4")     return 4;
+
+        throw std::runtime_error ("unsupported accessor type " + type);
+    }
+
+
+    /// <summary> Gets the element at the given index of a top-level glTF array, throwing if it doesn't exist. </summary>
+    const util::JsonValue& element (const util::JsonValue& root, const char* const arrayName, const long long index)
+    {
+        const auto array = root.find (arrayName);
+
+        if (!array || index < 0 || static_cast<size_t> (index) >= array->size())
+        {
+            throw std::runtime_error (std::string ("invalid reference into ") + arrayName);
+        }
+
+        return (*array)[static_cast<size_t> (index)];
+    }
+
+
+    /// <summary> Resolves an accessor into a pointer, stride and type, checking it lies within its buffer. </summary>
+    Accessor resolveAccessor (const util::JsonValue& root, const std::vector<Buffer>& buffers, const long long index)
+    {
+        const auto& accessor    = element (root, "accessors", index);
+
+        if (accessor.find ("sparse"))
+        {
+            throw std::runtime_error ("sparse accessors are not supported");
+        }
+
+        const auto typeMember   = accessor.find ("type");
+
+        Accessor result { };
+        result.count            = static_cast<size_t> (accessor.integerOf ("count", 0));
+        result.componentType    = static_cast<int> (accessor.integerOf ("componentType", 0));
+        result.components       = componentCount (typeMember ? typeMember->asString() : std::string { });
+        result.normalized       = accessor.find ("normalized") && accessor.find ("normalized")->asBoolean();
+
+        const auto elementSize  = componentSize (result.componentType) * result.components;
+        const auto& view        = element (root, "bufferViews", accessor.integerOf ("bufferView"));
+        const auto bufferIndex  = view.integerOf ("buffer");
+
+        if (bufferIndex < 0 || static_cast<size_t> (bufferIndex) >= buffers.size())
+        {
+            throw std::runtime_error ("invalid buffer reference");
+        }
+
+        const auto& buffer      = buffers[static_cast<size_t> (bufferIndex)];
+        const auto viewOffset   = static_cast<size_t> (view.integerOf ("byteOffset", 0));
+        const auto viewLength   = static_cast<size_t> (view.integerOf ("byteLength", 0));
+        const auto offset       = static_cast<size_t> (accessor.integerOf ("byteOffset", 0));
+        const auto stride       = static_cast<size_t> (view.integerOf ("byteStride", 0));
+
+        result.stride           = stride > 0 ? stride : elementSize;
+
+        if (result.count == 0)
+        {
+            throw std::runtime_error ("an accessor has no elements");
+        }
+
+        // Make sure the final element lies within both the view and the buffer. The sizes come straight from the file so each check is
+        // arranged to never overflow, the final element is at offset + (count - 1) * stride.
+        if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset ||
+            offset > viewLength || elementSize > viewLength - offset ||
+            result.count - 1 > (viewLength - offset - elementSize) / result.stride)
+        {
+            throw std::runtime_error ("an accessor reads outside of its buffer");
+        }
+
+        result.data             = buffer.data + viewOffset + offset;
+
+        return result;
+    }
+
+
+    /// <summary> Calculates the local transform of a node from its matrix or translation, rotation and scale. </summary>
+    glm::mat4 localTransform (const util::JsonValue& node)
+    {
+        if (const auto matrix = node.find ("matrix"))
+        {
+            glm::mat4 result { 1.f };
+
+            for (size_t i = 0; i < 16 && i < matrix->size(); ++i)
+            {
+                result[i / 4][i % 4] = static_cast<float> ((*matrix)[i].asNumber());
+            }
+
+            return result;
+        }
+
+        const auto readVector = [&] (const char* const name, const float fallback, float* output, const size_t count)
+        {
+            const auto member = node.find (name);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                output[i] = member && i < member->size() ? static_cast<float> ((*member)[i].asNumber (fallback)) : fallback;
+            }
+        };
+
+        float translation[3], rotation[4], scale[3];
+        readVector ("translation", 0.f, translation, 3);
+        readVector ("scale", 1.f, scale, 3);
+        readVector ("rotation", 0.f, rotation, 4);
+
+        if (!node.find ("rotation"))
+        {
+            rotation[3] = 1.f;
+        }
+
+        // glTF stores quaternions as XYZW.
+        const auto orientation = glm::quat (rotation[3], rotation[0], rotation[1], rotation[2]);
+
+        return glm::translate (glm::mat4 (1.f), glm::vec3 (translation[0], translation[1], translation[2])) *
+               glm::mat4_cast (orientation) *
+               glm::scale (glm::mat4 (1.f), glm::vec3 (scale[0], scale[1], scale[2]));
+    }
+
+
+    /// <summary> Converts the metallic-roughness materials into the Phong materials used by the renderer. </summary>
+    void buildMaterials (const util::JsonValue& root, const std::string& directory, ImportedScene& scene)
+    {
+        const auto materials = root.find ("materials");
+
+        if (!materials)
+        {
+            return;
+        }
+
+        bool warnedEmbedded { false };
+
+        for (size_t i = 0; i < materials->size(); ++i)
+        {
+            const auto& material    = (*materials)[i];
+            const auto  pbr         = material.find ("pbrMetallicRoughness");
+
+            glm::vec3   base        { 1.f };
+            float       metallic    { 1.f }, roughness { 1.f }, textureID { -1.f };
+
+            if (pbr)
+            {
+                if (const auto factor = pbr->find ("baseColorFactor"))
+                {
+                    for (size_t c = 0; c < 3 && c < factor->size(); ++c)
+                    {
+                        base[c] = static_cast<float> ((*factor)[c].asNumber (1.0));
+                    }
+                }
+
+                metallic    = static_cast<float> (pbr->numberOf ("metallicFactor", 1.0));
+                roughness   = static_cast<float> (pbr->numberOf ("roughnessFactor", 1.0));
+
+                // Resolve the base colour texture to the file holding its image.
+                if (const auto texture = pbr->find ("baseColorTexture"))
+                {
+                    const auto& image = element (root, "images", element (root, "textures", texture->integerOf ("index")).integerOf ("source"));
+                    const auto  uri   = image.find ("uri");
+
+                    if (uri && uri->asString().compare (0, 5, "data:") != 0)
+                    {
+                        const auto location = directory + uri->asString();
+                        const auto existing = std::find (scene.textures.begin(), scene.textures.end(), location);
+                        textureID           = static_cast<float> (existing - scene.textures.begin());
+
+                        if (existing == scene.textures.end())
+                        {
+                            scene.textures.push_back (location);
+                        }
+                    }
+
+                    else if (!warnedEmbedded)
+                    {
+                        std::cerr << "glTF: embedded images aren't supported, the materials using them will be untextured." << std::endl;
+                        warnedEmbedded = true;
+                    }
+                }
+            }
+
+            // Approximate the specular response: dielectrics reflect ~4% whereas metals tint reflections with the base colour. The
+            // shininess mapping is the usual Blinn-Phong approximation of a GGX lobe.
+            const auto alpha = util::max (roughness * roughness, 0.01f);
+
+            MyView::Material result { };
+            result.diffuseColour    = base * (1.f - metallic);
+            result.specularColour   = glm::mix (glm::vec3 (0.04f), base, metallic);
+            result.shininess        = util::min (2.f / (alpha * alpha) - 2.f, 1000.f);
+            result.textureID        = textureID;
+
+            // Fully metallic surfaces would otherwise be black wherever the lights don't reach.
+            if (metallic >= 1.f)
+            {
+                result.diffuseColour = base * 0.25f;
+            }
+
+            scene.materials.push_back (result);
+        }
+    }
+
+    #pragma endregion
+
+
+    #pragma region Loading
+
+    /// <summary> Splits a file into its JSON and, for binary containers, its embedded binary chunk. </summary>
+    void splitContainer (const util::MappedFile& file, const char*& jsonBegin, const char*& jsonEnd, Buffer& embedded)
+    {
+        const auto bytes = reinterpret_cast<const unsigned char*> (file.data());
+        uint32_t   magic { 0 };
+
+        if (file.size() >= 12)
+        {
+            std::memcpy (&magic, bytes, sizeof (magic));
+        }
+
+        // A plain .gltf file is entirely JSON.
+        if (magic != glbMagic)
+        {
+            jsonBegin   = file.data();
+            jsonEnd     = file.end();
+            return;
+        }
+
+        uint32_t header[3];
+        std::memcpy (header, bytes, sizeof (header));
+
+        if (header[1] != 2)
+        {
+            throw std::runtime_error ("only version 2 binary containers are supported");
+        }
+
+        const auto length = std::min<size_t> (header[2], file.size());
+        size_t     offset { 12 };
+
+        while (offset + 8 <= length)
+        {
+            uint32_t chunk[2];
+            std::memcpy (chunk, bytes + offset, sizeof (chunk));
+            offset += 8;
+
+            if (offset + chunk[0] > length)
+            {
+                throw std::runtime_error ("truncated binary container");
+            }
+
+            if (chunk[1] == glbJsonChunk && !jsonBegin)
+            {
+                jsonBegin   = file.data() + offset;
+                jsonEnd     = jsonBegin + chunk[0];
+            }
+
+            else if (chunk[1] == glbBinaryChunk && !embedded.data)
+            {
+                embedded.data = bytes + offset;
+                embedded.size = chunk[0];
+            }
+
+            // Chunks are padded to four bytes.
+            offset += (chunk[0] + 3) & ~3U;
+        }
+
+        if (!jsonBegin)
+        {
+            throw std::runtime_error ("the binary container has no JSON chunk");
+        }
+    }
+
+
+    /// <summary> Maps every buffer the document references. </summary>
+    std::vector<Buffer> loadBuffers (const util::JsonValue& root, const std::string& directory, const Buffer& embedded, std::vector<util::MappedFile>& files)
+    {
+        std::vector<Buffer> buffers { };
+        const auto          array   = root.find ("buffers");
+
+        if (!array)
+        {
+            return buffers;
+        }
+
+        files.reserve (array->size());
+
+        for (size_t i = 0; i < array->size(); ++i)
+        {
+            const auto uri = (*array)[i].find ("uri");
+
+            // The first buffer of a binary container may refer to the embedded chunk.
+            if (!uri)
+            {
+                if (i != 0 || !embedded.data)
+                {
+                    throw std::runtime_error ("a buffer has no data");
+                }
+
+                buffers.push_back (embedded);
+                continue;
+            }
+
+            if (uri->asString().compare (0, 5, "data:") == 0)
+            {
+                throw std::runtime_error ("base64 encoded buffers are not supported, use binary buffers");
+            }
+
+            files.emplace_back();
+
+            if (!files.back().open (directory + uri->asString()))
+            {
+                throw std::runtime_error ("unable to open buffer " + uri->asString());
+            }
+
+            Buffer buffer { };
+            buffer.data = reinterpret_cast<const unsigned char*> (files.back().data());
+            buffer.size = files.back().size();
+            buffers.push_back (buffer);
+        }
+
+        return buffers;
+    }
+
+
+    /// <summary> Decodes a primitive directly into its place in the scene tables. </summary>
+    void decodePrimitive (const util::JsonValue& root, const std::vector<Buffer>& buffers, const Primitive& primitive,
+                          Vertex* const vertices, unsigned int* const elements)
+    {
+        const auto positions = resolveAccessor (root, buffers, primitive.position);
+
+        for (size_t i = 0; i < primitive.vertexCount; ++i)
+        {
+            positions.readFloats (i, &vertices[i].position.x, 3);
+        }
+
+        if (primitive.normal >= 0)
+        {
+            const auto normals = resolveAccessor (root, buffers, primitive.normal);
+
+            for (size_t i = 0; i < primitive.vertexCount && i < normals.count; ++i)
+            {
+                normals.readFloats (i, &vertices[i].normal.x, 3);
+            }
+        }
+
+        if (primitive.texture >= 0)
+        {
+            const auto textures = resolveAccessor (root, buffers, primitive.texture);
+
+            for (size_t i = 0; i < primitive.vertexCount && i < textures.count; ++i)
+            {
+                textures.readFloats (i, &vertices[i].texturePoint.x, 2);
+            }
+        }
+
+        if (primitive.indices >= 0)
+        {
+            const auto indices = resolveAccessor (root, buffers, primitive.indices);
+
+            for (size_t i = 0; i < primitive.elementCount; ++i)
+            {
+                const auto index = indices.readIndex (i);
+
+                if (index >= primitive.vertexCount)
+                {
+                    throw std::runtime_error ("a primitive references a vertex which doesn't exist");
+                }
+
+                elements[i] = index;
+            }
+        }
+
+        // Non-indexed primitives draw their vertices in order.
+        else
+        {
+            for (size_t i = 0; i < primitive.elementCount; ++i)
+            {
+                elements[i] = static_cast<unsigned int> (i);
+            }
+        }
+
+        // Generate flat-ish normals when none were provided.
+        if (primitive.normal < 0)
+        {
+            for (size_t i = 0; i + 2 < primitive.elementCount; i += 3)
+            {
+                auto&       a       = vertices[elements[i]];
+                auto&       b       = vertices[elements[i + 1]];
+                auto&       c       = vertices[elements[i + 2]];
+                const auto  normal  = glm::cross (b.position - a.position, c.position - a.position);
+
+                a.normal += normal;
+                b.normal += normal;
+                c.normal += normal;
+            }
+
+            for (size_t i = 0; i < primitive.vertexCount; ++i)
+            {
+                const auto length = glm::length (vertices[i].normal);
+                vertices[i].normal = length > 0.f ? vertices[i].normal / length : glm::vec3 (0.f, 1.f, 0.f);
+            }
+        }
+    }
+
+    #pragma endregion
+}
+
+
+namespace util
+{
+    void importGltf (ImportedScene& scene, const std::string& fileLocation)
+    {
+        /// The JSON header is small and parsed on the calling thread, every primitive is then sized so that its range in the scene
+        /// tables is known up front, letting each primitive be decoded straight from the mapped buffers into its final location in parallel.
+        using Clock = std::chrono::steady_clock;
+        const auto elapsed = [] (const Clock::time_point start) { return std::chrono::duration<double, std::milli> (Clock::now() - start).count(); };
+
+        auto stageStart = Clock::now();
+
+        MappedFile file { };
+        scene.sources.push_back (fileLocation);
+
+        if (!file.open (fileLocation))
+        {
+            throw std::runtime_error ("unable to open the file");
+        }
+
+        const char* jsonBegin   { nullptr };
+        const char* jsonEnd     { nullptr };
+        Buffer      embedded    { };
+        splitContainer (file, jsonBegin, jsonEnd, embedded);
+
+        const auto                  root        = JsonValue::parse (jsonBegin, jsonEnd);
+        const auto                  directory   = directoryOf (fileLocation);
+        std::vector<MappedFile>     bufferFiles { };
+        const auto                  buffers     = loadBuffers (root, directory, embedded, bufferFiles);
+
+        // External buffers need watching along with the document.
+        const auto bufferArray = root.find ("buffers");
+
+        for (size_t i = 0; bufferArray && i < bufferArray->size(); ++i)
+        {
+            if (const auto uri = (*bufferArray)[i].find ("uri"))
+            {
+                scene.sources.push_back (directory + uri->asString());
+            }
+        }
+
+        const auto headerTime = elapsed (stageStart);
+        stageStart = Clock::now();
+
+        // Gather every triangle primitive, remembering which scene mesh each glTF mesh primitive became.
+        std::vector<Primitive>              primitives      { };
+        std::vector<std::vector<size_t>>    meshPrimitives  { };
+        const auto                          meshes          = root.find ("meshes");
+
+        for (size_t m = 0; meshes && m < meshes->size(); ++m)
+        {
+            meshPrimitives.emplace_back();
+            const auto array = (*meshes)[m].find ("primitives");
+
+            for (size_t p = 0; array && p < array->size(); ++p)
+            {
+                const auto& source      = (*array)[p];
+                const auto  attributes  = source.find ("attributes");
+
+                if (source.integerOf ("mode", modeTriangles) != modeTriangles || !attributes || !attributes->find ("POSITION"))
+                {
+                    std::cerr << "glTF: skipping a primitive which isn't a triangle list with positions." << std::endl;
+                    continue;
+                }
+
+                Primitive primitive { };
+                primitive.position      = attributes->integerOf ("POSITION");
+                primitive.normal        = attributes->integerOf ("NORMAL");
+                primitive.texture       = attributes->integerOf ("TEXCOORD_0");
+                primitive.indices       = source.integerOf ("indices");
+                primitive.material      = source.integerOf ("material");
+                primitive.vertexCount   = static_cast<size_t> (element (root, "accessors", primitive.position).integerOf ("count", 0));
+                primitive.elementCount  = primitive.indices >= 0 ? static_cast<size_t> (element (root, "accessors", primitive.indices).integerOf ("count", 0))
+                                                                 : primitive.vertexCount;
+
+                meshPrimitives.back().push_back (primitives.size());
+                primitives.push_back (primitive);
+            }
+        }
+
+        // Assign each primitive its range in the tables.
+        size_t vertexCount { 0 }, elementCount { 0 };
+        std::vector<std::pair<size_t, size_t>> offsets (primitives.size());
+        scene.meshes.resize (primitives.size());
+
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            offsets[i] = { vertexCount, elementCount };
+
+            auto& mesh          = scene.meshes[i];
+            mesh.verticesIndex  = static_cast<GLint> (vertexCount);
+            mesh.elementsOffset = elementCount * sizeof (unsigned int);
+            mesh.elementCount   = primitives[i].elementCount;
+
+            vertexCount     += primitives[i].vertexCount;
+            elementCount    += primitives[i].elementCount;
+        }
+
+        scene.vertices.resize (vertexCount);
+        scene.elements.resize (elementCount);
+
+        parallelFor (primitives.size(), [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                decodePrimitive (root, buffers, primitives[i], &scene.vertices[offsets[i].first], &scene.elements[offsets[i].second]);
+            }
+        });
+
+        const auto decodeTime = elapsed (stageStart);
+        stageStart = Clock::now();
+
+        buildMaterials (root, directory, scene);
+        const auto defaultMaterial = scene.materials.size();
+
+        // Walk the node hierarchy of the default scene, creating an instance of each primitive of each mesh a node refers to.
+        std::vector<std::pair<long long, glm::mat4>> stack { };
+        const auto nodes    = root.find ("nodes");
+        const auto scenes   = root.find ("scenes");
+
+        if (scenes && scenes->size() > 0)
+        {
+            const auto& active  = (*scenes)[static_cast<size_t> (util::max (root.integerOf ("scene", 0), 0LL)) % scenes->size()];
+            const auto  roots   = active.find ("nodes");
+
+            for (size_t i = 0; roots && i < roots->size(); ++i)
+            {
+                stack.push_back ({ (*roots)[i].asInteger(), glm::mat4 (1.f) });
+            }
+        }
+
+        // Without a scene every node which isn't a child is a root.
+        else if (nodes)
+        {
+            std::vector<bool> isChild (nodes->size(), false);
+
+            for (size_t i = 0; i < nodes->size(); ++i)
+            {
+                if (const auto children = (*nodes)[i].find ("children"))
+                {
+                    for (size_t c = 0; c < children->size(); ++c)
+                    {
+                        const auto child = (*children)[c].asInteger (-1);
+
+                        if (child >= 0 && static_cast<size_t> (child) < isChild.size())
+                        {
+                            isChild[static_cast<size_t> (child)] = true;
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < nodes->size(); ++i)
+            {
+                if (!isChild[i])
+                {
+                    stack.push_back ({ static_cast<long long> (i), glm::mat4 (1.f) });
+                }
+            }
+        }
+
+        // A node hierarchy is a tree, so no valid file visits more nodes than it has. Anything else contains a cycle.
+        size_t visited { 0 };
+        bool   usesDefaultMaterial { false };
+
+        while (!stack.empty())
+        {
+            const auto current = stack.back();
+            stack.pop_back();
+
+            if (++visited > (nodes ? nodes->size() : 0))
+            {
+                throw std::runtime_error ("the node hierarchy contains a cycle");
+            }
+
+            const auto& node    = element (root, "nodes", current.first);
+            const auto  world   = current.second * localTransform (node);
+            const auto  mesh    = node.integerOf ("mesh");
+
+            if (mesh >= 0 && static_cast<size_t> (mesh) < meshPrimitives.size())
+            {
+                for (const auto primitive : meshPrimitives[static_cast<size_t> (mesh)])
+                {
+                    const auto material = primitives[primitive].material;
+
+                    ImportedInstance instance { };
+                    instance.meshIndex      = primitive;
+                    instance.materialIndex  = material >= 0 && static_cast<size_t> (material) < defaultMaterial ? static_cast<size_t> (material) : defaultMaterial;
+                    instance.transform      = world;
+
+                    usesDefaultMaterial |= instance.materialIndex == defaultMaterial;
+                    scene.instances.push_back (instance);
+                }
+            }
+
+            if (const auto children = node.find ("children"))
+            {
+                for (size_t c = 0; c < children->size(); ++c)
+                {
+                    stack.push_back ({ (*children)[c].asInteger (-1), world });
+                }
+            }
+        }
+
+        if (usesDefaultMaterial)
+        {
+            scene.materials.emplace_back();
+        }
+
+        const auto sceneTime = elapsed (stageStart);
+
+        std::cout   << "glTF: header " << headerTime << "ms, decode " << primitives.size() << " primitives " << decodeTime << "ms ("
+                    << (vertexCount * sizeof (Vertex) + elementCount * sizeof (unsigned int)) / (1024.0 * 1024.0) / (decodeTime / 1000.0)
+                    << "MB/s), scene " << sceneTime << "ms." << std::endl;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#if !defined    _IMPORTED_SCENE_
+#define         _IMPORTED_SCENE_
+
+
+// STL headers.
+#include <string>
+#include <vector>
+
+
+// Engine headers.
+#include <glm/gtc/type_ptr.hpp>
+
+
+// Personal headers.
+#include <Misc/Vertex.h>
+#include <MyView/Material.h>
+#include <MyView/Mesh.h>
+
+
+/// <summary>
+/// An instance of an imported mesh, placed in the world with its own material.
+/// </summary>
+struct ImportedInstance final
+{
+    size_t      meshIndex       { 0 };      //!< The index of the mesh in ImportedScene::meshes.
+    size_t      materialIndex   { 0 };      //!< The index of the material in ImportedScene::materials.
+    glm::mat4   transform       { 1.f };    //!< The model transformation matrix of the instance.
+};
+
+
+/// <summary>
+/// The renderer-ready tables produced by an importer. The vertex and element tables are laid out exactly as they will be in the VBOs
+/// so they can be uploaded without any further processing. Meshes occupy the tables in order, so the vertices of a mesh end where
+/// the vertices of the next mesh begin.
+/// </summary>
+struct ImportedScene final
+{
+    std::vector<Vertex>             vertices    { };    //!< The interleaved vertices of every mesh.
+    std::vector<unsigned int>       elements    { };    //!< The elements of every mesh, relative to the first vertex of the mesh.
+    std::vector<MyView::Mesh>       meshes      { };    //!< The vertex index, element offset in bytes and element count of each mesh.
+    std::vector<MyView::Material>   materials   { };    //!< Every material, the texture ID is an index into textures.
+    std::vector<std::string>        textures    { };    //!< The file location of every texture referenced by the materials.
+    std::vector<ImportedInstance>   instances   { };    //!< Every instance in the scene.
+    std::vector<std::string>        sources     { };    //!< The scene file and every file it pulled data from, textures aside.
+
+    /// <summary> Gets the number of vertices belonging to the mesh at the given index. </summary>
+    size_t vertexCountOf (const size_t mesh) const
+    {
+        const auto end = mesh + 1 < meshes.size() ? static_cast<size_t> (meshes[mesh + 1].verticesIndex) : vertices.size();
+        return end - static_cast<size_t> (meshes[mesh].verticesIndex);
+    }
+};
+
+#endif // _IMPORTED_SCENE_
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "Importer.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+
+
+
+namespace util
+{
+    bool importScene (ImportedScene& scene, const std::string& fileLocation)
+    {
+        // Start from a clean slate.
+        scene = ImportedScene { };
+
+        // Determine the importer from the extension.
+        const auto dot          = fileLocation.find_last_of ('.');
+        auto       extension    = dot == std::string::npos ? std::string { } : fileLocation.substr (dot + 1);
+        std::transform (extension.begin(), extension.end(), extension.begin(), [] (const char c) { return static_cast<char> (std::tolower (c)); });
+
+        const auto start = std::chrono::steady_clock::now();
+
+        try
+        {
+            if (extension == "obj")
+            {
+                importObj (scene, fileLocation);
+            }
+
+            else if (extension == "gltf" || extension == "glb")
+            {
+                importGltf (scene, fileLocation);
+            }
+
+            else
+            {
+                std::cerr << "Unable to import " << fileLocation << ": unsupported file type." << std::endl;
+                return false;
+            }
+        }
+
+        catch (const std::exception& error)
+        {
+            std::cerr << "Unable to import " << fileLocation << ": " << error.what() << std::endl;
+            scene = ImportedScene { };
+            return false;
+        }
+
+        const auto milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+        std::cout   << "Imported " << fileLocation << " in " << milliseconds << "ms: "
+                    << scene.meshes.size() << " meshes, " << scene.vertices.size() << " vertices, " << scene.elements.size() / 3 << " triangles, "
+                    << scene.materials.size() << " materials, " << scene.instances.size() << " instances." << std::endl;
+
+        return true;
+    }
+
+
+    std::string directoryOf (const std::string& fileLocation)
+    {
+        const auto separator = fileLocation.find_last_of ("/\\");
+        return separator == std::string::npos ? std::string { } : fileLocation.substr (0, separator + 1);
+    }
+}
\ No newline at end of file
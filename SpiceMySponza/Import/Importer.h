@@ -0,0 +1,38 @@
+#pragma once
+
+#if !defined    _IMPORTER_
+#define         _IMPORTER_
+
+
+// STL headers.
+#include <string>
+
+
+// Forward declarations.
+struct ImportedScene;
+
+
+namespace util
+{
+    /// <summary> Imports a scene, choosing the importer from the file extension (.obj, .gltf or .glb). Timings are written to std::cout. </summary>
+    /// <returns> Whether the scene was imported, any errors are written to std::cerr. </returns>
+    /// <param name="scene"> The scene to fill, any existing data is discarded. </param>
+    /// <param name="fileLocation"> The location of the scene file. </param>
+    bool importScene (ImportedScene& scene, const std::string& fileLocation);
+
+
+    /// <summary> Imports a Wavefront OBJ file and the MTL libraries it references. The file is parsed in parallel chunks. </summary>
+    /// <exception cref="std::runtime_error"> Thrown if the file can't be read or is malformed. </exception>
+    void importObj (ImportedScene& scene, const std::string& fileLocation);
+
+
+    /// <summary> Imports a glTF 2.0 file, either a .glb container or a .gltf file with external binary buffers. Primitives are decoded in parallel. </summary>
+    /// <exception cref="std::runtime_error"> Thrown if the file can't be read, is malformed or uses an unsupported feature. </exception>
+    void importGltf (ImportedScene& scene, const std::string& fileLocation);
+
+
+    /// <summary> Gets the directory part of a file location, including the trailing separator. </summary>
+    std::string directoryOf (const std::string& fileLocation);
+}
+
+#endif // _IMPORTER_
\ No newline at end of file
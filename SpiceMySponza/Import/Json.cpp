@@ -0,0 +1,413 @@
+#include "Json.h"
+
+
+
+// STL headers.
+#include <cctype>
+#include <cstdlib>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+
+
+namespace util
+{
+    #pragma region Parser
+
+    /// <summary>
+    /// A recursive descent parser which fills JsonValue objects. Kept out of the header as nothing else needs to see it.
+    /// </summary>
+    class JsonParser final
+    {
+        public:
+
+            JsonParser (const char* begin, const char* end) : m_current (begin), m_end (end) { }
+
+            JsonValue parseDocument()
+            {
+                JsonValue root { };
+                parseValue (root);
+                skipWhitespace();
+
+                if (m_current != m_end)
+                {
+                    fail ("unexpected data after the root value");
+                }
+
+                return root;
+            }
+
+        private:
+
+            void fail (const char* const reason) const
+            {
+                throw std::runtime_error (std::string ("JSON parse error: ") + reason);
+            }
+
+
+            void skipWhitespace()
+            {
+                while (m_current != m_end && (*m_current == ' ' || *m_current == '\t' || *m_current == '\n' || *m_current == '\r'))
+                {
+                    ++m_current;
+                }
+            }
+
+
+            void expect (const char character)
+            {
+                skipWhitespace();
+
+                if (m_current == m_end || *m_current != character)
+                {
+                    fail ("unexpected character");
+                }
+
+                ++m_current;
+            }
+
+
+            bool consumeLiteral (const char* literal)
+            {
+                auto current = m_current;
+
+                for (; *literal; ++literal, ++current)
+                {
+                    if (current == m_end || *current != *literal)
+                    {
+                        return false;
+                    }
+                }
+
+                m_current = current;
+                return true;
+            }
+
+
+            void parseValue (JsonValue& value)
+            {
+                skipWhitespace();
+
+                if (m_current == m_end)
+                {
+                    fail ("unexpected end of document");
+                }
+
+                switch (*m_current)
+                {
+                    case '{':
+                        parseObject (value);
+                        break;
+
+                    case '[':
+                        parseArray (value);
+                        break;
+
+                    case '"':
+                        value.m_type = JsonValue::Type::String;
+                        parseString (value.m_string);
+                        break;
+
+                    case 't':
+                    case 'f':
+                        value.m_type = JsonValue::Type::Boolean;
+                        value.m_boolean = *m_current == 't';
+
+                        if (!consumeLiteral (value.m_boolean ? "true" : "false"))
+                        {
+                            fail ("invalid literal");
+                        }
+
+                        break;
+
+                    case 'n':
+                        value.m_type = JsonValue::Type::Null;
+
+                        if (!consumeLiteral ("null"))
+                        {
+                            fail ("invalid literal");
+                        }
+
+                        break;
+
+                    default:
+                        parseNumber (value);
+                        break;
+                }
+            }
+
+
+            void parseObject (JsonValue& value)
+            {
+                value.m_type = JsonValue::Type::Object;
+                expect ('{');
+                skipWhitespace();
+
+                if (m_current != m_end && *m_current == '}')
+                {
+                    ++m_current;
+                    return;
+                }
+
+                while (true)
+                {
+                    skipWhitespace();
+                    value.m_object.emplace_back();
+                    auto& member = value.m_object.back();
+
+                    parseString (member.first);
+                    expect (':');
+                    parseValue (member.second);
+                    skipWhitespace();
+
+                    if (m_current == m_end)
+                    {
+                        fail ("unterminated object");
+                    }
+
+                    if (*m_current++ == '}')
+                    {
+                        return;
+                    }
+
+                    if (m_current[-1] != ',')
+                    {
+                        fail ("expected ',' or '}' in object");
+                    }
+                }
+            }
+
+
+            void parseArray (JsonValue& value)
+            {
+                value.m_type = JsonValue::Type::Array;
+                expect ('[');
+                skipWhitespace();
+
+                if (m_current != m_end && *m_current == ']')
+                {
+                    ++m_current;
+                    return;
+                }
+
+                while (true)
+                {
+                    value.m_array.emplace_back();
+                    parseValue (value.m_array.back());
+                    skipWhitespace();
+
+                    if (m_current == m_end)
+                    {
+                        fail ("unterminated array");
+                    }
+
+                    if (*m_current++ == ']')
+                    {
+                        return;
+                    }
+
+                    if (m_current[-1] != ',')
+                    {
+                        fail ("expected ',' or ']' in array");
+                    }
+                }
+            }
+
+
+            void parseString (std::string& string)
+            {
+                expect ('"');
+
+                while (m_current != m_end && *m_current != '"')
+                {
+                    if (*m_current != '\\')
+                    {
+                        string.push_back (*m_current++);
+                        continue;
+                    }
+
+                    // Deal with escape sequences.
+                    if (++m_current == m_end)
+                    {
+                        break;
+                    }
+
+                    switch (*m_current++)
+                    {
+                        case 'b':   string.push_back ('\b'); break;
+                        case 'f':   string.push_back ('\f'); break;
+                        case 'n':   string.push_back ('\n'); break;
+                        case 'r':   string.push_back ('\r'); break;
+                        case 't':   string.push_back ('\t'); break;
+                        case 'u':   parseUnicodeEscape (string); break;
+                        default:    string.push_back (m_current[-1]); break;
+                    }
+                }
+
+                if (m_current == m_end)
+                {
+                    fail ("unterminated string");
+                }
+
+                ++m_current;
+            }
+
+
+            void parseUnicodeEscape (std::string& string)
+            {
+                if (m_end - m_current < 4)
+                {
+                    fail ("truncated unicode escape");
+                }
+
+                const std::string hex (m_current, m_current + 4);
+                const auto codePoint = static_cast<unsigned int> (std::strtoul (hex.c_str(), nullptr, 16));
+                m_current += 4;
+
+                // Encode as UTF-8. Surrogate pairs aren't combined, glTF URIs and names never need them.
+                if (codePoint < 0x80)
+                {
+                    string.push_back (static_cast<char> (codePoint));
+                }
+
+                else if (codePoint < 0x800)
+                {
+                    string.push_back (static_cast<char> (0xC0 | (codePoint >> 6)));
+                    string.push_back (static_cast<char> (0x80 | (codePoint & 0x3F)));
+                }
+
+                else
+                {
+                    string.push_back (static_cast<char> (0xE0 | (codePoint >> 12)));
+                    string.push_back (static_cast<char> (0x80 | ((codePoint >> 6) & 0x3F)));
+                    string.push_back (static_cast<char> (0x80 | (codePoint & 0x3F)));
+                }
+            }
+
+
+            void parseNumber (JsonValue& value)
+            {
+                // Numbers are short so copy them out. They're read with the classic locale because strtod follows the global locale, which
+                // may expect a decimal comma.
+                const auto start = m_current;
+
+                while (m_current != m_end && (std::isdigit (static_cast<unsigned char> (*m_current)) || *m_current == '-' || *m_current == '+' ||
+                                              *m_current == '.' || *m_current == 'e' || *m_current == 'E'))
+                {
+                    ++m_current;
+                }
+
+                if (start == m_current)
+                {
+                    fail ("unexpected character");
+                }
+
+                std::istringstream number { std::string (start, m_current) };
+                number.imbue (std::locale::classic());
+
+                value.m_type    = JsonValue::Type::Number;
+                number >> value.m_number;
+
+                if (number.fail() || number.peek() != std::char_traits<char>::eof())
+                {
+                    fail ("invalid number");
+                }
+            }
+
+
+            const char* m_current   { nullptr };    //!< The next character to be parsed.
+            const char* m_end       { nullptr };    //!< One past the final character of the document.
+    };
+
+    #pragma endregion
+
+
+    #pragma region Constructors
+
+    JsonValue::JsonValue (JsonValue&& move)
+    {
+        *this = std::move (move);
+    }
+
+
+    JsonValue& JsonValue::operator= (JsonValue&& move)
+    {
+        if (this != &move)
+        {
+            m_type      = move.m_type;
+            m_boolean   = move.m_boolean;
+            m_number    = move.m_number;
+            m_string    = std::move (move.m_string);
+            m_array     = std::move (move.m_array);
+            m_object    = std::move (move.m_object);
+
+            // Reset primitives.
+            move.m_type     = Type::Null;
+            move.m_boolean  = false;
+            move.m_number   = 0.0;
+        }
+
+        return *this;
+    }
+
+    #pragma endregion
+
+
+    #pragma region Parsing
+
+    JsonValue JsonValue::parse (const char* begin, const char* end)
+    {
+        return JsonParser (begin, end).parseDocument();
+    }
+
+    #pragma endregion
+
+
+    #pragma region Getters
+
+    size_t JsonValue::size() const
+    {
+        switch (m_type)
+        {
+            case Type::Array:
+                return m_array.size();
+
+            case Type::Object:
+                return m_object.size();
+
+            default:
+                return 0;
+        }
+    }
+
+
+    const JsonValue* JsonValue::find (const std::string& key) const
+    {
+        for (const auto& member : m_object)
+        {
+            if (member.first == key)
+            {
+                return &member.second;
+            }
+        }
+
+        return nullptr;
+    }
+
+
+    double JsonValue::numberOf (const std::string& key, const double fallback) const
+    {
+        const auto member = find (key);
+        return member ? member->asNumber (fallback) : fallback;
+    }
+
+
+    long long JsonValue::integerOf (const std::string& key, const long long fallback) const
+    {
+        const auto member = find (key);
+        return member ? member->asInteger (fallback) : fallback;
+    }
+
+    #pragma endregion
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#pragma once
+
+#if !defined    _IMPORT_JSON_
+#define         _IMPORT_JSON_
+
+
+// STL headers.
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace util
+{
+    /// <summary>
+    /// A minimal JSON document object model, just enough to read glTF headers. Objects keep their members in file order and are searched
+    /// linearly, glTF objects are small so this is faster than hashing in practice.
+    /// </summary>
+    class JsonValue final
+    {
+        public:
+
+            #pragma region Types
+
+            /// <summary> The type of data held by the value. </summary>
+            enum class Type : int
+            {
+                Null    = 0,
+                Boolean = 1,
+                Number  = 2,
+                String  = 3,
+                Array   = 4,
+                Object  = 5
+            };
+
+            #pragma endregion
+
+            #pragma region Constructors and destructor
+
+            JsonValue()                                     = default;
+            JsonValue (const JsonValue& copy)               = default;
+            JsonValue& operator= (const JsonValue& copy)    = default;
+            ~JsonValue()                                    = default;
+
+            JsonValue (JsonValue&& move);
+            JsonValue& operator= (JsonValue&& move);
+
+            #pragma endregion
+
+            #pragma region Parsing
+
+            /// <summary> Parses a complete JSON document. </summary>
+            /// <returns> The root value of the document. </returns>
+            /// <param name="begin"> The first character of the document. </param>
+            /// <param name="end"> One past the last character of the document. </param>
+            /// <exception cref="std::runtime_error"> Thrown if the document is malformed. </exception>
+            static JsonValue parse (const char* begin, const char* end);
+
+            #pragma endregion
+
+            #pragma region Getters
+
+            Type getType() const                { return m_type; }
+            bool isNull() const                 { return m_type == Type::Null; }
+            bool isNumber() const               { return m_type == Type::Number; }
+            bool isString() const               { return m_type == Type::String; }
+            bool isArray() const                { return m_type == Type::Array; }
+            bool isObject() const               { return m_type == Type::Object; }
+
+            /// <summary> Gets the number of elements in an array or members in an object, zero for every other type. </summary>
+            size_t size() const;
+
+            /// <summary> Finds the member of an object with the given key. </summary>
+            /// <returns> The member or nullptr if the value isn't an object or doesn't contain the key. </returns>
+            const JsonValue* find (const std::string& key) const;
+
+            /// <summary> Gets the element of an array at the given index. The index must be valid. </summary>
+            const JsonValue& operator[] (const size_t index) const  { return m_array[index]; }
+
+            /// <summary> Gets the value as a number, or the fallback if it isn't one. </summary>
+            double asNumber (const double fallback = 0.0) const     { return m_type == Type::Number ? m_number : fallback; }
+
+            /// <summary> Gets the value as an integer, or the fallback if it isn't a number. </summary>
+            long long asInteger (const long long fallback = 0) const { return m_type == Type::Number ? static_cast<long long> (m_number) : fallback; }
+
+            /// <summary> Gets the value as a boolean, or the fallback if it isn't one. </summary>
+            bool asBoolean (const bool fallback = false) const      { return m_type == Type::Boolean ? m_boolean : fallback; }
+
+            /// <summary> Gets the string data of the value, empty if it isn't a string. </summary>
+            const std::string& asString() const                     { return m_string; }
+
+            /// <summary> Gets the number of the member with the given key, or the fallback if it doesn't exist. </summary>
+            double numberOf (const std::string& key, const double fallback = 0.0) const;
+
+            /// <summary> Gets the integer of the member with the given key, or the fallback if it doesn't exist. </summary>
+            long long integerOf (const std::string& key, const long long fallback = -1) const;
+
+            #pragma endregion
+
+        private:
+
+            #pragma region Implementation data
+
+            friend class JsonParser;
+
+            Type                                            m_type      { Type::Null }; //!< The type of data the value holds.
+            bool                                            m_boolean   { false };      //!< The data of a boolean value.
+            double                                          m_number    { 0.0 };        //!< The data of a number value.
+            std::string                                     m_string    { };            //!< The data of a string value.
+            std::vector<JsonValue>                          m_array     { };            //!< The elements of an array value.
+            std::vector<std::pair<std::string, JsonValue>>  m_object    { };            //!< The members of an object value.
+
+            #pragma endregion
+    };
+}
+
+#endif // _IMPORT_JSON_
\ No newline at end of file
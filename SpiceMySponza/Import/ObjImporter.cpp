@@ -0,0 +1,838 @@
+#include "Importer.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+
+// Engine headers.
+#include <glm/glm.hpp>
+
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+#include <Utility/MappedFile.h>
+#include <Utility/Parallel.h>
+
+
+
+namespace
+{
+    #pragma region Parsing data
+
+    /// <summary> Flags indicating which indices of a corner are relative to the chunk rather than to the file. </summary>
+    enum LocalFlags : unsigned char
+    {
+        LocalPosition   = 1,
+        LocalTexture    = 2,
+        LocalNormal     = 4
+    };
+
+
+    /// <summary>
+    /// A single corner of a triangle. Indices are zero-based, -1 means the attribute wasn't given. Negative OBJ indices are relative to
+    /// the number of attributes read so far, which isn't known for a chunk until every earlier chunk is parsed, so they're stored relative
+    /// to the chunk and flagged until they can be resolved.
+    /// </summary>
+    struct Corner final
+    {
+        int             position    { -1 };
+        int             texture     { -1 };
+        int             normal      { -1 };
+        unsigned char   localMask   { 0 };
+
+        bool operator== (const Corner& rhs) const { return position == rhs.position && texture == rhs.texture && normal == rhs.normal; }
+    };
+
+
+    /// <summary> Hashes the resolved indices of a corner for de-indexing. </summary>
+    struct CornerHash final
+    {
+        size_t operator() (const Corner& corner) const
+        {
+            auto hash = static_cast<size_t> (corner.position) * 73856093U;
+            hash ^= static_cast<size_t> (corner.texture) * 19349663U;
+            hash ^= static_cast<size_t> (corner.normal) * 83492791U;
+            return hash;
+        }
+    };
+
+
+    /// <summary> A group, object or material statement, which applies from the given corner onwards. </summary>
+    struct Statement final
+    {
+        size_t          corner      { 0 };
+        bool            isMaterial  { false };
+        std::string     name        { };
+    };
+
+
+    /// <summary> The data read from a line-aligned section of the file by a single thread. </summary>
+    struct Chunk final
+    {
+        const char*                 begin           { nullptr };
+        const char*                 end             { nullptr };
+
+        std::vector<glm::vec3>      positions       { };
+        std::vector<glm::vec2>      textures        { };
+        std::vector<glm::vec3>      normals         { };
+        std::vector<Corner>         corners         { };    //!< Three corners per triangle, polygons are triangulated as fans.
+        std::vector<Statement>      statements      { };
+        std::vector<std::string>    libraries       { };
+
+        size_t                      positionBase    { 0 };  //!< The number of positions in every earlier chunk.
+        size_t                      textureBase     { 0 };  //!< The number of texture co-ordinates in every earlier chunk.
+        size_t                      normalBase      { 0 };  //!< The number of normals in every earlier chunk.
+    };
+
+
+    /// <summary> The triangles of a single group and material pair, spread across any number of chunks. </summary>
+    struct MeshBuild final
+    {
+        std::string                                             material    { };
+        std::vector<std::pair<size_t, std::pair<size_t, size_t>>> ranges    { };    //!< Pairs of chunk index and corner range.
+        std::vector<Vertex>                                     vertices    { };
+        std::vector<unsigned int>                               elements    { };
+    };
+
+    #pragma endregion
+
+
+    #pragma region Lexing
+
+    bool isSpace (const char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+
+    void skipSpaces (const char*& current, const char* const end)
+    {
+        while (current < end && isSpace (*current))
+        {
+            ++current;
+        }
+    }
+
+
+    void skipLine (const char*& current, const char* const end)
+    {
+        while (current < end && *current != '\n')
+        {
+            ++current;
+        }
+
+        if (current < end)
+        {
+            ++current;
+        }
+    }
+
+
+    /// <summary> Checks whether the line starts with the given keyword followed by whitespace, skipping past it if so. </summary>
+    bool consumeKeyword (const char*& current, const char* const end, const char* const keyword)
+    {
+        const auto length = std::strlen (keyword);
+
+        if (static_cast<size_t> (end - current) > length && std::strncmp (current, keyword, length) == 0 && isSpace (current[length]))
+        {
+            current += length;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    /// <summary> Reads the rest of the line with surrounding whitespace trimmed. Leaves current at the end of the line. </summary>
+    std::string readRestOfLine (const char*& current, const char* const end)
+    {
+        skipSpaces (current, end);
+        const auto start = current;
+
+        while (current < end && *current != '\n' && *current != '\r')
+        {
+            ++current;
+        }
+
+        auto last = current;
+
+        while (last > start && isSpace (last[-1]))
+        {
+            --last;
+        }
+
+        return std::string (start, last);
+    }
+
+
+    /// <summary>
+    /// A locale-independent float parser. std::strtof is both locale-sensitive and several times slower, and float parsing dominates
+    /// the cost of reading an OBJ file.
+    /// </summary>
+    float parseFloat (const char*& current, const char* const end)
+    {
+        skipSpaces (current, end);
+
+        bool negative { false };
+
+        if (current < end && (*current == '-' || *current == '+'))
+        {
+            negative = *current++ == '-';
+        }
+
+        double value { 0.0 };
+
+        while (current < end && *current >= '0' && *current <= '9')
+        {
+            value = value * 10.0 + (*current++ - '0');
+        }
+
+        if (current < end && *current == '.')
+        {
+            ++current;
+            double scale { 0.1 };
+
+            while (current < end && *current >= '0' && *current <= '9')
+            {
+                value += (*current++ - '0') * scale;
+                scale *= 0.1;
+            }
+        }
+
+        if (current < end && (*current == 'e' || *current == 'E'))
+        {
+            ++current;
+            bool negativeExponent { false };
+
+            if (current < end && (*current == '-' || *current == '+'))
+            {
+                negativeExponent = *current++ == '-';
+            }
+
+            int exponent { 0 };
+
+            while (current < end && *current >= '0' && *current <= '9')
+            {
+                exponent = exponent * 10 + (*current++ - '0');
+            }
+
+            value *= std::pow (10.0, negativeExponent ? -exponent : exponent);
+        }
+
+        return static_cast<float> (negative ? -value : value);
+    }
+
+
+    /// <summary> Parses a signed integer. </summary>
+    /// <returns> Whether any digits were read. </returns>
+    bool parseInt (const char*& current, const char* const end, int& value)
+    {
+        bool negative { false };
+
+        if (current < end && (*current == '-' || *current == '+'))
+        {
+            negative = *current++ == '-';
+        }
+
+        const auto start = current;
+        value = 0;
+
+        while (current < end && *current >= '0' && *current <= '9')
+        {
+            value = value * 10 + (*current++ - '0');
+        }
+
+        if (negative)
+        {
+            value = -value;
+        }
+
+        return current != start;
+    }
+
+
+    /// <summary> Converts an OBJ index into a zero-based index, flagging relative indices as local to the chunk. </summary>
+    int convertIndex (const int index, const size_t localCount, const unsigned char flag, unsigned char& localMask)
+    {
+        if (index > 0)
+        {
+            return index - 1;
+        }
+
+        if (index < 0)
+        {
+            localMask |= flag;
+            return static_cast<int> (localCount) + index;
+        }
+
+        return -1;
+    }
+
+    #pragma endregion
+
+
+    #pragma region Chunk parsing
+
+    /// <summary> Parses the corners of a face statement and triangulates it as a fan. </summary>
+    void parseFace (const char*& current, const char* const end, Chunk& chunk, std::vector<Corner>& polygon)
+    {
+        polygon.clear();
+
+        while (true)
+        {
+            skipSpaces (current, end);
+            Corner corner { };
+            int    index  { 0 };
+
+            if (!parseInt (current, end, index))
+            {
+                break;
+            }
+
+            corner.position = convertIndex (index, chunk.positions.size(), LocalPosition, corner.localMask);
+
+            if (current < end && *current == '/')
+            {
+                ++current;
+
+                if (parseInt (current, end, index))
+                {
+                    corner.texture = convertIndex (index, chunk.textures.size(), LocalTexture, corner.localMask);
+                }
+
+                if (current < end && *current == '/')
+                {
+                    ++current;
+
+                    if (parseInt (current, end, index))
+                    {
+                        corner.normal = convertIndex (index, chunk.normals.size(), LocalNormal, corner.localMask);
+                    }
+                }
+            }
+
+            polygon.push_back (corner);
+        }
+
+        for (size_t i = 2; i < polygon.size(); ++i)
+        {
+            chunk.corners.push_back (polygon[0]);
+            chunk.corners.push_back (polygon[i - 1]);
+            chunk.corners.push_back (polygon[i]);
+        }
+    }
+
+
+    void parseChunk (Chunk& chunk)
+    {
+        auto                current { chunk.begin };
+        const auto          end     { chunk.end };
+        std::vector<Corner> polygon { };
+
+        while (current < end)
+        {
+            skipSpaces (current, end);
+
+            if (current >= end)
+            {
+                break;
+            }
+
+            if (consumeKeyword (current, end, "v"))
+            {
+                const auto x = parseFloat (current, end);
+                const auto y = parseFloat (current, end);
+                const auto z = parseFloat (current, end);
+                chunk.positions.emplace_back (x, y, z);
+            }
+
+            else if (consumeKeyword (current, end, "vn"))
+            {
+                const auto x = parseFloat (current, end);
+                const auto y = parseFloat (current, end);
+                const auto z = parseFloat (current, end);
+                chunk.normals.emplace_back (x, y, z);
+            }
+
+            else if (consumeKeyword (current, end, "vt"))
+            {
+                // OBJ places v = 0 at the bottom of the image whereas our images are uploaded top row first.
+                const auto u = parseFloat (current, end);
+                const auto v = parseFloat (current, end);
+                chunk.textures.emplace_back (u, 1.f - v);
+            }
+
+            else if (consumeKeyword (current, end, "f"))
+            {
+                parseFace (current, end, chunk, polygon);
+            }
+
+            else if (consumeKeyword (current, end, "g") || consumeKeyword (current, end, "o"))
+            {
+                Statement statement { };
+                statement.corner    = chunk.corners.size();
+                statement.name      = readRestOfLine (current, end);
+                chunk.statements.push_back (std::move (statement));
+            }
+
+            else if (consumeKeyword (current, end, "usemtl"))
+            {
+                Statement statement { };
+                statement.corner        = chunk.corners.size();
+                statement.isMaterial    = true;
+                statement.name          = readRestOfLine (current, end);
+                chunk.statements.push_back (std::move (statement));
+            }
+
+            else if (consumeKeyword (current, end, "mtllib"))
+            {
+                chunk.libraries.push_back (readRestOfLine (current, end));
+            }
+
+            skipLine (current, end);
+        }
+    }
+
+
+    /// <summary> Splits the file into roughly equal chunks which always begin at the start of a line. </summary>
+    std::vector<Chunk> splitIntoChunks (const util::MappedFile& file)
+    {
+        // Small chunks aren't worth the overhead of a thread, but we want a few per worker so an uneven chunk doesn't hold everyone up.
+        const size_t minimumChunkSize   = 1 << 20;
+        const auto   chunkCount         = std::max<size_t> (1, std::min<size_t> (util::workerCount() * 4, file.size() / minimumChunkSize));
+
+        std::vector<Chunk> chunks (chunkCount);
+        auto               start { file.data() };
+
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            const char* finish = i + 1 == chunkCount ? file.end() : file.data() + file.size() / chunkCount * (i + 1);
+
+            if (finish < start)
+            {
+                finish = start;
+            }
+
+            // Move to the start of the next line.
+            while (finish > file.data() && finish < file.end() && finish[-1] != '\n')
+            {
+                ++finish;
+            }
+
+            chunks[i].begin = start;
+            chunks[i].end   = finish;
+            start           = finish;
+        }
+
+        return chunks;
+    }
+
+
+    /// <summary> Converts the chunk-relative indices into file-relative indices and checks every index is valid. </summary>
+    void resolveChunk (Chunk& chunk, const size_t positions, const size_t textures, const size_t normals)
+    {
+        for (auto& corner : chunk.corners)
+        {
+            if (corner.localMask & LocalPosition)
+            {
+                corner.position += static_cast<int> (chunk.positionBase);
+            }
+
+            if (corner.localMask & LocalTexture)
+            {
+                corner.texture += static_cast<int> (chunk.textureBase);
+            }
+
+            if (corner.localMask & LocalNormal)
+            {
+                corner.normal += static_cast<int> (chunk.normalBase);
+            }
+
+            corner.localMask = 0;
+
+            if (corner.position < 0 || static_cast<size_t> (corner.position) >= positions ||
+                corner.texture >= static_cast<int> (textures) || corner.normal >= static_cast<int> (normals))
+            {
+                throw std::runtime_error ("a face references a vertex attribute which doesn't exist");
+            }
+        }
+    }
+
+    #pragma endregion
+
+
+    #pragma region Mesh building
+
+    /// <summary> Fetches an attribute by its file-relative index, finding which chunk holds it with a binary search over the chunk bases. </summary>
+    template <typename T> const T& fetchAttribute (const std::vector<Chunk>& chunks, const size_t index,
+                                                   size_t Chunk::* base, std::vector<T> Chunk::* attributes)
+    {
+        size_t low { 0 }, high { chunks.size() - 1 };
+
+        while (low < high)
+        {
+            const auto middle = (low + high + 1) / 2;
+
+            if (chunks[middle].*base <= index)
+            {
+                low = middle;
+            }
+
+            else
+            {
+                high = middle - 1;
+            }
+        }
+
+        // Skip chunks which contain none of the attribute.
+        while ((chunks[low].*attributes).size() <= index - chunks[low].*base)
+        {
+            ++low;
+        }
+
+        return (chunks[low].*attributes)[index - chunks[low].*base];
+    }
+
+
+    /// <summary> De-indexes the corners of a mesh into unique vertices, generating smooth normals for vertices which lack one. </summary>
+    void buildMesh (MeshBuild& mesh, const std::vector<Chunk>& chunks)
+    {
+        size_t cornerCount { 0 };
+
+        for (const auto& range : mesh.ranges)
+        {
+            cornerCount += range.second.second - range.second.first;
+        }
+
+        std::unordered_map<Corner, unsigned int, CornerHash> lookup { };
+        lookup.reserve (cornerCount / 2);
+        mesh.elements.reserve (cornerCount);
+
+        bool missingNormals { false };
+
+        for (const auto& range : mesh.ranges)
+        {
+            const auto& corners = chunks[range.first].corners;
+
+            for (auto i = range.second.first; i < range.second.second; ++i)
+            {
+                const auto& corner = corners[i];
+                const auto  result = lookup.emplace (corner, static_cast<unsigned int> (mesh.vertices.size()));
+
+                if (result.second)
+                {
+                    Vertex vertex { };
+                    vertex.position = fetchAttribute (chunks, corner.position, &Chunk::positionBase, &Chunk::positions);
+
+                    if (corner.texture >= 0)
+                    {
+                        vertex.texturePoint = fetchAttribute (chunks, corner.texture, &Chunk::textureBase, &Chunk::textures);
+                    }
+
+                    if (corner.normal >= 0)
+                    {
+                        vertex.normal = fetchAttribute (chunks, corner.normal, &Chunk::normalBase, &Chunk::normals);
+                    }
+
+                    else
+                    {
+                        missingNormals = true;
+                    }
+
+                    mesh.vertices.push_back (vertex);
+                }
+
+                mesh.elements.push_back (result.first->second);
+            }
+        }
+
+        // Accumulate area-weighted face normals onto the vertices which were given no normal.
+        if (missingNormals)
+        {
+            for (size_t i = 0; i + 2 < mesh.elements.size(); i += 3)
+            {
+                auto&       a       = mesh.vertices[mesh.elements[i]];
+                auto&       b       = mesh.vertices[mesh.elements[i + 1]];
+                auto&       c       = mesh.vertices[mesh.elements[i + 2]];
+                const auto  normal  = glm::cross (b.position - a.position, c.position - a.position);
+
+                a.normal += normal;
+                b.normal += normal;
+                c.normal += normal;
+            }
+
+            for (auto& vertex : mesh.vertices)
+            {
+                const auto length = glm::length (vertex.normal);
+                vertex.normal = length > 0.f ? vertex.normal / length : glm::vec3 (0.f, 1.f, 0.f);
+            }
+        }
+    }
+
+    #pragma endregion
+
+
+    #pragma region Materials
+
+    /// <summary> Reads every material in an MTL library, adding them to the scene and the name lookup. </summary>
+    void parseMaterialLibrary (const std::string& fileLocation, const std::string& directory, ImportedScene& scene,
+                               std::unordered_map<std::string, size_t>& materials, std::unordered_map<std::string, size_t>& textures)
+    {
+        // Watch the library even when it's missing so that creating it causes a reload.
+        scene.sources.push_back (fileLocation);
+
+        util::MappedFile file { };
+
+        if (!file.open (fileLocation))
+        {
+            std::cerr << "Unable to open material library " << fileLocation << "." << std::endl;
+            return;
+        }
+
+        MyView::Material* material { nullptr };
+        auto              current  { file.data() };
+        const auto        end      { file.end() };
+
+        while (current < end)
+        {
+            skipSpaces (current, end);
+
+            if (consumeKeyword (current, end, "newmtl"))
+            {
+                const auto name = readRestOfLine (current, end);
+                materials[name] = scene.materials.size();
+                scene.materials.emplace_back();
+                material = &scene.materials.back();
+            }
+
+            else if (material && consumeKeyword (current, end, "Kd"))
+            {
+                const auto r = parseFloat (current, end);
+                const auto g = parseFloat (current, end);
+                const auto b = parseFloat (current, end);
+                material->diffuseColour = glm::vec3 (r, g, b);
+            }
+
+            else if (material && consumeKeyword (current, end, "Ks"))
+            {
+                const auto r = parseFloat (current, end);
+                const auto g = parseFloat (current, end);
+                const auto b = parseFloat (current, end);
+                material->specularColour = glm::vec3 (r, g, b);
+            }
+
+            else if (material && consumeKeyword (current, end, "Ns"))
+            {
+                material->shininess = parseFloat (current, end);
+            }
+
+            // The renderer uses a single ambient map, take whichever map is given.
+            else if (material && (consumeKeyword (current, end, "map_Kd") || consumeKeyword (current, end, "map_Ka")))
+            {
+                const auto texture  = directory + readRestOfLine (current, end);
+                const auto result   = textures.emplace (texture, scene.textures.size());
+
+                if (result.second)
+                {
+                    scene.textures.push_back (texture);
+                }
+
+                material->textureID = static_cast<float> (result.first->second);
+            }
+
+            skipLine (current, end);
+        }
+    }
+
+    #pragma endregion
+}
+
+
+namespace util
+{
+    void importObj (ImportedScene& scene, const std::string& fileLocation)
+    {
+        /// The file is split into line-aligned chunks which are parsed completely independently. The only state in an OBJ file which
+        /// crosses chunk boundaries is the attribute counts, needed for relative indices, and the current group and material, so chunks
+        /// record those symbolically and a cheap sequential pass resolves them afterwards. Meshes are then de-indexed in parallel and
+        /// written straight into the renderer's tables.
+        using Clock = std::chrono::steady_clock;
+        const auto elapsed = [] (const Clock::time_point start) { return std::chrono::duration<double, std::milli> (Clock::now() - start).count(); };
+
+        auto stageStart = Clock::now();
+
+        MappedFile file { };
+        scene.sources.push_back (fileLocation);
+
+        if (!file.open (fileLocation))
+        {
+            throw std::runtime_error ("unable to open the file");
+        }
+
+        auto chunks = splitIntoChunks (file);
+
+        parallelFor (chunks.size(), [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                parseChunk (chunks[i]);
+            }
+        });
+
+        const auto parseTime = elapsed (stageStart);
+        stageStart = Clock::now();
+
+        // Calculate the attribute bases of each chunk so relative indices can be resolved.
+        size_t positions { 0 }, textures { 0 }, normals { 0 };
+
+        for (auto& chunk : chunks)
+        {
+            chunk.positionBase  = positions;
+            chunk.textureBase   = textures;
+            chunk.normalBase    = normals;
+
+            positions   += chunk.positions.size();
+            textures    += chunk.textures.size();
+            normals     += chunk.normals.size();
+        }
+
+        if (positions > static_cast<size_t> (INT_MAX))
+        {
+            throw std::runtime_error ("too many vertices");
+        }
+
+        parallelFor (chunks.size(), [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                resolveChunk (chunks[i], positions, textures, normals);
+            }
+        });
+
+        // Walk the statements in file order to split the triangles into a mesh per group and material.
+        std::vector<MeshBuild>                  meshes      { };
+        std::unordered_map<std::string, size_t> meshLookup  { };
+        std::string                             group       { }, material { };
+
+        const auto addRange = [&] (const size_t chunk, const size_t begin, const size_t end)
+        {
+            if (begin >= end)
+            {
+                return;
+            }
+
+            const auto key      = group + '\n' + material;
+            const auto result   = meshLookup.emplace (key, meshes.size());
+
+            if (result.second)
+            {
+                meshes.emplace_back();
+                meshes.back().material = material;
+            }
+
+            meshes[result.first->second].ranges.push_back ({ chunk, { begin, end } });
+        };
+
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            size_t start { 0 };
+
+            for (const auto& statement : chunks[i].statements)
+            {
+                addRange (i, start, statement.corner);
+                start = statement.corner;
+                (statement.isMaterial ? material : group) = statement.name;
+            }
+
+            addRange (i, start, chunks[i].corners.size());
+        }
+
+        const auto resolveTime = elapsed (stageStart);
+        stageStart = Clock::now();
+
+        // De-index every mesh.
+        parallelFor (meshes.size(), [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                buildMesh (meshes[i], chunks);
+            }
+        });
+
+        // The materials only need reading once the meshes know which they use.
+        std::unordered_map<std::string, size_t> materialLookup  { };
+        std::unordered_map<std::string, size_t> textureLookup   { };
+        const auto                              directory       = directoryOf (fileLocation);
+
+        for (const auto& chunk : chunks)
+        {
+            for (const auto& library : chunk.libraries)
+            {
+                parseMaterialLibrary (directory + library, directory, scene, materialLookup, textureLookup);
+            }
+        }
+
+        // Lay the meshes out contiguously in the scene tables.
+        size_t vertexCount { 0 }, elementCount { 0 }, defaultMaterial { scene.materials.size() };
+        bool   usesDefaultMaterial { false };
+        std::vector<std::pair<size_t, size_t>> offsets (meshes.size());
+
+        scene.meshes.resize (meshes.size());
+        scene.instances.resize (meshes.size());
+
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            offsets[i] = { vertexCount, elementCount };
+
+            auto& mesh              = scene.meshes[i];
+            mesh.verticesIndex      = static_cast<GLint> (vertexCount);
+            mesh.elementsOffset     = elementCount * sizeof (unsigned int);
+            mesh.elementCount       = meshes[i].elements.size();
+
+            // OBJ has no instancing so every mesh is placed once at the origin.
+            const auto materialIt               = materialLookup.find (meshes[i].material);
+            scene.instances[i].meshIndex        = i;
+            scene.instances[i].materialIndex    = materialIt != materialLookup.end() ? materialIt->second : defaultMaterial;
+            usesDefaultMaterial                 |= materialIt == materialLookup.end();
+
+            vertexCount     += meshes[i].vertices.size();
+            elementCount    += meshes[i].elements.size();
+        }
+
+        if (usesDefaultMaterial)
+        {
+            scene.materials.emplace_back();
+        }
+
+        scene.vertices.resize (vertexCount);
+        scene.elements.resize (elementCount);
+
+        parallelFor (meshes.size(), [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                std::copy (meshes[i].vertices.begin(), meshes[i].vertices.end(), scene.vertices.begin() + offsets[i].first);
+                std::copy (meshes[i].elements.begin(), meshes[i].elements.end(), scene.elements.begin() + offsets[i].second);
+            }
+        });
+
+        const auto buildTime = elapsed (stageStart);
+
+        const auto megabytes = file.size() / (1024.0 * 1024.0);
+        std::cout   << "OBJ: " << megabytes << "MB in " << chunks.size() << " chunks, parse " << parseTime << "ms ("
+                    << megabytes / (parseTime / 1000.0) << "MB/s), resolve " << resolveTime << "ms, build " << buildTime << "ms." << std::endl;
+    }
+}
\ No newline at end of file
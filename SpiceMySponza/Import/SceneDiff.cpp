@@ -0,0 +1,121 @@
+#include "SceneDiff.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstring>
+
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+#include <Utility/Parallel.h>
+
+
+
+namespace
+{
+    /// <summary> Compares two equally sized ranges of plain data. </summary>
+    template <typename T> bool sameData (const T* const lhs, const T* const rhs, const size_t count)
+    {
+        return count == 0 || std::memcmp (lhs, rhs, count * sizeof (T)) == 0;
+    }
+
+
+    /// <summary> Checks whether the geometry of a mesh is identical in both scenes. </summary>
+    bool sameMesh (const ImportedScene& loaded, const ImportedScene& updated, const size_t index)
+    {
+        const auto& before      = loaded.meshes[index];
+        const auto& after       = updated.meshes[index];
+        const auto  vertexCount = updated.vertexCountOf (index);
+
+        if (before.elementCount != after.elementCount || loaded.vertexCountOf (index) != vertexCount)
+        {
+            return false;
+        }
+
+        // Elements are relative to the first vertex of the mesh so they compare equal wherever the mesh sits in the tables.
+        const auto elementsBefore   = loaded.elements.data() + before.elementsOffset / sizeof (unsigned int);
+        const auto elementsAfter    = updated.elements.data() + after.elementsOffset / sizeof (unsigned int);
+
+        return sameData (elementsBefore, elementsAfter, after.elementCount) &&
+               sameData (loaded.vertices.data() + before.verticesIndex, updated.vertices.data() + after.verticesIndex, vertexCount);
+    }
+
+
+    /// <summary> Checks whether two materials are identical. </summary>
+    bool sameMaterial (const MyView::Material& lhs, const MyView::Material& rhs)
+    {
+        return lhs.diffuseColour == rhs.diffuseColour && lhs.textureID == rhs.textureID &&
+               lhs.specularColour == rhs.specularColour && lhs.shininess == rhs.shininess;
+    }
+
+
+    /// <summary> Checks whether two instances are identical. </summary>
+    bool sameInstance (const ImportedInstance& lhs, const ImportedInstance& rhs)
+    {
+        return lhs.meshIndex == rhs.meshIndex && lhs.materialIndex == rhs.materialIndex && lhs.transform == rhs.transform;
+    }
+}
+
+
+namespace util
+{
+    SceneDiff diffScenes (const ImportedScene& loaded, const ImportedScene& updated, const std::vector<std::string>& modifiedFiles)
+    {
+        SceneDiff diff { };
+
+        // Geometry is by far the most data so the meshes are compared in parallel. Use chars because std::vector<bool> isn't thread safe.
+        const auto          common  = std::min (loaded.meshes.size(), updated.meshes.size());
+        std::vector<char>   changed (common, 0);
+
+        util::parallelFor (common, [&] (const size_t begin, const size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                changed[i] = sameMesh (loaded, updated, i) ? 0 : 1;
+            }
+        }, 64);
+
+        for (size_t i = 0; i < updated.meshes.size(); ++i)
+        {
+            if (i >= common || changed[i])
+            {
+                diff.meshes.push_back (i);
+            }
+        }
+
+        diff.meshesRemoved = updated.meshes.size() < loaded.meshes.size();
+
+        // Materials.
+        for (size_t i = 0; i < updated.materials.size(); ++i)
+        {
+            if (i >= loaded.materials.size() || !sameMaterial (loaded.materials[i], updated.materials[i]))
+            {
+                diff.materials.push_back (i);
+            }
+        }
+
+        // A texture needs reloading if its location has changed or if the file itself has been modified.
+        diff.texturesMoved = loaded.textures.size() != updated.textures.size();
+
+        for (size_t i = 0; i < updated.textures.size(); ++i)
+        {
+            const auto& texture = updated.textures[i];
+            const auto  moved   = i >= loaded.textures.size() || loaded.textures[i] != texture;
+            
+            if (moved || std::find (modifiedFiles.begin(), modifiedFiles.end(), texture) != modifiedFiles.end())
+            {
+                diff.textures.push_back (i);
+                diff.texturesMoved = diff.texturesMoved || moved;
+            }
+        }
+
+        // Instances are cheap to rebuild so we only need to know whether anything differs.
+        diff.instancesChanged = loaded.instances.size() != updated.instances.size() ||
+                                !std::equal (loaded.instances.begin(), loaded.instances.end(), updated.instances.begin(), sameInstance);
+
+        return diff;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#if !defined    _SCENE_DIFF_
+#define         _SCENE_DIFF_
+
+
+// STL headers.
+#include <string>
+#include <vector>
+
+
+// Forward declarations.
+struct ImportedScene;
+
+
+/// <summary>
+/// The differences between a loaded scene and a freshly imported version of it. Indices refer to the updated scene, anything beyond
+/// the end of the loaded tables is new and anything beyond the end of the updated tables has been removed.
+/// </summary>
+struct SceneDiff final
+{
+    std::vector<size_t>     meshes           { };        //!< Each mesh whose vertices or elements are new or have changed.
+    std::vector<size_t>     materials        { };        //!< Each material which is new or has changed.
+    std::vector<size_t>     textures         { };        //!< Each texture whose location or file contents have changed.
+    bool                    meshesRemoved    { false };  //!< Whether the updated scene has fewer meshes.
+    bool                    texturesMoved    { false };  //!< Whether the texture list was added to, removed from or reordered.
+    bool                    instancesChanged { false };  //!< Whether any instance was added, removed or altered.
+
+    /// <summary> Checks whether the scenes are identical as far as the renderer is concerned. </summary>
+    bool empty() const
+    {
+        return meshes.empty() && materials.empty() && textures.empty() && !meshesRemoved && !texturesMoved && !instancesChanged;
+    }
+};
+
+
+namespace util
+{
+    /// <summary> Compares a loaded scene with an updated version so only the changes need uploading. Meshes are compared in parallel. </summary>
+    /// <returns> The changes required to turn the loaded scene into the updated scene. </returns>
+    /// <param name="loaded"> The scene currently in use by the renderer. </param>
+    /// <param name="updated"> The newly imported scene. </param>
+    /// <param name="modifiedFiles"> Files known to have changed on disk, used to detect textures which changed in place. </param>
+    SceneDiff diffScenes (const ImportedScene& loaded, const ImportedScene& updated, const std::vector<std::string>& modifiedFiles);
+}
+
+#endif // _SCENE_DIFF_
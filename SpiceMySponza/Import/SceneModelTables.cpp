@@ -0,0 +1,87 @@
+#include "SceneModelTables.h"
+
+
+
+// STL headers.
+#include <unordered_map>
+
+
+
+// Engine headers.
+#include <SceneModel/SceneModel.hpp>
+
+
+
+// Personal headers.
+#include <Utility/SceneModel.h>
+
+
+
+namespace util
+{
+    void tabulateSceneModel (SceneModelTables& tables, const SceneModel::Context& scene, const SceneModel::GeometryBuilder& builder, const std::string& fileLocation)
+    {
+        tables              = SceneModelTables { };
+        auto& imported      = tables.scene;
+        imported.sources.push_back (fileLocation);
+
+        // Materials refer to their texture by file, each file gets one entry in the texture list.
+        std::unordered_map<SceneModel::MaterialId, size_t>  materials   { };
+        std::unordered_map<std::string, size_t>             textures    { };
+
+        for (const auto& material : scene.getAllMaterials())
+        {
+            const auto& file    = material.getAmbientMap();
+            const auto  texture = textures.emplace (file, imported.textures.size());
+
+            if (texture.second)
+            {
+                imported.textures.push_back (file);
+            }
+
+            MyView::Material tableMaterial { };
+            tableMaterial.diffuseColour     = material.getDiffuseColour();
+            tableMaterial.textureID         = file.empty() ? -1.f : static_cast<float> (texture.first->second);
+            tableMaterial.specularColour    = material.getSpecularColour();
+            tableMaterial.shininess         = material.getShininess();
+
+            materials.emplace (material.getId(), imported.materials.size());
+            imported.materials.push_back (tableMaterial);
+            tables.materialIds.push_back (material.getId());
+        }
+
+        // Meshes are laid out contiguously, followed by their instances.
+        std::vector<Vertex> vertices { };
+
+        for (const auto& mesh : builder.getAllMeshes())
+        {
+            const auto  meshIndex   = imported.meshes.size();
+            const auto& elements    = mesh.getElementArray();
+            util::assembleVertices (vertices, mesh);
+
+            MyView::Mesh tableMesh { };
+            tableMesh.verticesIndex     = static_cast<GLint> (imported.vertices.size());
+            tableMesh.elementsOffset    = imported.elements.size() * sizeof (unsigned int);
+            tableMesh.elementCount      = elements.size();
+            tableMesh.vertexCount       = vertices.size();
+
+            imported.vertices.insert (imported.vertices.end(), vertices.begin(), vertices.end());
+            imported.elements.insert (imported.elements.end(), elements.begin(), elements.end());
+            imported.meshes.push_back (tableMesh);
+            tables.meshIds.push_back (mesh.getId());
+
+            for (const auto id : scene.getInstancesByMeshId (mesh.getId()))
+            {
+                const auto& instance    = scene.getInstanceById (id);
+                const auto  material    = materials.find (instance.getMaterialId());
+
+                ImportedInstance tableInstance { };
+                tableInstance.meshIndex         = meshIndex;
+                tableInstance.materialIndex     = material != materials.end() ? material->second : 0;
+                tableInstance.transform         = (glm::mat4) instance.getTransformationMatrix();
+
+                imported.instances.push_back (tableInstance);
+            }
+        }
+    }
+}
\ No newline at end of file
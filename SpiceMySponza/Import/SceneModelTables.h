@@ -0,0 +1,42 @@
+#pragma once
+
+#if !defined    _SCENE_MODEL_TABLES_
+#define         _SCENE_MODEL_TABLES_
+
+
+// STL headers.
+#include <string>
+#include <vector>
+
+
+// Engine headers.
+#include <SceneModel/SceneModel_fwd.hpp>
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+
+
+/// <summary>
+/// The content of a SceneModel::Context laid out as the tables an importer produces, so SceneDiff can compare sponza with a copy which
+/// was read again after its file changed. Meshes and materials are in the order the SceneModel lists them, which is the file order.
+/// </summary>
+struct SceneModelTables final
+{
+    ImportedScene                           scene       { };    //!< The tables, the textures are the ambient maps of the materials.
+    std::vector<SceneModel::MeshId>         meshIds     { };    //!< The SceneModel ID of each mesh in the tables.
+    std::vector<SceneModel::MaterialId>     materialIds { };    //!< The SceneModel ID of each material in the tables.
+};
+
+
+namespace util
+{
+    /// <summary> Lays out the meshes, materials and instances of a SceneModel scene as tables, assembling vertices the way MyView does. </summary>
+    /// <param name="tables"> The tables to fill, any existing data is discarded. </param>
+    /// <param name="scene"> Provides the materials and instances. </param>
+    /// <param name="builder"> Provides the meshes. </param>
+    /// <param name="fileLocation"> The file the scene was read from, recorded as its only source. </param>
+    void tabulateSceneModel (SceneModelTables& tables, const SceneModel::Context& scene, const SceneModel::GeometryBuilder& builder, const std::string& fileLocation);
+}
+
+#endif // _SCENE_MODEL_TABLES_
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "SceneReferences.h"
+
+
+
+// Personal headers.
+#include <Import/ImportedScene.h>
+
+
+
+namespace util
+{
+    SceneReferences findReferences (const ImportedScene& scene)
+    {
+        SceneReferences references { };
+        references.meshes.assign (scene.meshes.size(), 0);
+        references.materials.assign (scene.materials.size(), 0);
+        references.textures.assign (scene.textures.size(), 0);
+
+        for (const auto& instance : scene.instances)
+        {
+            references.meshes[instance.meshIndex]           = 1;
+            references.materials[instance.materialIndex]    = 1;
+        }
+
+        // Textures are only reachable through a referenced material.
+        for (size_t i = 0; i < scene.materials.size(); ++i)
+        {
+            const auto texture = scene.materials[i].textureID;
+
+            if (references.materials[i] && texture >= 0.f && static_cast<size_t> (texture) < scene.textures.size())
+            {
+                references.textures[static_cast<size_t> (texture)] = 1;
+            }
+        }
+
+        return references;
+    }
+}
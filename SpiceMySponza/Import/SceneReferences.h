@@ -0,0 +1,34 @@
+#pragma once
+
+#if !defined    _SCENE_REFERENCES_
+#define         _SCENE_REFERENCES_
+
+
+// STL headers.
+#include <vector>
+
+
+// Forward declarations.
+struct ImportedScene;
+
+
+/// <summary>
+/// Marks which meshes, materials and textures of an imported scene are reachable from its instances. Scene libraries often contain far
+/// more assets than are placed, so only the reachable ones need decoding and uploading.
+/// </summary>
+struct SceneReferences final
+{
+    std::vector<char>   meshes      { };    //!< Non-zero for each mesh which at least one instance uses.
+    std::vector<char>   materials   { };    //!< Non-zero for each material which at least one instance uses.
+    std::vector<char>   textures    { };    //!< Non-zero for each texture which at least one referenced material uses.
+};
+
+
+namespace util
+{
+    /// <summary> Walks the instances of a scene to find which of its assets are actually used. </summary>
+    /// <returns> The reachability of every mesh, material and texture in the scene. </returns>
+    SceneReferences findReferences (const ImportedScene& scene);
+}
+
+#endif // _SCENE_REFERENCES_
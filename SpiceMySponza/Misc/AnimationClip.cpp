@@ -0,0 +1,155 @@
+#include "AnimationClip.h"
+
+
+
+// STL headers.
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+
+
+// Identifies a clip file, the version changes whenever the layout does.
+const std::uint32_t clipMagic   = 0x43414D53;
+const std::uint32_t clipVersion = 1;
+
+
+
+#pragma region Loading and saving
+
+bool AnimationClip::load (const std::string& fileLocation)
+{
+    m_header = nullptr;
+    m_memory.clear();
+
+    if (!m_file.open (fileLocation) || m_file.size() < sizeof (Header))
+    {
+        m_file.close();
+        return false;
+    }
+
+    Header header { };
+    std::memcpy (&header, m_file.data(), sizeof (Header));
+
+    // The tables are sampled in place so the file must be exactly the size the header claims.
+    if (header.magic != clipMagic || header.version != clipVersion || header.trackCount == 0 || header.keyCount == 0 ||
+        !(header.sampleRate > 0.f) || m_file.size() != fileSize (header.trackCount, header.keyCount))
+    {
+        m_file.close();
+        return false;
+    }
+
+    locateTables (m_file.data());
+    return true;
+}
+
+
+bool AnimationClip::save (const std::string& fileLocation) const
+{
+    if (!m_header)
+    {
+        return false;
+    }
+
+    std::ofstream file { fileLocation, std::ios::binary };
+
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file.write (reinterpret_cast<const char*> (m_header), fileSize (getTrackCount(), getKeyCount()));
+
+    return file.good();
+}
+
+
+bool AnimationClip::create (const std::uint32_t trackCount, const std::uint32_t keyCount, const float sampleRate)
+{
+    if (trackCount == 0 || keyCount == 0 || !(sampleRate > 0.f))
+    {
+        return false;
+    }
+
+    m_file.close();
+    m_memory.assign (fileSize (trackCount, keyCount), 0);
+
+    Header header { };
+    header.magic        = clipMagic;
+    header.version      = clipVersion;
+    header.trackCount   = trackCount;
+    header.keyCount     = keyCount;
+    header.sampleRate   = sampleRate;
+    std::memcpy (m_memory.data(), &header, sizeof (Header));
+
+    locateTables (m_memory.data());
+
+    // Start every key off as the identity.
+    const float translation[3]  = { 0.f, 0.f, 0.f };
+    const float rotation[4]     = { 0.f, 0.f, 0.f, 1.f };
+
+    for (std::uint32_t track = 0; track < trackCount; ++track)
+    {
+        for (std::uint32_t key = 0; key < keyCount; ++key)
+        {
+            setKey (track, key, translation, rotation, 1.f);
+        }
+    }
+
+    return true;
+}
+
+
+void AnimationClip::setKey (const std::uint32_t track, const std::uint32_t key, const float* translation, const float* rotation, const float scale)
+{
+    assert (!m_memory.empty() && track < getTrackCount() && key < getKeyCount());
+
+    // The tables are only writable when the clip lives in m_memory.
+    const auto index        = track * getKeyCount() + key;
+    const auto translations = const_cast<float*> (m_translations) + index * 3;
+    const auto rotations    = const_cast<std::int16_t*> (m_rotations) + index * 4;
+
+    std::memcpy (translations, translation, sizeof (float) * 3);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        const auto clamped  = rotation[i] < -1.f ? -1.f : rotation[i] > 1.f ? 1.f : rotation[i];
+        rotations[i]        = static_cast<std::int16_t> (std::lround (clamped * 32767.f));
+    }
+
+    const_cast<float*> (m_scales)[index] = scale;
+}
+
+#pragma endregion
+
+
+#pragma region Implementation data
+
+void AnimationClip::locateTables (const char* data)
+{
+    m_header        = reinterpret_cast<const Header*> (data);
+
+    const auto keys = static_cast<size_t> (m_header->trackCount) * m_header->keyCount;
+    data            += sizeof (Header);
+
+    m_translations  = reinterpret_cast<const float*> (data);
+    data            += keys * sizeof (float) * 3;
+
+    m_rotations     = reinterpret_cast<const std::int16_t*> (data);
+    data            += keys * sizeof (std::int16_t) * 4;
+
+    m_scales        = reinterpret_cast<const float*> (data);
+}
+
+
+size_t AnimationClip::fileSize (const std::uint32_t trackCount, const std::uint32_t keyCount)
+{
+    static_assert (sizeof (Header) == 32, "The clip header must match the file layout.");
+
+    const auto keys = static_cast<size_t> (trackCount) * keyCount;
+
+    return sizeof (Header) + keys * (sizeof (float) * 3 + sizeof (std::int16_t) * 4 + sizeof (float));
+}
+
+#pragma endregion
@@ -0,0 +1,124 @@
+#pragma once
+
+#if !defined    _ANIMATION_CLIP_
+#define         _ANIMATION_CLIP_
+
+
+// STL headers.
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Personal headers.
+#include <Utility/MappedFile.h>
+
+
+/// <summary>
+/// A looping set of translation, rotation and uniform scale tracks, each keyed at the same fixed sample rate. Clips are stored in a compact
+/// binary file which is mapped into memory and sampled in place, so only the pages of the keys which are actually used are ever read.
+/// The file is a 32 byte header followed by three tables, each holding every key of the first track then every key of the next:
+///
+///     translations    three floats per key.
+///     rotations       four signed normalised 16-bit integers per key, an x, y, z, w quaternion.
+///     scales          one float per key.
+///
+/// Everything is little-endian. The last key of a track blends back into the first so tracks loop seamlessly.
+/// </summary>
+class AnimationClip final
+{
+    public:
+
+        #pragma region File layout
+
+        /// <summary> The start of a clip file. </summary>
+        struct Header final
+        {
+            std::uint32_t   magic           { 0 };      //!< Always "SMAC".
+            std::uint32_t   version         { 0 };      //!< Changes whenever the layout does.
+            std::uint32_t   trackCount      { 0 };      //!< How many tracks the clip contains.
+            std::uint32_t   keyCount        { 0 };      //!< How many keys each track contains.
+            float           sampleRate      { 0.f };    //!< How many keys there are per second.
+            std::uint32_t   reserved[3];                //!< Zero.
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        AnimationClip()                                         = default;
+        ~AnimationClip()                                        = default;
+
+        AnimationClip (AnimationClip&& move)                    = delete;
+        AnimationClip& operator= (AnimationClip&& move)         = delete;
+        AnimationClip (const AnimationClip& copy)               = delete;
+        AnimationClip& operator= (const AnimationClip& copy)    = delete;
+
+        #pragma endregion
+
+        #pragma region Loading and saving
+
+        /// <summary> Maps a clip file into memory, replacing the current clip. </summary>
+        /// <returns> Whether the file could be mapped and has a valid layout. </returns>
+        bool load (const std::string& fileLocation);
+
+        /// <summary> Writes the clip in the binary format. </summary>
+        /// <returns> Whether the file could be written. </returns>
+        bool save (const std::string& fileLocation) const;
+
+        /// <summary> Replaces the current clip with an empty one held in memory, every key starts as the identity transform. </summary>
+        /// <returns> False if any count is zero or the sample rate isn't positive. </returns>
+        bool create (const std::uint32_t trackCount, const std::uint32_t keyCount, const float sampleRate);
+
+        /// <summary> Sets a key of a clip created in memory, mapped clips are read-only. </summary>
+        /// <param name="rotation"> An x, y, z, w quaternion which should be normalised. </param>
+        void setKey (const std::uint32_t track, const std::uint32_t key, const float* translation, const float* rotation, const float scale);
+
+        #pragma endregion
+
+        #pragma region Getters
+
+        bool isValid() const                                        { return m_header != nullptr; }
+        std::uint32_t getTrackCount() const                         { return m_header ? m_header->trackCount : 0; }
+        std::uint32_t getKeyCount() const                           { return m_header ? m_header->keyCount : 0; }
+        float getSampleRate() const                                 { return m_header ? m_header->sampleRate : 0.f; }
+
+        /// <summary> Gets the length of the loop in seconds. </summary>
+        float getDuration() const                                   { return m_header ? m_header->keyCount / m_header->sampleRate : 0.f; }
+
+        /// <summary> Gets the three floats of each key of a track. </summary>
+        const float* translations (const std::uint32_t track) const         { return m_translations + static_cast<size_t> (track) * getKeyCount() * 3; }
+
+        /// <summary> Gets the four quantised quaternion components of each key of a track. </summary>
+        const std::int16_t* rotations (const std::uint32_t track) const     { return m_rotations + static_cast<size_t> (track) * getKeyCount() * 4; }
+
+        /// <summary> Gets the scale of each key of a track. </summary>
+        const float* scales (const std::uint32_t track) const               { return m_scales + static_cast<size_t> (track) * getKeyCount(); }
+
+        /// <summary> Converts a quantised quaternion component back to a float. </summary>
+        static float dequantise (const std::int16_t value)                  { return value / 32767.f; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> Points the tables at the data following the given header. </summary>
+        void locateTables (const char* data);
+
+        /// <summary> Calculates the size of a clip file with the given counts. </summary>
+        static size_t fileSize (const std::uint32_t trackCount, const std::uint32_t keyCount);
+
+        util::MappedFile    m_file          { };        //!< The mapped clip file, if it was loaded.
+        std::vector<char>   m_memory        { };        //!< The clip data, if it was created in memory.
+
+        const Header*       m_header        { nullptr };    //!< The header of the clip.
+        const float*        m_translations  { nullptr };    //!< The first translation of the first track.
+        const std::int16_t* m_rotations     { nullptr };    //!< The first rotation of the first track.
+        const float*        m_scales        { nullptr };    //!< The first scale of the first track.
+
+        #pragma endregion
+};
+
+#endif // _ANIMATION_CLIP_
@@ -0,0 +1,442 @@
+#include "Animator.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+
+
+
+// Personal headers.
+#include <Misc/AnimationClip.h>
+#include <Misc/ThreadPool.h>
+
+
+
+// Platform headers.
+#if defined (_M_X64) || defined (_M_IX86) || defined (__SSE__)
+    #include <xmmintrin.h>
+    #define ANIMATOR_SSE
+#endif
+
+
+
+// How many instances each job evaluates, a multiple of 64 so no two jobs write to the same dirty word.
+const size_t jobSize    = 1024;
+
+// How many instances are evaluated at once.
+const size_t laneCount  = 4;
+
+
+
+namespace
+{
+    #pragma region Lanes
+
+    #if defined (ANIMATOR_SSE)
+
+    /// <summary> A value for each instance in a batch. </summary>
+    using Lanes = __m128;
+
+    inline Lanes load (const float* data)                       { return _mm_loadu_ps (data); }
+    inline void store (float* data, const Lanes value)          { _mm_storeu_ps (data, value); }
+    inline Lanes splat (const float value)                      { return _mm_set1_ps (value); }
+    inline Lanes add (const Lanes a, const Lanes b)             { return _mm_add_ps (a, b); }
+    inline Lanes sub (const Lanes a, const Lanes b)             { return _mm_sub_ps (a, b); }
+    inline Lanes mul (const Lanes a, const Lanes b)             { return _mm_mul_ps (a, b); }
+    inline Lanes div (const Lanes a, const Lanes b)             { return _mm_div_ps (a, b); }
+    inline Lanes sqrt (const Lanes a)                           { return _mm_sqrt_ps (a); }
+
+    #else
+
+    /// <summary> A value for each instance in a batch, for platforms without SSE. The compiler is left to vectorise the loops. </summary>
+    struct Lanes final
+    {
+        float v[laneCount];
+    };
+
+    template <typename Function> inline Lanes each (const Lanes a, const Lanes b, const Function& function)
+    {
+        Lanes result { };
+
+        for (size_t i = 0; i < laneCount; ++i)
+        {
+            result.v[i] = function (a.v[i], b.v[i]);
+        }
+
+        return result;
+    }
+
+    inline Lanes load (const float* data)                       { Lanes result { }; std::memcpy (result.v, data, sizeof (result.v)); return result; }
+    inline void store (float* data, const Lanes value)          { std::memcpy (data, value.v, sizeof (value.v)); }
+    inline Lanes splat (const float value)                      { return Lanes { { value, value, value, value } }; }
+    inline Lanes add (const Lanes a, const Lanes b)             { return each (a, b, [] (const float x, const float y) { return x + y; }); }
+    inline Lanes sub (const Lanes a, const Lanes b)             { return each (a, b, [] (const float x, const float y) { return x - y; }); }
+    inline Lanes mul (const Lanes a, const Lanes b)             { return each (a, b, [] (const float x, const float y) { return x * y; }); }
+    inline Lanes div (const Lanes a, const Lanes b)             { return each (a, b, [] (const float x, const float y) { return x / y; }); }
+    inline Lanes sqrt (const Lanes a)                           { return each (a, a, [] (const float x, const float) { return std::sqrt (x); }); }
+
+    #endif
+
+    /// <summary> Calculates a * b + c. </summary>
+    inline Lanes mad (const Lanes a, const Lanes b, const Lanes c)  { return add (mul (a, b), c); }
+
+    #pragma endregion
+
+    #pragma region Batches
+
+    /// <summary> The channels of a key, in the order they're blended. </summary>
+    enum Channel : size_t
+    {
+        TranslationX, TranslationY, TranslationZ, RotationX, RotationY, RotationZ, RotationW, Scale, ChannelCount
+    };
+
+
+    /// <summary> The gathered inputs of a batch of instances, laid out so each value of every lane sits together. </summary>
+    struct BatchInput final
+    {
+        float   from[ChannelCount][laneCount];  //!< The earlier key of each lane.
+        float   to[ChannelCount][laneCount];    //!< The later key of each lane, on the same side of the quaternion double cover as the earlier one.
+        float   weight[laneCount];              //!< How far between the keys each lane is.
+        float   base[12][laneCount];            //!< The column-major 4x3 base transform of each lane.
+    };
+
+
+    /// <summary> Blends the keys of every lane and places them relative to the base transforms, giving column-major 4x3 matrices. </summary>
+    void evaluateBatch (const BatchInput& input, float (&output)[12][laneCount])
+    {
+        // Blend every channel, rotations are normalised afterwards which is plenty accurate for keys sampled this closely.
+        const auto  weight = load (input.weight);
+        Lanes       key[ChannelCount];
+
+        for (size_t channel = 0; channel < ChannelCount; ++channel)
+        {
+            const auto from = load (input.from[channel]);
+            key[channel]    = mad (sub (load (input.to[channel]), from), weight, from);
+        }
+
+        const auto length   = sqrt (mad (key[RotationX], key[RotationX], mad (key[RotationY], key[RotationY], mad (key[RotationZ], key[RotationZ], mul (key[RotationW], key[RotationW])))));
+        const auto inverse  = div (splat (1.f), length);
+        const auto x        = mul (key[RotationX], inverse);
+        const auto y        = mul (key[RotationY], inverse);
+        const auto z        = mul (key[RotationZ], inverse);
+        const auto w        = mul (key[RotationW], inverse);
+
+        // Build the scaled rotation matrix of the key.
+        const auto one      = splat (1.f);
+        const auto two      = splat (2.f);
+        const auto scale    = key[Scale];
+
+        const auto xx = mul (x, x), yy = mul (y, y), zz = mul (z, z);
+        const auto xy = mul (x, y), xz = mul (x, z), yz = mul (y, z);
+        const auto wx = mul (w, x), wy = mul (w, y), wz = mul (w, z);
+
+        Lanes local[3][3];
+        local[0][0] = mul (scale, sub (one, mul (two, add (yy, zz))));
+        local[0][1] = mul (scale, mul (two, add (xy, wz)));
+        local[0][2] = mul (scale, mul (two, sub (xz, wy)));
+        local[1][0] = mul (scale, mul (two, sub (xy, wz)));
+        local[1][1] = mul (scale, sub (one, mul (two, add (xx, zz))));
+        local[1][2] = mul (scale, mul (two, add (yz, wx)));
+        local[2][0] = mul (scale, mul (two, add (xz, wy)));
+        local[2][1] = mul (scale, mul (two, sub (yz, wx)));
+        local[2][2] = mul (scale, sub (one, mul (two, add (xx, yy))));
+
+        Lanes base[4][3];
+
+        for (size_t column = 0; column < 4; ++column)
+        {
+            for (size_t row = 0; row < 3; ++row)
+            {
+                base[column][row] = load (input.base[column * 3 + row]);
+            }
+        }
+
+        // Multiply the base by the key, the translation of the key moves along the axes of the base.
+        for (size_t row = 0; row < 3; ++row)
+        {
+            for (size_t column = 0; column < 3; ++column)
+            {
+                const auto value = mad (base[0][row], local[column][0], mad (base[1][row], local[column][1], mul (base[2][row], local[column][2])));
+                store (output[column * 3 + row], value);
+            }
+
+            const auto translation = mad (base[0][row], key[TranslationX], mad (base[1][row], key[TranslationY], mad (base[2][row], key[TranslationZ], base[3][row])));
+            store (output[9 + row], translation);
+        }
+    }
+
+    #pragma endregion
+}
+
+
+
+#pragma region Instances
+
+size_t Animator::addClip (std::shared_ptr<const AnimationClip> clip)
+{
+    m_clips.push_back (std::move (clip));
+    return m_clips.size() - 1;
+}
+
+
+bool Animator::addInstance (const std::uint32_t mesh, const std::int32_t material, const float* transform, const size_t clip, const std::uint32_t track,
+                            const float phase, const float speed)
+{
+    if (clip >= m_clips.size() || !m_clips[clip] || track >= m_clips[clip]->getTrackCount())
+    {
+        return false;
+    }
+
+    auto&       instances   = m_meshes[mesh];
+    const auto  index       = instances.materials.size();
+
+    instances.materials.push_back (material);
+    instances.clips.push_back (static_cast<std::uint32_t> (clip));
+    instances.tracks.push_back (track);
+    instances.phases.push_back (phase);
+    instances.speeds.push_back (speed);
+
+    // Until the first update the instance sits at its base transform.
+    instances.transforms.insert (instances.transforms.end(), transform, transform + 16);
+    instances.dirty.resize ((index + 64) / 64, 0);
+
+    for (size_t column = 0; column < 4; ++column)
+    {
+        instances.bases.insert (instances.bases.end(), transform + column * 4, transform + column * 4 + 3);
+    }
+
+    ++instances.version;
+
+    return true;
+}
+
+
+void Animator::clear()
+{
+    m_clips.clear();
+    m_meshes.clear();
+    m_time = 0.0;
+}
+
+
+size_t Animator::getInstanceCount() const
+{
+    size_t count { 0 };
+
+    for (const auto& pair : m_meshes)
+    {
+        count += pair.second.materials.size();
+    }
+
+    return count;
+}
+
+#pragma endregion
+
+
+#pragma region Animation
+
+void Animator::update (const double seconds, ThreadPool* pool)
+{
+    /// Each job evaluates a contiguous run of the instances of one mesh. The calling thread takes the first job rather than sitting idle,
+    /// and if it's a worker itself everything runs inline since waiting on the pool from inside it could deadlock.
+    const auto start = Clock::now();
+    m_time += seconds;
+
+    struct Job final
+    {
+        MeshInstances*  instances;
+        size_t          begin;
+        size_t          end;
+    };
+
+    std::vector<Job> jobs { };
+
+    for (auto& pair : m_meshes)
+    {
+        auto&       instances   = pair.second;
+        const auto  count       = instances.materials.size();
+
+        for (size_t begin = 0; begin < count; begin += jobSize)
+        {
+            jobs.push_back ({ &instances, begin, std::min (count, begin + jobSize) });
+        }
+    }
+
+    if (jobs.empty())
+    {
+        return;
+    }
+
+    std::vector<std::future<size_t>> futures { };
+
+    if (pool && !pool->isWorkerThread())
+    {
+        for (size_t i = 1; i < jobs.size(); ++i)
+        {
+            const auto job = jobs[i];
+            futures.push_back (pool->submit ([this, job] () { return evaluate (*job.instances, job.begin, job.end); }));
+        }
+    }
+
+    else
+    {
+        for (size_t i = 1; i < jobs.size(); ++i)
+        {
+            std::promise<size_t> result { };
+            result.set_value (evaluate (*jobs[i].instances, jobs[i].begin, jobs[i].end));
+            futures.push_back (result.get_future());
+        }
+    }
+
+    auto changed = evaluate (*jobs.front().instances, jobs.front().begin, jobs.front().end);
+
+    for (auto& future : futures)
+    {
+        changed += future.get();
+    }
+
+    // Meshes which didn't move keep their version so MyView doesn't upload them again.
+    size_t instanceCount { 0 };
+
+    for (auto& pair : m_meshes)
+    {
+        auto& instances = pair.second;
+        instanceCount   += instances.materials.size();
+
+        if (std::any_of (instances.dirty.begin(), instances.dirty.end(), [] (const std::uint64_t word) { return word != 0; }))
+        {
+            instances.version.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (Clock::now() - start).count();
+
+    ++m_statistics.updateCount;
+    m_statistics.instanceCount  += instanceCount;
+    m_statistics.changedCount   += changed;
+    m_statistics.totalTime      += milliseconds;
+    m_statistics.maxTime        = std::max (m_statistics.maxTime, milliseconds);
+}
+
+
+size_t Animator::evaluate (MeshInstances& instances, const size_t begin, const size_t end) const
+{
+    /// The keys of each lane are gathered with scalar code since every instance may be at a different point of a different clip, after
+    /// that the whole batch is blended and transformed together. The results are compared with the previous matrices as they're
+    /// scattered back so the dirty bits only mark instances which really moved.
+    BatchInput  input   { };
+    float       output[12][laneCount];
+    size_t      changed { 0 };
+
+    for (size_t batch = begin; batch < end; batch += laneCount)
+    {
+        const auto lanes = std::min (laneCount, end - batch);
+
+        for (size_t lane = 0; lane < laneCount; ++lane)
+        {
+            // Spare lanes repeat the last instance, they're never written back.
+            const auto  index       = batch + std::min (lane, lanes - 1);
+            const auto& clip        = *m_clips[instances.clips[index]];
+            const auto  track       = instances.tracks[index];
+            const auto  keyCount    = clip.getKeyCount();
+
+            // Find the pair of keys either side of the current time, the last key loops back to the first.
+            const auto  local       = m_time * instances.speeds[index] + instances.phases[index];
+            auto        position    = std::fmod (local * clip.getSampleRate(), static_cast<double> (keyCount));
+            position                = position < 0.0 ? position + keyCount : position;
+
+            const auto  first       = std::min (static_cast<std::uint32_t> (position), keyCount - 1);
+            const auto  second      = first + 1 < keyCount ? first + 1 : 0;
+            input.weight[lane]      = static_cast<float> (position - first);
+
+            const auto  translations    = clip.translations (track);
+            const auto  rotations       = clip.rotations (track);
+            const auto  scales          = clip.scales (track);
+
+            float       dot { 0.f };
+
+            for (size_t i = 0; i < 3; ++i)
+            {
+                input.from[TranslationX + i][lane]  = translations[first * 3 + i];
+                input.to[TranslationX + i][lane]    = translations[second * 3 + i];
+            }
+
+            for (size_t i = 0; i < 4; ++i)
+            {
+                input.from[RotationX + i][lane]     = AnimationClip::dequantise (rotations[first * 4 + i]);
+                input.to[RotationX + i][lane]       = AnimationClip::dequantise (rotations[second * 4 + i]);
+                dot                                 += input.from[RotationX + i][lane] * input.to[RotationX + i][lane];
+            }
+
+            // Take the shortest path between the rotations.
+            if (dot < 0.f)
+            {
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    input.to[RotationX + i][lane] = -input.to[RotationX + i][lane];
+                }
+            }
+
+            input.from[Scale][lane] = scales[first];
+            input.to[Scale][lane]   = scales[second];
+
+            for (size_t i = 0; i < 12; ++i)
+            {
+                input.base[i][lane] = instances.bases[index * 12 + i];
+            }
+        }
+
+        evaluateBatch (input, output);
+
+        // Scatter the results back into full 4x4 matrices.
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            const auto  index   = batch + lane;
+            const auto  bit     = std::uint64_t { 1 } << (index % 64);
+            auto&       word    = instances.dirty[index / 64];
+
+            float matrix[16] =
+            {
+                output[0][lane], output[1][lane],  output[2][lane],  0.f,
+                output[3][lane], output[4][lane],  output[5][lane],  0.f,
+                output[6][lane], output[7][lane],  output[8][lane],  0.f,
+                output[9][lane], output[10][lane], output[11][lane], 1.f
+            };
+
+            const auto destination = instances.transforms.data() + index * 16;
+
+            if (std::memcmp (destination, matrix, sizeof (matrix)) != 0)
+            {
+                std::memcpy (destination, matrix, sizeof (matrix));
+                word |= bit;
+                ++changed;
+            }
+
+            else
+            {
+                word &= ~bit;
+            }
+        }
+    }
+
+    return changed;
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+void Animator::printStatistics (std::ostream& stream) const
+{
+    stream  << "Animation: " << getInstanceCount() << " instances, " << m_statistics.updateCount << " updates, "
+            << m_statistics.instancesPerMillisecond() << " instances/ms, " << m_statistics.changedCount << " changed, update "
+            << m_statistics.averageTime() << "ms average, " << m_statistics.maxTime << "ms max." << std::endl;
+}
+
+#pragma endregion
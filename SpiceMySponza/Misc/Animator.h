@@ -0,0 +1,146 @@
+#pragma once
+
+#if !defined    _ANIMATOR_
+#define         _ANIMATOR_
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+
+// Forward declarations.
+class AnimationClip;
+class ThreadPool;
+
+
+/// <summary>
+/// Plays keyframed clips on instances of the scene. Each frame every animated instance samples its track, blends the two nearest keys
+/// and places the result relative to its base transform. Instances are evaluated four at a time with SIMD and the batches are split
+/// into jobs for the thread pool. Like the simulation channel, the results are kept in per-mesh arrays which can be handed to MyView
+/// as instance streams, along with a dirty bit per instance so only the matrices which actually moved are uploaded.
+/// </summary>
+class Animator final
+{
+    public:
+
+        #pragma region Animator types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> The animated instances of a mesh. The arrays are ready to be streamed, the rest is the state of the animation. </summary>
+        struct MeshInstances final
+        {
+            std::vector<float>              transforms  { };    //!< Sixteen floats per instance.
+            std::vector<std::int32_t>       materials   { };    //!< A material ID per instance.
+            std::vector<std::uint64_t>      dirty       { };    //!< A bit per instance, set if its matrix changed in the latest version.
+            std::atomic<std::uint64_t>      version     { 0 };  //!< Incremented whenever any matrix changes.
+
+            std::vector<float>              bases       { };    //!< Twelve floats per instance, the column-major 4x3 transform animations are relative to.
+            std::vector<std::uint32_t>      clips       { };    //!< The index of the clip each instance plays.
+            std::vector<std::uint32_t>      tracks      { };    //!< The track of the clip each instance follows.
+            std::vector<float>              phases      { };    //!< How far into the clip each instance starts in seconds.
+            std::vector<float>              speeds      { };    //!< How quickly each instance plays its clip.
+        };
+
+        /// <summary>
+        /// How quickly instances are being animated since the statistics were last reset. Times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  updateCount     { 0 };      //!< How many times every instance has been evaluated.
+            size_t  instanceCount   { 0 };      //!< How many instances have been evaluated across every update.
+            size_t  changedCount    { 0 };      //!< How many of those instances ended up with a different matrix.
+            double  totalTime       { 0.0 };    //!< The sum of the time each update took.
+            double  maxTime         { 0.0 };    //!< The longest an update took.
+
+            double averageTime() const              { return updateCount > 0 ? totalTime / updateCount : 0.0; }
+            double instancesPerMillisecond() const  { return totalTime > 0.0 ? instanceCount / totalTime : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        Animator()                                  = default;
+        ~Animator()                                 = default;
+
+        Animator (Animator&& move)                  = delete;
+        Animator& operator= (Animator&& move)       = delete;
+        Animator (const Animator& copy)             = delete;
+        Animator& operator= (const Animator& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Instances
+
+        /// <summary> Adds a clip which instances can play. </summary>
+        /// <returns> The index of the clip. </returns>
+        size_t addClip (std::shared_ptr<const AnimationClip> clip);
+
+        /// <summary> Animates an instance of a mesh. Adding instances may move the arrays so streams must be set again afterwards. </summary>
+        /// <returns> False if the clip or track doesn't exist. </returns>
+        /// <param name="transform"> The column-major 4x4 base transform of the instance. Projections are lost, only the affine part is kept. </param>
+        /// <param name="phase"> How far into the clip the instance starts in seconds. </param>
+        /// <param name="speed"> How quickly the instance plays the clip, one being the rate it was authored at. </param>
+        bool addInstance (const std::uint32_t mesh, const std::int32_t material, const float* transform, const size_t clip, const std::uint32_t track,
+                          const float phase, const float speed);
+
+        /// <summary> Removes every instance and clip, rewinding the animation. </summary>
+        void clear();
+
+        /// <summary> Gets the animated instances of every mesh, keyed by mesh ID. </summary>
+        const std::unordered_map<std::uint32_t, MeshInstances>& getMeshes() const   { return m_meshes; }
+
+        /// <summary> Gets the total number of animated instances. </summary>
+        size_t getInstanceCount() const;
+
+        #pragma endregion
+
+        #pragma region Animation
+
+        /// <summary> Advances the animation then evaluates every instance, waiting for the jobs to finish. Call between frames. </summary>
+        /// <param name="seconds"> How much time has passed since the last update. </param>
+        /// <param name="pool"> The workers to split the instances between, without one everything is evaluated on the calling thread. </param>
+        void update (const double seconds, ThreadPool* pool);
+
+        /// <summary> Gets how long the animation has been playing in seconds. </summary>
+        double getTime() const                      { return m_time; }
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const            { return m_statistics; }
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics()                      { m_statistics = { }; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> Evaluates the instances [begin, end) of a mesh, begin must be a multiple of 64 so jobs never share a dirty word. </summary>
+        /// <returns> How many of the instances changed. </returns>
+        size_t evaluate (MeshInstances& instances, const size_t begin, const size_t end) const;
+
+        std::vector<std::shared_ptr<const AnimationClip>>   m_clips         { };    //!< Every clip instances can play.
+        std::unordered_map<std::uint32_t, MeshInstances>    m_meshes        { };    //!< The animated instances of each mesh.
+        double                                              m_time          { 0.0 };    //!< How long the animation has been playing in seconds.
+        Statistics                                          m_statistics    { };    //!< How quickly instances are being animated.
+
+        #pragma endregion
+};
+
+#endif // _ANIMATOR_
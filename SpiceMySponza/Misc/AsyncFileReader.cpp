@@ -0,0 +1,691 @@
+#include "AsyncFileReader.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+
+
+// Personal headers.
+#include <Misc/ThreadPool.h>
+
+
+
+// Platform headers.
+#if defined (__linux__)
+    #include <sys/syscall.h>
+
+    // io_uring is driven through the raw system calls so liburing isn't required.
+    #if defined (__NR_io_uring_setup)
+        #define ASYNC_FILE_READER_IO_URING
+
+        #include <cerrno>
+        #include <cstdint>
+        #include <fcntl.h>
+        #include <linux/io_uring.h>
+        #include <sys/eventfd.h>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <sys/uio.h>
+        #include <unistd.h>
+    #endif
+#endif
+
+
+
+#pragma region Implementation types
+
+/// <summary>
+/// A file waiting to be read or in the process of being read.
+/// </summary>
+struct AsyncFileReader::Request final
+{
+    std::string         file        { };        //!< The location of the file.
+    Completion          completion  { };        //!< Called once the file has been read.
+    std::vector<char>   data        { };        //!< Receives the contents of the file.
+
+    #if defined (ASYNC_FILE_READER_IO_URING)
+
+        size_t          offset      { 0 };      //!< How many bytes have been read so far.
+        int             descriptor  { -1 };     //!< The open file descriptor.
+        iovec           vector      { };        //!< Describes the remaining part of the data for the kernel.
+
+    #endif
+};
+
+
+#if defined (ASYNC_FILE_READER_IO_URING)
+
+    /// <summary>
+    /// The shared rings of an io_uring instance along with an eventfd used to wake the thread waiting on it.
+    /// </summary>
+    struct AsyncFileReader::Ring final
+    {
+        int             ringDescriptor  { -1 };         //!< The io_uring file descriptor.
+        int             wakeDescriptor  { -1 };         //!< An eventfd which is always being read by the ring.
+
+        unsigned*       sqHead          { nullptr };    //!< The head of the submission queue, advanced by the kernel.
+        unsigned*       sqTail          { nullptr };    //!< The tail of the submission queue, advanced by us.
+        unsigned*       sqMask          { nullptr };    //!< Wraps submission indices.
+        unsigned*       sqArray         { nullptr };    //!< Maps submission queue slots to entries.
+        unsigned        sqEntries       { 0 };          //!< The capacity of the submission queue.
+        io_uring_sqe*   sqes            { nullptr };    //!< The submission queue entries.
+
+        unsigned*       cqHead          { nullptr };    //!< The head of the completion queue, advanced by us.
+        unsigned*       cqTail          { nullptr };    //!< The tail of the completion queue, advanced by the kernel.
+        unsigned*       cqMask          { nullptr };    //!< Wraps completion indices.
+        io_uring_cqe*   cqes            { nullptr };    //!< The completion queue entries.
+
+        void*           sqMemory        { nullptr };    //!< The mapped submission ring.
+        size_t          sqSize          { 0 };          //!< The size of the mapped submission ring.
+        void*           cqMemory        { nullptr };    //!< The mapped completion ring, may be the submission ring.
+        size_t          cqSize          { 0 };          //!< The size of the mapped completion ring.
+        size_t          sqesSize        { 0 };          //!< The size of the mapped submission entries.
+
+        Ring()                                  = default;
+        Ring (Ring&& move)                      = delete;
+        Ring& operator= (Ring&& move)           = delete;
+        Ring (const Ring& copy)                 = delete;
+        Ring& operator= (const Ring& copy)      = delete;
+
+        ~Ring()
+        {
+            if (sqes)
+            {
+                munmap (sqes, sqesSize);
+            }
+
+            if (cqMemory && cqMemory != sqMemory)
+            {
+                munmap (cqMemory, cqSize);
+            }
+
+            if (sqMemory)
+            {
+                munmap (sqMemory, sqSize);
+            }
+
+            if (ringDescriptor >= 0)
+            {
+                close (ringDescriptor);
+            }
+
+            if (wakeDescriptor >= 0)
+            {
+                close (wakeDescriptor);
+            }
+        }
+
+
+        /// <summary> Creates and maps an io_uring instance. </summary>
+        /// <returns> The ring or nullptr if the kernel doesn't support io_uring or it has been disabled. </returns>
+        static std::unique_ptr<Ring> create (const unsigned entries)
+        {
+            std::unique_ptr<Ring>   ring        { new Ring() };
+            io_uring_params         parameters  { };
+
+            ring->ringDescriptor = static_cast<int> (syscall (__NR_io_uring_setup, entries, &parameters));
+            ring->wakeDescriptor = eventfd (0, EFD_CLOEXEC);
+
+            if (ring->ringDescriptor < 0 || ring->wakeDescriptor < 0)
+            {
+                return nullptr;
+            }
+
+            ring->sqSize    = parameters.sq_off.array + parameters.sq_entries * sizeof (unsigned);
+            ring->cqSize    = parameters.cq_off.cqes + parameters.cq_entries * sizeof (io_uring_cqe);
+            ring->sqesSize  = parameters.sq_entries * sizeof (io_uring_sqe);
+
+            // Newer kernels let both rings share a single mapping.
+            const auto single = (parameters.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+            if (single)
+            {
+                ring->sqSize = ring->cqSize = std::max (ring->sqSize, ring->cqSize);
+            }
+
+            const auto map = [&] (const size_t size, const off_t offset) -> void*
+            {
+                const auto memory = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ringDescriptor, offset);
+                return memory != MAP_FAILED ? memory : nullptr;
+            };
+
+            ring->sqMemory  = map (ring->sqSize, IORING_OFF_SQ_RING);
+            ring->cqMemory  = single ? ring->sqMemory : map (ring->cqSize, IORING_OFF_CQ_RING);
+            ring->sqes      = static_cast<io_uring_sqe*> (map (ring->sqesSize, IORING_OFF_SQES));
+
+            if (!ring->sqMemory || !ring->cqMemory || !ring->sqes)
+            {
+                return nullptr;
+            }
+
+            const auto sq       = static_cast<char*> (ring->sqMemory);
+            const auto cq       = static_cast<char*> (ring->cqMemory);
+
+            ring->sqHead        = reinterpret_cast<unsigned*> (sq + parameters.sq_off.head);
+            ring->sqTail        = reinterpret_cast<unsigned*> (sq + parameters.sq_off.tail);
+            ring->sqMask        = reinterpret_cast<unsigned*> (sq + parameters.sq_off.ring_mask);
+            ring->sqArray       = reinterpret_cast<unsigned*> (sq + parameters.sq_off.array);
+            ring->sqEntries     = parameters.sq_entries;
+
+            ring->cqHead        = reinterpret_cast<unsigned*> (cq + parameters.cq_off.head);
+            ring->cqTail        = reinterpret_cast<unsigned*> (cq + parameters.cq_off.tail);
+            ring->cqMask        = reinterpret_cast<unsigned*> (cq + parameters.cq_off.ring_mask);
+            ring->cqes          = reinterpret_cast<io_uring_cqe*> (cq + parameters.cq_off.cqes);
+
+            return ring;
+        }
+
+
+        /// <summary> Queues a vectored read, it's only seen by the kernel on the next call to enter(). </summary>
+        /// <returns> Whether there was room in the submission queue. </returns>
+        bool pushRead (const int descriptor, const iovec* const vector, const size_t offset, const std::uint64_t userData)
+        {
+            // Only this thread writes the tail, the kernel advances the head as it consumes entries.
+            const auto tail = *sqTail;
+
+            if (tail - __atomic_load_n (sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+            {
+                return false;
+            }
+
+            const auto index    = tail & *sqMask;
+            auto&      entry    = sqes[index];
+
+            std::memset (&entry, 0, sizeof (entry));
+            entry.opcode        = IORING_OP_READV;
+            entry.fd            = descriptor;
+            entry.addr          = reinterpret_cast<std::uint64_t> (vector);
+            entry.len           = 1;
+            entry.off           = offset;
+            entry.user_data     = userData;
+
+            sqArray[index]      = index;
+            __atomic_store_n (sqTail, tail + 1, __ATOMIC_RELEASE);
+
+            return true;
+        }
+
+
+        /// <summary> Submits queued entries and waits for at least the given number of completions. </summary>
+        void enter (const unsigned toSubmit, const unsigned waitFor)
+        {
+            syscall (__NR_io_uring_enter, ringDescriptor, toSubmit, waitFor, IORING_ENTER_GETEVENTS, nullptr, 0);
+        }
+
+
+        /// <summary> Calls function (userData, result) for every available completion. </summary>
+        template <typename Function> void reap (const Function& function)
+        {
+            auto       head = *cqHead;
+            const auto tail = __atomic_load_n (cqTail, __ATOMIC_ACQUIRE);
+
+            while (head != tail)
+            {
+                const auto& entry = cqes[head & *cqMask];
+                function (entry.user_data, entry.res);
+                ++head;
+            }
+
+            __atomic_store_n (cqHead, head, __ATOMIC_RELEASE);
+        }
+    };
+
+#else
+
+    /// <summary> io_uring isn't available on this platform. </summary>
+    struct AsyncFileReader::Ring final { };
+
+#endif
+
+#pragma endregion
+
+
+#pragma region Constructors and destructor
+
+AsyncFileReader::AsyncFileReader (std::shared_ptr<ThreadPool> pool, const size_t queueDepth)
+    : m_pool (std::move (pool)), m_queueDepth (std::max<size_t> (queueDepth, 1))
+{
+    #if defined (ASYNC_FILE_READER_IO_URING)
+
+        // One extra entry is needed for the wake read which is always queued.
+        m_ring = Ring::create (static_cast<unsigned> (m_queueDepth + 1));
+
+        if (m_ring)
+        {
+            m_backend       = Backend::IoUring;
+            m_ringThread    = std::thread (&AsyncFileReader::runRing, this);
+        }
+
+    #endif
+}
+
+
+AsyncFileReader::~AsyncFileReader()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_stopping = true;
+    }
+
+    if (m_ringThread.joinable())
+    {
+        wakeRing();
+        m_ringThread.join();
+    }
+}
+
+#pragma endregion
+
+
+#pragma region Getters
+
+AsyncFileReader::Statistics AsyncFileReader::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    // Include the current busy period so the throughput is meaningful whilst reads are still happening.
+    auto statistics = m_statistics;
+
+    if (m_outstanding != 0)
+    {
+        statistics.busySeconds += std::chrono::duration<double> (Clock::now() - m_busySince).count();
+    }
+
+    return statistics;
+}
+
+#pragma endregion
+
+
+#pragma region Reading
+
+void AsyncFileReader::read (const std::string& file, Completion completion)
+{
+    read (std::vector<std::string> { file }, std::move (completion));
+}
+
+
+void AsyncFileReader::read (const std::vector<std::string>& files, Completion completion)
+{
+    if (files.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        if (m_outstanding == 0)
+        {
+            m_busySince = Clock::now();
+        }
+
+        for (const auto& file : files)
+        {
+            std::unique_ptr<Request> request { new Request() };
+            request->file       = file;
+            request->completion = completion;
+
+            m_queue.push_back (std::move (request));
+            ++m_outstanding;
+        }
+
+        if (m_backend == Backend::ThreadPool)
+        {
+            dispatchToPool();
+        }
+    }
+
+    // The whole batch is submitted to the kernel together.
+    if (m_backend == Backend::IoUring)
+    {
+        wakeRing();
+    }
+}
+
+
+std::future<std::vector<char>> AsyncFileReader::read (const std::string& file)
+{
+    auto promise    = std::make_shared<std::promise<std::vector<char>>>();
+    auto future     = promise->get_future();
+
+    read (file, [promise] (const std::string& file, std::vector<char>& data, const bool success)
+    {
+        if (success)
+        {
+            promise->set_value (std::move (data));
+        }
+
+        else
+        {
+            promise->set_exception (std::make_exception_ptr (std::runtime_error ("unable to read " + file)));
+        }
+    });
+
+    return future;
+}
+
+
+Task<std::vector<char>> AsyncFileReader::readTask (const std::string& file, CancellationToken token)
+{
+    auto task = Task<std::vector<char>>::pending (std::move (token));
+
+    read (file, [task] (const std::string& file, std::vector<char>& data, const bool success)
+    {
+        if (success)
+        {
+            task.setValue (std::move (data));
+        }
+
+        else
+        {
+            task.setError (std::make_exception_ptr (std::runtime_error ("unable to read " + file)));
+        }
+    });
+
+    return task;
+}
+
+
+void AsyncFileReader::wait()
+{
+    std::unique_lock<std::mutex> lock { m_mutex };
+    m_idle.wait (lock, [this] () { return m_outstanding == 0; });
+}
+
+
+void AsyncFileReader::printStatistics (std::ostream& stream) const
+{
+    const auto statistics = getStatistics();
+
+    stream  << "File reads (" << (m_backend == Backend::IoUring ? "io_uring" : "thread pool") << ", queue depth " << m_queueDepth << "): "
+            << statistics.fileCount << " files, " << statistics.failureCount << " failed, "
+            << statistics.byteCount / (1024.0 * 1024.0) << "MB in " << statistics.busySeconds * 1000.0 << "ms, "
+            << statistics.throughput() << "MB/s." << std::endl;
+}
+
+
+void AsyncFileReader::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    m_statistics    = Statistics { };
+    m_busySince     = Clock::now();
+}
+
+#pragma endregion
+
+
+#pragma region Implementation
+
+void AsyncFileReader::dispatchToPool()
+{
+    while (m_reading < m_queueDepth && !m_queue.empty())
+    {
+        // std::function must be copyable so the request is passed as a raw pointer and owned again inside the job.
+        const auto request = m_queue.front().release();
+        m_queue.pop_front();
+        ++m_reading;
+
+        m_pool->post ([this, request] ()
+        {
+            std::unique_ptr<Request> owned { request };
+
+            const auto success = readWholeFile (owned->file, owned->data);
+            releaseSlot (*owned, success);
+            finish (std::move (owned), success);
+        });
+    }
+}
+
+
+bool AsyncFileReader::readWholeFile (const std::string& file, std::vector<char>& data)
+{
+    std::ifstream stream { file, std::ios::binary | std::ios::ate };
+
+    if (!stream.is_open())
+    {
+        return false;
+    }
+
+    data.resize (static_cast<size_t> (stream.tellg()));
+    stream.seekg (0);
+
+    return data.empty() || static_cast<bool> (stream.read (data.data(), data.size()));
+}
+
+
+void AsyncFileReader::releaseSlot (const Request& request, const bool success)
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    --m_reading;
+
+    if (success)
+    {
+        ++m_statistics.fileCount;
+        m_statistics.byteCount += request.data.size();
+    }
+
+    else
+    {
+        ++m_statistics.failureCount;
+    }
+
+    if (m_backend == Backend::ThreadPool)
+    {
+        dispatchToPool();
+    }
+}
+
+
+void AsyncFileReader::finish (std::unique_ptr<Request> request, const bool success)
+{
+    try
+    {
+        if (request->completion)
+        {
+            request->completion (request->file, request->data, success);
+        }
+    }
+
+    catch (...)
+    {
+        // Completion handlers are responsible for reporting their own errors.
+    }
+
+    request.reset();
+
+    // Notify whilst locked, a waiting destructor may otherwise destroy the condition variable first.
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    if (--m_outstanding == 0)
+    {
+        m_statistics.busySeconds += std::chrono::duration<double> (Clock::now() - m_busySince).count();
+        m_idle.notify_all();
+    }
+}
+
+
+void AsyncFileReader::wakeRing()
+{
+    #if defined (ASYNC_FILE_READER_IO_URING)
+
+        const std::uint64_t one { 1 };
+        const auto          ignored = write (m_ring->wakeDescriptor, &one, sizeof (one));
+        (void) ignored;
+
+    #endif
+}
+
+
+void AsyncFileReader::runRing()
+{
+    #if defined (ASYNC_FILE_READER_IO_URING)
+
+        /// The ring thread owns the submission queue. A read of the eventfd is always queued so that waiting for completions also wakes
+        /// up when requests are queued or the reader is stopping. Completion handlers are posted to the thread pool so decoding never holds
+        /// up submission.
+        auto&                   ring            = *m_ring;
+        std::uint64_t           wakeValue       { 0 };
+        const iovec             wakeVector      { &wakeValue, sizeof (wakeValue) };
+        bool                    wakeQueued      { false };
+        std::vector<Request*>   continuing      { };
+
+        // Passes a request on once it has been read or failed.
+        const auto done = [this] (Request* const request, const bool success)
+        {
+            if (request->descriptor >= 0)
+            {
+                close (request->descriptor);
+                request->descriptor = -1;
+            }
+
+            releaseSlot (*request, success);
+            m_pool->post ([this, request, success] () { finish (std::unique_ptr<Request> (request), success); });
+        };
+
+        // Queues a read of the remaining part of a file.
+        const auto queueRead = [&ring] (Request* const request)
+        {
+            request->vector.iov_base    = request->data.data() + request->offset;
+            request->vector.iov_len     = request->data.size() - request->offset;
+
+            return ring.pushRead (request->descriptor, &request->vector, request->offset, reinterpret_cast<std::uint64_t> (request));
+        };
+
+        while (true)
+        {
+            unsigned toSubmit { 0 };
+
+            if (!wakeQueued && ring.pushRead (ring.wakeDescriptor, &wakeVector, 0, 0))
+            {
+                wakeQueued = true;
+                ++toSubmit;
+            }
+
+            // Partial reads carry on from where they stopped, anything which doesn't fit waits for the next pass.
+            std::vector<Request*> waiting { };
+
+            for (const auto request : continuing)
+            {
+                if (queueRead (request))
+                {
+                    ++toSubmit;
+                }
+
+                else
+                {
+                    waiting.push_back (request);
+                }
+            }
+
+            continuing.swap (waiting);
+
+            // Take as many new requests as the queue depth allows.
+            std::vector<std::unique_ptr<Request>> starting { };
+
+            {
+                std::lock_guard<std::mutex> lock { m_mutex };
+
+                if (m_stopping && m_reading == 0 && m_queue.empty())
+                {
+                    break;
+                }
+
+                while (m_reading < m_queueDepth && !m_queue.empty())
+                {
+                    starting.push_back (std::move (m_queue.front()));
+                    m_queue.pop_front();
+                    ++m_reading;
+                }
+            }
+
+            // Files which fail to open or are empty finish straight away, so more requests may be waiting for their slots.
+            bool finishedEarly { false };
+
+            for (auto& owned : starting)
+            {
+                const auto  request = owned.release();
+                struct stat status;
+
+                request->descriptor = open (request->file.c_str(), O_RDONLY | O_CLOEXEC);
+
+                if (request->descriptor < 0 || fstat (request->descriptor, &status) != 0)
+                {
+                    done (request, false);
+                    finishedEarly = true;
+                    continue;
+                }
+
+                request->data.resize (static_cast<size_t> (status.st_size));
+
+                if (request->data.empty())
+                {
+                    done (request, true);
+                    finishedEarly = true;
+                    continue;
+                }
+
+                if (queueRead (request))
+                {
+                    ++toSubmit;
+                }
+
+                else
+                {
+                    continuing.push_back (request);
+                }
+            }
+
+            ring.enter (toSubmit, finishedEarly ? 0 : 1);
+
+            ring.reap ([&] (const std::uint64_t userData, const int result)
+            {
+                if (userData == 0)
+                {
+                    wakeQueued = false;
+                    return;
+                }
+
+                const auto request = reinterpret_cast<Request*> (userData);
+
+                if (result == -EINTR || result == -EAGAIN)
+                {
+                    continuing.push_back (request);
+                }
+
+                else if (result < 0)
+                {
+                    done (request, false);
+                }
+
+                else
+                {
+                    request->offset += static_cast<size_t> (result);
+
+                    // Reads can come back short, a zero-length read means the file shrank whilst it was being read.
+                    if (result > 0 && request->offset < request->data.size())
+                    {
+                        continuing.push_back (request);
+                    }
+
+                    else
+                    {
+                        request->data.resize (request->offset);
+                        done (request, true);
+                    }
+                }
+            });
+        }
+
+    #endif
+}
+
+#pragma endregion
@@ -0,0 +1,167 @@
+#pragma once
+
+#if !defined    _ASYNC_FILE_READER_
+#define         _ASYNC_FILE_READER_
+
+
+// STL headers.
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Personal headers.
+#include <Misc/Task.h>
+
+
+// Forward declarations.
+class ThreadPool;
+
+
+/// <summary>
+/// Reads whole files without blocking the caller. On Linux the reads are batched through io_uring, elsewhere (or if io_uring isn't
+/// available) they're spread across a thread pool. At most the queue depth of reads are in flight at once and each completion handler
+/// runs on the thread pool as soon as its file arrives, so decoding overlaps the remaining reads.
+/// </summary>
+class AsyncFileReader final
+{
+    public:
+
+        #pragma region Types
+
+        /// <summary> The mechanism used to perform the reads. </summary>
+        enum class Backend : int
+        {
+            ThreadPool  = 0,
+            IoUring     = 1
+        };
+
+        /// <summary> Called once a file has been read. The data may be moved out of the vector. </summary>
+        using Completion = std::function<void (const std::string& file, std::vector<char>& data, const bool success)>;
+
+        /// <summary>
+        /// A summary of the reads performed since the statistics were last reset.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  fileCount       { 0 };      //!< How many files were read successfully.
+            size_t  failureCount    { 0 };      //!< How many files couldn't be read.
+            size_t  byteCount       { 0 };      //!< The total size of every file read.
+            double  busySeconds     { 0.0 };    //!< The time during which at least one read was outstanding.
+
+            /// <summary> Gets the read throughput in megabytes per second. </summary>
+            double throughput() const { return busySeconds > 0.0 ? byteCount / (busySeconds * 1024.0 * 1024.0) : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        /// <summary> Creates the reader, choosing io_uring when the platform supports it. </summary>
+        /// <param name="pool"> The thread pool used for completion handlers and, when io_uring isn't available, the reads themselves. </param>
+        /// <param name="queueDepth"> The maximum number of reads in flight at once. </param>
+        AsyncFileReader (std::shared_ptr<ThreadPool> pool, const size_t queueDepth = 32);
+
+        /// <summary> Waits for every outstanding read before destroying the reader. </summary>
+        ~AsyncFileReader();
+
+        AsyncFileReader (AsyncFileReader&& move)                    = delete;
+        AsyncFileReader& operator= (AsyncFileReader&& move)         = delete;
+        AsyncFileReader (const AsyncFileReader& copy)               = delete;
+        AsyncFileReader& operator= (const AsyncFileReader& copy)    = delete;
+
+        #pragma endregion
+
+        #pragma region Getters
+
+        Backend getBackend() const                              { return m_backend; }
+        size_t getQueueDepth() const                            { return m_queueDepth; }
+        const std::shared_ptr<ThreadPool>& getThreadPool() const { return m_pool; }
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const;
+
+        #pragma endregion
+
+        #pragma region Reading
+
+        /// <summary> Queues a file to be read, the completion handler runs on the thread pool once it has been. </summary>
+        void read (const std::string& file, Completion completion);
+
+        /// <summary> Queues several files at once so they can be submitted together, each completes independently. </summary>
+        void read (const std::vector<std::string>& files, Completion completion);
+
+        /// <summary> Queues a file to be read, the future provides the contents or throws if the file couldn't be read. </summary>
+        std::future<std::vector<char>> read (const std::string& file);
+
+        /// <summary> Queues a file to be read as the first stage of a task chain, the task fails if the file couldn't be read. </summary>
+        /// <param name="token"> Cancels every later stage, the read itself still happens if it has been queued. </param>
+        Task<std::vector<char>> readTask (const std::string& file, CancellationToken token = { });
+
+        /// <summary> Blocks until every queued read and its completion handler has finished. </summary>
+        void wait();
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics();
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Request;
+        struct Ring;
+
+        /// <summary> Hands queued requests to the thread pool until the queue depth is reached. The mutex must be held. </summary>
+        void dispatchToPool();
+
+        /// <summary> Reads a whole file with blocking I/O, used by the thread pool backend. </summary>
+        static bool readWholeFile (const std::string& file, std::vector<char>& data);
+
+        /// <summary> Frees the read slot of a request once its data has arrived, letting another read start. </summary>
+        void releaseSlot (const Request& request, const bool success);
+
+        /// <summary> Runs the completion handler of a request on the calling thread and marks it as finished. </summary>
+        void finish (std::unique_ptr<Request> request, const bool success);
+
+        /// <summary> The loop run by the io_uring thread, it submits queued requests and reaps their completions. </summary>
+        void runRing();
+
+        /// <summary> Wakes the io_uring thread so it notices new requests or that the reader is stopping. </summary>
+        void wakeRing();
+
+        std::shared_ptr<ThreadPool>             m_pool          { nullptr };                //!< Runs completion handlers and thread pool reads.
+        size_t                                  m_queueDepth    { 32 };                     //!< The maximum number of reads in flight.
+        Backend                                 m_backend       { Backend::ThreadPool };    //!< How reads are performed.
+
+        mutable std::mutex                      m_mutex         { };                        //!< Protects the queue, counters and statistics.
+        std::condition_variable                 m_idle          { };                        //!< Signalled when the last outstanding request finishes.
+        std::deque<std::unique_ptr<Request>>    m_queue         { };                        //!< Requests waiting for a read slot.
+        size_t                                  m_reading       { 0 };                      //!< How many reads are in flight.
+        size_t                                  m_outstanding   { 0 };                      //!< How many requests haven't finished their completion handler.
+        bool                                    m_stopping      { false };                  //!< Tells the io_uring thread to exit once everything has finished.
+
+        Statistics                              m_statistics    { };                        //!< The statistics gathered so far.
+        Clock::time_point                       m_busySince     { };                        //!< When the reader last went from idle to busy.
+
+        std::unique_ptr<Ring>                   m_ring          { nullptr };                //!< The io_uring instance, null when using the thread pool.
+        std::thread                             m_ringThread    { };                        //!< Submits and reaps io_uring reads.
+
+        #pragma endregion
+};
+
+#endif // _ASYNC_FILE_READER_
@@ -0,0 +1,134 @@
+#include "FileWatcher.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+// Platform headers.
+#if defined (_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+
+
+#pragma region Constructors
+
+FileWatcher::FileWatcher (FileWatcher&& move)
+{
+    *this = std::move (move);
+}
+
+
+FileWatcher& FileWatcher::operator= (FileWatcher&& move)
+{
+    // Avoid moving self to self.
+    if (this != &move)
+    {
+        m_files         = std::move (move.m_files);
+        m_times         = std::move (move.m_times);
+        m_checkInterval = move.m_checkInterval;
+        m_lastCheck     = move.m_lastCheck;
+    }
+
+    return *this;
+}
+
+#pragma endregion
+
+
+#pragma region Watching
+
+void FileWatcher::watch (const std::vector<std::string>& files)
+{
+    m_files = files;
+    m_times.resize (m_files.size());
+
+    for (size_t i = 0; i < m_files.size(); ++i)
+    {
+        m_times[i] = modificationTime (m_files[i]);
+    }
+
+    m_lastCheck = Clock::now();
+}
+
+
+void FileWatcher::clear()
+{
+    m_files.clear();
+    m_times.clear();
+}
+
+
+bool FileWatcher::poll (std::vector<std::string>& changed)
+{
+    // Don't hit the file system every frame.
+    const auto now = Clock::now();
+
+    if (m_files.empty() || now - m_lastCheck < m_checkInterval)
+    {
+        return false;
+    }
+
+    m_lastCheck = now;
+
+    bool anyChanged { false };
+
+    for (size_t i = 0; i < m_files.size(); ++i)
+    {
+        const auto time = modificationTime (m_files[i]);
+
+        if (time != m_times[i])
+        {
+            m_times[i] = time;
+            changed.push_back (m_files[i]);
+            anyChanged = true;
+        }
+    }
+
+    return anyChanged;
+}
+
+
+long long FileWatcher::modificationTime (const std::string& file)
+{
+    #if defined (_WIN32)
+
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+        if (!GetFileAttributesExA (file.c_str(), GetFileExInfoStandard, &attributes))
+        {
+            return -1;
+        }
+
+        return static_cast<long long> (attributes.ftLastWriteTime.dwHighDateTime) << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+
+    #else
+
+        struct stat status;
+
+        if (stat (file.c_str(), &status) != 0)
+        {
+            return -1;
+        }
+
+        #if defined (__linux__)
+
+            return static_cast<long long> (status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+
+        #else
+
+            return static_cast<long long> (status.st_mtime);
+
+        #endif
+
+    #endif
+}
+
+#pragma endregion
@@ -0,0 +1,74 @@
+#pragma once
+
+#if !defined    _FILE_WATCHER_
+#define         _FILE_WATCHER_
+
+
+// STL headers.
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+/// <summary>
+/// Polls the modification time of a set of files so that assets can be reloaded whilst the application is running. Polling is
+/// throttled to the check interval so it's cheap enough to call every frame.
+/// </summary>
+class FileWatcher final
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        FileWatcher()                                   = default;
+        FileWatcher (const FileWatcher& copy)           = default;
+        FileWatcher& operator= (const FileWatcher& copy) = default;
+        ~FileWatcher()                                  = default;
+
+        FileWatcher (FileWatcher&& move);
+        FileWatcher& operator= (FileWatcher&& move);
+
+        #pragma endregion
+
+        #pragma region Getters and setters
+
+        std::chrono::milliseconds getCheckInterval() const      { return m_checkInterval; }
+        void setCheckInterval (const std::chrono::milliseconds interval) { m_checkInterval = interval; }
+
+        #pragma endregion
+
+        #pragma region Watching
+
+        /// <summary> Replaces the watched files, their current modification times are taken as the baseline. </summary>
+        /// <param name="files"> The files to watch, missing files are watched for their creation. </param>
+        void watch (const std::vector<std::string>& files);
+
+        /// <summary> Stops watching every file. </summary>
+        void clear();
+
+        /// <summary> Checks whether any watched file has been modified, created or deleted since the last check. </summary>
+        /// <returns> Whether anything changed. The changed files are appended to the given vector. </returns>
+        /// <param name="changed"> Receives the location of each changed file. </param>
+        bool poll (std::vector<std::string>& changed);
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> Gets the modification time of a file. </summary>
+        /// <returns> A platform-specific timestamp, only useful for comparison, or -1 if the file doesn't exist. </returns>
+        static long long modificationTime (const std::string& file);
+
+        std::vector<std::string>    m_files         { };                                    //!< The location of each watched file.
+        std::vector<long long>      m_times         { };                                    //!< The last seen modification time of each file.
+        std::chrono::milliseconds   m_checkInterval { 250 };                                //!< The minimum time between two checks of the file system.
+        Clock::time_point           m_lastCheck     { };                                    //!< When the file system was last checked.
+
+        #pragma endregion
+};
+
+#endif // _FILE_WATCHER_
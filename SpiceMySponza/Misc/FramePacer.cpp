@@ -0,0 +1,271 @@
+#include "FramePacer.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+
+
+// Personal headers.
+#include <Utility/Maths.h>
+
+
+
+// The number of samples kept for the statistics, enough for a couple of seconds at common refresh rates.
+const size_t sampleCapacity = 240;
+
+
+
+#pragma region Constructors
+
+FramePacer::FramePacer()
+{
+    m_intervals.reserve (sampleCapacity);
+    m_fenceWaits.reserve (sampleCapacity);
+}
+
+
+FramePacer::FramePacer (FramePacer&& move)
+{
+    *this = std::move (move);
+}
+
+
+FramePacer& FramePacer::operator= (FramePacer&& move)
+{
+    // Avoid moving self to self.
+    if (this != &move)
+    {
+        m_framesInFlight    = move.m_framesInFlight;
+        m_targetRefreshRate = move.m_targetRefreshRate;
+        m_smoothingFactor   = move.m_smoothingFactor;
+        m_smoothedFrameTime = move.m_smoothedFrameTime;
+
+        m_hasPresented      = move.m_hasPresented;
+        m_lastPresent       = std::move (move.m_lastPresent);
+        m_nextDeadline      = std::move (move.m_nextDeadline);
+
+        m_intervals         = std::move (move.m_intervals);
+        m_nextInterval      = move.m_nextInterval;
+        m_fenceWaits        = std::move (move.m_fenceWaits);
+        m_nextFenceWait     = move.m_nextFenceWait;
+
+        // Reset primitives.
+        move.m_smoothedFrameTime    = 0.f;
+        move.m_hasPresented         = false;
+        move.m_nextInterval         = 0;
+        move.m_nextFenceWait        = 0;
+    }
+
+    return *this;
+}
+
+#pragma endregion
+
+
+#pragma region Getters and setters
+
+void FramePacer::setFramesInFlight (const unsigned int frames)
+{
+    m_framesInFlight = util::clamp (frames, 1U, maxFramesInFlight());
+}
+
+
+void FramePacer::setTargetRefreshRate (const float hertz)
+{
+    m_targetRefreshRate = util::max (hertz, 0.f);
+
+    // Start the deadlines again from the next present.
+    m_nextDeadline = Clock::now();
+}
+
+
+void FramePacer::setSmoothingFactor (const float factor)
+{
+    m_smoothingFactor = util::clamp (factor, 0.01f, 1.f);
+}
+
+#pragma endregion
+
+
+#pragma region Pacing
+
+void FramePacer::framePresented()
+{
+    /// The deadline is advanced by exactly one period each frame rather than being measured from "now", otherwise any oversleep would
+    /// accumulate and the average rate would drift below the target. If we fall more than a whole period behind we give up on catching
+    /// up, presenting a burst of frames to recover would be worse for pacing than simply dropping the missed deadline.
+    if (m_targetRefreshRate > 0.f)
+    {
+        waitForDeadline();
+    }
+
+    const auto now = Clock::now();
+
+    if (m_hasPresented)
+    {
+        const auto interval = std::chrono::duration<float, std::milli> (now - m_lastPresent).count();
+
+        // Record the sample in the ring.
+        if (m_intervals.size() < sampleCapacity)
+        {
+            m_intervals.push_back (interval);
+        }
+
+        else
+        {
+            m_intervals[m_nextInterval] = interval;
+        }
+
+        m_nextInterval = (m_nextInterval + 1) % sampleCapacity;
+
+        // Update the exponential moving average, seeding it with the first sample.
+        m_smoothedFrameTime = m_smoothedFrameTime == 0.f ? interval : m_smoothedFrameTime + m_smoothingFactor * (interval - m_smoothedFrameTime);
+    }
+
+    m_lastPresent   = now;
+    m_hasPresented  = true;
+}
+
+
+void FramePacer::recordFenceWait (const float milliseconds)
+{
+    if (m_fenceWaits.size() < sampleCapacity)
+    {
+        m_fenceWaits.push_back (milliseconds);
+    }
+
+    else
+    {
+        m_fenceWaits[m_nextFenceWait] = milliseconds;
+    }
+
+    m_nextFenceWait = (m_nextFenceWait + 1) % sampleCapacity;
+}
+
+
+FramePacer::Statistics FramePacer::getStatistics() const
+{
+    Statistics stats { };
+    stats.sampleCount       = m_intervals.size();
+    stats.smoothedFrameTime = m_smoothedFrameTime;
+
+    if (!m_fenceWaits.empty())
+    {
+        float total { 0.f };
+
+        for (const auto wait : m_fenceWaits)
+        {
+            total += wait;
+        }
+
+        stats.meanFenceWait = total / m_fenceWaits.size();
+    }
+
+    if (m_intervals.empty())
+    {
+        return stats;
+    }
+
+    // Calculate the mean and range first.
+    float total { 0.f };
+    stats.minInterval = m_intervals[0];
+    stats.maxInterval = m_intervals[0];
+
+    for (const auto interval : m_intervals)
+    {
+        total += interval;
+        stats.minInterval = util::min (stats.minInterval, interval);
+        stats.maxInterval = util::max (stats.maxInterval, interval);
+    }
+
+    stats.meanInterval = total / m_intervals.size();
+
+    // Now the deviation and the frame-to-frame delta. The ring must be walked in order for the delta to be meaningful.
+    float variance { 0.f }, deltas { 0.f };
+    const auto count    = m_intervals.size();
+    const auto oldest   = count < sampleCapacity ? 0 : m_nextInterval;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto current  = m_intervals[(oldest + i) % count];
+        const auto offset   = current - stats.meanInterval;
+        variance += offset * offset;
+
+        if (i > 0)
+        {
+            deltas += std::abs (current - m_intervals[(oldest + i - 1) % count]);
+        }
+    }
+
+    stats.jitter = std::sqrt (variance / count);
+
+    if (count > 1)
+    {
+        stats.meanAbsoluteDelta = deltas / (count - 1);
+    }
+
+    return stats;
+}
+
+
+void FramePacer::printStatistics (std::ostream& stream) const
+{
+    const auto stats = getStatistics();
+
+    stream  << "Frame pacing over " << stats.sampleCount << " presents (" << m_framesInFlight << " frames in flight";
+
+    if (m_targetRefreshRate > 0.f)
+    {
+        stream << ", target " << m_targetRefreshRate << "Hz";
+    }
+
+    stream  << "):" << std::endl
+            << "    interval    mean " << stats.meanInterval << "ms, min " << stats.minInterval << "ms, max " << stats.maxInterval << "ms" << std::endl
+            << "    jitter      deviation " << stats.jitter << "ms, mean delta " << stats.meanAbsoluteDelta << "ms" << std::endl
+            << "    smoothed    " << stats.smoothedFrameTime << "ms" << std::endl
+            << "    fence wait  " << stats.meanFenceWait << "ms" << std::endl;
+}
+
+
+void FramePacer::resetStatistics()
+{
+    m_intervals.clear();
+    m_fenceWaits.clear();
+    m_nextInterval  = 0;
+    m_nextFenceWait = 0;
+}
+
+
+void FramePacer::waitForDeadline()
+{
+    const auto period   = std::chrono::duration_cast<Clock::duration> (std::chrono::duration<float> (1.f / m_targetRefreshRate));
+    auto now            = Clock::now();
+
+    // Resynchronise if we've fallen behind by more than a period.
+    if (now > m_nextDeadline + period)
+    {
+        m_nextDeadline = now;
+    }
+
+    // Sleeping is coarse so leave the final couple of milliseconds to a spin.
+    const auto spinThreshold = std::chrono::milliseconds (2);
+
+    if (m_nextDeadline - now > spinThreshold)
+    {
+        std::this_thread::sleep_for (m_nextDeadline - now - spinThreshold);
+    }
+
+    while (Clock::now() < m_nextDeadline)
+    {
+        std::this_thread::yield();
+    }
+
+    m_nextDeadline += period;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#if !defined    _FRAME_PACER_
+#define         _FRAME_PACER_
+
+
+// STL headers.
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+
+/// <summary>
+/// Controls how frames are paced. MyView uses the frames in flight value to throttle itself with fences so the CPU can't queue frames
+/// far ahead of the GPU, the main loop calls framePresented() after every update so the pacer can hold frames to a target refresh
+/// rate, smooth the frame time and gather present-interval jitter statistics for profiling.
+/// </summary>
+class FramePacer final
+{
+    public:
+
+        #pragma region Statistics
+
+        /// <summary>
+        /// A summary of the recently recorded present intervals. All times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  sampleCount         { 0 };      //!< How many present intervals the statistics were calculated from.
+            float   meanInterval        { 0.f };    //!< The average time between two presents.
+            float   minInterval         { 0.f };    //!< The shortest time between two presents.
+            float   maxInterval         { 0.f };    //!< The longest time between two presents.
+            float   jitter              { 0.f };    //!< The standard deviation of the present interval.
+            float   meanAbsoluteDelta   { 0.f };    //!< The average difference between consecutive intervals, shows stutter better than the deviation.
+            float   smoothedFrameTime   { 0.f };    //!< The exponentially smoothed frame time.
+            float   meanFenceWait       { 0.f };    //!< The average time the CPU was blocked waiting for the GPU to retire a frame.
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        FramePacer();
+        FramePacer (const FramePacer& copy)             = default;
+        FramePacer& operator= (const FramePacer& copy)  = default;
+        ~FramePacer()                                   = default;
+
+        FramePacer (FramePacer&& move);
+        FramePacer& operator= (FramePacer&& move);
+
+        #pragma endregion
+
+        #pragma region Getters and setters
+
+        unsigned int getFramesInFlight() const  { return m_framesInFlight; }
+        float getTargetRefreshRate() const      { return m_targetRefreshRate; }
+        float getSmoothingFactor() const        { return m_smoothingFactor; }
+        float getSmoothedFrameTime() const      { return m_smoothedFrameTime; }
+
+        /// <summary> Sets how many frames the CPU may submit before it must wait for the GPU. </summary>
+        /// <param name="frames"> Clamped between 1 and maxFramesInFlight(). </param>
+        void setFramesInFlight (const unsigned int frames);
+
+        /// <summary> Sets the rate at which frames should be presented. </summary>
+        /// <param name="hertz"> The target refresh rate, zero or less disables the limit. </param>
+        void setTargetRefreshRate (const float hertz);
+
+        /// <summary> Sets the weight given to the newest frame time when smoothing. </summary>
+        /// <param name="factor"> Clamped between 0.01 and 1, 1 effectively disables smoothing. </param>
+        void setSmoothingFactor (const float factor);
+
+        /// <summary> The largest number of frames which may be in flight at once. </summary>
+        static unsigned int maxFramesInFlight() { return 4; }
+
+        #pragma endregion
+
+        #pragma region Pacing
+
+        /// <summary> Should be called once a frame has been presented. Waits for the target refresh deadline and records the interval. </summary>
+        void framePresented();
+
+        /// <summary> Records how long the CPU was blocked waiting on a frame fence. </summary>
+        /// <param name="milliseconds"> The duration of the wait. </param>
+        void recordFenceWait (const float milliseconds);
+
+        /// <summary> Calculates the statistics of the recorded present intervals. </summary>
+        Statistics getStatistics() const;
+
+        /// <summary> Writes the current statistics to the given stream in a human readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded sample. </summary>
+        void resetStatistics();
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        // Using declarations.
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        /// <summary> Sleeps until the next refresh deadline, spinning for the final part to avoid oversleeping. </summary>
+        void waitForDeadline();
+
+        unsigned int        m_framesInFlight    { 2 };      //!< How many frames may be queued before the CPU is throttled.
+        float               m_targetRefreshRate { 0.f };    //!< The desired number of presents per second, zero means unlimited.
+        float               m_smoothingFactor   { 0.1f };   //!< The weight of the newest sample in the exponential moving average.
+        float               m_smoothedFrameTime { 0.f };    //!< The smoothed frame time in milliseconds.
+
+        bool                m_hasPresented      { false };  //!< Whether a previous present exists to measure an interval from.
+        TimePoint           m_lastPresent       { };        //!< When the previous frame was presented.
+        TimePoint           m_nextDeadline      { };        //!< When the next frame should be presented if a target refresh rate is set.
+
+        std::vector<float>  m_intervals         { };        //!< A ring of the most recent present intervals in milliseconds.
+        size_t              m_nextInterval      { 0 };      //!< The position in the ring to write the next interval.
+        std::vector<float>  m_fenceWaits        { };        //!< A ring of the most recent fence waits in milliseconds.
+        size_t              m_nextFenceWait     { 0 };      //!< The position in the ring to write the next fence wait.
+
+        #pragma endregion
+};
+
+#endif // _FRAME_PACER_
\ No newline at end of file
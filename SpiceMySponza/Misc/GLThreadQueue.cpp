@@ -0,0 +1,55 @@
+#include "GLThreadQueue.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+#pragma region Work
+
+void GLThreadQueue::post (std::function<void()> work)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_work.push_back (std::move (work));
+    }
+
+    m_posted.notify_all();
+}
+
+
+size_t GLThreadQueue::execute()
+{
+    // Take the queue so work can post more work without deadlocking or running forever.
+    std::vector<std::function<void()>> work { };
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        work.swap (m_work);
+    }
+
+    for (auto& job : work)
+    {
+        job();
+    }
+
+    return work.size();
+}
+
+
+size_t GLThreadQueue::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    return m_work.size();
+}
+
+
+void GLThreadQueue::wait() const
+{
+    std::unique_lock<std::mutex> lock { m_mutex };
+    m_posted.wait (lock, [this] () { return !m_work.empty(); });
+}
+
+#pragma endregion
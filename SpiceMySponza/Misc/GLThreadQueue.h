@@ -0,0 +1,62 @@
+#pragma once
+
+#if !defined    _GL_THREAD_QUEUE_
+#define         _GL_THREAD_QUEUE_
+
+
+// STL headers.
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+
+/// <summary>
+/// Collects work which must run on the thread owning the OpenGL context, such as uploading loaded assets. Any thread may post work,
+/// the render thread runs it at the start of each frame. This makes the render thread a valid executor for Task continuations.
+/// </summary>
+class GLThreadQueue final
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        GLThreadQueue()                                         = default;
+        ~GLThreadQueue()                                        = default;
+
+        GLThreadQueue (GLThreadQueue&& move)                    = delete;
+        GLThreadQueue& operator= (GLThreadQueue&& move)         = delete;
+        GLThreadQueue (const GLThreadQueue& copy)               = delete;
+        GLThreadQueue& operator= (const GLThreadQueue& copy)    = delete;
+
+        #pragma endregion
+
+        #pragma region Work
+
+        /// <summary> Queues work to be run the next time the render thread executes the queue. </summary>
+        void post (std::function<void()> work);
+
+        /// <summary> Runs the work queued so far, work posted while executing waits until the next call. Call from the render thread. </summary>
+        /// <returns> How many pieces of work were run. </returns>
+        size_t execute();
+
+        /// <summary> Gets how much work is waiting to be run. </summary>
+        size_t getPendingCount() const;
+
+        /// <summary> Blocks until there's work waiting to be run, for when the render thread has nothing else to do. </summary>
+        void wait() const;
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        mutable std::mutex                  m_mutex     { };    //!< Protects the queue.
+        mutable std::condition_variable     m_posted    { };    //!< Signalled when work is posted.
+        std::vector<std::function<void()>>  m_work      { };    //!< Work waiting for the render thread.
+
+        #pragma endregion
+};
+
+#endif // _GL_THREAD_QUEUE_
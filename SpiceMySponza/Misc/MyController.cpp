@@ -1,11 +1,100 @@
 #include "MyController.h"
+#include <Import/ImportedScene.h>
+#include <Import/Importer.h>
+#include <Import/SceneDiff.h>
+#include <Import/SceneModelTables.h>
+#include <Misc/AnimationClip.h>
+#include <Misc/Animator.h>
+#include <Misc/AsyncFileReader.h>
+#include <Misc/FramePacer.h>
+#include <Misc/GLThreadQueue.h>
+#include <Misc/RenderServer.h>
+#include <Misc/SceneEditor.h>
+#include <Misc/SimulationChannel.h>
+#include <Misc/ThreadPool.h>
+#include <Misc/TransformHierarchy.h>
+#include <Misc/ViewSwitcher.h>
+#include <MyView/InstanceStream.h>
 #include <MyView/MyView.h>
+#include <MyView/Prefab.h>
+#include <MyView/ResourcePool.h>
 #include <SceneModel/SceneModel.hpp>
+#include <Utility/HeadlessContext.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <tygra/Window.hpp>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+// enough reads to keep a fast drive busy without queueing every texture
+static const size_t file_queue_depth = 32;
+
+// SceneModel reads sponza from the working directory every time a context
+// or geometry builder is constructed
+static const char sponza_file[] = "sponza.tcf";
+
+// hands per-mesh instance arrays to the view, which reads them in place
+template <typename Meshes> static void
+stream_instances(MyView& view, const Meshes& meshes)
+{
+    for (const auto& pair : meshes) {
+        const auto& instances = pair.second;
+        MyView::InstanceStream stream;
+        stream.transforms = instances.transforms.data();
+        stream.materials = instances.materials.data();
+        stream.count = instances.materials.size();
+        stream.version = &instances.version;
+        stream.dirty = instances.dirty.data();
+        view.setInstanceStream(pair.first, stream);
+    }
+}
+
+template <typename Meshes> static void
+remove_streams(MyView& view, const Meshes& meshes)
+{
+    for (const auto& pair : meshes) {
+        view.removeInstanceStream(pair.first);
+    }
+}
+
+// a gentle bob, sway and pulse, each track a little out of step with the
+// last so neighbouring instances don't move in unison
+static std::shared_ptr<const AnimationClip>
+make_default_clip()
+{
+    const std::uint32_t tracks = 8;
+    const std::uint32_t keys = 64;
+    const float rate = 16.f;
+    const float pi = 3.14159265f;
+
+    auto clip = std::make_shared<AnimationClip>();
+    clip->create(tracks, keys, rate);
+    for (std::uint32_t track = 0; track < tracks; ++track) {
+        for (std::uint32_t key = 0; key < keys; ++key) {
+            const float angle = 2.f * pi * key / keys + track * pi / tracks;
+            const float sway = 0.1f * std::sin(angle);
+            const float translation[3] = { 0.f, 5.f * std::sin(angle), 0.f };
+            const float rotation[4] = { 0.f, std::sin(sway), 0.f,
+                                        std::cos(sway) };
+            clip->setKey(track, key, translation, rotation,
+                         1.f + 0.05f * std::cos(angle));
+        }
+    }
+    return clip;
+}
 
 MyController::
-MyController() : camera_turn_mode_(false)
+MyController() : hierarchy_spinner_(TransformHierarchy::noParent),
+                 prefab_id_(0),
+                 prefab_grid_(false),
+                 edit_running_(false),
+                 camera_turn_mode_(false)
 {
 	camera_move_speed_[0] = 0;
 	camera_move_speed_[1] = 0;
@@ -14,19 +103,728 @@ MyController() : camera_turn_mode_(false)
 	camera_rotate_speed_[0] = 0;
 	camera_rotate_speed_[1] = 0;
 	scene_ = std::make_shared<SceneModel::Context>();
+	camera_scene_ = scene_;
 	view_ = std::make_shared<MyView>();
     view_->setScene(scene_);
+    pacer_ = std::make_shared<FramePacer>();
+    view_->setFramePacer(pacer_);
+    pool_ = std::make_shared<ThreadPool>();
+    reader_ = std::make_shared<AsyncFileReader>(pool_, file_queue_depth);
+    view_->setFileReader(reader_);
+    gl_queue_ = std::make_shared<GLThreadQueue>();
+    view_->setGLThreadQueue(gl_queue_);
 }
 
 MyController::
 ~MyController()
 {
+    if (editor_) {
+        stopEditStress();
+    }
+    // a reload may be waiting for the render thread, run it to let it
+    // cancel. a chain which finishes elsewhere posts an empty job so the
+    // wait always ends without polling
+    if (scene_reload_.isValid()) {
+        scene_reload_.getToken().cancel();
+        scene_reload_.whenDone(*gl_queue_, [] (const Task<void>&) {});
+        while (!scene_reload_.isReady()) {
+            gl_queue_->wait();
+            gl_queue_->execute();
+        }
+    }
+}
+
+std::shared_ptr<FramePacer> MyController::
+getFramePacer() const
+{
+    return pacer_;
+}
+
+bool MyController::
+importScene(const std::string& file_location)
+{
+    auto imported = std::make_shared<ImportedScene>();
+    if (!util::importScene(*imported, file_location)) {
+        return false;
+    }
+    view_->setImportedScene(imported);
+    if (second_view_) {
+        second_view_->setImportedScene(imported);
+    }
+    imported_file_ = file_location;
+    imported_ = imported;
+    watchScene(*imported_);
+    return true;
+}
+
+bool MyController::
+connectSimulation(const std::string& channel_name)
+{
+    // the renderer creates the block so the simulation can start at any time
+    auto simulation = std::make_shared<SimulationChannel>();
+    if (!simulation->create(channel_name)) {
+        return false;
+    }
+    view_->setSimulationChannel(simulation);
+    simulation_ = simulation;
+    return true;
+}
+
+bool MyController::
+startRenderServer(const std::string& server_name)
+{
+    // must happen before the view starts so it can make room for a batch
+    auto server = std::make_shared<RenderServer>();
+    if (!server->start(server_name)) {
+        return false;
+    }
+    view_->setRenderServer(server);
+    server_ = server;
+    return true;
+}
+
+void MyController::
+enableVirtualTexturing()
+{
+    // must happen before the view starts so the textures are paged in
+    view_->setVirtualTexturing(true);
+}
+
+void MyController::
+enableSimilarTextureMerging()
+{
+    // identical textures are always merged, similar ones are opt-in
+    view_->setSimilarTextureMerging(true);
+}
+
+void MyController::
+enableDepthPrepass()
+{
+    // the position stream is only built if asked for before the view starts
+    view_->setDepthPrepass(true);
+}
+
+void MyController::
+enableStripification()
+{
+    // meshes are only stripped as they're uploaded
+    view_->setStripification(true);
+}
+
+void MyController::
+enableTransformCache()
+{
+    // X toggles it at run time so each pass count can be compared
+    view_->setTransformCache(true);
+}
+
+void MyController::
+enableOcclusionQueries()
+{
+    // O toggles it at run time so frame times can be compared
+    view_->setOcclusionQueries(true);
+}
+
+void MyController::
+enableSecondView()
+{
+    // a second camera on the same scene which B switches to. both views
+    // draw from one copy of the assets, found in the pool by the file they
+    // came from, so switching and hot reloads don't upload anything twice.
+    // only the first view receives the render settings and streams
+    if (second_view_) {
+        return;
+    }
+    auto resources = std::make_shared<MyView::ResourcePool>();
+    second_scene_ = std::make_shared<SceneModel::Context>();
+    second_view_ = std::make_shared<MyView>();
+    second_view_->setScene(second_scene_);
+    second_view_->setFramePacer(pacer_);
+    second_view_->setFileReader(reader_);
+    second_view_->setGLThreadQueue(gl_queue_);
+    if (imported_) {
+        second_view_->setImportedScene(imported_);
+    }
+    view_->setResourcePool(resources);
+    second_view_->setResourcePool(resources);
+    switcher_ = std::make_shared<ViewSwitcher>(
+        std::vector<std::shared_ptr<MyView>>{ view_, second_view_ });
+}
+
+bool MyController::
+loadAnimation(const std::string& file_location)
+{
+    auto clip = std::make_shared<AnimationClip>();
+    if (!clip->load(file_location)) {
+        return false;
+    }
+    animation_clip_ = clip;
+    return true;
+}
+
+bool MyController::
+runHeadless(const std::atomic<bool>& running)
+{
+    util::HeadlessContext context;
+    if (!context.create()) {
+        std::cerr << "Unable to create a headless OpenGL context" << std::endl;
+        return false;
+    }
+
+    // drive the view the same way a window would, minus presenting
+    tygra::WindowViewDelegate& view = *view_;
+    view.windowViewWillStart(nullptr);
+    view.windowViewDidReset(nullptr, 1, 1);
+
+    while (running) {
+        windowControlViewWillRender(nullptr);
+        view.windowViewRender(nullptr);
+
+        // nothing to render so don't spin
+        if (!server_ || !server_->hasRequests()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    view.windowViewDidStop(nullptr);
+    return true;
+}
+
+void MyController::
+watchScene(const ImportedScene& scene)
+{
+    // watch the textures too so they can be edited in place
+    auto files = scene.sources;
+    files.insert(files.end(), scene.textures.begin(), scene.textures.end());
+    scene_watcher_.watch(files);
+}
+
+void MyController::
+pollSceneReload()
+{
+    std::vector<std::string> changed;
+    if (imported_ == nullptr || !scene_watcher_.poll(changed)) {
+        return;
+    }
+
+    // a newer change supersedes a reload in flight, its files are kept
+    // so the next diff still covers them
+    if (scene_reload_.isValid()) {
+        scene_reload_.getToken().cancel();
+    }
+    reload_changes_.insert(reload_changes_.end(),
+                           changed.begin(), changed.end());
+
+    // import and diff on the pool, then hand the result to the view on
+    // the render thread where it uploads the differences
+    using Reload = std::pair<std::shared_ptr<const ImportedScene>,
+                             std::shared_ptr<const SceneDiff>>;
+    const auto loaded = imported_;
+    const auto file = imported_file_;
+    const auto changes = reload_changes_;
+
+    scene_reload_ = util::startTask(*pool_, [file] ()
+    {
+        auto updated = std::make_shared<ImportedScene>();
+        if (!util::importScene(*updated, file)) {
+            throw std::runtime_error("unable to import " + file);
+        }
+        return std::shared_ptr<const ImportedScene>(updated);
+    })
+    .then(*pool_, [loaded, changes] (std::shared_ptr<const ImportedScene>& updated)
+    {
+        auto diff = std::make_shared<SceneDiff>(
+            util::diffScenes(*loaded, *updated, changes));
+        return Reload(updated, diff);
+    })
+    .then(*gl_queue_, [this] (Reload& reload)
+    {
+        view_->updateImportedScene(reload.first, reload.second);
+        if (second_view_) {
+            second_view_->updateImportedScene(reload.first, reload.second);
+        }
+        imported_ = reload.first;
+        reload_changes_.clear();
+        watchScene(*imported_);
+    });
+
+    scene_reload_.whenDone(InlineExecutor::get(), [] (const Task<void>& task)
+    {
+        try {
+            task.get();
+        }
+        catch (const TaskCancelled&) {
+        }
+        catch (const std::exception& error) {
+            std::cerr << "Scene reload failed: " << error.what() << std::endl;
+        }
+    });
+}
+
+void MyController::
+pollSponzaReload()
+{
+    if (imported_ != nullptr) {
+        return;
+    }
+
+    // the loaded content is laid out as tables once, in the background, so
+    // a change to the file can be diffed against it. the copy is read here
+    // rather than on the pool as the view reads the file on this thread
+    if (sponza_tables_ == nullptr) {
+        if (!sponza_tabulation_.isValid()) {
+            const auto content = std::make_shared<const SceneModel::Context>();
+            const auto builder =
+                std::make_shared<const SceneModel::GeometryBuilder>();
+            sponza_tabulation_ = util::startTask(*pool_,
+                                                 [content, builder] ()
+            {
+                auto tables = std::make_shared<SceneModelTables>();
+                util::tabulateSceneModel(*tables, *content, *builder,
+                                         sponza_file);
+                return std::shared_ptr<const SceneModelTables>(tables);
+            });
+        }
+        if (!sponza_tabulation_.isReady()) {
+            return;
+        }
+        sponza_tables_ = sponza_tabulation_.get();
+        watchScene(sponza_tables_->scene);
+        return;
+    }
+
+    std::vector<std::string> changed;
+    if (!scene_watcher_.poll(changed)) {
+        return;
+    }
+    if (scene_reload_.isValid()) {
+        scene_reload_.getToken().cancel();
+    }
+    reload_changes_.insert(reload_changes_.end(),
+                           changed.begin(), changed.end());
+
+    // read the file again into a fresh context and diff it on the pool, the
+    // view uploads the differences on the render thread. the camera stays
+    // with scene_ so reloading doesn't move it
+    struct Reload {
+        std::shared_ptr<const SceneModel::Context> content;
+        std::shared_ptr<const SceneModelTables> tables;
+        std::shared_ptr<const SceneDiff> diff;
+    };
+    const auto loaded = sponza_tables_;
+    const auto changes = reload_changes_;
+
+    scene_reload_ = util::startTask(*pool_, [loaded, changes] ()
+    {
+        Reload reload;
+        reload.content = std::make_shared<const SceneModel::Context>();
+        const SceneModel::GeometryBuilder builder;
+        auto tables = std::make_shared<SceneModelTables>();
+        util::tabulateSceneModel(*tables, *reload.content, builder,
+                                 sponza_file);
+        reload.diff = std::make_shared<const SceneDiff>(
+            util::diffScenes(loaded->scene, tables->scene, changes));
+        reload.tables = tables;
+        return reload;
+    })
+    .then(*gl_queue_, [this] (Reload& reload)
+    {
+        view_->updateSceneContent(reload.content, reload.tables,
+                                  reload.diff);
+        if (second_view_) {
+            second_view_->updateSceneContent(reload.content, reload.tables,
+                                             reload.diff);
+        }
+        sponza_content_ = reload.content;
+        sponza_tables_ = reload.tables;
+        reload_changes_.clear();
+        watchScene(sponza_tables_->scene);
+    });
+
+    scene_reload_.whenDone(InlineExecutor::get(), [] (const Task<void>& task)
+    {
+        try {
+            task.get();
+        }
+        catch (const TaskCancelled&) {
+        }
+        catch (const std::exception& error) {
+            std::cerr << "Scene reload failed: " << error.what() << std::endl;
+        }
+    });
+}
+
+void MyController::
+toggleAnimation()
+{
+    if (animator_) {
+        stopAnimation();
+    }
+    else {
+        startAnimation();
+    }
+}
+
+void MyController::
+startAnimation()
+{
+    if (hierarchy_) {
+        stopHierarchy();
+    }
+    if (editor_) {
+        stopEditStress();
+    }
+    const auto source = animation_clip_ ? animation_clip_ : make_default_clip();
+    const auto tracks = source->getTrackCount();
+    animator_ = std::make_shared<Animator>();
+    const auto clip = animator_->addClip(source);
+
+    // every instance of the scene plays the clip, spread across its tracks
+    // and started at different points so they don't move in lockstep
+    size_t count = 0;
+    forEachSceneInstance([&] (std::uint32_t mesh, std::int32_t material,
+                              const float* transform) {
+        animator_->addInstance(mesh, material, transform, clip,
+                               count % tracks, count * 0.37f, 1.f);
+        ++count;
+    });
+
+    // the arrays are final now so the view can read them in place
+    stream_instances(*view_, animator_->getMeshes());
+
+    animation_time_ = std::chrono::steady_clock::now();
+    std::cout << "Animating " << count << " instances" << std::endl;
+}
+
+void MyController::
+stopAnimation()
+{
+    remove_streams(*view_, animator_->getMeshes());
+    animator_->printStatistics(std::cout);
+    animator_.reset();
+}
+
+void MyController::
+toggleHierarchy()
+{
+    if (hierarchy_) {
+        stopHierarchy();
+    }
+    else {
+        startHierarchy();
+    }
+}
+
+void MyController::
+startHierarchy()
+{
+    if (animator_) {
+        stopAnimation();
+    }
+    if (editor_) {
+        stopEditStress();
+    }
+    hierarchy_ = std::make_shared<TransformHierarchy>();
+
+    // each mesh hangs its instances off a root at their centre, then only
+    // the root of the busiest mesh turns so the rest of the hierarchy is
+    // never recomputed
+    struct Group {
+        glm::vec3 centre = glm::vec3(0.f);
+        std::vector<std::pair<std::int32_t, glm::mat4>> instances;
+    };
+    std::map<std::uint32_t, Group> groups;
+    forEachSceneInstance([&] (std::uint32_t mesh, std::int32_t material,
+                              const float* transform) {
+        const auto matrix = glm::make_mat4(transform);
+        groups[mesh].centre += glm::vec3(matrix[3]);
+        groups[mesh].instances.push_back(std::make_pair(material, matrix));
+    });
+
+    size_t busiest = 0;
+    for (auto& pair : groups) {
+        auto& group = pair.second;
+        const auto centre = group.centre / float(group.instances.size());
+        const auto root = hierarchy_->addNode(
+            TransformHierarchy::noParent,
+            glm::translate(glm::mat4(1.f), centre));
+        for (const auto& instance : group.instances) {
+            const auto node = hierarchy_->addNode(
+                root, glm::translate(glm::mat4(1.f), -centre) * instance.second);
+            hierarchy_->attachInstance(node, pair.first, instance.first);
+        }
+        if (group.instances.size() > busiest) {
+            busiest = group.instances.size();
+            hierarchy_spinner_ = root;
+        }
+    }
+
+    hierarchy_->update(pool_.get());
+    stream_instances(*view_, hierarchy_->getMeshes());
+    hierarchy_time_ = std::chrono::steady_clock::now();
+    std::cout << "Hierarchy of " << hierarchy_->getNodeCount() << " nodes"
+              << std::endl;
+}
+
+void MyController::
+stopHierarchy()
+{
+    remove_streams(*view_, hierarchy_->getMeshes());
+    hierarchy_->printStatistics(std::cout);
+    hierarchy_.reset();
+}
+
+void MyController::
+togglePrefabGrid()
+{
+    if (prefab_grid_) {
+        view_->removePrefab(prefab_id_);
+        prefab_placements_.clear();
+        prefab_grid_ = false;
+        return;
+    }
+
+    // the whole scene becomes one prefab, then copies of it surround the
+    // original so each copy costs a single matrix however many meshes it has
+    MyView::Prefab prefab;
+    glm::vec3 lower(std::numeric_limits<float>::max());
+    glm::vec3 upper(-std::numeric_limits<float>::max());
+    forEachSceneInstance([&] (std::uint32_t mesh, std::int32_t material,
+                              const float* transform) {
+        MyView::Prefab::Entry entry;
+        entry.mesh = mesh;
+        entry.transform = glm::make_mat4(transform);
+        entry.material = material;
+        prefab.entries.push_back(entry);
+        lower = glm::min(lower, glm::vec3(entry.transform[3]));
+        upper = glm::max(upper, glm::vec3(entry.transform[3]));
+    });
+    if (prefab.entries.empty()) {
+        return;
+    }
+
+    // instance origins underestimate the extent so leave a margin
+    const auto size = (upper - lower) * 1.5f;
+    for (int z = -1; z <= 1; ++z) {
+        for (int x = -1; x <= 1; ++x) {
+            if (x == 0 && z == 0) {
+                continue;
+            }
+            const auto placement = glm::translate(
+                glm::mat4(1.f), glm::vec3(x * size.x, 0.f, z * size.z));
+            const auto values = glm::value_ptr(placement);
+            prefab_placements_.insert(prefab_placements_.end(),
+                                      values, values + 16);
+        }
+    }
+
+    prefab_id_ = view_->addPrefab(prefab);
+
+    MyView::InstanceStream stream;
+    stream.transforms = prefab_placements_.data();
+    stream.transformStride = sizeof(glm::mat4);
+    stream.count = prefab_placements_.size() / 16;
+    view_->setPrefabInstances(prefab_id_, stream);
+    prefab_grid_ = true;
+
+    std::cout << "Prefab of " << prefab.entries.size() << " meshes placed "
+              << stream.count << " times" << std::endl;
+}
+
+void MyController::
+toggleEditStress()
+{
+    if (editor_) {
+        stopEditStress();
+    }
+    else {
+        startEditStress();
+    }
+}
+
+void MyController::
+startEditStress()
+{
+    if (animator_) {
+        stopAnimation();
+    }
+    if (hierarchy_) {
+        stopHierarchy();
+    }
+    editor_ = std::make_shared<SceneEditor>();
+
+    // the render thread adds the scene itself so it still looks the same,
+    // streamed meshes no longer draw the instances of the scene
+    struct Template {
+        std::uint32_t mesh;
+        std::int32_t material;
+        glm::mat4 transform;
+    };
+    auto templates = std::make_shared<std::vector<Template>>();
+    forEachSceneInstance([&] (std::uint32_t mesh, std::int32_t material,
+                              const float* transform) {
+        Template instance = { mesh, material, glm::make_mat4(transform) };
+        templates->push_back(instance);
+    });
+    if (templates->empty()) {
+        editor_.reset();
+        return;
+    }
+
+    // a writer of its own for the scene, applying whenever its ring fills
+    const auto scene_writer = editor_->createWriter();
+    for (const auto& instance : *templates) {
+        while (scene_writer->addInstance(instance.mesh, instance.material,
+                                         glm::value_ptr(instance.transform))
+               == SceneEditor::invalidInstance) {
+            editor_->apply();
+        }
+    }
+    editor_->apply();
+    streamEdits();
+
+    // every writer keeps adding copies of the scene, nudging and removing
+    // them as quickly as it can
+    const auto thread_count =
+        std::max(std::thread::hardware_concurrency(), 2u);
+    edit_running_ = true;
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        const auto writer = editor_->createWriter();
+        if (!writer) {
+            break;
+        }
+        edit_threads_.emplace_back([this, writer, templates, i] {
+            const size_t max_instances = 2000;
+            std::mt19937 random(i);
+            std::uniform_real_distribution<float> offset(-200.f, 200.f);
+            std::vector<SceneEditor::InstanceID> instances;
+            while (edit_running_) {
+                const auto choice = random() % 4;
+                auto done = true;
+                if (instances.size() < max_instances && choice == 0) {
+                    const auto& instance =
+                        (*templates)[random() % templates->size()];
+                    const auto transform = glm::translate(
+                        glm::mat4(1.f),
+                        glm::vec3(offset(random), 0.f, offset(random))) *
+                        instance.transform;
+                    const auto id = writer->addInstance(
+                        instance.mesh, instance.material,
+                        glm::value_ptr(transform));
+                    done = id != SceneEditor::invalidInstance;
+                    if (done) {
+                        instances.push_back(id);
+                    }
+                }
+                else if (!instances.empty() && choice == 1) {
+                    const auto index = random() % instances.size();
+                    if (writer->removeInstance(instances[index])) {
+                        instances[index] = instances.back();
+                        instances.pop_back();
+                    }
+                    else {
+                        done = false;
+                    }
+                }
+                else if (!instances.empty()) {
+                    const auto& instance =
+                        (*templates)[random() % templates->size()];
+                    const auto transform = glm::translate(
+                        glm::mat4(1.f),
+                        glm::vec3(offset(random), 0.f, offset(random))) *
+                        instance.transform;
+                    done = writer->moveInstance(
+                        instances[random() % instances.size()],
+                        glm::value_ptr(transform));
+                }
+                // a full ring empties on the next frame
+                if (!done) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::cout << "Editing with " << edit_threads_.size() << " threads"
+              << std::endl;
+}
+
+void MyController::
+stopEditStress()
+{
+    edit_running_ = false;
+    for (auto& thread : edit_threads_) {
+        thread.join();
+    }
+    edit_threads_.clear();
+
+    for (const auto mesh : edit_meshes_) {
+        view_->removeInstanceStream(mesh);
+    }
+    edit_meshes_.clear();
+    editor_->printStatistics(std::cout);
+    editor_.reset();
+}
+
+void MyController::
+streamEdits()
+{
+    // meshes which lost every instance go back to drawing the scene
+    const auto& meshes = editor_->getMeshes();
+    for (const auto mesh : edit_meshes_) {
+        if (meshes.find(mesh) == meshes.end()) {
+            view_->removeInstanceStream(mesh);
+        }
+    }
+    edit_meshes_.clear();
+
+    for (const auto& pair : meshes) {
+        const auto& instances = *pair.second;
+        MyView::InstanceStream stream;
+        stream.transforms = instances.transforms.data();
+        stream.materials = instances.materials.data();
+        stream.count = instances.materials.size();
+        stream.version = &instances.version;
+        stream.dirty = instances.dirty.data();
+        view_->setInstanceStream(pair.first, stream);
+        edit_meshes_.push_back(pair.first);
+    }
+}
+
+void MyController::
+forEachSceneInstance(const std::function<void(std::uint32_t, std::int32_t,
+                                              const float*)>& visit) const
+{
+    if (imported_) {
+        for (const auto& instance : imported_->instances) {
+            visit(static_cast<std::uint32_t>(instance.meshIndex),
+                  static_cast<std::int32_t>(instance.materialIndex),
+                  glm::value_ptr(instance.transform));
+        }
+        return;
+    }
+    // the instances of a reloaded file replace those of scene_
+    const SceneModel::Context& content =
+        sponza_content_ ? *sponza_content_ : *scene_;
+    for (const auto& mesh : SceneModel::GeometryBuilder().getAllMeshes()) {
+        for (const auto id : content.getInstancesByMeshId(mesh.getId())) {
+            const auto& instance = content.getInstanceById(id);
+            const glm::mat4 transform(instance.getTransformationMatrix());
+            visit(mesh.getId(),
+                  static_cast<std::int32_t>(instance.getMaterialId()),
+                  glm::value_ptr(transform));
+        }
+    }
 }
 
 void MyController::
 windowControlWillStart(std::shared_ptr<tygra::Window> window)
 {
-    window->setView(view_);
+    if (switcher_) {
+        window->setView(switcher_);
+    } else {
+        window->setView(view_);
+    }
     window->setTitle("3D Graphics Programming :: SpiceMySponza");
 }
 
@@ -40,8 +838,33 @@ void MyController::
 windowControlViewWillRender(std::shared_ptr<tygra::Window> window)
 {
     scene_->update();
+    if (second_scene_) {
+        second_scene_->update();
+    }
+    gl_queue_->execute();
+    pollSceneReload();
+    pollSponzaReload();
+    if (animator_) {
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::duration<double> elapsed = now - animation_time_;
+        animation_time_ = now;
+        animator_->update(elapsed.count(), pool_.get());
+    }
+    if (editor_ && editor_->apply()) {
+        streamEdits();
+    }
+    if (hierarchy_) {
+        const auto now = std::chrono::steady_clock::now();
+        const std::chrono::duration<float> elapsed = now - hierarchy_time_;
+        hierarchy_time_ = now;
+        const auto turned = glm::rotate(
+            hierarchy_->getLocalTransform(hierarchy_spinner_),
+            elapsed.count() * 10.f, glm::vec3(0, 1, 0));
+        hierarchy_->setLocalTransform(hierarchy_spinner_, turned);
+        hierarchy_->update(pool_.get());
+    }
     if (camera_turn_mode_) {
-        scene_->getCamera().setRotationalVelocity(glm::vec2(0, 0));
+        camera_scene_->getCamera().setRotationalVelocity(glm::vec2(0, 0));
     }
 }
 
@@ -56,7 +879,7 @@ windowControlMouseMoved(std::shared_ptr<tygra::Window> window,
         int dx = x - prev_x;
         int dy = y - prev_y;
         const float mouse_speed = 0.6f;
-        scene_->getCamera().setRotationalVelocity(
+        camera_scene_->getCamera().setRotationalVelocity(
             glm::vec2(-dx * mouse_speed, -dy * mouse_speed));
     }
     prev_x = x;
@@ -121,6 +944,102 @@ windowControlKeyboardChanged(std::shared_ptr<tygra::Window> window,
         {
             view_->toggleWireframeType();
         }
+        break;
+    case 'F':
+        if (down)
+        {
+            cycleFramesInFlight();
+        }
+        break;
+    case 'T':
+        if (down)
+        {
+            cycleTargetRefreshRate();
+        }
+        break;
+    case 'N':
+        if (down)
+        {
+            toggleAnimation();
+        }
+        break;
+    case 'H':
+        if (down)
+        {
+            toggleHierarchy();
+        }
+        break;
+    case 'G':
+        if (down)
+        {
+            togglePrefabGrid();
+        }
+        break;
+    case 'J':
+        if (down)
+        {
+            toggleEditStress();
+        }
+        break;
+    case 'C':
+        if (down)
+        {
+            view_->cycleCullingMode();
+        }
+        break;
+    case 'V':
+        if (down)
+        {
+            view_->togglePanoramaMode();
+        }
+        break;
+    case 'B':
+        if (down)
+        {
+            switchView();
+        }
+        break;
+    case 'Z':
+        if (down)
+        {
+            view_->toggleDepthPrepass();
+        }
+        break;
+    case 'X':
+        if (down)
+        {
+            view_->toggleTransformCache();
+        }
+        break;
+    case 'O':
+        if (down)
+        {
+            view_->toggleOcclusionQueries();
+        }
+        break;
+    case 'P':
+        if (down)
+        {
+            pacer_->printStatistics(std::cout);
+            reader_->printStatistics(std::cout);
+            view_->printStatistics(std::cout);
+            if (simulation_) {
+                simulation_->printStatistics(std::cout);
+            }
+            if (server_) {
+                server_->printStatistics(std::cout);
+            }
+            if (animator_) {
+                animator_->printStatistics(std::cout);
+            }
+            if (hierarchy_) {
+                hierarchy_->printStatistics(std::cout);
+            }
+            if (editor_) {
+                editor_->printStatistics(std::cout);
+            }
+        }
+        break;
 	}
 
 	updateCameraTranslation();
@@ -181,7 +1100,7 @@ windowControlGamepadAxisMoved(std::shared_ptr<tygra::Window> window,
 		else {
 			camera_rotate_speed_[0] = 0.f;
 		}
-        scene_->getCamera().setRotationalVelocity(
+        camera_scene_->getCamera().setRotationalVelocity(
             glm::vec2(camera_rotate_speed_[0] * rotate_speed,
 			          camera_rotate_speed_[1] * rotate_speed));
 		break;
@@ -192,7 +1111,7 @@ windowControlGamepadAxisMoved(std::shared_ptr<tygra::Window> window,
 		else {
 			camera_rotate_speed_[1] = 0.f;
 		}
-        scene_->getCamera().setRotationalVelocity(
+        camera_scene_->getCamera().setRotationalVelocity(
             glm::vec2(camera_rotate_speed_[0] * rotate_speed,
 			          camera_rotate_speed_[1] * rotate_speed));
 		break;
@@ -218,6 +1137,48 @@ windowControlGamepadButtonChanged(std::shared_ptr<tygra::Window> window,
     }
 }
 
+void MyController::
+cycleFramesInFlight()
+{
+    const auto frames = pacer_->getFramesInFlight() % FramePacer::maxFramesInFlight() + 1;
+    pacer_->setFramesInFlight(frames);
+    pacer_->resetStatistics();
+    std::cout << "Frames in flight: " << frames << std::endl;
+}
+
+void MyController::
+cycleTargetRefreshRate()
+{
+    // Cycle through unlimited, 60Hz and 30Hz.
+    const auto current = pacer_->getTargetRefreshRate();
+    const float next = current == 0.f ? 60.f : current == 60.f ? 30.f : 0.f;
+    pacer_->setTargetRefreshRate(next);
+    pacer_->resetStatistics();
+
+    if (next > 0.f) {
+        std::cout << "Target refresh rate: " << next << "Hz" << std::endl;
+    }
+    else {
+        std::cout << "Target refresh rate: unlimited" << std::endl;
+    }
+}
+
+void MyController::
+switchView()
+{
+    if (!switcher_) {
+        return;
+    }
+    // leave the camera being switched away from where it is
+    camera_scene_->getCamera().setLinearVelocity(glm::vec3(0, 0, 0));
+    camera_scene_->getCamera().setRotationalVelocity(glm::vec2(0, 0));
+    switcher_->cycle();
+    camera_scene_ = switcher_->getPresented() == 0 ? scene_ : second_scene_;
+    updateCameraTranslation();
+    std::cout << "Presenting view " << switcher_->getPresented() + 1
+              << std::endl;
+}
+
 void MyController::
 updateCameraTranslation()
 {
@@ -226,6 +1187,6 @@ updateCameraTranslation()
 		+ key_speed * camera_move_speed_[1];
 	const float forward_speed = key_speed * camera_move_speed_[2]
 		- key_speed * camera_move_speed_[3];
-    scene_->getCamera().setLinearVelocity(
+    camera_scene_->getCamera().setLinearVelocity(
         glm::vec3(sideward_speed, 0, forward_speed));
 }
@@ -1,8 +1,32 @@
 #pragma once
 #include <tygra/WindowControlDelegate.hpp>
 #include <SceneModel/SceneModel_fwd.hpp>
-
+#include <Misc/FileWatcher.h>
+#include <Misc/Task.h>
+#include <Misc/TransformHierarchy.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class AnimationClip;
+class Animator;
+class AsyncFileReader;
+class FramePacer;
+class GLThreadQueue;
 class MyView;
+class RenderServer;
+class SceneEditor;
+class SimulationChannel;
+class ThreadPool;
+class ViewSwitcher;
+struct ImportedScene;
+struct SceneDiff;
+struct SceneModelTables;
 
 class MyController : public tygra::WindowControlDelegate
 {
@@ -12,6 +36,45 @@ public:
 
     ~MyController();
 
+    std::shared_ptr<FramePacer>
+    getFramePacer() const;
+
+    bool
+    importScene(const std::string& file_location);
+
+    bool
+    connectSimulation(const std::string& channel_name);
+
+    bool
+    startRenderServer(const std::string& server_name);
+
+    bool
+    loadAnimation(const std::string& file_location);
+
+    void
+    enableVirtualTexturing();
+
+    void
+    enableSimilarTextureMerging();
+
+    void
+    enableDepthPrepass();
+
+    void
+    enableStripification();
+
+    void
+    enableTransformCache();
+
+    void
+    enableOcclusionQueries();
+
+    void
+    enableSecondView();
+
+    bool
+    runHeadless(const std::atomic<bool>& running);
+
 private:
 
     void
@@ -57,8 +120,96 @@ private:
     void
     updateCameraTranslation();
 
+    void
+    cycleFramesInFlight();
+
+    void
+    cycleTargetRefreshRate();
+
+    void
+    switchView();
+
+    void
+    watchScene(const ImportedScene& scene);
+
+    void
+    pollSceneReload();
+
+    void
+    pollSponzaReload();
+
+    void
+    toggleAnimation();
+
+    void
+    startAnimation();
+
+    void
+    stopAnimation();
+
+    void
+    toggleHierarchy();
+
+    void
+    startHierarchy();
+
+    void
+    stopHierarchy();
+
+    void
+    togglePrefabGrid();
+
+    void
+    toggleEditStress();
+
+    void
+    startEditStress();
+
+    void
+    stopEditStress();
+
+    void
+    streamEdits();
+
+    void
+    forEachSceneInstance(const std::function<void(std::uint32_t, std::int32_t,
+                                                  const float*)>& visit) const;
+
     std::shared_ptr<MyView> view_;
     std::shared_ptr<SceneModel::Context> scene_;
+    std::shared_ptr<MyView> second_view_;
+    std::shared_ptr<SceneModel::Context> second_scene_;
+    std::shared_ptr<ViewSwitcher> switcher_;
+    std::shared_ptr<SceneModel::Context> camera_scene_;
+    std::shared_ptr<FramePacer> pacer_;
+    std::shared_ptr<ThreadPool> pool_;
+    std::shared_ptr<AsyncFileReader> reader_;
+    std::shared_ptr<GLThreadQueue> gl_queue_;
+    std::shared_ptr<SimulationChannel> simulation_;
+    std::shared_ptr<RenderServer> server_;
+    std::shared_ptr<Animator> animator_;
+    std::shared_ptr<const AnimationClip> animation_clip_;
+    std::chrono::steady_clock::time_point animation_time_;
+    std::shared_ptr<TransformHierarchy> hierarchy_;
+    TransformHierarchy::NodeID hierarchy_spinner_;
+    std::chrono::steady_clock::time_point hierarchy_time_;
+    std::vector<float> prefab_placements_;
+    size_t prefab_id_;
+    bool prefab_grid_;
+    std::shared_ptr<SceneEditor> editor_;
+    std::vector<std::thread> edit_threads_;
+    std::atomic<bool> edit_running_;
+    std::vector<std::uint32_t> edit_meshes_;
+
+    std::string imported_file_;
+    std::shared_ptr<const ImportedScene> imported_;
+    FileWatcher scene_watcher_;
+    std::vector<std::string> reload_changes_;
+    Task<void> scene_reload_;
+
+    std::shared_ptr<const SceneModel::Context> sponza_content_;
+    std::shared_ptr<const SceneModelTables> sponza_tables_;
+    Task<std::shared_ptr<const SceneModelTables>> sponza_tabulation_;
 
     bool camera_turn_mode_;
 	float camera_move_speed_[4];
@@ -0,0 +1,666 @@
+#include "RenderServer.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+
+// Platform headers.
+#if defined (_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <sdkddkver.h>
+    #include <WinSock2.h>
+    #include <Windows.h>
+
+    // Unix domain sockets only arrived in the Windows 10 April 2018 SDK, older SDKs fall back to a loopback TCP port.
+    #if defined (NTDDI_WIN10_RS4)
+        #include <afunix.h>
+        #define UNIX_SOCKETS
+    #endif
+
+    #pragma comment (lib, "Ws2_32.lib")
+
+    using NativeSocket = SOCKET;
+    using PollSocket = WSAPOLLFD;
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+
+    #define UNIX_SOCKETS
+
+    using NativeSocket = int;
+    using PollSocket = pollfd;
+#endif
+
+
+
+// Personal headers.
+#include <Utility/ImageEncoder.h>
+
+
+
+// How long the listening thread waits for activity before checking whether the server has stopped, in milliseconds.
+const int pollTimeout = 50;
+
+// Slots are aligned so every image starts on its own cache line.
+const size_t slotAlignment = 64;
+
+// The owner of a slot which is still being rendered to after its client disconnected, it's freed once the job completes.
+const std::uint64_t orphanedSlot = ~std::uint64_t (0);
+
+static_assert (sizeof (RenderServer::Request) == 64, "Clients rely on requests being exactly 64 bytes.");
+static_assert (sizeof (RenderServer::Response) == 64, "Clients rely on responses being exactly 64 bytes.");
+
+
+
+/// <summary>
+/// A connected client along with any part of a request which has arrived.
+/// </summary>
+struct RenderServer::Connection final
+{
+    std::uint64_t   id          { 0 };  //!< The ID used by jobs and slots to refer to the client.
+    std::intptr_t   socket      { -1 }; //!< The native socket.
+    char            buffer[sizeof (Request)];   //!< The partial request.
+    size_t          received    { 0 };  //!< How much of the request has arrived.
+};
+
+
+
+namespace
+{
+    NativeSocket native (const std::intptr_t socket)
+    {
+        return static_cast<NativeSocket> (socket);
+    }
+
+
+    void closeSocket (const std::intptr_t socket)
+    {
+        #if defined (_WIN32)
+            closesocket (native (socket));
+        #else
+            close (native (socket));
+        #endif
+    }
+
+
+    /// <summary> Stops the socket from blocking so a client which stops reading can't stall the server. </summary>
+    bool setNonBlocking (const std::intptr_t socket)
+    {
+        #if defined (_WIN32)
+            u_long enable = 1;
+            return ioctlsocket (native (socket), FIONBIO, &enable) == 0;
+        #else
+            const auto flags = fcntl (native (socket), F_GETFL, 0);
+            return flags != -1 && fcntl (native (socket), F_SETFL, flags | O_NONBLOCK) != -1;
+        #endif
+    }
+
+
+    /// <summary> Checks whether the last failed socket call only failed because it would have blocked. </summary>
+    bool wouldBlock()
+    {
+        #if defined (_WIN32)
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        #else
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        #endif
+    }
+
+
+    int pollSockets (std::vector<PollSocket>& sockets, const int timeout)
+    {
+        #if defined (_WIN32)
+            return WSAPoll (sockets.data(), static_cast<ULONG> (sockets.size()), timeout);
+        #else
+            return poll (sockets.data(), static_cast<nfds_t> (sockets.size()), timeout);
+        #endif
+    }
+
+
+    /// <summary> Sends without blocking or raising SIGPIPE. </summary>
+    /// <returns> Whether the whole message was sent. </returns>
+    bool sendAll (const std::intptr_t socket, const void* data, const size_t size)
+    {
+        #if defined (_WIN32)
+            const auto sent = send (native (socket), static_cast<const char*> (data), static_cast<int> (size), 0);
+        #else
+            const auto sent = send (native (socket), data, size, MSG_NOSIGNAL);
+        #endif
+
+        return sent >= 0 && static_cast<size_t> (sent) == size;
+    }
+
+
+    /// <summary> Creates a non-blocking socket listening at the given path. </summary>
+    /// <returns> The socket, or -1 if it couldn't be created. </returns>
+    std::intptr_t openListener (const std::string& path)
+    {
+        #if defined (UNIX_SOCKETS)
+            sockaddr_un address { };
+            address.sun_family = AF_UNIX;
+
+            if (path.size() >= sizeof (address.sun_path))
+            {
+                return -1;
+            }
+
+            std::strcpy (address.sun_path, path.c_str());
+            const auto listener = static_cast<std::intptr_t> (socket (AF_UNIX, SOCK_STREAM, 0));
+        #else
+            // Without Unix domain sockets the server listens on a port chosen by the system, which clients read from the file at the path.
+            sockaddr_in address { };
+            address.sin_family      = AF_INET;
+            address.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+            address.sin_port        = 0;
+
+            const auto listener = static_cast<std::intptr_t> (socket (AF_INET, SOCK_STREAM, IPPROTO_TCP));
+        #endif
+
+        if (listener == static_cast<std::intptr_t> (-1))
+        {
+            return -1;
+        }
+
+        if (bind (native (listener), reinterpret_cast<const sockaddr*> (&address), sizeof (address)) != 0 ||
+            ::listen (native (listener), SOMAXCONN) != 0 || !setNonBlocking (listener))
+        {
+            closeSocket (listener);
+            return -1;
+        }
+
+        #if !defined (UNIX_SOCKETS)
+            auto length = static_cast<int> (sizeof (address));
+            const auto file = getsockname (native (listener), reinterpret_cast<sockaddr*> (&address), &length) == 0 ? 
+                std::fopen (path.c_str(), "w") : nullptr;
+
+            if (!file)
+            {
+                closeSocket (listener);
+                return -1;
+            }
+
+            std::fprintf (file, "%u", static_cast<unsigned int> (ntohs (address.sin_port)));
+            std::fclose (file);
+        #endif
+
+        return listener;
+    }
+
+
+    /// <summary> Responses are tiny and latency matters more than throughput, so TCP mustn't hold them back to coalesce them. </summary>
+    void disableCoalescing (const std::intptr_t socket)
+    {
+        #if !defined (UNIX_SOCKETS)
+            const BOOL enable = TRUE;
+            setsockopt (native (socket), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*> (&enable), sizeof (enable));
+        #else
+            (void) socket;
+        #endif
+    }
+
+
+    float milliseconds (const RenderServer::Clock::duration duration)
+    {
+        return std::chrono::duration<float, std::milli> (duration).count();
+    }
+}
+
+
+
+#pragma region Constructors and destructor
+
+RenderServer::~RenderServer()
+{
+    stop();
+}
+
+#pragma endregion
+
+
+#pragma region Server control
+
+bool RenderServer::start (const std::string& name, const Settings& settings)
+{
+    stop();
+
+    #if defined (_WIN32)
+        static const auto winsock = [] () { WSADATA data { }; return WSAStartup (MAKEWORD (2, 2), &data) == 0; }();
+
+        if (!winsock)
+        {
+            return false;
+        }
+    #endif
+
+    // Every slot can hold the largest image the server will render.
+    const auto largest  = util::maxEncodedPNGSize (settings.maxWidth, settings.maxHeight);
+    const auto slotSize = (largest + slotAlignment - 1) / slotAlignment * slotAlignment;
+
+    if (settings.slotCount == 0 || settings.maxBatchSize == 0 || !m_images.create (name, slotSize * settings.slotCount))
+    {
+        return false;
+    }
+
+    // A stale socket file is left behind if the previous server crashed.
+    const auto path = socketPath (name);
+    std::remove (path.c_str());
+
+    const auto listener = openListener (path);
+
+    if (listener == -1)
+    {
+        m_images.close();
+        return false;
+    }
+
+    m_slotSize      = slotSize;
+    m_settings      = settings;
+    m_socketPath    = path;
+    m_listener      = listener;
+    m_slotOwners.assign (settings.slotCount, 0);
+    m_slotsRendering.assign (settings.slotCount, false);
+    resetStatistics();
+
+    m_running       = true;
+    m_thread        = std::thread (&RenderServer::listen, this);
+
+    return true;
+}
+
+
+void RenderServer::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_running = false;
+    m_thread.join();
+
+    // Disconnect everyone, which empties the queue and releases every slot.
+    std::vector<std::uint64_t> clients { };
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        for (const auto& pair : m_connections)
+        {
+            clients.push_back (pair.first);
+        }
+    }
+
+    for (const auto client : clients)
+    {
+        disconnect (client);
+    }
+
+    closeSocket (m_listener);
+    std::remove (m_socketPath.c_str());
+
+    m_listener = -1;
+    m_images.close();
+}
+
+
+std::string RenderServer::socketPath (const std::string& name)
+{
+    #if defined (_WIN32)
+        char directory[MAX_PATH + 1] = "";
+        GetTempPathA (sizeof (directory), directory);
+
+        return std::string (directory) + name + ".sock";
+    #else
+        return "/tmp/" + name + ".sock";
+    #endif
+}
+
+#pragma endregion
+
+
+#pragma region Render thread
+
+std::vector<RenderServer::Job> RenderServer::takeBatch()
+{
+    std::vector<Job> batch { };
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    if (m_queue.empty())
+    {
+        return batch;
+    }
+
+    // Views can only share a pass if they share a resolution. Anything which doesn't match keeps its place in the queue.
+    const auto  width   = m_queue.front().request.width;
+    const auto  height  = m_queue.front().request.height;
+    const auto  now     = Clock::now();
+    auto        slot    = m_slotOwners.begin();
+
+    for (auto job = m_queue.begin(); job != m_queue.end() && batch.size() < m_settings.maxBatchSize;)
+    {
+        if (job->request.width != width || job->request.height != height)
+        {
+            ++job;
+            continue;
+        }
+
+        slot = std::find (slot, m_slotOwners.end(), 0);
+
+        if (slot == m_slotOwners.end())
+        {
+            break;
+        }
+
+        *slot           = job->client;
+        m_slotsRendering[slot - m_slotOwners.begin()] = true;
+        job->slot       = static_cast<std::uint32_t> (slot - m_slotOwners.begin());
+        job->started    = now;
+
+        batch.push_back (*job);
+        job = m_queue.erase (job);
+    }
+
+    m_queuedCount = m_queue.size();
+
+    if (!batch.empty())
+    {
+        ++m_statistics.batchCount;
+    }
+
+    return batch;
+}
+
+
+void RenderServer::complete (const Job& job, const size_t size, const size_t batchSize, const float renderTime, const float encodeTime)
+{
+    const auto now = Clock::now();
+
+    Response response { };
+    response.id         = job.request.id;
+    response.status     = size > 0 ? Status::Done : Status::Failed;
+    response.slot       = job.slot;
+    response.batchSize  = static_cast<std::uint32_t> (batchSize);
+    response.offset     = job.slot * static_cast<std::uint64_t> (m_slotSize);
+    response.size       = size;
+    response.waitTime   = milliseconds (job.started - job.received);
+    response.renderTime = renderTime;
+    response.encodeTime = encodeTime;
+    response.totalTime  = milliseconds (now - job.received);
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        m_slotsRendering[job.slot] = false;
+
+        // There's nothing for the client to read when encoding fails so it won't release the slot, and nobody is left to if it has gone.
+        if (size == 0 || m_slotOwners[job.slot] == orphanedSlot)
+        {
+            m_slotOwners[job.slot] = 0;
+        }
+
+        if (size == 0)
+        {
+            ++m_statistics.failedCount;
+        }
+
+        else
+        {
+            ++m_statistics.completedCount;
+            m_statistics.totalWait      += response.waitTime;
+            m_statistics.totalRender    += response.renderTime;
+            m_statistics.totalEncode    += response.encodeTime;
+            m_statistics.totalLatency   += response.totalTime;
+            m_statistics.maxLatency     = std::max<double> (m_statistics.maxLatency, response.totalTime);
+        }
+    }
+
+    respond (job.client, response);
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+RenderServer::Statistics RenderServer::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    return m_statistics;
+}
+
+
+void RenderServer::printStatistics (std::ostream& stream) const
+{
+    const auto statistics = getStatistics();
+
+    stream  << "Render server: " << statistics.completedCount << " images in " << statistics.batchCount << " batches ("
+            << statistics.averageBatchSize() << " views per batch), " << statistics.busyCount << " busy, " << statistics.invalidCount
+            << " invalid, " << statistics.failedCount << " failed. Latency " << statistics.averageLatency() << "ms average ("
+            << statistics.averageWait() << "ms queued, " << statistics.averageRender() << "ms rendering, " << statistics.averageEncode()
+            << "ms encoding), " << statistics.maxLatency << "ms max." << std::endl;
+}
+
+
+void RenderServer::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    m_statistics = { };
+}
+
+#pragma endregion
+
+
+#pragma region Implementation
+
+void RenderServer::listen()
+{
+    std::vector<PollSocket>     sockets { };
+    std::vector<Connection*>    polled  { };
+
+    while (m_running)
+    {
+        // Only this thread adds or removes connections so they can be polled without holding the lock.
+        sockets.clear();
+        polled.clear();
+
+        PollSocket listener { };
+        listener.fd     = native (m_listener);
+        listener.events = POLLIN;
+        sockets.push_back (listener);
+
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+
+            for (const auto& pair : m_connections)
+            {
+                PollSocket client { };
+                client.fd       = native (pair.second->socket);
+                client.events   = POLLIN;
+
+                sockets.push_back (client);
+                polled.push_back (pair.second);
+            }
+        }
+
+        if (pollSockets (sockets, pollTimeout) <= 0)
+        {
+            continue;
+        }
+
+        // Accept every waiting connection.
+        if (sockets[0].revents & POLLIN)
+        {
+            for (auto accepted = static_cast<std::intptr_t> (accept (native (m_listener), nullptr, nullptr)); accepted != -1;
+                 accepted = static_cast<std::intptr_t> (accept (native (m_listener), nullptr, nullptr)))
+            {
+                if (!setNonBlocking (accepted))
+                {
+                    closeSocket (accepted);
+                    continue;
+                }
+
+                disableCoalescing (accepted);
+
+                auto connection     = new Connection { };
+                connection->socket  = accepted;
+
+                std::lock_guard<std::mutex> lock { m_mutex };
+                connection->id = m_nextClient++;
+                m_connections.emplace (connection->id, connection);
+            }
+        }
+
+        // Read whatever each client has sent, a request may arrive in several pieces.
+        for (size_t i = 0; i < polled.size(); ++i)
+        {
+            auto& connection = *polled[i];
+
+            if (!(sockets[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+                continue;
+            }
+
+            while (true)
+            {
+                const auto capacity = sizeof (Request) - connection.received;
+                const auto read     = recv (native (connection.socket), connection.buffer + connection.received, static_cast<int> (capacity), 0);
+
+                if (read <= 0)
+                {
+                    if (read == 0 || !wouldBlock())
+                    {
+                        disconnect (connection.id);
+                    }
+
+                    break;
+                }
+
+                connection.received += static_cast<size_t> (read);
+
+                if (connection.received == sizeof (Request))
+                {
+                    Request request { };
+                    std::memcpy (&request, connection.buffer, sizeof (Request));
+                    connection.received = 0;
+
+                    handle (connection, request);
+                }
+            }
+        }
+    }
+}
+
+
+void RenderServer::handle (Connection& connection, const Request& request)
+{
+    Response response { };
+    response.id = request.id;
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        if (request.type == RequestType::Release)
+        {
+            if (request.id < m_slotOwners.size() && m_slotOwners[request.id] == connection.id && !m_slotsRendering[request.id])
+            {
+                m_slotOwners[request.id] = 0;
+            }
+
+            return;
+        }
+
+        const auto valid = request.type == RequestType::Render && request.width > 0 && request.height > 0 &&
+                           request.width <= m_settings.maxWidth && request.height <= m_settings.maxHeight;
+
+        if (!valid)
+        {
+            response.status = Status::Invalid;
+            ++m_statistics.invalidCount;
+        }
+
+        // Answering immediately when the queue is full tells the client to back off rather than letting latency grow without bound.
+        else if (m_queue.size() >= m_settings.queueCapacity)
+        {
+            response.status = Status::Busy;
+            ++m_statistics.busyCount;
+        }
+
+        else
+        {
+            Job job { };
+            job.request     = request;
+            job.client      = connection.id;
+            job.received    = Clock::now();
+
+            m_queue.push_back (job);
+            m_queuedCount = m_queue.size();
+
+            return;
+        }
+    }
+
+    respond (connection.id, response);
+}
+
+
+void RenderServer::respond (const std::uint64_t client, const Response& response)
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    const auto connection = m_connections.find (client);
+
+    if (connection == m_connections.end())
+    {
+        return;
+    }
+
+    // A client which has stopped reading would eventually block the render thread, so it's cut off. The listening thread notices
+    // the shutdown and cleans the connection up.
+    if (!sendAll (connection->second->socket, &response, sizeof (response)))
+    {
+        #if defined (_WIN32)
+            shutdown (native (connection->second->socket), SD_BOTH);
+        #else
+            shutdown (native (connection->second->socket), SHUT_RDWR);
+        #endif
+    }
+}
+
+
+void RenderServer::disconnect (const std::uint64_t client)
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    const auto connection = m_connections.find (client);
+
+    if (connection == m_connections.end())
+    {
+        return;
+    }
+
+    closeSocket (connection->second->socket);
+    delete connection->second;
+    m_connections.erase (connection);
+
+    // Nobody is left to read the images or release the slots. Slots which are still being rendered to can't be reused until the job completes.
+    m_queue.erase (std::remove_if (m_queue.begin(), m_queue.end(), [=] (const Job& job) { return job.client == client; }), m_queue.end());
+    m_queuedCount = m_queue.size();
+
+    for (size_t i = 0; i < m_slotOwners.size(); ++i)
+    {
+        if (m_slotOwners[i] == client)
+        {
+            m_slotOwners[i] = m_slotsRendering[i] ? orphanedSlot : 0;
+        }
+    }
+}
+
+#pragma endregion
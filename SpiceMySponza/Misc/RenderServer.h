@@ -0,0 +1,244 @@
+#pragma once
+
+#if !defined    _RENDER_SERVER_
+#define         _RENDER_SERVER_
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+// Personal headers.
+#include <Utility/SharedMemory.h>
+
+
+/// <summary>
+/// Lets other processes on the machine request renders of the scene without linking the renderer. Clients connect to a Unix domain
+/// socket and send fixed-size requests containing a camera pose and resolution. Windows SDKs without Unix domain sockets use a loopback
+/// TCP port instead, which is written as text to the file where the socket would have been. Requests are queued until the render thread takes them
+/// as a batch of views which share a resolution, renders the batch in one pass and encodes each view as a PNG directly into a slot of a
+/// shared memory block. The response tells the client which slot to read, and the client sends the slot back once it's done with it.
+///
+/// The queue and the slots are both bounded. A request which arrives to a full queue is answered as busy straight away, and queued
+/// requests wait for a free slot, so a client which never releases its slots only ever slows itself down.
+/// </summary>
+class RenderServer final
+{
+    public:
+
+        #pragma region Protocol
+
+        /// <summary> What a client message asks the server to do. </summary>
+        enum class RequestType : std::uint32_t
+        {
+            Render  = 1,    //!< Render the scene from the given camera.
+            Release = 2     //!< Return the slot given as the ID so it can hold another image.
+        };
+
+        /// <summary> How a request was handled. </summary>
+        enum class Status : std::uint32_t
+        {
+            Done    = 0,    //!< The image is in the slot.
+            Busy    = 1,    //!< The queue was full, try again later.
+            Invalid = 2,    //!< The request was malformed or exceeded the limits of the server.
+            Failed  = 3     //!< The image couldn't be rendered or encoded.
+        };
+
+        /// <summary> A message from a client, always exactly 64 bytes. </summary>
+        struct Request final
+        {
+            RequestType     type            { RequestType::Render };    //!< What the message asks for.
+            std::uint32_t   id              { 0 };                      //!< Chosen by the client and echoed in the response, or the slot to release.
+            float           position[3];                                //!< The world-space position of the camera.
+            float           direction[3];                               //!< The normalised world-space viewing direction.
+            std::uint32_t   width           { 0 };                      //!< The width of the image in pixels.
+            std::uint32_t   height          { 0 };                      //!< The height of the image in pixels.
+            float           fieldOfView     { 0.f };                    //!< The vertical field of view in degrees, zero uses the scene camera.
+            std::uint32_t   padding[5];                                 //!< Reserved.
+        };
+
+        /// <summary> The reply to a render request, always exactly 64 bytes. Times are in milliseconds. </summary>
+        struct Response final
+        {
+            std::uint32_t   id              { 0 };      //!< The ID of the request.
+            Status          status          { Status::Done };
+            std::uint32_t   slot            { 0 };      //!< The slot holding the image, which must be released afterwards.
+            std::uint32_t   batchSize       { 0 };      //!< How many views were rendered alongside this one.
+            std::uint64_t   offset          { 0 };      //!< Where the PNG starts in the shared block.
+            std::uint64_t   size            { 0 };      //!< The size of the PNG in bytes.
+            float           waitTime        { 0.f };    //!< How long the request was queued for.
+            float           renderTime      { 0.f };    //!< How long the batch took to render and read back.
+            float           encodeTime      { 0.f };    //!< How long the image took to encode.
+            float           totalTime       { 0.f };    //!< The time between receiving the request and sending the response.
+            std::uint32_t   padding[4];                 //!< Reserved.
+        };
+
+        #pragma endregion
+
+        #pragma region Server types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> The limits of the server, fixed when it starts. </summary>
+        struct Settings final
+        {
+            std::uint32_t   queueCapacity   { 64 };     //!< How many requests may wait before new ones are rejected as busy.
+            std::uint32_t   slotCount       { 16 };     //!< How many images may be held by clients at once.
+            std::uint32_t   maxWidth        { 1920 };   //!< The widest image which can be requested.
+            std::uint32_t   maxHeight       { 1080 };   //!< The tallest image which can be requested.
+            std::uint32_t   maxBatchSize    { 4 };      //!< The most views rendered in one pass.
+        };
+
+        /// <summary> A request which the render thread has taken from the queue, along with the slot its image will be written to. </summary>
+        struct Job final
+        {
+            Request             request     { };    //!< What the client asked for.
+            std::uint64_t       client      { 0 };  //!< The connection the request came from.
+            std::uint32_t       slot        { 0 };  //!< Where the image should be encoded to.
+            Clock::time_point   received    { };    //!< When the request arrived.
+            Clock::time_point   started     { };    //!< When the render thread took the request.
+        };
+
+        /// <summary>
+        /// Request counts and latencies since the statistics were last reset.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  completedCount  { 0 };      //!< How many images have been sent.
+            size_t  busyCount       { 0 };      //!< How many requests were rejected because the queue was full.
+            size_t  invalidCount    { 0 };      //!< How many requests were malformed or too large.
+            size_t  failedCount     { 0 };      //!< How many requests failed to render or encode.
+            size_t  batchCount      { 0 };      //!< How many batches have been rendered.
+            double  totalWait       { 0.0 };    //!< The sum of the time completed requests spent queued.
+            double  totalRender     { 0.0 };    //!< The sum of the time completed requests spent rendering.
+            double  totalEncode     { 0.0 };    //!< The sum of the time completed requests spent encoding.
+            double  totalLatency    { 0.0 };    //!< The sum of the time between receiving and answering completed requests.
+            double  maxLatency      { 0.0 };    //!< The longest time between receiving and answering a request.
+
+            double averageWait() const      { return completedCount > 0 ? totalWait / completedCount : 0.0; }
+            double averageRender() const    { return completedCount > 0 ? totalRender / completedCount : 0.0; }
+            double averageEncode() const    { return completedCount > 0 ? totalEncode / completedCount : 0.0; }
+            double averageLatency() const   { return completedCount > 0 ? totalLatency / completedCount : 0.0; }
+            double averageBatchSize() const { return batchCount > 0 ? completedCount / static_cast<double> (batchCount) : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        RenderServer()                                      = default;
+        ~RenderServer();
+
+        RenderServer (RenderServer&& move)                  = delete;
+        RenderServer& operator= (RenderServer&& move)       = delete;
+        RenderServer (const RenderServer& copy)             = delete;
+        RenderServer& operator= (const RenderServer& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Server control
+
+        /// <summary> Creates the image block and starts listening on the socket of the given name. </summary>
+        /// <returns> Whether the socket and the block could both be created. </returns>
+        /// <param name="name"> Names both the socket, see socketPath(), and the shared image block. </param>
+        bool start (const std::string& name, const Settings& settings);
+
+        /// <summary> Starts the server with the default settings. </summary>
+        bool start (const std::string& name)            { return start (name, Settings { }); }
+
+        /// <summary> Disconnects every client and stops listening. Every job which has been taken must be completed first. </summary>
+        void stop();
+
+        bool isRunning() const                          { return m_running; }
+        const Settings& getSettings() const             { return m_settings; }
+
+        /// <summary> Gets where the socket of the given name lives in the file system. </summary>
+        static std::string socketPath (const std::string& name);
+
+        #pragma endregion
+
+        #pragma region Render thread
+
+        /// <summary> Checks whether any requests are waiting without taking the lock. </summary>
+        bool hasRequests() const                        { return m_queuedCount.load (std::memory_order_relaxed) > 0; }
+
+        /// <summary> Takes the oldest request and any others of the same resolution, as many as the batch size and free slots allow. </summary>
+        /// <returns> The jobs to render together, empty if nothing is queued or every slot is in use. </returns>
+        std::vector<Job> takeBatch();
+
+        /// <summary> Gets where the image of a job should be encoded to. </summary>
+        char* slotData (const std::uint32_t slot) const { return m_images.data() + slot * m_slotSize; }
+        size_t getSlotSize() const                      { return m_slotSize; }
+
+        /// <summary> Sends the image of a job to its client. Safe to call from any thread. </summary>
+        /// <param name="size"> The size of the encoded image, zero if encoding failed. </param>
+        /// <param name="batchSize"> How many views were rendered alongside this one. </param>
+        /// <param name="renderTime"> How long the batch took to render and read back in milliseconds. </param>
+        /// <param name="encodeTime"> How long the image took to encode in milliseconds. </param>
+        void complete (const Job& job, const size_t size, const size_t batchSize, const float renderTime, const float encodeTime);
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const;
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics();
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        struct Connection;
+
+        /// <summary> Accepts connections and reads requests until the server stops. </summary>
+        void listen();
+
+        /// <summary> Handles a complete message from a client. </summary>
+        void handle (Connection& connection, const Request& request);
+
+        /// <summary> Sends a response to a client if it's still connected. </summary>
+        void respond (const std::uint64_t client, const Response& response);
+
+        /// <summary> Closes a connection, discarding its queued requests and releasing its slots. </summary>
+        void disconnect (const std::uint64_t client);
+
+        util::SharedMemory                          m_images        { };        //!< The slots which images are encoded into.
+        size_t                                      m_slotSize      { 0 };      //!< The size of each slot in bytes.
+        Settings                                    m_settings      { };        //!< The limits of the server.
+        std::string                                 m_socketPath    { };        //!< Where the listening socket is bound.
+        std::intptr_t                               m_listener      { -1 };     //!< The native listening socket.
+
+        std::atomic<bool>                           m_running       { false };  //!< Tells the listening thread to keep going.
+        std::thread                                 m_thread        { };        //!< Accepts connections and reads requests.
+
+        mutable std::mutex                          m_mutex         { };        //!< Protects the queue, slots, connections and statistics.
+        std::deque<Job>                             m_queue         { };        //!< Requests waiting to be rendered, oldest first.
+        std::atomic<size_t>                         m_queuedCount   { 0 };      //!< The size of the queue, readable without the lock.
+        std::vector<std::uint64_t>                  m_slotOwners    { };        //!< The client holding each slot, zero for free slots.
+        std::vector<bool>                           m_slotsRendering    { };    //!< Whether each slot belongs to a job which hasn't completed.
+        std::unordered_map<std::uint64_t, Connection*>  m_connections   { };    //!< Every connected client by ID.
+        std::uint64_t                               m_nextClient    { 1 };      //!< The ID the next connection receives.
+
+        Statistics                                  m_statistics    { };        //!< Request counts and latencies.
+
+        #pragma endregion
+};
+
+#endif // _RENDER_SERVER_
@@ -0,0 +1,547 @@
+#include "SceneEditor.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+
+
+// How many edits a writer can publish between frames before they're refused.
+const size_t editCapacity = 4096;
+
+// How many reclaimed IDs can wait for a writer to reuse them, the rest wait with the editor.
+const size_t returnCapacity = 4096;
+
+// How many bits of an instance ID identify the instance within its writer, the rest identify the writer.
+const std::uint32_t idBits = 24;
+
+// The pinned epoch of a writer which isn't publishing.
+const std::uint64_t idleEpoch = std::numeric_limits<std::uint64_t>::max();
+
+
+
+const SceneEditor::InstanceID SceneEditor::invalidInstance;
+const size_t SceneEditor::maxWriters;
+
+
+
+/// <summary>
+/// A single change to the scene as published by a writer.
+/// </summary>
+struct SceneEditor::Edit final
+{
+    enum class Type : std::uint32_t
+    {
+        Add     = 0,    //!< Creates the instance.
+        Move    = 1,    //!< Replaces the transform.
+        Remove  = 2     //!< Destroys the instance and retires its ID.
+    };
+
+    Type            type;           //!< What the edit does.
+    InstanceID      instance;       //!< The instance being edited.
+    std::uint32_t   mesh;           //!< The mesh of an added instance.
+    std::int32_t    material;       //!< The material of an added instance.
+    float           transform[16];  //!< The model matrix of an added or moved instance.
+};
+
+
+
+#pragma region Writer
+
+SceneEditor::Writer::Writer (std::atomic<std::uint64_t>& epoch, const std::uint32_t index)
+    : m_edits (new Edit[editCapacity]), m_returned (new InstanceID[returnCapacity]), m_epoch (epoch), m_index (index), m_pinned (idleEpoch)
+{
+}
+
+
+SceneEditor::Writer::~Writer()
+{
+}
+
+
+SceneEditor::InstanceID SceneEditor::Writer::addInstance (const std::uint32_t mesh, const std::int32_t material, const float* transform)
+{
+    // Check for room first so a refused edit doesn't use up an ID.
+    if (m_editTail.load (std::memory_order_relaxed) - m_editHead.load (std::memory_order_acquire) == editCapacity)
+    {
+        return invalidInstance;
+    }
+
+    // Reuse reclaimed IDs before allocating new ones so the location table stays small.
+    InstanceID id { };
+    const auto returnHead = m_returnHead.load (std::memory_order_relaxed);
+
+    if (returnHead != m_returnTail.load (std::memory_order_acquire))
+    {
+        id = m_returned[returnHead % returnCapacity];
+        m_returnHead.store (returnHead + 1, std::memory_order_release);
+    }
+
+    // The last ID of the last writer would be invalidInstance, so that writer has one fewer.
+    else if (m_nextID < (1u << idBits) - (m_index == maxWriters - 1 ? 1u : 0u))
+    {
+        id = (m_index << idBits) | m_nextID++;
+    }
+
+    else
+    {
+        return invalidInstance;
+    }
+
+    Edit edit { };
+    edit.type       = Edit::Type::Add;
+    edit.instance   = id;
+    edit.mesh       = mesh;
+    edit.material   = material;
+    std::memcpy (edit.transform, transform, sizeof (edit.transform));
+
+    publish (edit);
+
+    return id;
+}
+
+
+bool SceneEditor::Writer::moveInstance (const InstanceID instance, const float* transform)
+{
+    Edit edit { };
+    edit.type       = Edit::Type::Move;
+    edit.instance   = instance;
+    std::memcpy (edit.transform, transform, sizeof (edit.transform));
+
+    return publish (edit);
+}
+
+
+bool SceneEditor::Writer::removeInstance (const InstanceID instance)
+{
+    Edit edit { };
+    edit.type       = Edit::Type::Remove;
+    edit.instance   = instance;
+
+    return publish (edit);
+}
+
+
+bool SceneEditor::Writer::publish (const Edit& edit)
+{
+    /// Pinning the epoch for the duration of the publish is what makes reclamation safe. If the render thread sees the writer idle before
+    /// draining, anything it published is in the ring and will be applied before IDs are reclaimed. Otherwise the pinned epoch holds back
+    /// every ID retired since, so an edit which raced a removal can never land on a reused ID.
+    m_pinned.store (m_epoch.load (std::memory_order_seq_cst), std::memory_order_seq_cst);
+
+    const auto tail = m_editTail.load (std::memory_order_relaxed);
+    const auto full = tail - m_editHead.load (std::memory_order_acquire) == editCapacity;
+
+    if (!full)
+    {
+        m_edits[tail % editCapacity] = edit;
+        m_editTail.store (tail + 1, std::memory_order_release);
+    }
+
+    m_pinned.store (idleEpoch, std::memory_order_release);
+
+    return !full;
+}
+
+#pragma endregion
+
+
+#pragma region Constructors and destructor
+
+SceneEditor::SceneEditor (const size_t gracePeriod)
+    : m_gracePeriod (std::max (gracePeriod, size_t { 1 }))
+{
+}
+
+
+SceneEditor::~SceneEditor()
+{
+}
+
+#pragma endregion
+
+
+#pragma region Editing
+
+SceneEditor::Writer* SceneEditor::createWriter()
+{
+    std::lock_guard<std::mutex> lock { m_writerMutex };
+
+    const auto index = m_writerCount.load (std::memory_order_relaxed);
+
+    if (index == maxWriters)
+    {
+        return nullptr;
+    }
+
+    // The writer must be complete before apply() can see it.
+    m_writers[index].reset (new Writer (m_epoch, static_cast<std::uint32_t> (index)));
+    m_writerCount.store (index + 1, std::memory_order_release);
+
+    return m_writers[index].get();
+}
+
+
+bool SceneEditor::apply()
+{
+    /// Edits are applied writer by writer, so edits from one thread keep their order but edits from different threads only keep the order
+    /// of the frames they were published in. Removing an instance swaps the last instance of the mesh into its slot so the arrays stay
+    /// packed, the moved instance is marked dirty and its location updated. Arrays are never reallocated in place: when a mesh outgrows
+    /// them the old arrays are retired along with the IDs of removed instances, since MyView may still have a stream pointing at them.
+    const auto start = Clock::now();
+
+    // The dirty bits only describe the previous apply.
+    for (auto& pair : m_meshes)
+    {
+        auto& instances = *pair.second;
+
+        for (const auto word : instances.dirtyWords)
+        {
+            instances.dirty[word] = 0;
+        }
+
+        instances.dirtyWords.clear();
+    }
+
+    // Read the pins before draining. A writer seen idle here has nothing half-published, so once the rings are drained no edit of theirs
+    // can refer to anything retired before now.
+    const auto      writerCount     = m_writerCount.load (std::memory_order_acquire);
+    std::uint64_t   oldestPinned    { idleEpoch };
+
+    for (size_t i = 0; i < writerCount; ++i)
+    {
+        oldestPinned = std::min (oldestPinned, m_writers[i]->m_pinned.load (std::memory_order_seq_cst));
+    }
+
+    if (m_locations.size() < writerCount)
+    {
+        m_locations.resize (writerCount);
+    }
+
+    size_t edits { 0 };
+
+    for (size_t i = 0; i < writerCount; ++i)
+    {
+        auto&       writer  = *m_writers[i];
+        const auto  head    = writer.m_editHead.load (std::memory_order_relaxed);
+        const auto  tail    = writer.m_editTail.load (std::memory_order_acquire);
+
+        for (auto edit = head; edit < tail; ++edit)
+        {
+            if (!applyEdit (writer.m_edits[edit % editCapacity]))
+            {
+                ++m_statistics.staleCount;
+            }
+        }
+
+        writer.m_editHead.store (tail, std::memory_order_release);
+        edits += tail - head;
+    }
+
+    // Meshes which weren't touched keep their version so MyView doesn't upload them again.
+    for (const auto instances : m_changed)
+    {
+        instances->version.fetch_add (1, std::memory_order_release);
+        instances->changed = false;
+    }
+
+    const auto changed = !m_changed.empty() || edits > 0;
+    m_changed.clear();
+
+    reclaim (oldestPinned);
+    m_epoch.fetch_add (1, std::memory_order_seq_cst);
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (Clock::now() - start).count();
+
+    ++m_statistics.applyCount;
+    m_statistics.editCount  += edits;
+    m_statistics.totalTime  += milliseconds;
+    m_statistics.maxTime    = std::max (m_statistics.maxTime, milliseconds);
+
+    return changed;
+}
+
+
+size_t SceneEditor::getInstanceCount() const
+{
+    size_t count { 0 };
+
+    for (const auto& pair : m_meshes)
+    {
+        count += pair.second->materials.size();
+    }
+
+    return count;
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+void SceneEditor::printStatistics (std::ostream& stream) const
+{
+    stream  << "Scene editor: " << m_writerCount.load() << " writers, " << getInstanceCount() << " instances, " << m_statistics.applyCount
+            << " applies, " << m_statistics.averageEdits() << " edits per apply, " << m_statistics.staleCount << " stale, "
+            << m_statistics.reclaimedCount << " IDs reclaimed, " << m_retiredIDs.size() << " IDs and " << m_retiredArrays.size()
+            << " arrays retired, apply " << m_statistics.averageTime() << "ms average, " << m_statistics.maxTime << "ms max." << std::endl;
+}
+
+#pragma endregion
+
+
+#pragma region Implementation data
+
+SceneEditor::RetiredArrays::RetiredArrays (RetiredArrays&& move)
+{
+    *this = std::move (move);
+}
+
+
+SceneEditor::RetiredArrays& SceneEditor::RetiredArrays::operator= (RetiredArrays&& move)
+{
+    // Avoid moving self to self.
+    if (this != &move)
+    {
+        mesh        = std::move (move.mesh);
+        transforms  = std::move (move.transforms);
+        materials   = std::move (move.materials);
+        dirty       = std::move (move.dirty);
+        epoch       = move.epoch;
+
+        // Reset primitives.
+        move.epoch  = 0;
+    }
+
+    return *this;
+}
+
+
+bool SceneEditor::applyEdit (const Edit& edit)
+{
+    const auto writer   = edit.instance >> idBits;
+    const auto local    = edit.instance & ((1u << idBits) - 1);
+
+    if (writer >= m_locations.size())
+    {
+        return false;
+    }
+
+    if (edit.type == Edit::Type::Add)
+    {
+        auto& locations = m_locations[writer];
+
+        if (locations.size() <= local)
+        {
+            locations.resize (local + 1, { invalidInstance, 0 });
+        }
+
+        auto& instances = meshInstances (edit.mesh);
+        reserveInstance (instances);
+
+        const auto slot = instances.materials.size();
+
+        instances.transforms.insert (instances.transforms.end(), edit.transform, edit.transform + 16);
+        instances.materials.push_back (edit.material);
+        instances.ids.push_back (edit.instance);
+        instances.dirty.resize ((slot + 64) / 64, 0);
+        markDirty (instances, slot);
+
+        locations[local] = { edit.mesh, static_cast<std::uint32_t> (slot) };
+        return true;
+    }
+
+    const auto location = locate (edit.instance);
+
+    if (!location)
+    {
+        return false;
+    }
+
+    auto& instances = *m_meshes.at (location->mesh);
+
+    if (edit.type == Edit::Type::Move)
+    {
+        std::memcpy (instances.transforms.data() + location->slot * 16, edit.transform, sizeof (edit.transform));
+        markDirty (instances, location->slot);
+        return true;
+    }
+
+    // Fill the gap with the last instance so the arrays stay packed.
+    const auto slot = location->slot;
+    const auto last = instances.materials.size() - 1;
+
+    if (slot != last)
+    {
+        const auto moved = instances.ids[last];
+
+        std::memcpy (instances.transforms.data() + slot * 16, instances.transforms.data() + last * 16, sizeof (float) * 16);
+        instances.materials[slot]   = instances.materials[last];
+        instances.ids[slot]         = moved;
+        locate (moved)->slot        = slot;
+        markDirty (instances, slot);
+    }
+
+    instances.transforms.resize (last * 16);
+    instances.materials.pop_back();
+    instances.ids.pop_back();
+    touch (instances);
+
+    const auto mesh = location->mesh;
+    const auto epoch = m_epoch.load (std::memory_order_relaxed);
+
+    location->mesh = invalidInstance;
+    m_retiredIDs.push_back ({ edit.instance, epoch });
+
+    // An empty mesh is retired whole since a stream may still be reading its arrays and version.
+    if (instances.materials.empty())
+    {
+        const auto empty = m_meshes.find (mesh);
+
+        RetiredArrays retired { };
+        retired.mesh    = std::move (empty->second);
+        retired.epoch   = epoch;
+
+        m_meshes.erase (empty);
+        m_retiredArrays.push_back (std::move (retired));
+    }
+
+    return true;
+}
+
+
+SceneEditor::MeshInstances& SceneEditor::meshInstances (const std::uint32_t mesh)
+{
+    auto& instances = m_meshes[mesh];
+
+    if (!instances)
+    {
+        instances.reset (new MeshInstances());
+    }
+
+    return *instances;
+}
+
+
+void SceneEditor::reserveInstance (MeshInstances& instances)
+{
+    const auto count = instances.materials.size();
+
+    if (count < instances.materials.capacity())
+    {
+        return;
+    }
+
+    // Grow into fresh arrays and retire the old ones rather than letting the vectors free them.
+    const auto capacity = std::max (count * 2, size_t { 64 });
+
+    RetiredArrays retired { };
+    retired.epoch = m_epoch.load (std::memory_order_relaxed);
+
+    std::vector<float>          transforms  { };
+    std::vector<std::int32_t>   materials   { };
+    std::vector<std::uint64_t>  dirty       { };
+
+    transforms.reserve (capacity * 16);
+    materials.reserve (capacity);
+    dirty.reserve ((capacity + 63) / 64);
+
+    transforms.assign (instances.transforms.begin(), instances.transforms.end());
+    materials.assign (instances.materials.begin(), instances.materials.end());
+    dirty.assign (instances.dirty.begin(), instances.dirty.end());
+
+    retired.transforms  = std::move (instances.transforms);
+    retired.materials   = std::move (instances.materials);
+    retired.dirty       = std::move (instances.dirty);
+
+    instances.transforms    = std::move (transforms);
+    instances.materials     = std::move (materials);
+    instances.dirty         = std::move (dirty);
+    instances.ids.reserve (capacity);
+
+    m_retiredArrays.push_back (std::move (retired));
+}
+
+
+void SceneEditor::markDirty (MeshInstances& instances, const size_t slot)
+{
+    const auto  word    = slot / 64;
+    auto&       bits    = instances.dirty[word];
+
+    if (bits == 0)
+    {
+        instances.dirtyWords.push_back (word);
+    }
+
+    bits |= std::uint64_t { 1 } << (slot % 64);
+    touch (instances);
+}
+
+
+void SceneEditor::touch (MeshInstances& instances)
+{
+    if (!instances.changed)
+    {
+        instances.changed = true;
+        m_changed.push_back (&instances);
+    }
+}
+
+
+SceneEditor::Location* SceneEditor::locate (const InstanceID id)
+{
+    const auto writer   = id >> idBits;
+    const auto local    = id & ((1u << idBits) - 1);
+
+    if (writer >= m_locations.size() || local >= m_locations[writer].size() || m_locations[writer][local].mesh == invalidInstance)
+    {
+        return nullptr;
+    }
+
+    return &m_locations[writer][local];
+}
+
+
+void SceneEditor::reclaim (const std::uint64_t oldestPinned)
+{
+    /// An ID retired in epoch e may still be the target of an edit from a writer which was publishing in epoch e or before, and a frame
+    /// in flight may still be drawing from arrays retired in any of the last few epochs. Both lists are in retirement order so reclaiming
+    /// stops at the first entry which isn't ready.
+    const auto epoch = m_epoch.load (std::memory_order_relaxed);
+
+    while (!m_retiredIDs.empty())
+    {
+        const auto& retired = m_retiredIDs.front();
+
+        if (retired.epoch >= oldestPinned || retired.epoch + m_gracePeriod > epoch)
+        {
+            break;
+        }
+
+        // IDs which don't fit in the return ring of their writer wait for the next frame.
+        auto&       writer  = *m_writers[retired.id >> idBits];
+        const auto  tail    = writer.m_returnTail.load (std::memory_order_relaxed);
+
+        if (tail - writer.m_returnHead.load (std::memory_order_acquire) == returnCapacity)
+        {
+            break;
+        }
+
+        writer.m_returned[tail % returnCapacity] = retired.id;
+        writer.m_returnTail.store (tail + 1, std::memory_order_release);
+
+        m_retiredIDs.pop_front();
+        ++m_statistics.reclaimedCount;
+    }
+
+    while (!m_retiredArrays.empty() && m_retiredArrays.front().epoch + m_gracePeriod <= epoch)
+    {
+        m_retiredArrays.pop_front();
+    }
+}
+
+#pragma endregion
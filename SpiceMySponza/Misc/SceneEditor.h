@@ -0,0 +1,263 @@
+#pragma once
+
+#if !defined    _SCENE_EDITOR_
+#define         _SCENE_EDITOR_
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+
+/// <summary>
+/// Lets any number of threads add, move and remove instances while the scene is being rendered. Each thread edits through a writer of
+/// its own which publishes edits to a lock-free single-producer ring, and once a frame the render thread applies every ring to per-mesh
+/// arrays ready to be streamed by MyView. Removed instance IDs and replaced arrays are retired rather than freed, then reclaimed using
+/// epochs: apply() advances the epoch and writers announce the epoch they're publishing in, so anything retired is only reused once
+/// every writer has moved past it and enough frames have passed that nothing in flight can still refer to it.
+/// </summary>
+class SceneEditor final
+{
+    public:
+
+        #pragma region Editor types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> Identifies an instance. The top bits hold the writer which added it so IDs can be allocated without synchronisation. </summary>
+        using InstanceID = std::uint32_t;
+
+        /// <summary> Returned when an instance couldn't be added. </summary>
+        static const InstanceID invalidInstance = 0xFFFFFFFF;
+
+        /// <summary> The most writers an editor supports, limited by the bits of the IDs which identify the writer. </summary>
+        static const size_t maxWriters = 256;
+
+        class Writer;
+
+        /// <summary> The instances of a mesh, ready to be streamed by MyView. Only read these on the thread which calls apply(). </summary>
+        struct MeshInstances final
+        {
+            std::vector<float>              transforms  { };    //!< Sixteen floats per instance.
+            std::vector<std::int32_t>       materials   { };    //!< A material ID per instance.
+            std::vector<std::uint64_t>      dirty       { };    //!< A bit per instance, set if its matrix changed in the latest version.
+            std::atomic<std::uint64_t>      version     { 0 };  //!< Incremented whenever any instance changes.
+            std::vector<InstanceID>         ids         { };    //!< The ID of each instance, used to relocate the last instance when one is removed.
+            std::vector<size_t>             dirtyWords  { };    //!< The words of the dirty bits set by the latest apply.
+            bool                            changed     { false };  //!< Whether the latest apply touched the mesh.
+        };
+
+        /// <summary>
+        /// How much editing is going on since the statistics were last reset. Times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  applyCount      { 0 };      //!< How many frames edits have been applied on.
+            size_t  editCount       { 0 };      //!< How many edits have been applied.
+            size_t  staleCount      { 0 };      //!< How many edits referred to an instance which had already been removed.
+            size_t  reclaimedCount  { 0 };      //!< How many instance IDs have been handed back to their writers.
+            double  totalTime       { 0.0 };    //!< The sum of the time each apply took.
+            double  maxTime         { 0.0 };    //!< The longest an apply took.
+
+            double averageEdits() const     { return applyCount > 0 ? editCount / static_cast<double> (applyCount) : 0.0; }
+            double averageTime() const      { return applyCount > 0 ? totalTime / applyCount : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        /// <summary> Prepares the editor. Every writer must have stopped editing before it's destroyed. </summary>
+        /// <param name="gracePeriod"> How many frames retired arrays and IDs are kept for, at least the number of frames in flight. </param>
+        SceneEditor (const size_t gracePeriod = 3);
+        ~SceneEditor();
+
+        SceneEditor (SceneEditor&& move)                    = delete;
+        SceneEditor& operator= (SceneEditor&& move)         = delete;
+        SceneEditor (const SceneEditor& copy)               = delete;
+        SceneEditor& operator= (const SceneEditor& copy)    = delete;
+
+        #pragma endregion
+
+        #pragma region Editing
+
+        /// <summary> Creates a writer for the calling thread. Writers live as long as the editor and must only be used by one thread. </summary>
+        /// <returns> The writer, or nullptr if the editor already has as many writers as IDs can distinguish. </returns>
+        Writer* createWriter();
+
+        /// <summary> Applies every edit published so far and reclaims whatever is no longer in use. Call from the render thread between frames. </summary>
+        /// <returns> Whether any mesh changed, meaning the streams must be set again. </returns>
+        bool apply();
+
+        /// <summary> Gets the instances of every mesh with at least one instance, keyed by mesh ID. </summary>
+        const std::unordered_map<std::uint32_t, std::unique_ptr<MeshInstances>>& getMeshes() const    { return m_meshes; }
+
+        /// <summary> Gets how many instances every mesh has in total. </summary>
+        size_t getInstanceCount() const;
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const        { return m_statistics; }
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics()                  { m_statistics = { }; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        struct Edit;
+
+        /// <summary> Where an instance lives, mesh is invalidInstance for IDs which are free or retired. </summary>
+        struct Location final
+        {
+            std::uint32_t   mesh;   //!< The mesh the instance belongs to.
+            std::uint32_t   slot;   //!< The position of the instance in the mesh arrays.
+        };
+
+        /// <summary> Arrays which MyView may still be reading, kept until the epoch they were retired in has passed. </summary>
+        struct RetiredArrays final
+        {
+            std::unique_ptr<MeshInstances>  mesh        { nullptr };    //!< A mesh which lost its last instance.
+            std::vector<float>              transforms  { };            //!< Transforms replaced by larger storage.
+            std::vector<std::int32_t>       materials   { };            //!< Materials replaced by larger storage.
+            std::vector<std::uint64_t>      dirty       { };            //!< Dirty bits replaced by larger storage.
+            std::uint64_t                   epoch       { 0 };          //!< The epoch the arrays were retired in.
+
+            RetiredArrays()                                 = default;
+            ~RetiredArrays()                                = default;
+
+            RetiredArrays (RetiredArrays&& move);
+            RetiredArrays& operator= (RetiredArrays&& move);
+        };
+
+        /// <summary> A removed instance ID waiting to be given back to its writer. </summary>
+        struct RetiredID final
+        {
+            InstanceID      id;     //!< The ID of the removed instance.
+            std::uint64_t   epoch;  //!< The epoch the instance was removed in.
+        };
+
+        /// <summary> Makes an edit take effect, returning whether it referred to a live instance. </summary>
+        bool applyEdit (const Edit& edit);
+
+        /// <summary> Gets the arrays of a mesh, creating them if necessary. </summary>
+        MeshInstances& meshInstances (const std::uint32_t mesh);
+
+        /// <summary> Ensures another instance fits in the mesh without the arrays moving, retiring the old arrays if they must. </summary>
+        void reserveInstance (MeshInstances& instances);
+
+        /// <summary> Sets the dirty bit of an instance. </summary>
+        void markDirty (MeshInstances& instances, const size_t slot);
+
+        /// <summary> Records that the mesh needs a new version at the end of the apply. </summary>
+        void touch (MeshInstances& instances);
+
+        /// <summary> Finds where an instance lives, nullptr if it isn't live. </summary>
+        Location* locate (const InstanceID id);
+
+        /// <summary> Hands retired IDs and arrays back once no writer or frame can still be using them. </summary>
+        /// <param name="oldestPinned"> The oldest epoch any writer was publishing in before the edits were applied. </param>
+        void reclaim (const std::uint64_t oldestPinned);
+
+        std::unique_ptr<Writer>                                             m_writers[maxWriters];  //!< Every writer, indexed by the top bits of the IDs they allocate.
+        std::atomic<size_t>                                                 m_writerCount   { 0 };  //!< How many writers have been created.
+        std::mutex                                                          m_writerMutex   { };    //!< Serialises the creation of writers.
+        std::atomic<std::uint64_t>                                          m_epoch         { 1 };  //!< Advanced at the end of each apply.
+        size_t                                                              m_gracePeriod   { 3 };  //!< How many epochs retired resources are kept for at the least.
+
+        std::unordered_map<std::uint32_t, std::unique_ptr<MeshInstances>>  m_meshes        { };    //!< The instances of each mesh.
+        std::vector<std::vector<Location>>                                  m_locations     { };    //!< Where each instance lives, by writer then ID.
+        std::deque<RetiredID>                                               m_retiredIDs    { };    //!< Removed IDs in the order they were retired.
+        std::deque<RetiredArrays>                                           m_retiredArrays { };    //!< Replaced arrays in the order they were retired.
+        std::vector<MeshInstances*>                                         m_changed       { };    //!< The meshes touched by the current apply.
+        Statistics                                                          m_statistics    { };    //!< How much editing is going on.
+
+        #pragma endregion
+};
+
+
+/// <summary>
+/// Publishes the edits of one thread. Edits are copied into a fixed ring which the render thread drains once a frame, when the ring is
+/// full the edit is refused and should be tried again after the next frame. Removed IDs come back through a second ring in the other
+/// direction once they're safe to reuse, so neither side ever waits on the other.
+/// </summary>
+class SceneEditor::Writer final
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        Writer (std::atomic<std::uint64_t>& epoch, const std::uint32_t index);
+        ~Writer();
+
+        Writer (Writer&& move)                      = delete;
+        Writer& operator= (Writer&& move)           = delete;
+        Writer (const Writer& copy)                 = delete;
+        Writer& operator= (const Writer& copy)      = delete;
+
+        #pragma endregion
+
+        #pragma region Editing
+
+        /// <summary> Adds an instance of a mesh, visible from the next frame. </summary>
+        /// <returns> The ID of the new instance, or invalidInstance if the ring is full or the writer has run out of IDs. </returns>
+        /// <param name="mesh"> The ID of the mesh in the SceneModel::Context, or the index of an imported mesh. </param>
+        /// <param name="material"> A SceneModel material ID or imported material index. </param>
+        /// <param name="transform"> Sixteen floats forming a column-major model matrix. </param>
+        InstanceID addInstance (const std::uint32_t mesh, const std::int32_t material, const float* transform);
+
+        /// <summary> Replaces the model matrix of an instance. Any writer may move any instance. </summary>
+        /// <returns> False if the ring is full. </returns>
+        bool moveInstance (const InstanceID instance, const float* transform);
+
+        /// <summary> Removes an instance. The ID must not be used again, it returns to its writer once it's safe to reuse. </summary>
+        /// <returns> False if the ring is full. </returns>
+        bool removeInstance (const InstanceID instance);
+
+        #pragma endregion
+
+    private:
+
+        friend class SceneEditor;
+
+        #pragma region Implementation data
+
+        /// <summary> Copies an edit into the ring, announcing the current epoch while doing so. </summary>
+        bool publish (const Edit& edit);
+
+        std::unique_ptr<Edit[]>         m_edits         { nullptr };    //!< The edits waiting to be applied.
+        std::unique_ptr<InstanceID[]>   m_returned      { nullptr };    //!< IDs which are safe to reuse.
+        std::atomic<std::uint64_t>&     m_epoch;                        //!< The epoch of the editor.
+        std::uint32_t                   m_index         { 0 };          //!< Which writer this is, forming the top bits of its IDs.
+        std::uint32_t                   m_nextID        { 0 };          //!< The next ID which has never been allocated.
+
+        char                            m_padding0[64];                 //!< Keeps the indices written by the writer away from the rest.
+        std::atomic<size_t>             m_editTail      { 0 };          //!< Where the next edit is published, written by the writer.
+        std::atomic<size_t>             m_returnHead    { 0 };          //!< The next returned ID to reuse, written by the writer.
+        std::atomic<std::uint64_t>      m_pinned;                       //!< The epoch being published in, the maximum value while idle.
+
+        char                            m_padding1[64];                 //!< Keeps the indices written by the render thread away from the rest.
+        std::atomic<size_t>             m_editHead      { 0 };          //!< The next edit to apply, written by the render thread.
+        std::atomic<size_t>             m_returnTail    { 0 };          //!< Where the next returned ID goes, written by the render thread.
+        char                            m_padding2[64];                 //!< Keeps the indices away from whatever follows the writer.
+
+        #pragma endregion
+};
+
+#endif // _SCENE_EDITOR_
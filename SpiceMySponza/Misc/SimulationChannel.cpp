@@ -0,0 +1,471 @@
+#include "SimulationChannel.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+
+
+// Identifies a block created by SimulationChannel, the version changes whenever the layout does.
+const std::uint32_t channelMagic    = 0x534D5350;
+const std::uint32_t channelVersion  = 2;
+
+// Regions are aligned to cache lines so the producer and consumer don't fight over them.
+const size_t cacheLine = 64;
+
+
+
+namespace
+{
+    /// <summary> Rounds the given size up to a whole number of cache lines. </summary>
+    size_t alignToCacheLine (const size_t size)
+    {
+        return (size + cacheLine - 1) / cacheLine * cacheLine;
+    }
+}
+
+
+
+#pragma region Shared layout
+
+/// <summary>
+/// The start of the shared block. The ring indices live on cache lines of their own since each is written by a different process.
+/// </summary>
+struct SimulationChannel::Header final
+{
+    std::uint32_t               magic;                      //!< Always channelMagic.
+    std::uint32_t               version;                    //!< Always channelVersion.
+    Capacities                  capacities;                 //!< The capacities the block was created with.
+    char                        padding0[cacheLine - 28];   //!< Moves the head onto its own cache line.
+
+    std::atomic<std::uint64_t>  head;                       //!< How many batches the producer has pushed.
+    char                        padding1[cacheLine - 8];    //!< Moves the tail onto its own cache line.
+
+    std::atomic<std::uint64_t>  tail;                       //!< How many batches the consumer has applied.
+    char                        padding2[cacheLine - 8];    //!< Moves the snapshot data onto its own cache line.
+
+    std::atomic<std::uint64_t>  sequence;                   //!< The sequence lock of the snapshot, odd whilst it's being written.
+    std::atomic<std::uint64_t>  rejected;                   //!< How many batches were rejected because the ring was full.
+    char                        padding3[cacheLine - 16];   //!< Pads the header to whole cache lines.
+};
+
+
+/// <summary>
+/// The start of each slot in the ring, followed by the instance updates then the lights.
+/// </summary>
+struct SimulationChannel::BatchHeader final
+{
+    std::uint64_t               timestamp;                  //!< When the batch was pushed.
+    std::uint32_t               updateCount;                //!< How many instance updates follow.
+    std::uint32_t               lightCount;                 //!< How many lights follow the updates.
+    std::uint32_t               hasCamera;                  //!< Whether the camera is valid.
+    std::uint32_t               hasLights;                  //!< Whether the lights replace the current lights.
+    Camera                      camera;                     //!< The camera, if there is one.
+    std::uint64_t               padding[2];                 //!< Keeps the updates 16-byte aligned.
+};
+
+
+/// <summary>
+/// The start of the snapshot, followed by every instance then the lights.
+/// </summary>
+struct SimulationChannel::SnapshotHeader final
+{
+    std::uint64_t               timestamp;                  //!< When the snapshot was published.
+    std::uint64_t               batchSequence;              //!< How many batches had been pushed when the snapshot was published.
+    std::uint32_t               instanceCount;              //!< How many instances follow.
+    std::uint32_t               lightCount;                 //!< How many lights follow the instances.
+    std::uint32_t               hasCamera;                  //!< Whether the camera is valid.
+    std::uint32_t               padding0;                   //!< Aligns the camera.
+    Camera                      camera;                     //!< The camera, if there is one.
+    std::uint64_t               padding1;                   //!< Keeps the instances 16-byte aligned.
+};
+
+
+static_assert (sizeof (SimulationChannel::InstanceUpdate) == 80, "InstanceUpdate must have the same layout in every process.");
+static_assert (sizeof (SimulationChannel::Light) == 64, "Light must have the same layout in every process.");
+static_assert (ATOMIC_LLONG_LOCK_FREE == 2, "Atomics shared between processes must be lock-free.");
+
+#pragma endregion
+
+
+#pragma region Connection
+
+bool SimulationChannel::create (const std::string& name, const Capacities& capacities)
+{
+    // The ring indices wrap using a mask so the slot count must be a power of two.
+    auto adjusted = capacities;
+    std::uint32_t slots { 1 };
+
+    while (slots < adjusted.slotCount)
+    {
+        slots <<= 1;
+    }
+
+    adjusted.slotCount = slots;
+    calculateLayout (adjusted);
+
+    if (!m_memory.create (name, m_blockSize))
+    {
+        return false;
+    }
+
+    auto& shared        = *new (m_memory.data()) Header();
+    shared.magic        = channelMagic;
+    shared.version      = channelVersion;
+    shared.capacities   = adjusted;
+    shared.head         = 0;
+    shared.tail         = 0;
+    shared.sequence     = 0;
+    shared.rejected     = 0;
+
+    m_snapshotSequence  = 0;
+    resetStatistics();
+
+    return true;
+}
+
+
+bool SimulationChannel::connect (const std::string& name)
+{
+    if (!m_memory.open (name) || m_memory.size() < sizeof (Header))
+    {
+        m_memory.close();
+        return false;
+    }
+
+    const auto& shared = header();
+
+    if (shared.magic != channelMagic || shared.version != channelVersion)
+    {
+        m_memory.close();
+        return false;
+    }
+
+    calculateLayout (shared.capacities);
+
+    if (m_memory.size() < m_blockSize)
+    {
+        m_memory.close();
+        return false;
+    }
+
+    m_snapshotSequence = 0;
+    resetStatistics();
+
+    return true;
+}
+
+
+void SimulationChannel::calculateLayout (const Capacities& capacities)
+{
+    static_assert (sizeof (BatchHeader) % 16 == 0 && sizeof (SnapshotHeader) % 16 == 0, "Headers must keep the data after them aligned.");
+    static_assert (sizeof (Header) % cacheLine == 0, "The header must keep the ring indices on cache lines of their own.");
+
+    m_capacities        = capacities;
+    m_slotSize          = alignToCacheLine (sizeof (BatchHeader) + capacities.batchUpdates * sizeof (InstanceUpdate) + capacities.lights * sizeof (Light));
+    m_ringOffset        = alignToCacheLine (sizeof (Header));
+    m_snapshotOffset    = m_ringOffset + capacities.slotCount * m_slotSize;
+    m_blockSize         = m_snapshotOffset + sizeof (SnapshotHeader) + capacities.snapshotUpdates * sizeof (InstanceUpdate) + capacities.lights * sizeof (Light);
+}
+
+
+SimulationChannel::Header& SimulationChannel::header() const
+{
+    return *reinterpret_cast<Header*> (m_memory.data());
+}
+
+
+char* SimulationChannel::slot (const std::uint64_t index) const
+{
+    return m_memory.data() + m_ringOffset + (index & (m_capacities.slotCount - 1)) * m_slotSize;
+}
+
+#pragma endregion
+
+
+#pragma region Producer
+
+bool SimulationChannel::push (const InstanceUpdate* updates, const size_t updateCount, const Camera* camera, const Light* lights, const size_t lightCount)
+{
+    if (!isConnected() || updateCount > m_capacities.batchUpdates || lightCount > m_capacities.lights)
+    {
+        return false;
+    }
+
+    // Only the producer writes the head so it can be read relaxed, the tail needs to be acquired so the slot is known to be free.
+    auto&       shared  = header();
+    const auto  head    = shared.head.load (std::memory_order_relaxed);
+
+    if (head - shared.tail.load (std::memory_order_acquire) >= m_capacities.slotCount)
+    {
+        shared.rejected.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    BatchHeader batch { };
+    batch.timestamp     = timestamp();
+    batch.updateCount   = static_cast<std::uint32_t> (updateCount);
+    batch.lightCount    = static_cast<std::uint32_t> (lights ? lightCount : 0);
+    batch.hasCamera     = camera != nullptr;
+    batch.hasLights     = lights != nullptr;
+
+    if (camera)
+    {
+        batch.camera = *camera;
+    }
+
+    auto destination = slot (head);
+    std::memcpy (destination, &batch, sizeof (batch));
+    std::memcpy (destination + sizeof (batch), updates, updateCount * sizeof (InstanceUpdate));
+
+    // memcpy mustn't be given a null source even when copying nothing.
+    if (batch.lightCount > 0)
+    {
+        std::memcpy (destination + sizeof (batch) + updateCount * sizeof (InstanceUpdate), lights, batch.lightCount * sizeof (Light));
+    }
+
+    // Releasing the head publishes the slot to the consumer.
+    shared.head.store (head + 1, std::memory_order_release);
+
+    return true;
+}
+
+
+bool SimulationChannel::publish (const InstanceUpdate* instances, const size_t instanceCount, const Camera* camera, const Light* lights, const size_t lightCount)
+{
+    if (!isConnected() || instanceCount > m_capacities.snapshotUpdates || lightCount > m_capacities.lights)
+    {
+        return false;
+    }
+
+    SnapshotHeader snapshot { };
+    auto& shared                = header();
+    snapshot.timestamp          = timestamp();
+    snapshot.batchSequence      = shared.head.load (std::memory_order_relaxed);
+    snapshot.instanceCount      = static_cast<std::uint32_t> (instanceCount);
+    snapshot.lightCount         = static_cast<std::uint32_t> (lights ? lightCount : 0);
+    snapshot.hasCamera          = camera != nullptr;
+
+    if (camera)
+    {
+        snapshot.camera = *camera;
+    }
+
+    // An odd sequence tells the consumer the snapshot is being written, it'll try again next frame.
+    const auto sequence = shared.sequence.load (std::memory_order_relaxed);
+    shared.sequence.store (sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+
+    auto destination = m_memory.data() + m_snapshotOffset;
+    std::memcpy (destination, &snapshot, sizeof (snapshot));
+    std::memcpy (destination + sizeof (snapshot), instances, instanceCount * sizeof (InstanceUpdate));
+
+    if (snapshot.lightCount > 0)
+    {
+        std::memcpy (destination + sizeof (snapshot) + instanceCount * sizeof (InstanceUpdate), lights, snapshot.lightCount * sizeof (Light));
+    }
+
+    shared.sequence.store (sequence + 2, std::memory_order_release);
+
+    return true;
+}
+
+#pragma endregion
+
+
+#pragma region Consumer
+
+size_t SimulationChannel::receive()
+{
+    if (!isConnected())
+    {
+        return 0;
+    }
+
+    size_t received = receiveSnapshot() ? 1 : 0;
+
+    // Only the consumer writes the tail, acquiring the head makes the contents of every slot before it visible.
+    auto&       shared  = header();
+    auto        tail    = shared.tail.load (std::memory_order_relaxed);
+    const auto  head    = shared.head.load (std::memory_order_acquire);
+    const auto  now     = timestamp();
+
+    for (; tail < head; ++tail)
+    {
+        const auto  source = slot (tail);
+        BatchHeader batch { };
+        std::memcpy (&batch, source, sizeof (batch));
+
+        // Never trust the counts of another process further than the slot.
+        const auto updateCount  = std::min<size_t> (batch.updateCount, m_capacities.batchUpdates);
+        const auto lightCount   = std::min<size_t> (batch.lightCount, m_capacities.lights);
+        const auto updates      = reinterpret_cast<const InstanceUpdate*> (source + sizeof (batch));
+        const auto lights       = reinterpret_cast<const Light*> (source + sizeof (batch) + updateCount * sizeof (InstanceUpdate));
+
+        apply (updates, updateCount);
+
+        if (batch.hasCamera)
+        {
+            m_camera    = batch.camera;
+            m_hasCamera = true;
+        }
+
+        if (batch.hasLights)
+        {
+            m_lights.assign (lights, lights + lightCount);
+            m_hasLights = true;
+        }
+
+        const auto latency              = now > batch.timestamp ? (now - batch.timestamp) / 1000000.0 : 0.0;
+        m_statistics.totalLatency       += latency;
+        m_statistics.maxLatency         = std::max (m_statistics.maxLatency, latency);
+        m_statistics.updateCount        += updateCount;
+        ++m_statistics.batchCount;
+        ++received;
+    }
+
+    shared.tail.store (tail, std::memory_order_release);
+
+    return received;
+}
+
+
+bool SimulationChannel::receiveSnapshot()
+{
+    /// The snapshot is copied out before being applied because the producer may start writing a newer one at any point. If the sequence
+    /// changed during the copy the copy is thrown away, the producer never waits for the consumer.
+    auto&       shared      = header();
+    const auto  sequence    = shared.sequence.load (std::memory_order_acquire);
+
+    if (sequence == m_snapshotSequence || sequence % 2 != 0)
+    {
+        return false;
+    }
+
+    const auto      source      = m_memory.data() + m_snapshotOffset;
+    SnapshotHeader  snapshot    { };
+    std::memcpy (&snapshot, source, sizeof (snapshot));
+
+    const auto instanceCount    = std::min<size_t> (snapshot.instanceCount, m_capacities.snapshotUpdates);
+    const auto lightCount       = std::min<size_t> (snapshot.lightCount, m_capacities.lights);
+    const auto size             = instanceCount * sizeof (InstanceUpdate) + lightCount * sizeof (Light);
+
+    m_snapshotCopy.resize (size);
+    std::memcpy (m_snapshotCopy.data(), source + sizeof (snapshot), size);
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+
+    if (shared.sequence.load (std::memory_order_relaxed) != sequence)
+    {
+        return false;
+    }
+
+    // Every mesh is emptied rather than removed so arrays handed out as instance streams stay valid.
+    for (auto& pair : m_meshes)
+    {
+        pair.second.transforms.clear();
+        pair.second.materials.clear();
+        pair.second.version.fetch_add (1, std::memory_order_release);
+    }
+
+    const auto instances    = reinterpret_cast<const InstanceUpdate*> (m_snapshotCopy.data());
+    const auto lights       = reinterpret_cast<const Light*> (m_snapshotCopy.data() + instanceCount * sizeof (InstanceUpdate));
+
+    apply (instances, instanceCount);
+
+    m_hasCamera = snapshot.hasCamera != 0;
+    m_camera    = snapshot.camera;
+    m_hasLights = true;
+    m_lights.assign (lights, lights + lightCount);
+
+    // Batches pushed before the snapshot are already part of it.
+    if (shared.tail.load (std::memory_order_relaxed) < snapshot.batchSequence)
+    {
+        shared.tail.store (snapshot.batchSequence, std::memory_order_release);
+    }
+
+    m_snapshotSequence          = sequence;
+    m_statistics.updateCount    += instanceCount;
+    ++m_statistics.snapshotCount;
+
+    return true;
+}
+
+
+void SimulationChannel::apply (const InstanceUpdate* updates, const size_t count)
+{
+    const auto matrixSize = sizeof (updates->transform) / sizeof (float);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& update      = updates[i];
+        const auto  instance    = static_cast<size_t> (update.instance);
+
+        // The index comes from another process. Every instance must fit in a snapshot, so anything beyond that is malformed and would
+        // otherwise let one update allocate billions of instances.
+        if (instance >= m_capacities.snapshotUpdates)
+        {
+            ++m_statistics.malformedCount;
+            continue;
+        }
+
+        // Mesh IDs come from the other process too and every one mentioned keeps its arrays for good, so once the agreed number of
+        // meshes exist any update naming another mesh is malformed as well.
+        if (m_meshes.size() >= m_capacities.meshes && m_meshes.find (update.mesh) == m_meshes.end())
+        {
+            ++m_statistics.malformedCount;
+            continue;
+        }
+
+        // Instances which haven't been sent yet have an empty transform so they aren't visible.
+        auto& mesh = m_meshes[update.mesh];
+
+        if (instance >= mesh.materials.size())
+        {
+            mesh.materials.resize (instance + 1, 0);
+            mesh.transforms.resize ((instance + 1) * matrixSize, 0.f);
+        }
+
+        std::memcpy (&mesh.transforms[instance * matrixSize], update.transform, sizeof (update.transform));
+        mesh.materials[instance] = update.material;
+        mesh.version.fetch_add (1, std::memory_order_release);
+    }
+}
+
+
+SimulationChannel::Statistics SimulationChannel::getStatistics() const
+{
+    auto statistics             = m_statistics;
+    statistics.seconds          = std::chrono::duration<double> (Clock::now() - m_statisticsStart).count();
+    statistics.rejectedCount    = isConnected() ? static_cast<size_t> (header().rejected.load (std::memory_order_relaxed)) : 0;
+
+    return statistics;
+}
+
+
+void SimulationChannel::printStatistics (std::ostream& stream) const
+{
+    const auto statistics = getStatistics();
+
+    stream  << "Simulation channel: " << statistics.batchCount << " batches, " << statistics.snapshotCount << " snapshots, "
+            << statistics.updatesPerSecond() << " updates/s, " << statistics.rejectedCount << " rejected, " << statistics.malformedCount << " malformed, latency "
+            << statistics.averageLatency() << "ms average, " << statistics.maxLatency << "ms max." << std::endl;
+}
+
+
+void SimulationChannel::resetStatistics()
+{
+    m_statistics        = { };
+    m_statisticsStart   = Clock::now();
+}
+
+
+std::uint64_t SimulationChannel::timestamp()
+{
+    return static_cast<std::uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (Clock::now().time_since_epoch()).count());
+}
+
+#pragma endregion
@@ -0,0 +1,221 @@
+#pragma once
+
+#if !defined    _SIMULATION_CHANNEL_
+#define         _SIMULATION_CHANNEL_
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// Personal headers.
+#include <Utility/SharedMemory.h>
+
+
+/// <summary>
+/// Carries instance, camera and light updates from a simulation running in another process through shared memory. Small changes are
+/// pushed as batches through a lock-free single-producer single-consumer ring, whilst complete states are published as a snapshot
+/// guarded by a sequence lock. Neither side ever blocks or makes a system call once connected; a full ring simply rejects the batch
+/// and a snapshot being written is picked up on a later frame. The consumer keeps the current state of every mesh in arrays which
+/// can be handed to MyView as instance streams.
+/// </summary>
+class SimulationChannel final
+{
+    public:
+
+        #pragma region Shared types
+
+        /// <summary> The transform and material of a single instance of a mesh. </summary>
+        struct InstanceUpdate final
+        {
+            std::uint32_t   mesh            { 0 };  //!< The mesh ID the instance belongs to.
+            std::uint32_t   instance        { 0 };  //!< The index of the instance within the mesh.
+            std::int32_t    material        { 0 };  //!< The material ID of the instance.
+            std::uint32_t   padding         { 0 };  //!< Keeps the transform 16-byte aligned.
+            float           transform[16];          //!< The column-major model matrix.
+        };
+
+        /// <summary> The position and viewing direction of the camera. </summary>
+        struct Camera final
+        {
+            float           position[3];            //!< The world-space position.
+            float           direction[3];           //!< The normalised world-space viewing direction.
+        };
+
+        /// <summary> A light laid out like the lights the shaders use. </summary>
+        struct Light final
+        {
+            float           position[3];            //!< The world-space position.
+            float           type;                   //!< The LightType of the light.
+            float           direction[3];           //!< The world-space direction of spot and directional lights.
+            float           coneAngle;              //!< The cone angle in degrees of spot lights.
+            float           colour[3];              //!< The un-attenuated colour.
+            float           aConstant;              //!< The constant attenuation co-efficient.
+            float           aLinear;                //!< The linear attenuation co-efficient.
+            float           aQuadratic;             //!< The quadratic attenuation co-efficient.
+            float           padding[2];             //!< Keeps the structure 16-byte aligned.
+        };
+
+        /// <summary> The fixed sizes of the shared block, agreed upon when it's created. </summary>
+        struct Capacities final
+        {
+            std::uint32_t   slotCount       { 64 };     //!< How many batches the ring holds, rounded up to a power of two.
+            std::uint32_t   batchUpdates    { 1024 };   //!< The most instance updates a batch can carry.
+            std::uint32_t   snapshotUpdates { 65536 };  //!< The most instances a snapshot can carry.
+            std::uint32_t   lights          { 16 };     //!< The most lights a batch or snapshot can carry.
+            std::uint32_t   meshes          { 4096 };   //!< The most distinct meshes the producer can refer to.
+        };
+
+        /// <summary> The current transforms and material IDs of the instances of a mesh, ready to be streamed by MyView. </summary>
+        struct MeshInstances final
+        {
+            std::vector<float>              transforms  { };    //!< Sixteen floats per instance.
+            std::vector<std::int32_t>       materials   { };    //!< A material ID per instance.
+            std::atomic<std::uint64_t>      version     { 0 };  //!< Incremented whenever either array changes.
+        };
+
+        /// <summary>
+        /// How quickly updates arrive since the statistics were last reset.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  batchCount          { 0 };      //!< How many batches have been received.
+            size_t  updateCount         { 0 };      //!< How many instance updates have been applied, including snapshots.
+            size_t  snapshotCount       { 0 };      //!< How many snapshots have been applied.
+            size_t  rejectedCount       { 0 };      //!< How many batches the producer found no room for.
+            size_t  malformedCount      { 0 };      //!< How many updates were discarded for naming an instance or mesh beyond the capacities.
+            double  totalLatency        { 0.0 };    //!< The sum of the time between sending and receiving each batch in milliseconds.
+            double  maxLatency          { 0.0 };    //!< The longest time between sending and receiving a batch in milliseconds.
+            double  seconds             { 0.0 };    //!< How long the statistics cover.
+
+            double averageLatency() const   { return batchCount > 0 ? totalLatency / batchCount : 0.0; }
+            double updatesPerSecond() const { return seconds > 0.0 ? updateCount / seconds : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        SimulationChannel()                                         = default;
+        ~SimulationChannel()                                        = default;
+
+        SimulationChannel (SimulationChannel&& move)                = delete;
+        SimulationChannel& operator= (SimulationChannel&& move)     = delete;
+        SimulationChannel (const SimulationChannel& copy)           = delete;
+        SimulationChannel& operator= (const SimulationChannel& copy) = delete;
+
+        #pragma endregion
+
+        #pragma region Connection
+
+        /// <summary> Creates the shared block, either process may create it as long as the other connects. </summary>
+        /// <returns> Whether the block could be created. </returns>
+        bool create (const std::string& name, const Capacities& capacities);
+
+        /// <summary> Creates the shared block with the default capacities. </summary>
+        bool create (const std::string& name)       { return create (name, Capacities { }); }
+
+        /// <summary> Connects to a block which the other process has created, checking that the layouts match. </summary>
+        bool connect (const std::string& name);
+
+        bool isConnected() const                    { return m_memory.isOpen(); }
+        const Capacities& getCapacities() const     { return m_capacities; }
+
+        #pragma endregion
+
+        #pragma region Producer
+
+        /// <summary> Sends a batch of instance updates along with an optional camera and set of lights. </summary>
+        /// <returns> False if the ring is full or the batch exceeds the capacities, the consumer is falling behind in the former case. </returns>
+        /// <param name="lights"> Replaces every light when given, even if lightCount is zero. </param>
+        bool push (const InstanceUpdate* updates, const size_t updateCount, const Camera* camera = nullptr, const Light* lights = nullptr, const size_t lightCount = 0);
+
+        /// <summary> Publishes the complete state, which the consumer applies in place of every batch sent before it. </summary>
+        /// <returns> False if the state exceeds the capacities. </returns>
+        bool publish (const InstanceUpdate* instances, const size_t instanceCount, const Camera* camera, const Light* lights, const size_t lightCount);
+
+        #pragma endregion
+
+        #pragma region Consumer
+
+        /// <summary> Applies the newest snapshot, if there is one, then every batch waiting in the ring. Never blocks. </summary>
+        /// <returns> How many batches and snapshots were applied. </returns>
+        size_t receive();
+
+        /// <summary> Gets the instances of every mesh the producer has mentioned, keyed by mesh ID. </summary>
+        const std::unordered_map<std::uint32_t, MeshInstances>& getMeshes() const   { return m_meshes; }
+
+        /// <summary> Gets the camera if the producer has sent one. </summary>
+        const Camera* getCamera() const                                             { return m_hasCamera ? &m_camera : nullptr; }
+
+        /// <summary> Checks whether the producer controls the lights, when it does getLights() replaces the lights of the scene. </summary>
+        bool hasLights() const                                                      { return m_hasLights; }
+        const std::vector<Light>& getLights() const                                 { return m_lights; }
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const;
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics();
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Header;
+        struct BatchHeader;
+        struct SnapshotHeader;
+
+        /// <summary> Calculates where each region lives in the block for the given capacities. </summary>
+        void calculateLayout (const Capacities& capacities);
+
+        /// <summary> Gets the header at the start of the shared block. </summary>
+        Header& header() const;
+
+        /// <summary> Gets the start of a slot in the ring. </summary>
+        char* slot (const std::uint64_t index) const;
+
+        /// <summary> Applies instance updates to the mesh arrays, growing them as required. </summary>
+        void apply (const InstanceUpdate* updates, const size_t count);
+
+        /// <summary> Reads the snapshot if it has changed and wasn't being written, applying it and skipping the batches it replaces. </summary>
+        bool receiveSnapshot();
+
+        /// <summary> Gets the current time in nanoseconds, comparable between processes. </summary>
+        static std::uint64_t timestamp();
+
+        util::SharedMemory                                  m_memory            { };        //!< The shared block.
+        Capacities                                          m_capacities        { };        //!< The capacities the block was created with.
+        size_t                                              m_slotSize          { 0 };      //!< The size of each slot in the ring in bytes.
+        size_t                                              m_ringOffset        { 0 };      //!< Where the ring starts in the block.
+        size_t                                              m_snapshotOffset    { 0 };      //!< Where the snapshot starts in the block.
+        size_t                                              m_blockSize         { 0 };      //!< The total size of the block.
+
+        std::unordered_map<std::uint32_t, MeshInstances>    m_meshes            { };        //!< The current instances of each mesh.
+        Camera                                              m_camera            { };        //!< The latest camera.
+        bool                                                m_hasCamera         { false };  //!< Whether a camera has been received.
+        std::vector<Light>                                  m_lights            { };        //!< The latest lights.
+        bool                                                m_hasLights         { false };  //!< Whether lights have been received.
+        std::uint64_t                                       m_snapshotSequence  { 0 };      //!< The sequence of the last snapshot applied.
+        std::vector<char>                                   m_snapshotCopy      { };        //!< Where snapshots are copied before being validated.
+
+        Statistics                                          m_statistics        { };        //!< Batch counts and latencies.
+        Clock::time_point                                   m_statisticsStart   { };        //!< When the statistics were last reset.
+
+        #pragma endregion
+};
+
+#endif // _SIMULATION_CHANNEL_
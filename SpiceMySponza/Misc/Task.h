@@ -0,0 +1,472 @@
+#pragma once
+
+#if !defined    _TASK_
+#define         _TASK_
+
+
+// STL headers.
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/// <summary>
+/// Thrown into a task chain when its cancellation token is cancelled before a stage starts.
+/// </summary>
+class TaskCancelled final : public std::runtime_error
+{
+    public:
+
+        TaskCancelled() : std::runtime_error ("The task was cancelled.") { }
+};
+
+
+/// <summary>
+/// An executor which runs posted work immediately on the calling thread, only suitable for cheap continuations.
+/// </summary>
+struct InlineExecutor final
+{
+    void post (const std::function<void()>& work) const { work(); }
+
+    /// <summary> Gets the shared instance, continuations keep a pointer to their executor so it must outlive them. </summary>
+    static InlineExecutor& get() { static InlineExecutor executor { }; return executor; }
+};
+
+
+/// <summary>
+/// A shared flag which every stage of a task chain checks before starting. Copies refer to the same flag so cancelling any copy
+/// cancels the whole chain, stages which are already running are allowed to finish.
+/// </summary>
+class CancellationToken final
+{
+    public:
+
+        CancellationToken() : m_flag (std::make_shared<std::atomic<bool>> (false)) { }
+
+        /// <summary> Stops any stage which hasn't started yet from running. </summary>
+        void cancel() const             { *m_flag = true; }
+
+        /// <summary> Checks whether the chain has been cancelled. </summary>
+        bool isCancelled() const        { return *m_flag; }
+
+    private:
+
+        std::shared_ptr<std::atomic<bool>> m_flag;  //!< The flag shared by every copy.
+};
+
+
+namespace util
+{
+    /// <summary> The type a continuation of a Task<T> returns, continuations receive the value of the task unless it's a Task<void>. </summary>
+    template <typename T, typename Function> struct ContinuationResult final
+    {
+        using type = typename std::decay<decltype (std::declval<Function&>() (std::declval<T&>()))>::type;
+    };
+
+    template <typename Function> struct ContinuationResult<void, Function> final
+    {
+        using type = typename std::decay<decltype (std::declval<Function&>()())>::type;
+    };
+}
+
+
+/// <summary>
+/// The result of a stage of work which runs on an executor, any object with a post (std::function<void()>) function such as a
+/// ThreadPool or GLThreadQueue. Continuations are attached with then() and run on whichever executor they're given once the
+/// value is ready, which lets loading code read as a sequence of stages while each stage runs on the right thread. Exceptions
+/// skip the remaining stages and are rethrown by get(). Tasks are cheap handles, copies refer to the same result. A Task<void> only
+/// signals completion, its stages return nothing and its continuations take no parameters.
+/// </summary>
+template <typename T> class Task final
+{
+    public:
+
+        #pragma region Constructors
+
+        /// <summary> Creates an invalid task which will never complete. </summary>
+        Task() = default;
+
+        /// <summary> Queues a function on the executor, the task completes with its return value. </summary>
+        /// <param name="executor"> Where the function should run. </param>
+        /// <param name="function"> The work to perform, taking no parameters. </param>
+        /// <param name="token"> Cancels the function and every continuation if it's cancelled before they start. </param>
+        template <typename Executor, typename Function> static Task start (Executor& executor, Function function, CancellationToken token = { });
+
+        /// <summary> Creates a task which completes when setValue() or setError() is called, used to adapt callback-based APIs. </summary>
+        static Task pending (CancellationToken token = { });
+
+        #pragma endregion
+
+        #pragma region Continuations
+
+        /// <summary> Queues a function on the executor once this task has a value, the function receives the value by reference. </summary>
+        /// <returns> A task which completes with the return value of the function, or the error of this task. </returns>
+        template <typename Executor, typename Function> auto then (Executor& executor, Function function) const
+            -> Task<typename util::ContinuationResult<T, Function>::type>;
+
+        /// <summary> Queues a function on the executor once this task has finished, successfully or not. Cancellation doesn't apply. </summary>
+        /// <param name="function"> Receives the finished task, calling get() provides the value or rethrows the error. </param>
+        template <typename Executor, typename Function> void whenDone (Executor& executor, Function function) const;
+
+        #pragma endregion
+
+        #pragma region Results
+
+        bool isValid() const                        { return m_state != nullptr; }
+        const CancellationToken& getToken() const   { return m_state->token; }
+
+        /// <summary> Checks whether the task has finished without blocking. </summary>
+        bool isReady() const;
+
+        /// <summary> Blocks until the task has finished. Never wait on a task from the executor it needs to run on. </summary>
+        void wait() const;
+
+        /// <summary> Waits for the task, returning its value or rethrowing its error. </summary>
+        typename std::add_lvalue_reference<T>::type get() const;
+
+        /// <summary> Completes a pending task with the given value, or none for a Task<void>, ignored if it has already finished. </summary>
+        template <typename... Arguments> void setValue (Arguments&&... value) const;
+
+        /// <summary> Completes a pending task with the given error, ignored if it has already finished. </summary>
+        void setError (std::exception_ptr error) const;
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        template <typename> friend class Task;
+
+        // A Task<void> stores a flag so finished and successful can be told apart the same way as any other task.
+        using Value = typename std::conditional<std::is_void<T>::value, bool, T>::type;
+
+        /// <summary>
+        /// The result shared between every copy of a task and the stage producing it. Continuations are given the state when they run
+        /// rather than holding on to it, so a task which never finishes doesn't keep itself alive.
+        /// </summary>
+        struct State final : std::enable_shared_from_this<State>
+        {
+            std::mutex                                  mutex           { };        //!< Protects every other member.
+            std::condition_variable                     finished        { };        //!< Signalled when the task finishes.
+            bool                                        ready           { false };  //!< Whether the value or error has been set.
+            std::unique_ptr<Value>                      value           { };        //!< The result of a successful stage.
+            std::exception_ptr                          error           { };        //!< The exception of a failed stage.
+            std::vector<std::function<void (State&)>>   continuations   { };        //!< Run once the task finishes.
+            CancellationToken                           token           { };        //!< Shared by every stage of the chain.
+        };
+
+        /// <summary> Sets the result of the state, notifies any waiters and runs the continuations on the calling thread. </summary>
+        static void finish (State& state, std::unique_ptr<Value> value, std::exception_ptr error);
+
+        /// <summary> Runs a stage function unless the chain was cancelled, storing either its value or its exception. </summary>
+        template <typename Function> static void run (State& state, Function& function);
+
+        /// <summary> Calls a stage function, storing what it returns. </summary>
+        template <typename Function> static std::unique_ptr<Value> invoke (Function& function, std::false_type);
+
+        /// <summary> Calls a stage function which returns nothing, storing that it succeeded. </summary>
+        template <typename Function> static std::unique_ptr<Value> invoke (Function& function, std::true_type);
+
+        /// <summary> Calls a continuation with the value of a finished state. </summary>
+        template <typename Function> static typename util::ContinuationResult<T, Function>::type pass (Function& function, State& state, std::false_type);
+
+        /// <summary> Calls a continuation of a Task<void>, which has no value to pass on. </summary>
+        template <typename Function> static typename util::ContinuationResult<T, Function>::type pass (Function& function, State& state, std::true_type);
+
+        /// <summary> Calls the given function once the state finishes, immediately if it already has. </summary>
+        static void onFinished (State& state, std::function<void (State&)> continuation);
+
+        std::shared_ptr<State> m_state { nullptr }; //!< The shared result, null for invalid tasks.
+
+        #pragma endregion
+};
+
+
+namespace util
+{
+    /// <summary> Queues a function on the executor, deducing the task type from its return value. </summary>
+    template <typename Executor, typename Function> auto startTask (Executor& executor, Function function, CancellationToken token = { })
+        -> Task<typename std::decay<decltype (function())>::type>
+    {
+        return Task<typename std::decay<decltype (function())>::type>::start (executor, std::move (function), std::move (token));
+    }
+
+
+    /// <summary> Combines several tasks into one which completes with every value in order, or with the error of the earliest task which failed. </summary>
+    template <typename T> Task<std::vector<T>> whenAll (const std::vector<Task<T>>& tasks, CancellationToken token = { })
+    {
+        auto combined = Task<std::vector<T>>::pending (std::move (token));
+
+        if (tasks.empty())
+        {
+            combined.setValue (std::vector<T> { });
+            return combined;
+        }
+
+        // Each task moves its result into the gathered slots as it finishes. The continuations only refer to the slots and never to
+        // the tasks, which would otherwise keep each other alive. The last task to finish completes the combined task.
+        struct Gathered final
+        {
+            std::atomic<size_t>                 remaining;  //!< How many tasks are still running.
+            std::vector<std::unique_ptr<T>>     values;     //!< The value of each task which succeeded.
+            std::vector<std::exception_ptr>     errors;     //!< The error of each task which failed.
+        };
+
+        auto gathered = std::make_shared<Gathered>();
+        gathered->remaining = tasks.size();
+        gathered->values.resize (tasks.size());
+        gathered->errors.resize (tasks.size());
+
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            tasks[i].whenDone (InlineExecutor::get(), [=] (const Task<T>& task)
+            {
+                try
+                {
+                    gathered->values[i] = std::unique_ptr<T> (new T (std::move (task.get())));
+                }
+
+                catch (...)
+                {
+                    gathered->errors[i] = std::current_exception();
+                }
+
+                if (--gathered->remaining > 0)
+                {
+                    return;
+                }
+
+                std::vector<T> values { };
+                values.reserve (gathered->values.size());
+
+                for (size_t j = 0; j < gathered->values.size(); ++j)
+                {
+                    if (gathered->errors[j])
+                    {
+                        combined.setError (gathered->errors[j]);
+                        return;
+                    }
+
+                    values.push_back (std::move (*gathered->values[j]));
+                }
+
+                combined.setValue (std::move (values));
+            });
+        }
+
+        return combined;
+    }
+}
+
+
+#pragma region Template implementation
+
+template <typename T> template <typename Executor, typename Function> Task<T> Task<T>::start (Executor& executor, Function function, CancellationToken token)
+{
+    auto task = pending (std::move (token));
+    auto state = task.m_state;
+
+    executor.post ([state, function] () mutable { run (*state, function); });
+
+    return task;
+}
+
+
+template <typename T> Task<T> Task<T>::pending (CancellationToken token)
+{
+    Task task { };
+    task.m_state        = std::make_shared<State>();
+    task.m_state->token = std::move (token);
+
+    return task;
+}
+
+
+template <typename T> template <typename Executor, typename Function> auto Task<T>::then (Executor& executor, Function function) const
+    -> Task<typename util::ContinuationResult<T, Function>::type>
+{
+    using Result = typename util::ContinuationResult<T, Function>::type;
+
+    // Continuations share the token so cancelling the chain skips every stage after the current one.
+    auto next           = Task<Result>::pending (m_state->token);
+    auto target         = next.m_state;
+    auto destination    = &executor;
+
+    onFinished (*m_state, [=] (State& antecedent)
+    {
+        // Failures skip the hop to the executor so chains unwind even when the executor is no longer being run.
+        if (antecedent.error || target->token.isCancelled())
+        {
+            Task<Result>::finish (*target, nullptr, antecedent.error ? antecedent.error : std::make_exception_ptr (TaskCancelled { }));
+            return;
+        }
+
+        // Whoever finished the state holds it whilst its continuations run, the stage needs its own hold for after the hop.
+        auto source = antecedent.shared_from_this();
+
+        destination->post ([=] () mutable
+        {
+            auto stage = [&] () { return pass (function, *source, std::is_void<T>()); };
+            Task<Result>::run (*target, stage);
+        });
+    });
+
+    return next;
+}
+
+
+template <typename T> template <typename Executor, typename Function> void Task<T>::whenDone (Executor& executor, Function function) const
+{
+    auto destination = &executor;
+
+    onFinished (*m_state, [=] (State& state)
+    {
+        Task task { };
+        task.m_state = state.shared_from_this();
+
+        destination->post ([=] () mutable { function (task); });
+    });
+}
+
+
+template <typename T> bool Task<T>::isReady() const
+{
+    std::lock_guard<std::mutex> lock { m_state->mutex };
+    return m_state->ready;
+}
+
+
+template <typename T> void Task<T>::wait() const
+{
+    std::unique_lock<std::mutex> lock { m_state->mutex };
+    m_state->finished.wait (lock, [this] () { return m_state->ready; });
+}
+
+
+template <typename T> typename std::add_lvalue_reference<T>::type Task<T>::get() const
+{
+    wait();
+
+    if (m_state->error)
+    {
+        std::rethrow_exception (m_state->error);
+    }
+
+    // A Task<void> discards its flag.
+    return static_cast<typename std::add_lvalue_reference<T>::type> (*m_state->value);
+}
+
+
+template <typename T> template <typename... Arguments> void Task<T>::setValue (Arguments&&... value) const
+{
+    finish (*m_state, std::unique_ptr<Value> (new Value (std::forward<Arguments> (value)...)), nullptr);
+}
+
+
+template <typename T> void Task<T>::setError (std::exception_ptr error) const
+{
+    finish (*m_state, nullptr, std::move (error));
+}
+
+
+template <typename T> void Task<T>::finish (State& state, std::unique_ptr<Value> value, std::exception_ptr error)
+{
+    std::vector<std::function<void (State&)>> continuations { };
+
+    {
+        std::lock_guard<std::mutex> lock { state.mutex };
+
+        if (state.ready)
+        {
+            return;
+        }
+
+        state.value = std::move (value);
+        state.error = std::move (error);
+        state.ready = true;
+        continuations.swap (state.continuations);
+    }
+
+    state.finished.notify_all();
+
+    for (auto& continuation : continuations)
+    {
+        continuation (state);
+    }
+}
+
+
+template <typename T> template <typename Function> void Task<T>::run (State& state, Function& function)
+{
+    if (state.token.isCancelled())
+    {
+        finish (state, nullptr, std::make_exception_ptr (TaskCancelled { }));
+        return;
+    }
+
+    try
+    {
+        auto value = invoke (function, std::is_void<decltype (function())>());
+        finish (state, std::move (value), nullptr);
+    }
+
+    catch (...)
+    {
+        finish (state, nullptr, std::current_exception());
+    }
+}
+
+
+template <typename T> template <typename Function> std::unique_ptr<typename Task<T>::Value> Task<T>::invoke (Function& function, std::false_type)
+{
+    return std::unique_ptr<Value> (new Value (function()));
+}
+
+
+template <typename T> template <typename Function> std::unique_ptr<typename Task<T>::Value> Task<T>::invoke (Function& function, std::true_type)
+{
+    function();
+    return std::unique_ptr<Value> (new Value (true));
+}
+
+
+template <typename T> template <typename Function> 
+typename util::ContinuationResult<T, Function>::type Task<T>::pass (Function& function, State& state, std::false_type)
+{
+    return function (*state.value);
+}
+
+
+template <typename T> template <typename Function> 
+typename util::ContinuationResult<T, Function>::type Task<T>::pass (Function& function, State&, std::true_type)
+{
+    return function();
+}
+
+
+template <typename T> void Task<T>::onFinished (State& state, std::function<void (State&)> continuation)
+{
+    {
+        std::lock_guard<std::mutex> lock { state.mutex };
+
+        if (!state.ready)
+        {
+            state.continuations.push_back (std::move (continuation));
+            return;
+        }
+    }
+
+    continuation (state);
+}
+
+#pragma endregion
+
+#endif // _TASK_
@@ -0,0 +1,205 @@
+#include "TemporalCuller.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+
+
+// Spheres which are visible by less than this are kept for a little longer rather than being tested every time the camera twitches.
+const float minimumMargin = 0.01f;
+
+
+
+#pragma region Culling
+
+void TemporalCuller::setSpheres (std::vector<glm::vec4> spheres)
+{
+    m_spheres = std::move (spheres);
+    m_visible.assign (m_spheres.size(), 1);
+    m_stamps.assign (m_spheres.size(), 0);
+    m_valid = false;
+}
+
+
+void TemporalCuller::setFullTestThresholds (const float distance, const float degrees)
+{
+    m_fullTestDistance  = distance;
+    m_fullTestAngle     = glm::radians (degrees);
+}
+
+
+void TemporalCuller::update (const glm::mat4& projection, const glm::mat4& view, const bool temporal)
+{
+    /// Every plane of the frustum is fixed relative to the camera, so if the camera moves by t the signed distance of any point to a
+    /// plane changes by at most |t|, and if it turns by an angle a the distance of a point d away changes by at most a * d. A sphere
+    /// which was m away from changing visibility therefore can't have changed whilst the camera has moved less than m / 2 and turned
+    /// less than (m / 2) / (d + m / 2) since the test, which are the deadlines placed on the odometers. Moving and turning are measured
+    /// separately because their effect on a sphere depends on its distance. A new projection changes the planes in ways the odometers
+    /// can't describe so everything is tested again, as is the case when the camera jumps or when most deadlines have passed anyway.
+    const auto start = Clock::now();
+
+    // Work out how far the camera moved and turned since the last update.
+    const auto inverse      = glm::inverse (view);
+    const auto position     = glm::vec3 (inverse[3]);
+    const auto rotation     = glm::mat3 (view) * glm::transpose (glm::mat3 (m_view));
+    const auto cosine       = glm::clamp ((rotation[0][0] + rotation[1][1] + rotation[2][2] - 1.f) / 2.f, -1.f, 1.f);
+    const auto moved        = glm::length (position - m_position);
+    const auto turned       = std::acos (cosine);
+
+    m_moved     += moved;
+    m_turned    += turned;
+    m_position  = position;
+    m_view      = view;
+
+    // Extract the planes from the combined matrix, normalised so distances are in world units.
+    const auto combined = projection * view;
+    const auto row      = [&combined] (const int r) { return glm::vec4 (combined[0][r], combined[1][r], combined[2][r], combined[3][r]); };
+
+    m_planes[0] = row (3) + row (0);
+    m_planes[1] = row (3) - row (0);
+    m_planes[2] = row (3) + row (1);
+    m_planes[3] = row (3) - row (1);
+    m_planes[4] = row (3) + row (2);
+    m_planes[5] = row (3) - row (2);
+
+    for (auto& plane : m_planes)
+    {
+        plane /= glm::length (glm::vec3 (plane));
+    }
+
+    if (!temporal || !m_valid || projection != m_projection || moved > m_fullTestDistance || turned > m_fullTestAngle)
+    {
+        m_projection = projection;
+        testAll();
+    }
+
+    else
+    {
+        // Test whatever is due, old deadlines from spheres tested since are skipped.
+        std::vector<std::uint32_t> due { };
+
+        const auto collect = [this, &due] (DeadlineQueue& queue, const double reading)
+        {
+            while (!queue.empty() && queue.top().at <= reading)
+            {
+                const auto deadline = queue.top();
+                queue.pop();
+
+                if (deadline.stamp == m_stamps[deadline.sphere])
+                {
+                    due.push_back (deadline.sphere);
+                }
+            }
+        };
+
+        collect (m_moveDeadlines, m_moved);
+        collect (m_turnDeadlines, m_turned);
+
+        // Once most spheres are due a clean sweep is cheaper than the queues.
+        if (due.size() > m_spheres.size() / 2)
+        {
+            testAll();
+        }
+
+        else
+        {
+            for (const auto sphere : due)
+            {
+                // A sphere can be due on both odometers, the second deadline is out of date after the first test.
+                test (sphere);
+            }
+        }
+    }
+
+    size_t visible { 0 };
+
+    for (const auto flag : m_visible)
+    {
+        visible += flag;
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (Clock::now() - start).count();
+
+    ++m_statistics.frameCount;
+    m_statistics.sphereCount    += m_spheres.size();
+    m_statistics.visibleCount   += visible;
+    m_statistics.totalTime      += milliseconds;
+    m_statistics.maxTime        = std::max (m_statistics.maxTime, milliseconds);
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+void TemporalCuller::printStatistics (std::ostream& stream) const
+{
+    stream  << "Culling: " << m_spheres.size() << " instances, " << m_statistics.frameCount << " frames, " << m_statistics.averageTested()
+            << " tested and " << m_statistics.averageVisible() << " visible per frame, " << m_statistics.fullCount << " full tests, update "
+            << m_statistics.averageTime() << "ms average, " << m_statistics.maxTime << "ms max." << std::endl;
+}
+
+#pragma endregion
+
+
+#pragma region Implementation data
+
+void TemporalCuller::test (const std::uint32_t sphere)
+{
+    const auto& bounds  = m_spheres[sphere];
+    const auto  centre  = glm::vec3 (bounds);
+    const auto  radius  = bounds.w;
+
+    ++m_stamps[sphere];
+    ++m_statistics.testedCount;
+
+    // Spheres without bounds are always drawn and never need testing again.
+    if (radius < 0.f)
+    {
+        m_visible[sphere] = 1;
+        return;
+    }
+
+    // Visible spheres are as far from being culled as their closest plane, culled spheres as far from being visible as their furthest.
+    auto inside     = std::numeric_limits<float>::max();
+    auto outside    = 0.f;
+
+    for (const auto& plane : m_planes)
+    {
+        const auto distance = glm::dot (glm::vec3 (plane), centre) + plane.w + radius;
+
+        inside  = std::min (inside, distance);
+        outside = std::max (outside, -distance);
+    }
+
+    const auto visible  = outside == 0.f;
+    const auto margin   = visible ? std::max (inside, minimumMargin) : outside;
+    const auto distance = glm::length (centre - m_position);
+    const auto stamp    = m_stamps[sphere];
+
+    m_visible[sphere] = visible ? 1 : 0;
+    m_moveDeadlines.push ({ m_moved + margin / 2.0, sphere, stamp });
+    m_turnDeadlines.push ({ m_turned + (margin / 2.0) / (distance + margin / 2.0), sphere, stamp });
+}
+
+
+void TemporalCuller::testAll()
+{
+    m_moveDeadlines = DeadlineQueue { };
+    m_turnDeadlines = DeadlineQueue { };
+
+    for (std::uint32_t sphere = 0; sphere < m_spheres.size(); ++sphere)
+    {
+        test (sphere);
+    }
+
+    m_valid = true;
+    ++m_statistics.fullCount;
+}
+
+#pragma endregion
@@ -0,0 +1,147 @@
+#pragma once
+
+#if !defined    _TEMPORAL_CULLER_
+#define         _TEMPORAL_CULLER_
+
+
+// STL headers.
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <queue>
+#include <vector>
+
+
+// Engine headers.
+#include <glm/gtc/type_ptr.hpp>
+
+
+/// <summary>
+/// Frustum culls bounding spheres while remembering the result between frames. Each test also measures how far the sphere is from
+/// changing visibility, which becomes a deadline on two odometers tracking how far the camera has moved and turned in total. Until the
+/// camera has travelled far enough to pass a deadline the sphere can't have changed visibility, so each frame only the spheres whose
+/// deadlines have passed are tested again. The deadlines are conservative: a sphere which might have become visible is always retested.
+/// </summary>
+class TemporalCuller final
+{
+    public:
+
+        #pragma region Culler types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary>
+        /// How much testing culling is doing since the statistics were last reset. Times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  frameCount      { 0 };      //!< How many frames have been culled.
+            size_t  sphereCount     { 0 };      //!< How many spheres there were across every frame.
+            size_t  testedCount     { 0 };      //!< How many spheres were actually tested across every frame.
+            size_t  visibleCount    { 0 };      //!< How many spheres were visible across every frame.
+            size_t  fullCount       { 0 };      //!< How many frames tested every sphere.
+            double  totalTime       { 0.0 };    //!< The sum of the time each update took.
+            double  maxTime         { 0.0 };    //!< The longest an update took.
+
+            double averageTested() const    { return frameCount > 0 ? testedCount / static_cast<double> (frameCount) : 0.0; }
+            double averageVisible() const   { return frameCount > 0 ? visibleCount / static_cast<double> (frameCount) : 0.0; }
+            double averageTime() const      { return frameCount > 0 ? totalTime / frameCount : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        TemporalCuller()                                        = default;
+        ~TemporalCuller()                                       = default;
+
+        TemporalCuller (TemporalCuller&& move)                  = delete;
+        TemporalCuller& operator= (TemporalCuller&& move)       = delete;
+        TemporalCuller (const TemporalCuller& copy)             = delete;
+        TemporalCuller& operator= (const TemporalCuller& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Culling
+
+        /// <summary> Replaces every sphere, all of them are tested on the next update. </summary>
+        /// <param name="spheres"> The world-space centre and radius of each sphere, a negative radius means always visible. </param>
+        void setSpheres (std::vector<glm::vec4> spheres);
+
+        /// <summary> Forgets every result so the next update tests every sphere. </summary>
+        void invalidate()                               { m_valid = false; }
+
+        /// <summary> Sets how far the camera may move or turn in a single frame before every sphere is tested rather than just those due. </summary>
+        void setFullTestThresholds (const float distance, const float degrees);
+
+        /// <summary> Brings the visibility of every sphere up to date with the given camera. </summary>
+        /// <param name="temporal"> Whether results may be reused, otherwise every sphere is tested. </param>
+        void update (const glm::mat4& projection, const glm::mat4& view, const bool temporal);
+
+        /// <summary> Checks whether a sphere was inside the frustum as of the last update. </summary>
+        bool isVisible (const size_t sphere) const      { return m_visible[sphere] != 0; }
+
+        size_t getSphereCount() const                   { return m_spheres.size(); }
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const                { return m_statistics; }
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics()                          { m_statistics = { }; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> When a sphere must be tested again, entries are discarded if the sphere has been tested since. </summary>
+        struct Deadline final
+        {
+            double          at;     //!< The odometer reading at which the sphere might change visibility.
+            std::uint32_t   sphere; //!< The sphere to test.
+            std::uint32_t   stamp;  //!< The test the deadline came from.
+
+            bool operator> (const Deadline& rhs) const  { return at > rhs.at; }
+        };
+
+        using DeadlineQueue = std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>>;
+
+        /// <summary> Tests a sphere against the current planes, recording its visibility and when it must be tested again. </summary>
+        void test (const std::uint32_t sphere);
+
+        /// <summary> Tests every sphere and starts the deadlines afresh. </summary>
+        void testAll();
+
+        std::vector<glm::vec4>      m_spheres               { };        //!< The centre and radius of each sphere.
+        std::vector<char>           m_visible               { };        //!< Whether each sphere was visible when last tested.
+        std::vector<std::uint32_t>  m_stamps                { };        //!< How many times each sphere has been tested, used to discard old deadlines.
+
+        DeadlineQueue               m_moveDeadlines         { };        //!< Deadlines on the distance the camera has moved.
+        DeadlineQueue               m_turnDeadlines         { };        //!< Deadlines on the angle the camera has turned.
+        double                      m_moved                 { 0.0 };    //!< How far the camera has moved in total.
+        double                      m_turned                { 0.0 };    //!< How far the camera has turned in total, in radians.
+
+        glm::vec4                   m_planes[6];                        //!< The normalised frustum planes, facing inwards.
+        glm::mat4                   m_projection            { 1.f };    //!< The projection the results were calculated with.
+        glm::mat4                   m_view                  { 1.f };    //!< The view of the previous update.
+        glm::vec3                   m_position              { 0.f };    //!< The camera position of the previous update.
+        bool                        m_valid                 { false };  //!< Whether the results describe the current spheres and projection.
+
+        float                       m_fullTestDistance      { 500.f };  //!< How far the camera can move in a frame before everything is tested.
+        float                       m_fullTestAngle         { 0.5f };   //!< How far the camera can turn in a frame before everything is tested, in radians.
+
+        Statistics                  m_statistics            { };        //!< How much testing culling is doing.
+
+        #pragma endregion
+};
+
+#endif // _TEMPORAL_CULLER_
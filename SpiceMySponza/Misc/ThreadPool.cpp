@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+
+
+
+// STL headers.
+#include <algorithm>
+
+
+
+#pragma region Constructors and destructor
+
+ThreadPool::ThreadPool (const unsigned int workers)
+{
+    const auto count = workers != 0 ? workers : std::max (std::thread::hardware_concurrency(), 1U);
+    m_workers.reserve (count);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        m_workers.emplace_back (&ThreadPool::work, this);
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+#pragma endregion
+
+
+#pragma region Jobs
+
+void ThreadPool::post (std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_jobs.push_back (std::move (job));
+    }
+
+    m_wake.notify_one();
+}
+
+
+bool ThreadPool::isWorkerThread() const
+{
+    const auto id = std::this_thread::get_id();
+    return std::any_of (m_workers.begin(), m_workers.end(), [id] (const std::thread& worker) { return worker.get_id() == id; });
+}
+
+
+void ThreadPool::work()
+{
+    while (true)
+    {
+        std::function<void()> job { };
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_wake.wait (lock, [this] () { return m_stopping || !m_jobs.empty(); });
+
+            // Only stop once every job has been run.
+            if (m_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move (m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        try
+        {
+            job();
+        }
+
+        catch (...)
+        {
+            // Posted jobs have nowhere to report errors, submitted jobs report through their future.
+        }
+    }
+}
+
+#pragma endregion
@@ -0,0 +1,91 @@
+#pragma once
+
+#if !defined    _THREAD_POOL_
+#define         _THREAD_POOL_
+
+
+// STL headers.
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/// <summary>
+/// A fixed set of worker threads which run queued jobs in the order they were submitted. Used for any work which shouldn't block the
+/// render thread, such as file reads and image decoding.
+/// </summary>
+class ThreadPool final
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        /// <summary> Starts the worker threads. </summary>
+        /// <param name="workers"> How many threads to start, zero uses one per hardware thread. </param>
+        explicit ThreadPool (const unsigned int workers = 0);
+
+        /// <summary> Finishes every queued job then stops the workers. </summary>
+        ~ThreadPool();
+
+        ThreadPool (ThreadPool&& move)                  = delete;
+        ThreadPool& operator= (ThreadPool&& move)       = delete;
+        ThreadPool (const ThreadPool& copy)             = delete;
+        ThreadPool& operator= (const ThreadPool& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Jobs
+
+        /// <summary> Gets the number of worker threads. </summary>
+        size_t getWorkerCount() const { return m_workers.size(); }
+
+        /// <summary> Queues a job without any way of retrieving its result, exceptions thrown by the job are discarded. </summary>
+        void post (std::function<void()> job);
+
+        /// <summary> Queues a job, the returned future provides its result or rethrows anything it threw. </summary>
+        template <typename Function> auto submit (Function&& function) -> std::future<decltype (function())>;
+
+        /// <summary> Checks whether the calling thread is one of the workers, useful for avoiding waiting on the pool from inside it. </summary>
+        bool isWorkerThread() const;
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> The loop each worker runs until the pool is destroyed. </summary>
+        void work();
+
+        std::vector<std::thread>            m_workers   { };        //!< The worker threads.
+        std::deque<std::function<void()>>   m_jobs      { };        //!< Jobs waiting for a worker.
+        std::mutex                          m_mutex     { };        //!< Protects the job queue and stopping flag.
+        std::condition_variable             m_wake      { };        //!< Signalled when a job is queued or the pool stops.
+        bool                                m_stopping  { false };  //!< Tells the workers to exit once the queue is empty.
+
+        #pragma endregion
+};
+
+
+#pragma region Template implementation
+
+template <typename Function> auto ThreadPool::submit (Function&& function) -> std::future<decltype (function())>
+{
+    // std::function must be copyable so the packaged task is shared.
+    using Result    = decltype (function());
+    auto task       = std::make_shared<std::packaged_task<Result()>> (std::forward<Function> (function));
+    auto future     = task->get_future();
+
+    post ([task] () { (*task)(); });
+
+    return future;
+}
+
+#pragma endregion
+
+#endif // _THREAD_POOL_
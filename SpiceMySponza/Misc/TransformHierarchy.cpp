@@ -0,0 +1,466 @@
+#include "TransformHierarchy.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <utility>
+
+
+
+// Personal headers.
+#include <Misc/ThreadPool.h>
+
+
+
+// The fewest nodes worth handing to a worker, smaller levels are evaluated on the calling thread.
+const size_t jobSize = 512;
+
+
+
+const TransformHierarchy::NodeID TransformHierarchy::noParent;
+
+
+
+namespace
+{
+    /// <summary> Rearranges an array so the element at order[i] moves to i. </summary>
+    template <typename T> void permute (std::vector<T>& array, const std::vector<std::uint32_t>& order)
+    {
+        auto sorted = array;
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            sorted[i] = array[order[i]];
+        }
+
+        array = std::move (sorted);
+    }
+}
+
+
+
+#pragma region Nodes
+
+TransformHierarchy::NodeID TransformHierarchy::addNode (const NodeID parent, const glm::mat4& local)
+{
+    if (parent != noParent && parent >= m_order.size())
+    {
+        return noParent;
+    }
+
+    // New nodes go at the end until the next update sorts them into place.
+    const auto id       = static_cast<NodeID> (m_order.size());
+    const auto index    = static_cast<std::uint32_t> (m_locals.size());
+
+    m_locals.push_back (local);
+    m_worlds.push_back (parent != noParent ? m_worlds[m_order[parent]] * local : local);
+    m_parents.push_back (parent != noParent ? m_order[parent] : noParent);
+    m_firstChild.push_back (0);
+    m_childCounts.push_back (0);
+    m_instanceMeshes.push_back (nullptr);
+    m_instanceSlots.push_back (0);
+    m_dirty.push_back (0);
+    m_ids.push_back (id);
+    m_order.push_back (index);
+
+    m_layoutStale = true;
+
+    return id;
+}
+
+
+bool TransformHierarchy::setParent (const NodeID node, const NodeID parent)
+{
+    if (node >= m_order.size() || (parent != noParent && parent >= m_order.size()))
+    {
+        return false;
+    }
+
+    const auto index        = m_order[node];
+    const auto parentIndex  = parent != noParent ? m_order[parent] : noParent;
+
+    // A node can't become a descendant of itself.
+    for (auto ancestor = parentIndex; ancestor != noParent; ancestor = m_parents[ancestor])
+    {
+        if (ancestor == index)
+        {
+            return false;
+        }
+    }
+
+    m_parents[index]    = parentIndex;
+    m_layoutStale       = true;
+
+    return true;
+}
+
+
+void TransformHierarchy::setLocalTransform (const NodeID node, const glm::mat4& local)
+{
+    const auto index = m_order[node];
+    m_locals[index] = local;
+
+    if (!m_dirty[index])
+    {
+        m_dirty[index] = 1;
+        m_dirtyNodes.push_back (index);
+    }
+}
+
+
+bool TransformHierarchy::attachInstance (const NodeID node, const std::uint32_t mesh, const std::int32_t material)
+{
+    if (node >= m_order.size() || m_instanceMeshes[m_order[node]])
+    {
+        return false;
+    }
+
+    const auto  index       = m_order[node];
+    auto&       instances   = m_meshes[mesh];
+    const auto  slot        = instances.materials.size();
+    const auto  world       = glm::value_ptr (m_worlds[index]);
+
+    instances.materials.push_back (material);
+    instances.transforms.insert (instances.transforms.end(), world, world + 16);
+    instances.dirty.resize ((slot + 64) / 64, 0);
+    ++instances.version;
+
+    m_instanceMeshes[index] = &instances;
+    m_instanceSlots[index]  = static_cast<std::uint32_t> (slot);
+
+    // Make sure the instance receives the world transform once its parents have been updated.
+    if (!m_dirty[index])
+    {
+        m_dirty[index] = 1;
+        m_dirtyNodes.push_back (index);
+    }
+
+    return true;
+}
+
+
+void TransformHierarchy::clear()
+{
+    m_locals.clear();
+    m_worlds.clear();
+    m_parents.clear();
+    m_firstChild.clear();
+    m_childCounts.clear();
+    m_instanceMeshes.clear();
+    m_instanceSlots.clear();
+    m_dirty.clear();
+    m_ids.clear();
+    m_order.clear();
+    m_levels.clear();
+    m_dirtyNodes.clear();
+    m_meshes.clear();
+
+    m_layoutStale = false;
+}
+
+#pragma endregion
+
+
+#pragma region Propagation
+
+void TransformHierarchy::update (ThreadPool* pool)
+{
+    /// Dirty nodes are bucketed by level. Working down from the top, the ranges of each level are merged, recomputed, then replaced by
+    /// the ranges of their children which join the bucket of the next level. Since the children of a range of parents are contiguous,
+    /// a dirty subtree costs one range per level no matter how wide it is, and untouched parts of the hierarchy are never visited.
+    const auto start = Clock::now();
+
+    // Clear the dirty bits of the previous version.
+    for (auto& pair : m_meshes)
+    {
+        auto& instances = pair.second;
+
+        for (const auto word : instances.dirtyWords)
+        {
+            instances.dirty[word] = 0;
+        }
+
+        instances.dirtyWords.clear();
+    }
+
+    std::vector<std::vector<Range>> pending { };
+
+    if (m_layoutStale)
+    {
+        // Everything may have moved so everything is recomputed.
+        rebuildLayout();
+        ++m_statistics.rebuildCount;
+
+        pending.resize (getLevelCount());
+
+        if (!pending.empty())
+        {
+            pending.front().push_back ({ m_levels[0], m_levels[1] });
+        }
+    }
+
+    else
+    {
+        pending.resize (getLevelCount());
+
+        for (const auto index : m_dirtyNodes)
+        {
+            pending[levelOf (index)].push_back ({ index, index + 1 });
+        }
+    }
+
+    for (const auto index : m_dirtyNodes)
+    {
+        m_dirty[index] = 0;
+    }
+
+    m_dirtyNodes.clear();
+
+    size_t evaluated { 0 };
+
+    for (size_t level = 0; level < pending.size(); ++level)
+    {
+        auto& ranges = pending[level];
+
+        if (ranges.empty())
+        {
+            continue;
+        }
+
+        // Merge overlapping and touching ranges so each node is only evaluated once.
+        std::sort (ranges.begin(), ranges.end(), [] (const Range& lhs, const Range& rhs) { return lhs.begin < rhs.begin; });
+
+        std::vector<Range> merged { ranges.front() };
+
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            if (ranges[i].begin <= merged.back().end)
+            {
+                merged.back().end = std::max (merged.back().end, ranges[i].end);
+            }
+
+            else
+            {
+                merged.push_back (ranges[i]);
+            }
+        }
+
+        // Split the level into jobs, the calling thread takes the first rather than sitting idle.
+        std::vector<Range> jobs { };
+
+        for (const auto& range : merged)
+        {
+            for (auto begin = range.begin; begin < range.end; begin += jobSize)
+            {
+                jobs.push_back ({ begin, std::min (range.end, begin + jobSize) });
+            }
+
+            evaluated += range.end - range.begin;
+        }
+
+        std::vector<std::future<void>> futures { };
+
+        if (pool && !pool->isWorkerThread())
+        {
+            for (size_t i = 1; i < jobs.size(); ++i)
+            {
+                const auto job = jobs[i];
+                futures.push_back (pool->submit ([this, job] () { evaluate (job); }));
+            }
+        }
+
+        else
+        {
+            for (size_t i = 1; i < jobs.size(); ++i)
+            {
+                evaluate (jobs[i]);
+            }
+        }
+
+        evaluate (jobs.front());
+
+        for (auto& future : futures)
+        {
+            future.get();
+        }
+
+        // Instances share dirty words so they're written on this thread.
+        for (const auto& range : merged)
+        {
+            writeInstances (range);
+
+            if (level + 1 < pending.size())
+            {
+                const auto last     = range.end - 1;
+                const Range children { m_firstChild[range.begin], m_firstChild[last] + m_childCounts[last] };
+
+                if (children.begin < children.end)
+                {
+                    pending[level + 1].push_back (children);
+                }
+            }
+        }
+    }
+
+    // Meshes which didn't move keep their version so MyView doesn't upload them again.
+    for (auto& pair : m_meshes)
+    {
+        if (!pair.second.dirtyWords.empty())
+        {
+            pair.second.version.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (Clock::now() - start).count();
+
+    ++m_statistics.updateCount;
+    m_statistics.nodeCount  += evaluated;
+    m_statistics.totalTime  += milliseconds;
+    m_statistics.maxTime    = std::max (m_statistics.maxTime, milliseconds);
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+void TransformHierarchy::printStatistics (std::ostream& stream) const
+{
+    stream  << "Transform hierarchy: " << getNodeCount() << " nodes in " << getLevelCount() << " levels, " << m_statistics.updateCount << " updates, "
+            << m_statistics.averageNodes() << " nodes recomputed per update, " << m_statistics.rebuildCount << " rebuilds, update "
+            << m_statistics.averageTime() << "ms average, " << m_statistics.maxTime << "ms max." << std::endl;
+}
+
+#pragma endregion
+
+
+#pragma region Implementation data
+
+void TransformHierarchy::rebuildLayout()
+{
+    const auto count = m_locals.size();
+
+    // Gather the children of every node, in the order they currently sit.
+    std::vector<std::vector<std::uint32_t>> children (count);
+    std::vector<std::uint32_t>              order    { };
+    order.reserve (count);
+
+    for (std::uint32_t index = 0; index < count; ++index)
+    {
+        if (m_parents[index] == noParent)
+        {
+            order.push_back (index);
+        }
+
+        else
+        {
+            children[m_parents[index]].push_back (index);
+        }
+    }
+
+    // Walk breadth-first, recording where each level starts. Children are appended in the order of their parents so siblings stay together.
+    m_levels.assign (1, 0);
+
+    for (size_t begin = 0; begin < order.size(); )
+    {
+        const auto end = order.size();
+
+        for (auto i = begin; i < end; ++i)
+        {
+            const auto& list = children[order[i]];
+            order.insert (order.end(), list.begin(), list.end());
+        }
+
+        m_levels.push_back (end);
+        begin = end;
+    }
+
+    // Move every array into the new order.
+    std::vector<std::uint32_t> position (count);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        position[order[i]] = i;
+    }
+
+    permute (m_locals, order);
+    permute (m_worlds, order);
+    permute (m_parents, order);
+    permute (m_instanceMeshes, order);
+    permute (m_instanceSlots, order);
+    permute (m_ids, order);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        if (m_parents[i] != noParent)
+        {
+            m_parents[i] = position[m_parents[i]];
+        }
+
+        m_order[m_ids[i]] = i;
+    }
+
+    // Each level holds the children of the level above in parent order, so the children of each node directly follow those of the node before it.
+    auto nextChild = static_cast<std::uint32_t> (m_levels.size() > 1 ? m_levels[1] : 0);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        m_firstChild[i]     = nextChild;
+        m_childCounts[i]    = static_cast<std::uint32_t> (children[order[i]].size());
+        nextChild           += m_childCounts[i];
+    }
+
+    // Everything is recomputed so nothing is left pending.
+    std::fill (m_dirty.begin(), m_dirty.end(), 0);
+    m_dirtyNodes.clear();
+    m_layoutStale = false;
+}
+
+
+void TransformHierarchy::evaluate (const Range range)
+{
+    for (auto i = range.begin; i < range.end; ++i)
+    {
+        const auto parent   = m_parents[i];
+        m_worlds[i]         = parent != noParent ? m_worlds[parent] * m_locals[i] : m_locals[i];
+    }
+}
+
+
+void TransformHierarchy::writeInstances (const Range range)
+{
+    for (auto i = range.begin; i < range.end; ++i)
+    {
+        const auto instances = m_instanceMeshes[i];
+
+        if (!instances)
+        {
+            continue;
+        }
+
+        const auto  slot    = m_instanceSlots[i];
+        const auto  word    = slot / 64;
+        auto&       bits    = instances->dirty[word];
+
+        std::memcpy (instances->transforms.data() + slot * 16, glm::value_ptr (m_worlds[i]), sizeof (float) * 16);
+
+        if (bits == 0)
+        {
+            instances->dirtyWords.push_back (word);
+        }
+
+        bits |= std::uint64_t { 1 } << (slot % 64);
+    }
+}
+
+
+size_t TransformHierarchy::levelOf (const size_t index) const
+{
+    // The levels are sorted by where they start, the first level starting after the node is the one after it.
+    return static_cast<size_t> (std::upper_bound (m_levels.begin(), m_levels.end(), index) - m_levels.begin()) - 1;
+}
+
+#pragma endregion
@@ -0,0 +1,185 @@
+#pragma once
+
+#if !defined    _TRANSFORM_HIERARCHY_
+#define         _TRANSFORM_HIERARCHY_
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+
+// Engine headers.
+#include <glm/gtc/type_ptr.hpp>
+
+
+// Forward declarations.
+class ThreadPool;
+
+
+/// <summary>
+/// A scene graph of parent-relative transforms. Nodes are stored breadth-first in parallel arrays, so every level is a contiguous
+/// range and the children of any contiguous range of parents are themselves contiguous. Changing a node marks it dirty and on update
+/// only the ranges below dirty nodes are recomputed, a level at a time with each level split between the workers. Nodes may carry an
+/// instance of a mesh, whose world matrix is written into per-mesh arrays along with a dirty bit, ready to be streamed by MyView.
+/// </summary>
+class TransformHierarchy final
+{
+    public:
+
+        #pragma region Hierarchy types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> Identifies a node, stays the same however the nodes are rearranged. </summary>
+        using NodeID = std::uint32_t;
+
+        /// <summary> The parent of root nodes. </summary>
+        static const NodeID noParent = 0xFFFFFFFF;
+
+        /// <summary> The world matrices and material IDs of the instances of a mesh, ready to be streamed by MyView. </summary>
+        struct MeshInstances final
+        {
+            std::vector<float>              transforms  { };    //!< Sixteen floats per instance.
+            std::vector<std::int32_t>       materials   { };    //!< A material ID per instance.
+            std::vector<std::uint64_t>      dirty       { };    //!< A bit per instance, set if its matrix changed in the latest version.
+            std::atomic<std::uint64_t>      version     { 0 };  //!< Incremented whenever any matrix changes.
+            std::vector<size_t>             dirtyWords  { };    //!< The words of the dirty bits set by the latest update.
+        };
+
+        /// <summary>
+        /// How much work updates are doing since the statistics were last reset. Times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  updateCount     { 0 };      //!< How many updates have run.
+            size_t  nodeCount       { 0 };      //!< How many world matrices have been recomputed across every update.
+            size_t  rebuildCount    { 0 };      //!< How many times the breadth-first layout was rebuilt.
+            double  totalTime       { 0.0 };    //!< The sum of the time each update took.
+            double  maxTime         { 0.0 };    //!< The longest an update took.
+
+            double averageNodes() const     { return updateCount > 0 ? nodeCount / static_cast<double> (updateCount) : 0.0; }
+            double averageTime() const      { return updateCount > 0 ? totalTime / updateCount : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        TransformHierarchy()                                            = default;
+        ~TransformHierarchy()                                           = default;
+
+        TransformHierarchy (TransformHierarchy&& move)                  = delete;
+        TransformHierarchy& operator= (TransformHierarchy&& move)       = delete;
+        TransformHierarchy (const TransformHierarchy& copy)             = delete;
+        TransformHierarchy& operator= (const TransformHierarchy& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Nodes
+
+        /// <summary> Adds a node, which lays the hierarchy out again on the next update. </summary>
+        /// <returns> The ID of the node, or noParent if the parent doesn't exist. </returns>
+        /// <param name="parent"> The node this one moves with, noParent for a root. </param>
+        /// <param name="local"> The transform relative to the parent. </param>
+        NodeID addNode (const NodeID parent, const glm::mat4& local);
+
+        /// <summary> Moves a node and its subtree under another parent, which lays the hierarchy out again on the next update. </summary>
+        /// <returns> False if either node doesn't exist or the parent is part of the subtree. </returns>
+        bool setParent (const NodeID node, const NodeID parent);
+
+        /// <summary> Replaces the parent-relative transform of a node, marking its subtree for the next update. </summary>
+        void setLocalTransform (const NodeID node, const glm::mat4& local);
+
+        /// <summary> Gets the transform of a node relative to its parent. </summary>
+        const glm::mat4& getLocalTransform (const NodeID node) const        { return m_locals[m_order[node]]; }
+
+        /// <summary> Gets the transform of a node in the world as of the last update. </summary>
+        const glm::mat4& getWorldTransform (const NodeID node) const        { return m_worlds[m_order[node]]; }
+
+        /// <summary> Places an instance of a mesh at a node. Adding instances may move the arrays so streams must be set again afterwards. </summary>
+        /// <returns> False if the node doesn't exist or already carries an instance. </returns>
+        bool attachInstance (const NodeID node, const std::uint32_t mesh, const std::int32_t material);
+
+        /// <summary> Removes every node and instance. </summary>
+        void clear();
+
+        size_t getNodeCount() const                                         { return m_locals.size(); }
+        size_t getLevelCount() const                                        { return m_levels.empty() ? 0 : m_levels.size() - 1; }
+
+        /// <summary> Gets the instances of every mesh, keyed by mesh ID. </summary>
+        const std::unordered_map<std::uint32_t, MeshInstances>& getMeshes() const   { return m_meshes; }
+
+        #pragma endregion
+
+        #pragma region Propagation
+
+        /// <summary> Recomputes the world transforms of every dirty subtree and the instances they carry. Call between frames. </summary>
+        /// <param name="pool"> The workers to split large levels between, without one everything is evaluated on the calling thread. </param>
+        void update (ThreadPool* pool);
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const                                    { return m_statistics; }
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics()                                              { m_statistics = { }; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> A run of consecutive nodes in breadth-first order. </summary>
+        struct Range final
+        {
+            size_t  begin;  //!< The first node.
+            size_t  end;    //!< One past the last node.
+        };
+
+        /// <summary> Sorts the nodes breadth-first, keeping siblings together in the order of their parents. </summary>
+        void rebuildLayout();
+
+        /// <summary> Recomputes the world transforms of a range of nodes whose parents are already up to date. </summary>
+        void evaluate (const Range range);
+
+        /// <summary> Writes the world transforms of any instances in a range to their mesh arrays. </summary>
+        void writeInstances (const Range range);
+
+        /// <summary> Finds the level a node belongs to. </summary>
+        size_t levelOf (const size_t index) const;
+
+        // Every array below is indexed in breadth-first order.
+        std::vector<glm::mat4>                              m_locals        { };    //!< The transform of each node relative to its parent.
+        std::vector<glm::mat4>                              m_worlds        { };    //!< The transform of each node in the world.
+        std::vector<std::uint32_t>                          m_parents       { };    //!< The position of the parent of each node, noParent for roots.
+        std::vector<std::uint32_t>                          m_firstChild    { };    //!< Where the children of each node start, or would start if it has none.
+        std::vector<std::uint32_t>                          m_childCounts   { };    //!< How many children each node has.
+        std::vector<MeshInstances*>                         m_instanceMeshes    { };    //!< The mesh each node carries an instance of, if any.
+        std::vector<std::uint32_t>                          m_instanceSlots { };    //!< Where the instance of each node sits in its mesh arrays.
+        std::vector<char>                                   m_dirty         { };    //!< Whether each node has been changed since the last update.
+        std::vector<NodeID>                                 m_ids           { };    //!< The ID of each node.
+
+        std::vector<std::uint32_t>                          m_order         { };    //!< The position of each node by ID.
+        std::vector<size_t>                                 m_levels        { };    //!< Where each level starts, followed by the node count.
+        std::vector<size_t>                                 m_dirtyNodes    { };    //!< Every node changed since the last update.
+        bool                                                m_layoutStale   { false };  //!< Whether nodes have been added or moved since the last update.
+
+        std::unordered_map<std::uint32_t, MeshInstances>    m_meshes        { };    //!< The instances of each mesh.
+        Statistics                                          m_statistics    { };    //!< How much work updates are doing.
+
+        #pragma endregion
+};
+
+#endif // _TRANSFORM_HIERARCHY_
@@ -0,0 +1,86 @@
+#include "ViewSwitcher.h"
+
+
+
+// STL headers.
+#include <cassert>
+#include <utility>
+
+
+
+// Personal headers.
+#include <MyView/MyView.h>
+
+
+
+#pragma region Constructors and destructor
+
+ViewSwitcher::ViewSwitcher (std::vector<std::shared_ptr<MyView>> views)
+    : m_views (std::move (views))
+{
+    assert (!m_views.empty());
+}
+
+#pragma endregion
+
+
+#pragma region Switching
+
+void ViewSwitcher::cycle()
+{
+    m_presented = (m_presented + 1) % m_views.size();
+    m_switched  = true;
+}
+
+#pragma endregion
+
+
+#pragma region Window view delegate
+
+void ViewSwitcher::windowViewWillStart (std::shared_ptr<tygra::Window> window)
+{
+    // The first view uploads the scene, the rest find it in the pool.
+    for (const auto& view : m_views)
+    {
+        static_cast<tygra::WindowViewDelegate&> (*view).windowViewWillStart (window);
+    }
+
+    m_switched = true;
+}
+
+
+void ViewSwitcher::windowViewDidReset (std::shared_ptr<tygra::Window> window, int width, int height)
+{
+    for (const auto& view : m_views)
+    {
+        static_cast<tygra::WindowViewDelegate&> (*view).windowViewDidReset (window, width, height);
+    }
+
+    m_switched = true;
+}
+
+
+void ViewSwitcher::windowViewDidStop (std::shared_ptr<tygra::Window> window)
+{
+    for (const auto& view : m_views)
+    {
+        static_cast<tygra::WindowViewDelegate&> (*view).windowViewDidStop (window);
+    }
+}
+
+
+void ViewSwitcher::windowViewRender (std::shared_ptr<tygra::Window> window)
+{
+    auto& view = *m_views[m_presented];
+
+    // Whichever view started or reset last left its own uniform bindings behind.
+    if (m_switched)
+    {
+        view.restoreContextState();
+        m_switched = false;
+    }
+
+    static_cast<tygra::WindowViewDelegate&> (view).windowViewRender (window);
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#if !defined    _VIEW_SWITCHER_
+#define         _VIEW_SWITCHER_
+
+
+// STL headers.
+#include <memory>
+#include <vector>
+
+
+// Engine headers.
+#include <tygra/WindowViewDelegate.hpp>
+
+
+// Forward declarations.
+class MyView;
+
+
+/// <summary>
+/// Presents one of several views in a window. Every view is started, reset and stopped with the window so they all stay ready, but only
+/// the presented view renders each frame. Views which share a resource pool therefore hold one copy of the scene between them and
+/// switching doesn't load anything. The views share the OpenGL context so the presented view restores its state after a switch.
+/// </summary>
+class ViewSwitcher final : public tygra::WindowViewDelegate
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        ViewSwitcher (std::vector<std::shared_ptr<MyView>> views);
+        ~ViewSwitcher()                                     = default;
+
+        ViewSwitcher (ViewSwitcher&& move)                  = delete;
+        ViewSwitcher& operator= (ViewSwitcher&& move)       = delete;
+        ViewSwitcher (const ViewSwitcher& copy)             = delete;
+        ViewSwitcher& operator= (const ViewSwitcher& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Switching
+
+        /// <summary> Gets the index of the view which renders each frame. </summary>
+        size_t getPresented() const                         { return m_presented; }
+
+        /// <summary> Presents the next view from the next frame onwards, wrapping around after the last. </summary>
+        void cycle();
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Window view delegate
+
+        void windowViewWillStart (std::shared_ptr<tygra::Window> window) override final;
+        void windowViewDidReset (std::shared_ptr<tygra::Window> window, int width, int height) override final;
+        void windowViewDidStop (std::shared_ptr<tygra::Window> window) override final;
+        void windowViewRender (std::shared_ptr<tygra::Window> window) override final;
+
+        #pragma endregion
+
+        #pragma region Implementation data
+
+        std::vector<std::shared_ptr<MyView>>    m_views     { };        //!< Every view the window may present.
+        size_t                                  m_presented { 0 };      //!< The index of the view which renders.
+        bool                                    m_switched  { false };  //!< Whether the presented view must restore its state before rendering.
+
+        #pragma endregion
+};
+
+#endif // _VIEW_SWITCHER_
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "InstanceStream.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+#pragma region Constructors
+
+MyView::InstanceStream::InstanceStream (InstanceStream&& move)
+{
+    *this = std::move (move);
+}
+
+
+MyView::InstanceStream& MyView::InstanceStream::operator= (InstanceStream&& move)
+{
+    // Avoid moving self to self.
+    if (this != &move)
+    {
+        transforms              = move.transforms;
+        transformStride         = move.transformStride;
+        materials               = move.materials;
+        materialStride          = move.materialStride;
+        count                   = move.count;
+        version                 = move.version;
+        dirty                   = move.dirty;
+
+        // Reset primitives.
+        move.transforms         = nullptr;
+        move.materials          = nullptr;
+        move.count              = 0;
+        move.version            = nullptr;
+        move.dirty              = nullptr;
+    }
+
+    return *this;
+}
+
+#pragma endregion
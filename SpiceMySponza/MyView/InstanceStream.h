@@ -0,0 +1,50 @@
+#pragma once
+
+#if !defined    _MY_VIEW_INSTANCE_STREAM_
+#define         _MY_VIEW_INSTANCE_STREAM_
+
+
+// STL headers.
+#include <atomic>
+#include <cstdint>
+
+
+// Personal headers.
+#include <MyView/MyView.h>
+
+
+/// <summary>
+/// Describes instance data which the host application keeps in its own arrays. The renderer reads the arrays in place rather than
+/// pulling each instance through the SceneModel::Context, only copying them into the GPU when the version counter changes. The
+/// arrays are read during windowViewRender so the host should only write to them between frames, incrementing the version after.
+/// When the host also marks which matrices changed, a stream which advances by a single version only uploads those matrices. Material
+/// IDs are only read when the whole stream is uploaded, so a host which changes them should leave the dirty bits out of that version.
+/// </summary>
+struct MyView::InstanceStream final
+{
+    #pragma region Implementation data
+
+    const void*                         transforms      { nullptr };                //!< The first column-major 4x4 float model matrix.
+    size_t                              transformStride { sizeof (float) * 16 };    //!< The distance in bytes between each matrix, tightly packed matrices avoid a copy.
+    const void*                         materials       { nullptr };                //!< The first 32-bit material ID, SceneModel IDs or imported material indices.
+    size_t                              materialStride  { sizeof (std::int32_t) };  //!< The distance in bytes between each material ID.
+    size_t                              count           { 0 };                      //!< How many instances there are.
+    const std::atomic<std::uint64_t>*   version         { nullptr };                //!< Incremented by the host after changing the arrays, without one they're read every frame.
+    const std::uint64_t*                dirty           { nullptr };                //!< Optional, a bit per instance set if its matrix changed in the latest version.
+
+    #pragma endregion
+
+    #pragma region Constructors and destructor
+
+    InstanceStream()                                        = default;
+    InstanceStream (const InstanceStream& copy)             = default;
+    InstanceStream& operator= (const InstanceStream& copy)  = default;
+    ~InstanceStream()                                       = default;
+
+    InstanceStream (InstanceStream&& move);
+    InstanceStream& operator= (InstanceStream&& move);
+
+    #pragma endregion
+};
+
+#endif // _MY_VIEW_INSTANCE_STREAM_
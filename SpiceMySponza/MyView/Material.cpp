@@ -3,10 +3,72 @@
 
 
 // STL headers.
+#include <cmath>
+#include <cstring>
 #include <utility>
 
 
 
+namespace
+{
+    // Half floats hold every integer up to this exactly, larger texture IDs would round to the wrong layer.
+    const float halfIntegerLimit    = 2048.f;
+
+    // The largest finite half float.
+    const float halfLimit           = 65504.f;
+
+
+    /// <summary> Converts a float to the nearest half float, rounding ties to even. </summary>
+    std::uint16_t toHalf (const float value)
+    {
+        std::uint32_t bits { };
+        std::memcpy (&bits, &value, sizeof (bits));
+
+        const auto      sign        = static_cast<std::uint32_t> ((bits >> 16) & 0x8000);
+        const auto      exponent    = static_cast<int> ((bits >> 23) & 0xFF) - 127 + 15;
+        std::uint32_t   mantissa    = bits & 0x7FFFFF;
+
+        // Infinity and NaN keep their meaning, anything too large becomes infinite.
+        if (((bits >> 23) & 0xFF) == 0xFF)
+        {
+            return static_cast<std::uint16_t> (sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+        }
+
+        if (exponent >= 31)
+        {
+            return static_cast<std::uint16_t> (sign | 0x7C00);
+        }
+
+        // Tiny values lose their implicit bit and become denormals, or zero if they're too small even for those.
+        auto shift = 13;
+
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+            {
+                return static_cast<std::uint16_t> (sign);
+            }
+
+            mantissa    |= 0x800000;
+            shift       = 14 - exponent;
+        }
+
+        // Rounding can carry into the exponent, which is exactly the next representable value.
+        auto        half        = (exponent > 0 ? static_cast<std::uint32_t> (exponent) << 10 : 0) | (mantissa >> shift);
+        const auto  remainder   = mantissa & ((1u << shift) - 1);
+        const auto  halfway     = 1u << (shift - 1);
+
+        if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+        {
+            ++half;
+        }
+
+        return static_cast<std::uint16_t> (sign | half);
+    }
+}
+
+
+
 #pragma region Constructors
 
 MyView::Material::Material (Material&& move)
@@ -33,4 +95,65 @@ MyView::Material& MyView::Material::operator= (Material&& move)
     return *this;
 }
 
+#pragma endregion
+
+
+#pragma region Packing
+
+size_t MyView::Material::Hash::operator() (const Material& material) const
+{
+    const float values[] = { material.diffuseColour.x, material.diffuseColour.y, material.diffuseColour.z, material.textureID,
+                             material.specularColour.x, material.specularColour.y, material.specularColour.z, material.shininess };
+
+    size_t hash { 0 };
+
+    for (const auto value : values)
+    {
+        // Negative zero compares equal to zero so they must hash the same.
+        const auto      normalised  = value == 0.f ? 0.f : value;
+        std::uint32_t   bits        { };
+        std::memcpy (&bits, &normalised, sizeof (bits));
+
+        hash = (hash ^ bits) * 16777619U;
+    }
+
+    return hash;
+}
+
+
+bool MyView::Material::operator== (const Material& rhs) const
+{
+    return  diffuseColour == rhs.diffuseColour && textureID == rhs.textureID &&
+            specularColour == rhs.specularColour && shininess == rhs.shininess;
+}
+
+
+bool MyView::Material::fitsHalfPrecision() const
+{
+    const float values[] = { diffuseColour.x, diffuseColour.y, diffuseColour.z, specularColour.x, specularColour.y, specularColour.z, shininess };
+
+    for (const auto value : values)
+    {
+        if (!(std::abs (value) <= halfLimit))
+        {
+            return false;
+        }
+    }
+
+    return textureID < halfIntegerLimit && textureID == std::floor (textureID);
+}
+
+
+void MyView::Material::packHalf (std::uint16_t* const texels) const
+{
+    texels[0] = toHalf (diffuseColour.x);
+    texels[1] = toHalf (diffuseColour.y);
+    texels[2] = toHalf (diffuseColour.z);
+    texels[3] = toHalf (textureID);
+    texels[4] = toHalf (specularColour.x);
+    texels[5] = toHalf (specularColour.y);
+    texels[6] = toHalf (specularColour.z);
+    texels[7] = toHalf (shininess);
+}
+
 #pragma endregion
\ No newline at end of file
@@ -4,6 +4,10 @@
 #define         _MY_VIEW_MATERIAL_
 
 
+// STL headers.
+#include <cstdint>
+
+
 // Engine headers.
 #include <glm/gtc/type_ptr.hpp>
 
@@ -37,6 +41,26 @@ struct MyView::Material final
     Material& operator= (Material&& move);
 
     #pragma endregion
+
+    #pragma region Packing
+
+    /// <summary> Hashes the value of a material so identical materials can share a slot in the material buffer. </summary>
+    struct Hash final
+    {
+        size_t operator() (const Material& material) const;
+    };
+
+    /// <summary> Compares every value, materials which are equal are drawn identically. </summary>
+    bool operator== (const Material& rhs) const;
+
+    /// <summary> Checks whether half floats can hold every value, texture IDs must stay exact and colours within range. </summary>
+    bool fitsHalfPrecision() const;
+
+    /// <summary> Writes the material as two RGBA16F texels, laid out the same as the two RGBA32F texels of the full material. </summary>
+    /// <param name="texels"> Eight half floats to write to. </param>
+    void packHalf (std::uint16_t* const texels) const;
+
+    #pragma endregion
 };
 
 #endif // _MY_VIEW_MATERIAL_
\ No newline at end of file
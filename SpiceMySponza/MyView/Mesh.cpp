@@ -3,10 +3,16 @@
 
 
 // STL headers.
+#include <algorithm>
 #include <utility>
 
 
 
+// Personal headers.
+#include <Misc/Vertex.h>
+
+
+
 #pragma region Constructors
 
 MyView::Mesh::Mesh (Mesh&& move)
@@ -23,13 +29,56 @@ MyView::Mesh& MyView::Mesh::operator= (Mesh&& move)
         verticesIndex       = move.verticesIndex;
         elementsOffset      = std::move (move.elementsOffset);
         elementCount        = move.elementCount;
+        strips              = move.strips;
+        vertexCount         = move.vertexCount;
+        centre              = move.centre;
+        radius              = move.radius;
+        extent              = move.extent;
 
         // Reset primitives.
         move.verticesIndex  = 0;
         move.elementCount   = 0;
+        move.strips         = false;
+        move.vertexCount    = 0;
+        move.radius         = -1.f;
     }
 
     return *this;
 }
 
+#pragma endregion
+
+
+#pragma region Bounds
+
+void MyView::Mesh::setBounds (const Vertex* const vertices, const size_t count)
+{
+    if (count == 0)
+    {
+        centre = glm::vec3 (0.f);
+        radius = -1.f;
+        extent = glm::vec3 (0.f);
+        return;
+    }
+
+    // The centre of the bounding box is a tight enough centre for the architecture of a scene.
+    auto lower = vertices[0].position;
+    auto upper = vertices[0].position;
+
+    for (size_t i = 1; i < count; ++i)
+    {
+        lower = glm::min (lower, vertices[i].position);
+        upper = glm::max (upper, vertices[i].position);
+    }
+
+    centre = (lower + upper) / 2.f;
+    extent = (upper - lower) / 2.f;
+    radius = 0.f;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        radius = std::max (radius, glm::length (vertices[i].position - centre));
+    }
+}
+
 #pragma endregion
\ No newline at end of file
@@ -4,6 +4,10 @@
 #define         _MY_VIEW_MESH_
 
 
+// Engine headers.
+#include <glm/gtc/type_ptr.hpp>
+
+
 // Personal headers.
 #include <MyView/MyView.h>
 
@@ -20,9 +24,14 @@ struct MyView::Mesh final
 {
     #pragma region Implementation data
 
-    GLint   verticesIndex   { 0 };  //!< The index of a VBO where the vertices for the mesh begin.
-    GLint   elementsOffset  { 0 };  //!< An offset in bytes used to draw the mesh in the scene.
-    size_t  elementCount    { 0 };  //!< Indicates how many elements there are.
+    GLint       verticesIndex   { 0 };      //!< The index of a VBO where the vertices for the mesh begin.
+    size_t      elementsOffset  { 0 };      //!< An offset in bytes used to draw the mesh in the scene, wide enough for element buffers beyond 2 GiB.
+    size_t      elementCount    { 0 };      //!< Indicates how many elements there are.
+    size_t      vertexCount     { 0 };      //!< How many vertices the mesh has from verticesIndex onwards.
+    bool        strips          { false };  //!< Whether the elements are triangle strips separated by restart indices rather than a triangle list.
+    glm::vec3   centre          { 0.f };    //!< The centre of the bounding sphere in model space.
+    float       radius          { -1.f };   //!< The radius of the bounding sphere, negative if the mesh has no bounds and can't be culled.
+    glm::vec3   extent          { 0.f };    //!< Half the size of the bounding box in model space, the box shares its centre with the sphere.
 
     #pragma endregion
 
@@ -37,6 +46,13 @@ struct MyView::Mesh final
     Mesh& operator= (Mesh&& move);
 
     #pragma endregion
+
+    #pragma region Bounds
+
+    /// <summary> Fits the bounding box and sphere around the given vertices, the sphere is centred on the box. </summary>
+    void setBounds (const Vertex* const vertices, const size_t count);
+
+    #pragma endregion
 };
 
 #endif // _MY_VIEW_MESH_
\ No newline at end of file
@@ -3,14 +3,23 @@
 
 
 // STL headers.
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_set>
 #include <utility>
 
 
 
 // Engine headers.
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <SceneModel/SceneModel.hpp>
 #include <tgl/tgl.h>
 #include <tygra/FileHelper.hpp>
@@ -18,15 +27,244 @@
 
 
 // Personal headers.
+#include <Import/ImportedScene.h>
+#include <Import/SceneDiff.h>
+#include <Import/SceneModelTables.h>
+#include <Import/SceneReferences.h>
+#include <Misc/AsyncFileReader.h>
+#include <Misc/FramePacer.h>
+#include <Misc/GLThreadQueue.h>
+#include <Misc/RenderServer.h>
+#include <Misc/SimulationChannel.h>
+#include <Misc/TemporalCuller.h>
+#include <Misc/ThreadPool.h>
 #include <Misc/Vertex.h>
+#include <MyView/InstanceStream.h>
 #include <MyView/Material.h>
 #include <MyView/Mesh.h>
+#include <MyView/Prefab.h>
+#include <MyView/ResourcePool.h>
+#include <MyView/SceneResources.h>
 #include <MyView/UniformData.h>
+#include <MyView/VirtualTextures.h>
+#include <Utility/ImageDeduplication.h>
+#include <Utility/ImageEncoder.h>
+#include <Utility/Maths.h>
 #include <Utility/OpenGL.h>
 #include <Utility/SceneModel.h>
 
 
 
+// The texture layer of an imported texture which hasn't been loaded because nothing referenced it, -1 means it failed to load.
+const float unloadedTexture = -2.f;
+
+// Identifies the assets of sponza in a resource pool, SceneModel always reads them from this file.
+const auto sponzaResources = "sponza.tcf";
+
+// The shaders used by the program.
+const auto vertexShaderLocation     = "sponza_vs.glsl";
+const auto fragmentShaderLocation   = "sponza_fs.glsl";
+
+// The shaders which reproject the panorama.
+const auto panoramaVertexLocation   = "panorama_vs.glsl";
+const auto panoramaFragmentLocation = "panorama_fs.glsl";
+
+// The location of the depth pre-pass shaders.
+const auto depthVertexLocation      = "depth_vs.glsl";
+const auto depthFragmentLocation    = "depth_fs.glsl";
+
+// The shader which captures static instances in world space.
+const auto captureVertexLocation    = "capture_vs.glsl";
+
+// The shaders of the wireframe overlay, the geometry shader gives each triangle its barycentric co-ordinates.
+const auto wireframeVertexLocation      = "wireframe_vs.glsl";
+const auto wireframeGeometryLocation    = "wireframe_gs.glsl";
+const auto wireframeFragmentLocation    = "wireframe_fs.glsl";
+
+// Below this attenuation the smoothstepped wire adds less than one step of an 8-bit colour, 3a^2 - 2a^3 < 1/256.
+const float wireframeCutoff         = 0.036f;
+
+// The shader which draws the bounding boxes of occlusion queries, only depth is tested so the pre-pass fragment shader is reused.
+const auto occlusionVertexLocation  = "occlusion_vs.glsl";
+
+// A box costs 12 triangles an instance, meshes with fewer triangles than this an instance are cheaper to draw than to query.
+const size_t occlusionMinTriangles  = 256;
+
+// Boxes are grown by this fraction of the bounding radius so their faces never share a depth with the surfaces of the mesh.
+const float occlusionPadding        = 0.01f;
+
+// Meshes whose last eight results were all visible are only queried once every few frames, they're drawn unconditionally in between.
+const unsigned int occlusionVisibleHistory  = 0xff;
+const size_t occlusionVisibleInterval       = 4;
+
+// Each captured vertex holds a world position, a world normal, a texture co-ordinate and the index of its instance.
+const GLsizei cachedVertexSize      = 36;
+
+// How far the camera can move from where the panorama was rendered before the parallax gives it away.
+const float panoramaTolerance       = 0.5f;
+
+// The feedback pass is drawn at this fraction of the width and height of the window.
+const GLsizei feedbackScale         = 8;
+
+// The largest face the panorama may have, a full screen of pixels at a narrow field of view would need enormous faces.
+const GLsizei panoramaMaxSize       = 2048;
+
+// Every shader the programs are built from, they're always read together so reloading rebuilds every program.
+const char* const shaderLocations[] =
+{
+    vertexShaderLocation, fragmentShaderLocation,
+    panoramaVertexLocation, panoramaFragmentLocation,
+    depthVertexLocation, depthFragmentLocation,
+    captureVertexLocation,
+    wireframeVertexLocation, wireframeGeometryLocation, wireframeFragmentLocation,
+    occlusionVertexLocation
+};
+
+
+
+namespace
+{
+    /// <summary> Creates the indices 0 to count - 1 in order. </summary>
+    std::vector<size_t> sequence (const size_t count)
+    {
+        std::vector<size_t> indices (count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            indices[i] = i;
+        }
+
+        return indices;
+    }
+
+
+    /// <summary> Gives each point the Morton code of where it lies within the bounding box of every point. </summary>
+    std::vector<std::uint32_t> mortonCodes (const std::vector<glm::vec3>& points)
+    {
+        auto lower = glm::vec3 (std::numeric_limits<float>::max());
+        auto upper = -lower;
+
+        for (const auto& point : points)
+        {
+            lower = glm::min (lower, point);
+            upper = glm::max (upper, point);
+        }
+
+        // Flat axes, such as the floor of a scene with a single storey, contribute nothing.
+        const auto extent = glm::max (upper - lower, glm::vec3 (1e-6f));
+
+        std::vector<std::uint32_t> codes { };
+        codes.reserve (points.size());
+
+        for (const auto& point : points)
+        {
+            const auto unit = (point - lower) / extent;
+            codes.push_back (util::mortonCode (unit.x, unit.y, unit.z));
+        }
+
+        return codes;
+    }
+
+
+    /// <summary> Sorts the indices of the points along a Z-order curve, ties keep their original order. </summary>
+    std::vector<size_t> mortonOrder (const std::vector<glm::vec3>& points)
+    {
+        const auto  codes = mortonCodes (points);
+        auto        order = sequence (points.size());
+
+        std::stable_sort (order.begin(), order.end(), [&codes] (const size_t lhs, const size_t rhs) { return codes[lhs] < codes[rhs]; });
+
+        return order;
+    }
+
+
+    /// <summary> Places the bounding sphere of a mesh in world space, a negative radius means the mesh is unbounded and stays so. </summary>
+    glm::vec4 worldSphere (const glm::mat4& model, const glm::vec3& centre, const float radius)
+    {
+        // Scaling grows the sphere by the largest scale of any axis.
+        const auto scale = std::max (glm::length (glm::vec3 (model[0])), std::max (glm::length (glm::vec3 (model[1])), glm::length (glm::vec3 (model[2]))));
+
+        return glm::vec4 (glm::vec3 (model * glm::vec4 (centre, 1.f)), radius < 0.f ? -1.f : radius * scale);
+    }
+
+
+    /// <summary> Finds how far a light reaches before its attenuation falls below the cutoff, directional lights reach everywhere. </summary>
+    float lightRange (const Light& light, const float cutoff)
+    {
+        const auto unbounded = std::numeric_limits<float>::infinity();
+
+        if (static_cast<LightType> (static_cast<int> (light.type)) == LightType::Directional)
+        {
+            return unbounded;
+        }
+
+        // Solve Kq * d * d + Kl * d + Kc = 1 / cutoff for d, spot lights are never brighter than a point light with the same co-efficients.
+        const auto c = light.aConstant - 1.f / cutoff;
+
+        if (light.aQuadratic > 0.f)
+        {
+            return (-light.aLinear + std::sqrt (light.aLinear * light.aLinear - 4.f * light.aQuadratic * c)) / (2.f * light.aQuadratic);
+        }
+
+        return light.aLinear > 0.f ? -c / light.aLinear : unbounded;
+    }
+
+
+    /// <summary> Grows half the size of a bounding box so the box stands clear of every surface it surrounds. </summary>
+    glm::vec3 paddedExtent (const glm::vec3& extent, const float radius)
+    {
+        return extent + glm::vec3 (radius * occlusionPadding);
+    }
+}
+
+
+
+/// <summary>
+/// A camera to draw the scene from and where in the framebuffer to draw it.
+/// </summary>
+struct MyView::SceneView final
+{
+    glm::mat4   projection  { 1.f };    //!< The projection matrix of the view.
+    glm::mat4   view        { 1.f };    //!< The view matrix of the view.
+    glm::vec3   position    { 0.f };    //!< The world-space position of the camera.
+    GLint       x           { 0 };      //!< The left edge of the viewport.
+    GLint       y           { 0 };      //!< The bottom edge of the viewport.
+    GLsizei     width       { 0 };      //!< The width of the viewport.
+    GLsizei     height      { 0 };      //!< The height of the viewport.
+    bool        cull        { false };  //!< Whether the instances of the scene should be culled against the frustum of the view.
+    bool        occlusion   { false };  //!< Whether large meshes are drawn conditionally on occlusion queries, which are then issued again.
+};
+
+
+
+/// <summary>
+/// A stream of instances owned by the host along with the buffers it has been uploaded to.
+/// </summary>
+struct MyView::StreamedInstances final
+{
+    InstanceStream  stream          { };        //!< Where the host keeps the instance data.
+    GLuint          transforms      { 0 };      //!< The model matrices of the instances.
+    SamplerBuffer   materialIDs     { };        //!< The material IDs of the instances, resolved to material buffer IDs.
+    std::uint64_t   version         { 0 };      //!< The version of the stream when it was last uploaded.
+    size_t          materialVersion { 0 };      //!< The version of the material slots the material IDs were resolved with.
+    bool            uploaded        { false };  //!< Whether the buffers contain any version of the stream.
+    bool            hasMaterials    { true };   //!< Whether material IDs are uploaded, prefab placements take theirs from the entries.
+};
+
+
+
+/// <summary>
+/// A prefab along with the placements streamed by the host. Only the transforms of the placements are uploaded, each entry is drawn
+/// with the same buffer and the entry transform and material are supplied as uniforms.
+/// </summary>
+struct MyView::PrefabInstances final
+{
+    Prefab              prefab      { };    //!< The entries to draw at each placement.
+    StreamedInstances   placements  { };    //!< Where the host keeps the placements and the buffer they're uploaded to.
+};
+
+
+
 #pragma region Constructors and destructor
 
 MyView::MyView (MyView&& move)
@@ -49,35 +287,173 @@ MyView& MyView::operator= (MyView&& move)
         m_program               = move.m_program;
 
         m_sceneVAO              = move.m_sceneVAO;
-        m_vertexVBO             = move.m_vertexVBO;
-        m_elementVBO            = move.m_elementVBO;
         m_uniformUBO            = move.m_uniformUBO;
-        m_textureArray          = move.m_textureArray;
-        m_materials             = std::move (move.m_materials);
         
         m_instancePoolSize      = move.m_instancePoolSize;
         m_poolTransforms        = move.m_poolTransforms;
         m_poolMaterialIDs       = std::move (move.m_poolMaterialIDs);
         
         m_aspectRatio           = move.m_aspectRatio;
+        m_viewportWidth         = move.m_viewportWidth;
+        m_viewportHeight        = move.m_viewportHeight;
+        m_viewOffset            = move.m_viewOffset;
+        m_viewStride            = move.m_viewStride;
+        m_viewCapacity          = move.m_viewCapacity;
 
         m_scene                 = std::move (move.m_scene);
-        m_meshes                = std::move (move.m_meshes);
-        m_materials             = std::move (move.m_materials);
+        m_content               = std::move (move.m_content);
+        m_resources             = std::move (move.m_resources);
+        m_resourcePool          = std::move (move.m_resourcePool);
+        m_instanceStreams       = std::move (move.m_instanceStreams);
+        m_prefabs               = std::move (move.m_prefabs);
+
+        m_imported              = std::move (move.m_imported);
+        m_instanceMaterials     = std::move (move.m_instanceMaterials);
+        m_instanceMatrices      = std::move (move.m_instanceMatrices);
+        m_sceneInstances        = std::move (move.m_sceneInstances);
+        m_meshVersion           = move.m_meshVersion;
+        m_missingMeshes         = std::move (move.m_missingMeshes);
+        m_missingMaterials      = std::move (move.m_missingMaterials);
+        m_unknownMeshes         = std::move (move.m_unknownMeshes);
+        m_unknownMaterials      = std::move (move.m_unknownMaterials);
+        m_lateMeshes            = move.m_lateMeshes;
+        m_lateMaterials         = move.m_lateMaterials;
+
+        m_pendingScene          = std::move (move.m_pendingScene);
+        m_pendingDiff           = std::move (move.m_pendingDiff);
+        m_pendingContent        = std::move (move.m_pendingContent);
+        m_pendingTables         = std::move (move.m_pendingTables);
+
+        m_reader                = std::move (move.m_reader);
+        m_glQueue               = std::move (move.m_glQueue);
+        m_shaderReload          = std::move (move.m_shaderReload);
+        m_simulation            = std::move (move.m_simulation);
+        m_pacer                 = std::move (move.m_pacer);
+        m_frameFences           = std::move (move.m_frameFences);
+
+        m_server                = std::move (move.m_server);
+        m_serverFramebuffer     = move.m_serverFramebuffer;
+        m_serverColour          = move.m_serverColour;
+        m_serverDepth           = move.m_serverDepth;
+        m_serverWidth           = move.m_serverWidth;
+        m_serverHeight          = move.m_serverHeight;
+        m_serverEncodes         = std::move (move.m_serverEncodes);
+
+        m_culler                = std::move (move.m_culler);
+        m_cullOffsets           = std::move (move.m_cullOffsets);
+        m_cullSource            = move.m_cullSource;
+        m_cullInstances         = move.m_cullInstances;
+        m_cullingMode           = move.m_cullingMode;
+
+        m_virtualTexturing      = move.m_virtualTexturing;
+        m_mergeSimilar          = move.m_mergeSimilar;
+        m_stripification        = move.m_stripification;
+        m_feedbackFramebuffer   = move.m_feedbackFramebuffer;
+        m_feedbackTarget        = move.m_feedbackTarget;
+        m_feedbackDepth         = move.m_feedbackDepth;
+        m_feedbackWidth         = move.m_feedbackWidth;
+        m_feedbackHeight        = move.m_feedbackHeight;
+        m_feedbackFrame         = move.m_feedbackFrame;
+        std::copy (move.m_feedbackBuffers, move.m_feedbackBuffers + 2, m_feedbackBuffers);
+        std::copy (move.m_feedbackSizes, move.m_feedbackSizes + 2, m_feedbackSizes);
+
+        m_depthPrepass          = move.m_depthPrepass;
+        m_depthProgram          = move.m_depthProgram;
+        m_depthVAO              = move.m_depthVAO;
+
+        m_transformCache        = move.m_transformCache;
+        m_cacheValid            = move.m_cacheValid;
+        m_captureProgram        = move.m_captureProgram;
+        m_cacheVAO              = move.m_cacheVAO;
+        m_cacheVBO              = move.m_cacheVBO;
+        m_cacheMaterialIDs      = std::move (move.m_cacheMaterialIDs);
+        m_cacheBases            = std::move (move.m_cacheBases);
+        m_cacheVertices         = move.m_cacheVertices;
+        m_cacheCaptures         = move.m_cacheCaptures;
+        m_cacheTime             = move.m_cacheTime;
+
+        m_occlusionQueries      = move.m_occlusionQueries;
+        m_occlusionProgram      = move.m_occlusionProgram;
+        m_occlusionVAO          = move.m_occlusionVAO;
+        m_occlusionTransforms   = move.m_occlusionTransforms;
+        m_occlusion             = std::move (move.m_occlusion);
+        m_occlusionPending      = std::move (move.m_occlusionPending);
+        m_occlusionMatrices     = std::move (move.m_occlusionMatrices);
+        m_occlusionFrame        = move.m_occlusionFrame;
+        m_occlusionIssued       = move.m_occlusionIssued;
+        m_occlusionResults      = move.m_occlusionResults;
+        m_occlusionHidden       = move.m_occlusionHidden;
+
+        m_panoramaMode          = move.m_panoramaMode;
+        m_panoramaValid         = move.m_panoramaValid;
+        m_panoramaProgram       = move.m_panoramaProgram;
+        m_panoramaVAO           = move.m_panoramaVAO;
+        m_panoramaFramebuffer   = move.m_panoramaFramebuffer;
+        m_panoramaColour        = move.m_panoramaColour;
+        m_panoramaDepth         = move.m_panoramaDepth;
+        m_panoramaSize          = move.m_panoramaSize;
+        m_panoramaLighting      = std::move (move.m_panoramaLighting);
+        m_panoramaRenders       = move.m_panoramaRenders;
+        m_panoramaReuses        = move.m_panoramaReuses;
+        std::copy (move.m_panoramaPosition, move.m_panoramaPosition + 3, m_panoramaPosition);
+
+        m_wireframeMode         = move.m_wireframeMode;
+        m_wireframeType         = move.m_wireframeType;
+        m_wireframeProgram      = move.m_wireframeProgram;
 
         // Reset primitives.
         move.m_program          = 0;
 
         move.m_sceneVAO         = 0;
-        move.m_vertexVBO        = 0;
-        move.m_elementVBO       = 0;
         move.m_uniformUBO       = 0;
-        move.m_textureArray     = 0;
 
         move.m_instancePoolSize = 0;
         move.m_poolTransforms   = 0;
 
         move.m_aspectRatio      = 0.f;
+        move.m_viewportWidth    = 0;
+        move.m_viewportHeight   = 0;
+        move.m_viewOffset       = 0;
+        move.m_viewStride       = 0;
+        move.m_viewCapacity     = 0;
+
+        move.m_serverFramebuffer    = 0;
+        move.m_serverColour         = 0;
+        move.m_serverDepth          = 0;
+        move.m_serverWidth          = 0;
+        move.m_serverHeight         = 0;
+
+        move.m_cullSource           = nullptr;
+        move.m_cullInstances        = 0;
+
+        move.m_feedbackFramebuffer  = 0;
+        move.m_feedbackTarget       = 0;
+        move.m_feedbackDepth        = 0;
+        move.m_feedbackWidth        = 0;
+        move.m_feedbackHeight       = 0;
+        move.m_feedbackFrame        = 0;
+
+        move.m_depthProgram         = 0;
+        move.m_depthVAO             = 0;
+
+        move.m_cacheValid           = false;
+        move.m_captureProgram       = 0;
+        move.m_cacheVAO             = 0;
+        move.m_cacheVBO             = 0;
+
+        move.m_occlusionProgram     = 0;
+        move.m_occlusionVAO         = 0;
+        move.m_occlusionTransforms  = 0;
+
+        move.m_panoramaValid        = false;
+        move.m_panoramaProgram      = 0;
+        move.m_panoramaVAO          = 0;
+        move.m_panoramaFramebuffer  = 0;
+        move.m_panoramaColour       = 0;
+        move.m_panoramaDepth        = 0;
+        move.m_panoramaSize         = 0;
+
+        move.m_wireframeProgram     = 0;
     }
 
     return *this;
@@ -113,644 +489,4237 @@ MyView::SamplerBuffer& MyView::SamplerBuffer::operator= (SamplerBuffer&& move)
 
 void MyView::setScene (std::shared_ptr<const SceneModel::Context> scene)
 {
-    m_scene = scene;
+    m_scene     = scene;
+    m_content   = scene;
 }
 
 
-void MyView::rebuildShaders()
+void MyView::setImportedScene (std::shared_ptr<const ImportedScene> scene)
 {
-    // We should be able to simply delete our current program, rebuild it and reset the VAO.
-    glDeleteProgram (m_program);
+    m_imported = scene;
+}
 
-    buildProgram();
-    bindUniformBufferObject();
-    constructVAO();
+
+void MyView::updateImportedScene (std::shared_ptr<const ImportedScene> scene, std::shared_ptr<const SceneDiff> diff)
+{
+    m_pendingScene  = scene;
+    m_pendingDiff   = diff;
 }
 
-#pragma endregion
 
+void MyView::updateSceneContent (std::shared_ptr<const SceneModel::Context> content, std::shared_ptr<const SceneModelTables> tables, std::shared_ptr<const SceneDiff> diff)
+{
+    m_pendingContent    = content;
+    m_pendingTables     = tables;
+    m_pendingDiff       = diff;
+}
 
-#pragma region Scene construction
 
-void MyView::windowViewWillStart (std::shared_ptr<tygra::Window> window)
+void MyView::setResourcePool (std::shared_ptr<ResourcePool> pool)
 {
-    assert (m_scene != nullptr);
-    
-    // Set up OpenGL as required by the application!
-    glEnable (GL_DEPTH_TEST);
-    glEnable (GL_CULL_FACE);
-    glClearColor (0.f, 0.1f, 0.f, 0.f);
-    
-    // Attempt to build the program, if it fails the user can reload after correcting any syntax errors.
-    buildProgram();
+    m_resourcePool = pool;
+}
 
-    // Generate the buffers.
-    generateOpenGLObjects();
 
-    // Retrieve the Sponza data ready for rendering.
-    buildMeshData();
-    
-    // Allocate the required run-time memory for instancing.
-    allocateExtraBuffers();
+void MyView::setVirtualTexturing (const bool enabled)
+{
+    m_virtualTexturing = enabled;
+}
 
-    // Ensure we have the required materials.
-    buildMaterialData();
 
-    // Prepare the UBO for usage.
-    bindUniformBufferObject();
+void MyView::setSimilarTextureMerging (const bool enabled)
+{
+    m_mergeSimilar = enabled;
+}
 
-    // Now we can construct the VAO so we're reading for rendering.
-    constructVAO();
+
+void MyView::setDepthPrepass (const bool enabled)
+{
+    m_depthPrepass = enabled;
 }
 
 
-bool MyView::buildProgram()
+void MyView::setStripification (const bool enabled)
 {
-    // Create the program to attach shaders to.
-    m_program                                       = glCreateProgram();
+    m_stripification = enabled;
+}
 
-    // Attempt to compile the shaders.
-    const auto vertexShaderLocation                 = "sponza_vs.glsl";
-    const auto fragmentShaderLocation               = "sponza_fs.glsl";
-    
-    const auto vertexShader                         = util::compileShaderFromFile (vertexShaderLocation, GL_VERTEX_SHADER);
-    const auto fragmentShader                       = util::compileShaderFromFile (fragmentShaderLocation, GL_FRAGMENT_SHADER);
-    
-    // Attach the shaders to the program we created.
-    const std::vector<GLchar*> vertexAttributes     = { "position", "normal", "textureCoord", "model", "pvm" };
-    const std::vector<GLchar*> fragmentAttributes   = {  };
 
-    util::attachShader (m_program, vertexShader, vertexAttributes);
-    util::attachShader (m_program, fragmentShader, fragmentAttributes);
+void MyView::setTransformCache (const bool enabled)
+{
+    m_transformCache = enabled;
+}
 
-    // Link the program
-    if (util::linkProgram (m_program))
-    {
-        std::cout << "OpenGL application built successfully." << std::endl;
-        return true;
-    }
 
-    return false;
+void MyView::setOcclusionQueries (const bool enabled)
+{
+    m_occlusionQueries = enabled;
 }
 
 
-void MyView::generateOpenGLObjects()
+void MyView::setFramePacer (std::shared_ptr<FramePacer> pacer)
 {
-    glGenVertexArrays (1, &m_sceneVAO);
+    m_pacer = pacer;
+}
 
-    glGenBuffers (1, &m_vertexVBO);
-    glGenBuffers (1, &m_elementVBO);
-    glGenBuffers (1, &m_uniformUBO);
-    glGenBuffers (1, &m_materials.vbo);
-    glGenBuffers (1, &m_poolTransforms);
-    glGenBuffers (1, &m_poolMaterialIDs.vbo);
-    
-    glGenTextures (1, &m_textureArray);
-    glGenTextures (1, &m_materials.tbo);
-    glGenTextures (1, &m_poolMaterialIDs.tbo);
+
+void MyView::setFileReader (std::shared_ptr<AsyncFileReader> reader)
+{
+    m_reader = reader;
 }
 
 
-void MyView::buildMeshData()
+void MyView::setGLThreadQueue (std::shared_ptr<GLThreadQueue> queue)
 {
-    // Begin to construct sponza.
-    const auto& builder = SceneModel::GeometryBuilder();
-    const auto& meshes  = builder.getAllMeshes();
+    m_glQueue = queue;
+}
 
-    // Resize our vector to speed up the loading process.
-    m_meshes.resize (meshes.size());
 
-    // Start by allocating enough memory in the VBOs to contain the scene.
-    size_t vertexSize { 0 }, elementSize { 0 };
-    util::calculateVBOSize (meshes, vertexSize, elementSize);
-    
-    util::allocateBuffer (m_vertexVBO, vertexSize, GL_ARRAY_BUFFER, GL_STATIC_DRAW);
-    util::allocateBuffer (m_elementVBO, elementSize, GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
-    
-    // Bind our VBOs.
-    glBindBuffer (GL_ARRAY_BUFFER, m_vertexVBO);
-    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_elementVBO);
+ThreadPool* MyView::decodingPool() const
+{
+    return m_reader ? m_reader->getThreadPool().get() : nullptr;
+}
 
-    // Iterate through each mesh adding them to the mesh container.
-    GLint vertexIndex   { 0 }; 
-    GLint elementOffset { 0 };
-    
-    for (unsigned int i = 0; i < meshes.size(); ++i)
-    {
-        // Cache the current mesh.
-        const auto& mesh        = meshes[i];
-        const auto& elements    = mesh.getElementArray();
-        
-        // Initialise a rendering-ready mesh.
-        Mesh* newMesh { new Mesh() };
-        newMesh->verticesIndex   = vertexIndex;
-        newMesh->elementsOffset  = elementOffset;
-        newMesh->elementCount    = elements.size();
-        
-        // Obtain the required vertex information.
-        std::vector<Vertex> vertices { };
-        util::assembleVertices (vertices, mesh);
 
-        // Fill the vertex buffer objects with data.
-        glBufferSubData (GL_ARRAY_BUFFER,           vertexIndex * sizeof (Vertex),  vertices.size() * sizeof (Vertex),          vertices.data());
-        glBufferSubData (GL_ELEMENT_ARRAY_BUFFER,   elementOffset,                  elements.size() * sizeof (unsigned int),    elements.data());
+void MyView::setInstanceStream (const SceneModel::MeshId mesh, const InstanceStream& stream)
+{
+    requestMesh (mesh);
 
-        // The vertexIndex needs an actual index value whereas elementOffset needs to be in bytes.
-        vertexIndex += vertices.size();
-        elementOffset += elements.size() * sizeof (unsigned int);
+    auto& streamed = m_instanceStreams[mesh];
 
-        // Finally create the pair and add the mesh to the vector.
-        m_meshes[i] = { mesh.getId(), std::move (newMesh) };
+    if (!streamed)
+    {
+        // The mesh is no longer static so it mustn't be drawn from the transform cache.
+        streamed        = new StreamedInstances();
+        m_cacheValid    = false;
     }
 
-    // Unbind the buffers.
-    glBindBuffer (GL_ARRAY_BUFFER, 0);
-    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+    // If the arrays have moved they may be completely different so the next frame must upload them regardless of the version.
+    const auto& current = streamed->stream;
+
+    if (current.transforms != stream.transforms || current.transformStride != stream.transformStride || current.materials != stream.materials ||
+        current.materialStride != stream.materialStride || current.count != stream.count || current.version != stream.version ||
+        current.dirty != stream.dirty)
+    {
+        streamed->stream    = stream;
+        streamed->uploaded  = false;
+    }
 }
 
 
-void MyView::allocateExtraBuffers()
+void MyView::removeInstanceStream (const SceneModel::MeshId mesh)
 {
-    /// Use DYNAMIC for the UBO because we'll only be updating once per frame but using for every instance in the scene.
-    /// Use STREAM for the instancing buffers because they will be updated once per mesh and only used for that mesh.
+    const auto streamed = m_instanceStreams.find (mesh);
 
-    // We'll need to keep track of the highest number of instances in the scene.
-    m_instancePoolSize          = highestInstanceCount();
+    if (streamed != m_instanceStreams.end())
+    {
+        glDeleteBuffers (1, &streamed->second->transforms);
+        glDeleteBuffers (1, &streamed->second->materialIDs.vbo);
+        glDeleteTextures (1, &streamed->second->materialIDs.tbo);
 
-    // We need to store two matrices per instance and we need to ensure the materialID pool aligns to a glm::vec4, otherwise we end up with missing data.
-    const auto transformSize    = m_instancePoolSize * sizeof (glm::mat4) * 2;
-    const auto materialIDSize   = (m_instancePoolSize + m_instancePoolSize % 4) * sizeof (MaterialID);
+        delete streamed->second;
+        m_instanceStreams.erase (streamed);
 
-    // The UBO will contain every uniform variable apart from textures. 
-    util::allocateBuffer (m_uniformUBO, sizeof (UniformData), GL_UNIFORM_BUFFER, GL_DYNAMIC_DRAW);
+        m_cacheValid = false;
+    }
+}
 
-    // The matrices pool stores the model and PVM transformation matrices of each instance, therefore we need two.
-    util::allocateBuffer (m_poolTransforms, transformSize, GL_ARRAY_BUFFER, GL_STREAM_DRAW);
 
-    // The material ID pool contains the instance-specific material ID required for correct shading.
-    util::allocateBuffer (m_poolMaterialIDs.vbo, materialIDSize, GL_TEXTURE_BUFFER, GL_STREAM_DRAW);
+size_t MyView::addPrefab (const Prefab& prefab)
+{
+    // Reuse the IDs of removed prefabs so the list doesn't keep growing.
+    const auto free = std::find (m_prefabs.begin(), m_prefabs.end(), nullptr);
+    const auto id   = static_cast<size_t> (free - m_prefabs.begin());
+
+    if (free == m_prefabs.end())
+    {
+        m_prefabs.push_back (nullptr);
+    }
+
+    m_prefabs[id]                           = new PrefabInstances();
+    m_prefabs[id]->prefab                   = prefab;
+    m_prefabs[id]->placements.hasMaterials  = false;
+
+    for (const auto& entry : prefab.entries)
+    {
+        requestMesh (entry.mesh);
+    }
+
+    return id;
 }
 
 
-void MyView::bindUniformBufferObject()
+void MyView::setPrefabInstances (const size_t prefab, const InstanceStream& stream)
 {
-    /// This part here may be confusing. There is only one Uniform Buffer Object in MyView and we use the UniformData class to manage how that 
-    /// data is managed by the shaders. Although all of the data is maintained in the class itself, we split it into "scene" and "lighting"
-    /// segments. We point the binding blocks to the correct parts of the UBO using the information UniformData gives us.
-    ///
-    /// I would rather UniformData had a Scene and Lighting class which meant the size and offset calculations were less brittle but that's for
-    /// another day.
+    if (prefab >= m_prefabs.size() || !m_prefabs[prefab])
+    {
+        return;
+    }
 
-    glBindBuffer (GL_UNIFORM_BUFFER, m_uniformUBO);
+    // The same rules as any other stream apply, moved arrays must be uploaded regardless of the version.
+    auto&       placements  = m_prefabs[prefab]->placements;
+    const auto& current     = placements.stream;
 
-    // Determine the UBO indices.
-    const auto scene = glGetUniformBlockIndex (m_program, "scene");
-    const auto lighting = glGetUniformBlockIndex (m_program, "lighting");
+    if (current.transforms != stream.transforms || current.transformStride != stream.transformStride || current.count != stream.count ||
+        current.version != stream.version || current.dirty != stream.dirty)
+    {
+        placements.stream   = stream;
+        placements.uploaded = false;
+    }
+}
 
-    // Bind each part of the UBO to the correct block.
-    glUniformBlockBinding (m_program, scene, UniformData::sceneBlock());
-    glUniformBlockBinding (m_program, lighting, UniformData::lightingBlock());
 
-    // Use the magic data contained in UniformData to separate the UBO into segments.
-    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::sceneBlock(),    m_uniformUBO, UniformData::sceneOffset(),    UniformData::sceneSize());
-    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::lightingBlock(), m_uniformUBO, UniformData::lightingOffset(), UniformData::lightingSize());
+void MyView::removePrefab (const size_t prefab)
+{
+    if (prefab >= m_prefabs.size() || !m_prefabs[prefab])
+    {
+        return;
+    }
 
-    // Unbind the buffer.
-    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+    const auto& placements = m_prefabs[prefab]->placements;
+
+    glDeleteBuffers (1, &placements.transforms);
+    glDeleteBuffers (1, &placements.materialIDs.vbo);
+    glDeleteTextures (1, &placements.materialIDs.tbo);
+
+    delete m_prefabs[prefab];
+    m_prefabs[prefab] = nullptr;
 }
 
 
-void MyView::buildMaterialData()
+void MyView::setSimulationChannel (std::shared_ptr<SimulationChannel> channel)
 {
-    /// We preload the materials into the GPU at the start of the scene because we know they will never change. Using this approach means that
-    /// each material can be linked with preloaded textures and therefore we only need to give an instance an ID so that it can choose the correct
-    /// material and texture for lighting calculations.
+    m_simulation = channel;
+}
 
-    // Obtain every material in the scene.
-    const auto& materials = m_scene->getAllMaterials();
 
-    // Load all of the images in the scen
-    std::vector<std::pair<std::string, tygra::Image>> images { };
-    util::loadImagesFromScene (images, materials);
+void MyView::setRenderServer (std::shared_ptr<RenderServer> server)
+{
+    m_server = server;
+}
 
-    // Iterate through them creating a buffer-ready material for each ID.
-    std::vector<Material> bufferMaterials (materials.size());
 
-    for (size_t id = 0; id < materials.size(); ++id)
+void MyView::rebuildShaders()
+{
+    // Both paths swap the programs through replacePrograms() so neither can forget one.
+    if (!m_reader || !m_glQueue)
     {
-        // Cache the material.
-        const auto& material            = materials[id];
+        replacePrograms (loadShaders());
+        return;
+    }
+
+    // Otherwise read the shaders in the background and only swap programs on the render thread once they've arrived.
+    m_shaderReload.cancel();
+    m_shaderReload = CancellationToken { };
 
-        // Check which texture ID to use. If it can't be determined then -1 indicates none.
-        const auto& texture             = material.getAmbientMap();
-        float       textureID           = -1.f;
+    const auto built = readShaders (m_shaderReload).then (*m_glQueue, [this] (ShaderSources& sources)
+    {
+        return replacePrograms (sources);
+    });
 
-        if (!texture.empty())
+    built.whenDone (InlineExecutor::get(), [] (const Task<bool>& task)
+    {
+        try
         {
-            // Determine the textureID.
-            for (size_t i = 0; i < images.size(); ++i)
-            {
-                // 0 means equality.
-                if (texture == images[i].first)
-                {
-                    // Cast back to an int otherwise we may have errors.
-                    textureID = (float) i;
-                    break;
-                }
-            }
+            task.get();
         }
 
-        // Create a buffer-ready material and fill it with correct data.
-        Material bufferMaterial { };
-        bufferMaterial.diffuseColour    = material.getDiffuseColour();
-        bufferMaterial.textureID        = textureID;
-        bufferMaterial.specularColour   = material.getSpecularColour();
-        bufferMaterial.shininess        = material.getShininess();
+        catch (const TaskCancelled&)
+        {
+            // A newer rebuild has taken over.
+        }
 
-        // Prepare to add it to the GPU and add the ID to the map. We need to remember that a material takes up two columns so the ID must be multiplied by two.
-        bufferMaterials[id] = std::move (bufferMaterial);
-        m_materialIDs.emplace (material.getId(), MaterialID (id * 2));
-    }
+        catch (const std::exception& error)
+        {
+            std::cerr << "Unable to rebuild the shaders: " << error.what() << std::endl;
+        }
+    });
+}
 
-    // Load the materials into the GPU and link the buffers together.
-    util::fillBuffer (m_materials.vbo, bufferMaterials, GL_TEXTURE_BUFFER, GL_STATIC_DRAW);
 
-    if (!images.empty())
+void MyView::cycleCullingMode()
+{
+    const char* const names[] = { "off", "every frame", "temporally coherent" };
+
+    m_cullingMode = (m_cullingMode + 1) % 3;
+
+    // Results from another mode shouldn't skew the statistics of this one.
+    if (m_culler)
     {
-        prepareTextureData (images[0].second.width(), images[0].second.height(), images.size());
+        m_culler->invalidate();
+        m_culler->resetStatistics();
     }
 
-    // Just prepare the materials.
-    else
-    {
+    std::cout << "Culling is " << names[m_cullingMode] << "." << std::endl;
+}
+
+
+void MyView::togglePanoramaMode()
+{
+    m_panoramaMode  = !m_panoramaMode;
+    m_panoramaValid = false;
+
+    std::cout << "Panorama reprojection is " << (m_panoramaMode ? "on." : "off.") << std::endl;
+}
+
+
+void MyView::toggleDepthPrepass()
+{
+    if (!m_resources || m_resources->positionVBO == 0)
+    {
+        std::cout << "The depth pre-pass needs the position stream, start with --depth-prepass." << std::endl;
+        return;
+    }
+
+    m_depthPrepass = !m_depthPrepass;
+
+    std::cout << "The depth pre-pass is " << (m_depthPrepass ? "on." : "off.") << std::endl;
+}
+
+
+void MyView::toggleTransformCache()
+{
+    m_transformCache = !m_transformCache;
+
+    if (!m_transformCache)
+    {
+        releaseTransformCache();
+    }
+
+    std::cout << "The transform cache is " << (m_transformCache ? "on." : "off.") << std::endl;
+}
+
+
+void MyView::toggleOcclusionQueries()
+{
+    m_occlusionQueries = !m_occlusionQueries;
+
+    if (!m_occlusionQueries)
+    {
+        releaseOcclusionQueries();
+    }
+
+    std::cout << "Occlusion queries are " << (m_occlusionQueries ? "on." : "off.") << std::endl;
+}
+
+
+void MyView::printStatistics (std::ostream& stream) const
+{
+    if (m_culler && m_cullingMode != 0)
+    {
+        m_culler->printStatistics (stream);
+    }
+
+    else
+    {
+        stream << "Culling: off." << std::endl;
+    }
+
+    if (m_resources && m_resources->virtualTextures)
+    {
+        m_resources->virtualTextures->printStatistics (stream);
+    }
+
+    stream  << "Panorama: " << (m_panoramaMode ? "on, " : "off, ") << m_panoramaRenders << " renders and " << m_panoramaReuses 
+            << " frames reprojected, " << m_panoramaSize << " pixel faces." << std::endl;
+
+    stream  << "Transform cache: " << (m_transformCache ? "on, " : "off, ") << m_cacheVertices << " vertices ("
+            << m_cacheVertices * cachedVertexSize / (1024.0 * 1024.0) << " MiB) captured " << m_cacheCaptures << " times, the last in "
+            << m_cacheTime << "ms." << std::endl;
+
+    stream  << "Occlusion queries: " << (m_occlusionQueries ? "on, " : "off, ") << m_occlusionIssued << " issued, " << m_occlusionHidden << " of "
+            << m_occlusionResults << " results read back were hidden." << std::endl;
+
+    stream  << "Late assets: " << m_lateMeshes << " meshes and " << m_lateMaterials << " materials uploaded when first referenced, "
+            << m_unknownMeshes.size() << " meshes and " << m_unknownMaterials.size() << " materials referenced which the scene doesn't have." << std::endl;
+}
+
+#pragma endregion
+
+
+#pragma region Scene construction
+
+void MyView::windowViewWillStart (std::shared_ptr<tygra::Window> window)
+{
+    assert (m_scene != nullptr);
+    
+    // Set up OpenGL as required by the application!
+    glEnable (GL_DEPTH_TEST);
+    glEnable (GL_CULL_FACE);
+    glEnable (GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex (util::restartIndex);
+    glClearColor (0.f, 0.1f, 0.f, 0.f);
+    
+    // Attempt to build the programs, if it fails the user can reload after correcting any syntax errors.
+    buildPrograms (loadShaders());
+
+    // Generate the buffers.
+    generateOpenGLObjects();
+
+    // Share the geometry, materials and textures with any other views of the scene.
+    acquireResources();
+    
+    // Allocate the required run-time memory for instancing.
+    allocateExtraBuffers();
+
+    // Prepare the UBO for usage.
+    bindUniformBufferObject();
+
+    // Now we can construct the VAO so we're reading for rendering.
+    constructVAO();
+}
+
+
+MyView::ShaderSources MyView::loadShaders() const
+{
+    ShaderSources sources { };
+
+    if (!m_reader)
+    {
+        for (const auto location : shaderLocations)
+        {
+            sources[location] = tygra::stringFromFile (location);
+        }
+
+        return sources;
+    }
+
+    // Read the shaders together, compilation still has to happen on this thread.
+    try
+    {
+        return readShaders ({ }).get();
+    }
+
+    catch (const std::exception& error)
+    {
+        std::cerr << "Unable to load the shaders: " << error.what() << std::endl;
+    }
+
+    // Empty shaders fail to compile so every program is left empty, as it would be if the files had errors.
+    for (const auto location : shaderLocations)
+    {
+        sources[location] = "";
+    }
+
+    return sources;
+}
+
+
+Task<MyView::ShaderSources> MyView::readShaders (CancellationToken token) const
+{
+    std::vector<Task<std::vector<char>>> files { };
+
+    for (const auto location : shaderLocations)
+    {
+        files.push_back (m_reader->readTask (location, token));
+    }
+
+    return util::whenAll (files, token).then (InlineExecutor::get(), [] (std::vector<std::vector<char>>& contents)
+    {
+        ShaderSources sources { };
+
+        for (size_t i = 0; i < contents.size(); ++i)
+        {
+            sources[shaderLocations[i]].assign (contents[i].begin(), contents[i].end());
+        }
+
+        return sources;
+    });
+}
+
+
+bool MyView::buildPrograms (const ShaderSources& sources)
+{
+    // Nothing has been built when starting, deleting zero is ignored.
+    glDeleteProgram (m_program);
+    glDeleteProgram (m_panoramaProgram);
+    glDeleteProgram (m_depthProgram);
+    glDeleteProgram (m_captureProgram);
+    glDeleteProgram (m_occlusionProgram);
+    glDeleteProgram (m_wireframeProgram);
+
+    const auto built = buildProgram (sources.at (vertexShaderLocation), sources.at (fragmentShaderLocation));
+    buildPanoramaProgram (sources);
+    buildDepthProgram (sources);
+    buildCaptureProgram (sources);
+    buildOcclusionProgram (sources);
+    buildWireframeProgram (sources);
+
+    return built;
+}
+
+
+bool MyView::replacePrograms (const ShaderSources& sources)
+{
+    const auto built = buildPrograms (sources);
+    bindUniformBufferObject();
+    constructVAO();
+
+    m_panoramaValid = false;
+    return built;
+}
+
+
+bool MyView::buildProgram (const std::string& vertexSource, const std::string& fragmentSource)
+{
+    // Create the program to attach shaders to.
+    m_program                                       = glCreateProgram();
+
+    // Attempt to compile the shaders.
+    const auto vertexShader                         = util::compileShaderFromSource (vertexSource, GL_VERTEX_SHADER);
+    const auto fragmentShader                       = util::compileShaderFromSource (fragmentSource, GL_FRAGMENT_SHADER);
+    
+    // Attach the shaders to the program we created.
+    const std::vector<GLchar*> vertexAttributes     = { "position", "normal", "textureCoord", "model" };
+    const std::vector<GLchar*> fragmentAttributes   = {  };
+
+    util::attachShader (m_program, vertexShader, vertexAttributes);
+    util::attachShader (m_program, fragmentShader, fragmentAttributes);
+
+    // Link the program
+    if (util::linkProgram (m_program))
+    {
+        std::cout << "OpenGL application built successfully." << std::endl;
+        return true;
+    }
+
+    return false;
+}
+
+
+void MyView::generateOpenGLObjects()
+{
+    glGenVertexArrays (1, &m_sceneVAO);
+    glGenVertexArrays (1, &m_panoramaVAO);
+    glGenVertexArrays (1, &m_depthVAO);
+    glGenVertexArrays (1, &m_occlusionVAO);
+
+    glGenBuffers (1, &m_uniformUBO);
+    glGenBuffers (1, &m_poolTransforms);
+    glGenBuffers (1, &m_occlusionTransforms);
+    glGenBuffers (1, &m_poolMaterialIDs.vbo);
+    
+    glGenTextures (1, &m_poolMaterialIDs.tbo);
+}
+
+
+void MyView::acquireResources()
+{
+    m_resources = m_resourcePool ? m_resourcePool->acquire (resourceKey()) : std::make_shared<SceneResources>();
+
+    // Only the first view of a scene uploads it, the rest draw from what it uploaded.
+    std::lock_guard<std::mutex> lock { m_resources->mutex };
+
+    if (!m_resources->built)
+    {
+        m_resources->generateOpenGLObjects();
+        m_resources->imported = m_imported;
+
+        // Whichever view builds the resources decides whether the textures are virtual, whether there's a position stream and whether
+        // meshes are stripped, the rest follow.
+        m_resources->stripify = m_stripification;
+
+        if (m_virtualTexturing)
+        {
+            m_resources->virtualTextures = std::make_shared<VirtualTextures>();
+        }
+
+        if (m_depthPrepass)
+        {
+            glGenBuffers (1, &m_resources->positionVBO);
+        }
+
+        // Retrieve the scene data ready for rendering and ensure we have the required materials.
+        buildMeshData();
+        buildMaterialData();
+
+        if (m_resources->stripify)
+        {
+            const auto& strips = m_resources->stripStatistics;
+
+            std::cout   << "Strips: " << strips.stripCount << " of " << strips.meshCount << " meshes, " << strips.listIndices << " -> " << strips.chosenIndices
+                        << " indices (" << (strips.listIndices - strips.chosenIndices) * sizeof (unsigned int) / 1024 << " KiB saved), "
+                        << strips.listMisses << " -> " << strips.chosenMisses << " vertices shaded by a simulated FIFO cache." << std::endl;
+        }
+
+        m_resources->built = true;
+    }
+
+    else
+    {
+        std::cout << "Sharing the resources of " << resourceKey() << " with another view." << std::endl;
+    }
+
+    if (!m_imported)
+    {
+        orderSceneInstances();
+    }
+}
+
+
+std::string MyView::resourceKey() const
+{
+    // Every SceneModel::Context is a copy of sponza, so they all share the same assets. Reloading an imported scene creates a new object
+    // but the file it was imported from stays the same, so views which share it keep sharing.
+    return m_imported && !m_imported->sources.empty() ? m_imported->sources.front() : sponzaResources;
+}
+
+
+void MyView::buildMeshData()
+{
+    // An imported scene replaces the SceneModel geometry entirely.
+    if (m_imported)
+    {
+        buildImportedMeshData();
+        return;
+    }
+
+    // Begin to construct sponza.
+    const auto& builder     = SceneModel::GeometryBuilder();
+    const auto& allMeshes   = builder.getAllMeshes();
+
+    // Only meshes which are instanced are worth assembling and uploading, along with any which streams or prefabs have asked for since.
+    std::vector<const SceneModel::Mesh*> meshes { };
+
+    for (const auto& mesh : allMeshes)
+    {
+        if (!m_content->getInstancesByMeshId (mesh.getId()).empty() || m_resources->lateMeshes.count (mesh.getId()) != 0)
+        {
+            meshes.push_back (&mesh);
+        }
+    }
+
+    // Assemble every mesh before uploading any so they can be laid out by where their instances are.
+    std::vector<std::vector<Vertex>>    vertices        (meshes.size());
+    std::vector<Mesh*>                  built           (meshes.size());
+    std::vector<glm::vec3>              meshCentres     (meshes.size(), glm::vec3 (0.f));
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        util::assembleVertices (vertices[i], *meshes[i]);
+
+        built[i] = new Mesh();
+        built[i]->setBounds (vertices[i].data(), vertices[i].size());
+
+        // A mesh sits wherever its instances are on average.
+        const auto& instances = m_content->getInstancesByMeshId (meshes[i]->getId());
+
+        for (const auto id : instances)
+        {
+            const auto model = (glm::mat4) m_content->getInstanceById (id).getTransformationMatrix();
+            meshCentres[i] += glm::vec3 (model * glm::vec4 (built[i]->centre, 1.f)) / static_cast<float> (instances.size());
+        }
+    }
+
+    // Meshes are uploaded and drawn in the Morton order of their centres, so meshes which are near each other in the scene are drawn one
+    // after another. Whether that helps any cache hasn't been measured. The instances belong to each view so orderSceneInstances() orders them.
+    const auto meshOrder = mortonOrder (meshCentres);
+
+    // Resize our vectors to speed up the loading process, the meshes are stored in the order they're drawn.
+    m_resources->meshes.resize (meshes.size());
+    m_resources->meshOrder = sequence (meshes.size());
+
+    // Start by allocating enough memory in the VBOs to contain the scene, with some headroom for meshes which are referenced later.
+    size_t vertexSize { 0 }, elementSize { 0 };
+    util::calculateVBOSize (meshes, vertexSize, elementSize);
+
+    m_resources->vertexCapacity    = vertexSize / sizeof (Vertex) + vertexSize / sizeof (Vertex) / 4;
+    m_resources->elementCapacity   = elementSize / sizeof (unsigned int) + elementSize / sizeof (unsigned int) / 4;
+    
+    util::allocateBuffer (m_resources->vertexVBO, m_resources->vertexCapacity * sizeof (Vertex), GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+    util::allocateBuffer (m_resources->elementVBO, m_resources->elementCapacity * sizeof (unsigned int), GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+    allocatePositions (m_resources->vertexCapacity);
+    
+    // Bind our VBOs.
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    // Iterate through each mesh adding them to the mesh container.
+    GLint   vertexIndex     { 0 }; 
+    size_t  elementOffset   { 0 };
+    
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        // Cache the current mesh.
+        const auto  source      = meshOrder[i];
+        const auto& mesh        = *meshes[source];
+        const auto& elements    = mesh.getElementArray();
+        
+        // Finish the rendering-ready mesh.
+        Mesh* newMesh { built[source] };
+        newMesh->verticesIndex   = vertexIndex;
+        newMesh->vertexCount     = vertices[source].size();
+
+        // Fill the vertex buffer objects with data.
+        glBufferSubData (GL_ARRAY_BUFFER,           vertexIndex * sizeof (Vertex),  vertices[source].size() * sizeof (Vertex),  vertices[source].data());
+        const auto written = uploadElements (*newMesh, elements.data(), elements.size(), elementOffset / sizeof (unsigned int));
+        uploadPositions (vertices[source].data(), vertices[source].size(), vertexIndex);
+
+        // The vertexIndex needs an actual index value whereas elementOffset needs to be in bytes.
+        vertexIndex += vertices[source].size();
+        elementOffset += written * sizeof (unsigned int);
+
+        // Finally create the pair and add the mesh to the vector.
+        m_resources->meshes[i] = { mesh.getId(), std::move (newMesh) };
+    }
+
+    m_resources->vertexUsage   = static_cast<size_t> (vertexIndex);
+    m_resources->elementUsage  = elementOffset / sizeof (unsigned int);
+
+    // Unbind the buffers.
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+void MyView::orderSceneInstances()
+{
+    /// Every view has its own SceneModel::Context, so whilst the meshes are shared, the instances of each mesh are ordered by each view.
+    /// The instances of each mesh are drawn in the Morton order of where they are, the same as the meshes themselves.
+    const auto& meshes = m_resources->meshes;
+
+    std::vector<glm::vec3>  centres         { };
+    std::vector<size_t>     firstInstances  (meshes.size());
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const auto& instances   = m_content->getInstancesByMeshId (meshes[i].first);
+        firstInstances[i]       = centres.size();
+
+        for (const auto id : instances)
+        {
+            const auto model = (glm::mat4) m_content->getInstanceById (id).getTransformationMatrix();
+            centres.push_back (glm::vec3 (model * glm::vec4 (meshes[i].second->centre, 1.f)));
+        }
+    }
+
+    const auto codes = mortonCodes (centres);
+
+    m_sceneInstances.assign (meshes.size(), { });
+    m_meshVersion = m_resources->meshVersion;
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const auto& instances   = m_content->getInstancesByMeshId (meshes[i].first);
+        const auto  first       = firstInstances[i];
+        auto        order       = sequence (instances.size());
+
+        std::stable_sort (order.begin(), order.end(), [&] (const size_t lhs, const size_t rhs) { return codes[first + lhs] < codes[first + rhs]; });
+
+        for (const auto j : order)
+        {
+            m_sceneInstances[i].push_back (instances[j]);
+        }
+    }
+}
+
+
+void MyView::allocateExtraBuffers()
+{
+    /// Use DYNAMIC for the UBO because we'll only be updating once per frame but using for every instance in the scene.
+    /// Use STREAM for the instancing buffers because they will be updated once per mesh and only used for that mesh.
+
+    // The UBO will contain every uniform variable apart from textures. It's followed by a scene block for each view which can be drawn at once,
+    // which is the window and a batch of render server requests.
+    GLint alignment { 0 };
+    glGetIntegerv (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment       = std::max (alignment, 1);
+
+    m_viewStride    = (UniformData::sceneSize() + alignment - 1) / alignment * alignment;
+    m_viewOffset    = (sizeof (UniformData) + alignment - 1) / alignment * alignment;
+    m_viewCapacity  = std::max<size_t> (1, m_server ? m_server->getSettings().maxBatchSize : 1);
+
+    util::allocateBuffer (m_uniformUBO, m_viewOffset + m_viewStride * m_viewCapacity, GL_UNIFORM_BUFFER, GL_DYNAMIC_DRAW);
+
+    allocateInstancePools();
+}
+
+
+void MyView::allocateInstancePools()
+{
+    // We'll need to keep track of the highest number of instances in the scene.
+    m_instancePoolSize          = highestInstanceCount();
+
+    // We need to store a matrix per instance and we need to ensure the materialID pool aligns to a glm::vec4, otherwise we end up with missing data.
+    const auto transformSize    = m_instancePoolSize * sizeof (glm::mat4);
+    const auto materialIDSize   = (m_instancePoolSize + m_instancePoolSize % 4) * sizeof (MaterialID);
+
+    // The matrices pool stores the model transformation matrix of each instance, the shaders combine it with the view and projection.
+    util::allocateBuffer (m_poolTransforms, transformSize, GL_ARRAY_BUFFER, GL_STREAM_DRAW);
+
+    // The material ID pool contains the instance-specific material ID required for correct shading.
+    util::allocateBuffer (m_poolMaterialIDs.vbo, materialIDSize, GL_TEXTURE_BUFFER, GL_STREAM_DRAW);
+}
+
+
+void MyView::bindUniformBufferObject()
+{
+    /// This part here may be confusing. There is only one Uniform Buffer Object in MyView and we use the UniformData class to manage how that 
+    /// data is managed by the shaders. Although all of the data is maintained in the class itself, we split it into "scene" and "lighting"
+    /// segments. We point the binding blocks to the correct parts of the UBO using the information UniformData gives us.
+    ///
+    /// I would rather UniformData had a Scene and Lighting class which meant the size and offset calculations were less brittle but that's for
+    /// another day.
+
+    glBindBuffer (GL_UNIFORM_BUFFER, m_uniformUBO);
+
+    // Determine the UBO indices.
+    const auto scene = glGetUniformBlockIndex (m_program, "scene");
+    const auto lighting = glGetUniformBlockIndex (m_program, "lighting");
+
+    // Bind each part of the UBO to the correct block.
+    glUniformBlockBinding (m_program, scene, UniformData::sceneBlock());
+    glUniformBlockBinding (m_program, lighting, UniformData::lightingBlock());
+
+    // Use the magic data contained in UniformData to separate the UBO into segments.
+    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::sceneBlock(),    m_uniformUBO, UniformData::sceneOffset(),    UniformData::sceneSize());
+    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::lightingBlock(), m_uniformUBO, UniformData::lightingOffset(), UniformData::lightingSize());
+
+    // Unbind the buffer.
+    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+}
+
+
+void MyView::buildMaterialData()
+{
+    /// We preload the materials into the GPU at the start of the scene because we know they will never change. Using this approach means that
+    /// each material can be linked with preloaded textures and therefore we only need to give an instance an ID so that it can choose the correct
+    /// material and texture for lighting calculations.
+
+    // An imported scene brings its own materials.
+    if (m_imported)
+    {
+        buildImportedMaterialData();
+        return;
+    }
+
+    // Find which materials are used by an instance, only those need uploading and only their textures need decoding.
+    std::unordered_set<SceneModel::MaterialId> referenced { };
+
+    for (const auto& pair : m_resources->meshes)
+    {
+        for (const auto instance : m_content->getInstancesByMeshId (pair.first))
+        {
+            referenced.insert (m_content->getInstanceById (instance).getMaterialId());
+        }
+    }
+
+    std::vector<SceneModel::Material> materials { };
+
+    for (const auto& material : m_content->getAllMaterials())
+    {
+        if (referenced.count (material.getId()) != 0)
+        {
+            materials.push_back (material);
+        }
+    }
+
+    loadSceneMaterials (materials);
+}
+
+
+void MyView::loadSceneMaterials (const std::vector<SceneModel::Material>& materials)
+{
+    // Load all of the images in the scene, materials often share a texture under a different name so only one copy of each is kept.
+    std::vector<std::pair<std::string, tygra::Image>> images { };
+
+    const auto decodeStart  = std::chrono::steady_clock::now();
+    const auto skipped      = util::loadImagesFromScene (images, materials, decodingPool());
+    const auto decodeTime   = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - decodeStart).count();
+
+    // Materials referenced later are laid out with the loaded textures rather than reloading every texture, unless they need one which isn't loaded.
+    m_resources->sceneTextureLayers = deduplicateTextures (images, skipped, decodeTime);
+
+    layoutSceneMaterials (materials);
+    uploadMaterialsAndTextures (m_resources->sceneMaterials, images);
+}
+
+
+void MyView::layoutSceneMaterials (const std::vector<SceneModel::Material>& materials)
+{
+    // Iterate through them creating a buffer-ready material for each ID, materials with the same values share one.
+    std::vector<Material>                                       bufferMaterials { };
+    std::unordered_map<Material, MaterialID, Material::Hash>    slots           { };
+
+    m_resources->materialIDs.clear();
+
+    for (const auto& material : materials)
+    {
+        // Prepare to add it to the GPU and add the ID to the map. We need to remember that a material takes up two columns so the ID must be multiplied by two.
+        auto        bufferMaterial  = createMaterial (material, m_resources->sceneTextureLayers);
+        const auto  slot            = slots.emplace (bufferMaterial, MaterialID (bufferMaterials.size()));
+
+        if (slot.second)
+        {
+            bufferMaterials.push_back (std::move (bufferMaterial));
+        }
+
+        m_resources->materialIDs.emplace (material.getId(), slot.first->second * 2);
+    }
+
+    m_resources->materialCount  = bufferMaterials.size();
+    m_resources->sceneMaterials = std::move (bufferMaterials);
+}
+
+
+MyView::Material MyView::createMaterial (const SceneModel::Material& material, const std::unordered_map<std::string, size_t>& layers)
+{
+    // Check which texture ID to use. If it can't be determined then -1 indicates none.
+    const auto  layer               = layers.find (material.getAmbientMap());
+    const auto  textureID           = layer != layers.end() ? (float) layer->second : -1.f;
+
+    // Create a buffer-ready material and fill it with correct data.
+    Material bufferMaterial { };
+    bufferMaterial.diffuseColour    = material.getDiffuseColour();
+    bufferMaterial.textureID        = textureID;
+    bufferMaterial.specularColour   = material.getSpecularColour();
+    bufferMaterial.shininess        = material.getShininess();
+
+    return bufferMaterial;
+}
+
+
+void MyView::buildImportedMeshData()
+{
+    /// Only meshes which an instance references are uploaded, the rest are uploaded lazily if a scene update references them. The importer
+    /// has already laid each mesh out exactly as the VBOs expect so no processing is needed. The buffers are given some headroom so that
+    /// meshes which grow or become referenced when the scene is hot reloaded can usually be appended rather than forcing a reallocation.
+    /// Meshes are laid out and drawn in the Morton order of where their instances are.
+    const auto& scene       = *m_imported;
+    const auto  references  = util::findReferences (scene);
+
+    // Size the buffers for the referenced meshes only.
+    size_t vertexCount { 0 }, elementCount { 0 };
+
+    for (size_t i = 0; i < scene.meshes.size(); ++i)
+    {
+        if (references.meshes[i])
+        {
+            vertexCount     += scene.vertexCountOf (i);
+            elementCount    += scene.meshes[i].elementCount;
+        }
+    }
+
+    m_resources->vertexUsage       = 0;
+    m_resources->elementUsage      = 0;
+    m_resources->vertexCapacity    = vertexCount + vertexCount / 4;
+    m_resources->elementCapacity   = elementCount + elementCount / 4;
+
+    util::allocateBuffer (m_resources->vertexVBO, m_resources->vertexCapacity * sizeof (Vertex), GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+    util::allocateBuffer (m_resources->elementVBO, m_resources->elementCapacity * sizeof (unsigned int), GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+    allocatePositions (m_resources->vertexCapacity);
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    // Imported meshes are identified by their index and own exactly the range they were uploaded to.
+    m_resources->meshes.resize (scene.meshes.size());
+    m_resources->meshCapacities.assign (scene.meshes.size(), { 0, 0 });
+    m_resources->residentMeshes.assign (scene.meshes.size(), false);
+
+    for (size_t i = 0; i < m_resources->meshes.size(); ++i)
+    {
+        m_resources->meshes[i] = { static_cast<SceneModel::MeshId> (i), new Mesh() };
+
+        if (references.meshes[i])
+        {
+            m_resources->meshes[i].second->setBounds (&scene.vertices[scene.meshes[i].verticesIndex], scene.vertexCountOf (i));
+        }
+    }
+
+    // A mesh sits wherever its instances are on average, unreferenced meshes all sit at the origin and are drawn together.
+    std::vector<glm::vec3>  meshCentres     (scene.meshes.size(), glm::vec3 (0.f));
+    std::vector<size_t>     instanceCounts  (scene.meshes.size(), 0);
+
+    for (const auto& instance : scene.instances)
+    {
+        meshCentres[instance.meshIndex] += glm::vec3 (instance.transform * glm::vec4 (m_resources->meshes[instance.meshIndex].second->centre, 1.f));
+        ++instanceCounts[instance.meshIndex];
+    }
+
+    for (size_t i = 0; i < meshCentres.size(); ++i)
+    {
+        meshCentres[i] /= static_cast<float> (std::max<size_t> (instanceCounts[i], 1));
+    }
+
+    m_resources->meshOrder = mortonOrder (meshCentres);
+
+    for (const auto i : m_resources->meshOrder)
+    {
+        if (references.meshes[i])
+        {
+            uploadImportedMesh (i, m_resources->vertexUsage, m_resources->elementUsage);
+
+            m_resources->meshCapacities[i] =  { scene.vertexCountOf (i), scene.meshes[i].elementCount };
+            m_resources->vertexUsage       += m_resources->meshCapacities[i].first;
+            m_resources->elementUsage      += m_resources->meshCapacities[i].second;
+        }
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    std::cout << "Uploaded " << m_resources->vertexUsage << " of " << scene.vertices.size() << " imported vertices, the rest aren't referenced." << std::endl;
+}
+
+
+void MyView::uploadImportedMesh (const size_t index, const size_t verticesIndex, const size_t elementIndex)
+{
+    const auto& scene           = *m_imported;
+    const auto& source          = scene.meshes[index];
+    const auto  firstElement    = source.elementsOffset / sizeof (unsigned int);
+    const auto  vertexCount     = scene.vertexCountOf (index);
+
+    // Elements are relative to the first vertex of the mesh so they can be copied as they are.
+    // Strips never need more elements than the list so the mesh always fits the range the list was given.
+    auto& mesh                  = *m_resources->meshes[index].second;
+
+    glBufferSubData (GL_ARRAY_BUFFER, verticesIndex * sizeof (Vertex), vertexCount * sizeof (Vertex), &scene.vertices[source.verticesIndex]);
+    uploadElements (mesh, &scene.elements[firstElement], source.elementCount, elementIndex);
+    uploadPositions (&scene.vertices[source.verticesIndex], vertexCount, verticesIndex);
+
+    mesh.verticesIndex          = (GLint) verticesIndex;
+    mesh.vertexCount            = vertexCount;
+    mesh.setBounds (&scene.vertices[source.verticesIndex], vertexCount);
+    m_resources->residentMeshes[index]     = true;
+}
+
+
+void MyView::buildImportedMaterialData()
+{
+    /// Like meshes, only the materials and textures reachable from an instance are loaded. Referenced materials are packed into the
+    /// material buffer in order, each imported material remembers its slot so instances can be pointed at it.
+    const auto references = util::findReferences (*m_imported);
+
+    std::vector<std::pair<std::string, tygra::Image>> images { };
+    loadImportedTextures (images, references);
+
+    const auto bufferMaterials = layoutImportedMaterials (references);
+    uploadMaterialsAndTextures (bufferMaterials, images);
+
+    // Instances are grouped once the materials have slots so each group can be sorted by them.
+    groupImportedInstances();
+
+    std::cout << "Uploaded " << bufferMaterials.size() << " unique materials for " << std::count_if (m_resources->materialSlots.begin(), m_resources->materialSlots.end(),
+                 [] (const MaterialID slot) { return slot >= 0; }) << " referenced imported materials." << std::endl;
+}
+
+
+void MyView::loadImportedTextures (std::vector<std::pair<std::string, tygra::Image>>& images, const SceneReferences& references)
+{
+    const auto& textures = m_imported->textures;
+
+    // Only decode the textures which are reachable.
+    std::vector<std::string> files { };
+
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (references.textures[i])
+        {
+            files.push_back (textures[i]);
+        }
+    }
+
+    const auto decodeStart  = std::chrono::steady_clock::now();
+    const auto skipped      = util::loadImagesFromFiles (images, files, decodingPool());
+    const auto decodeTime   = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - decodeStart).count();
+
+    // Images which failed to load have been skipped and duplicates removed so the layer of each texture must be looked up.
+    const auto layers = deduplicateTextures (images, skipped, decodeTime);
+
+    m_resources->textureLayers.resize (textures.size());
+
+    for (size_t i = 0; i < m_resources->textureLayers.size(); ++i)
+    {
+        const auto layer    = layers.find (textures[i]);
+        m_resources->textureLayers[i]  = !references.textures[i] ? unloadedTexture : layer != layers.end() ? (float) layer->second : -1.f;
+    }
+}
+
+
+std::unordered_map<std::string, size_t> MyView::deduplicateTextures (std::vector<std::pair<std::string, tygra::Image>>& images, const size_t skippedFiles,
+                                                                     const double decodeTime) const
+{
+    /// Material libraries refer to the same picture under different names, either as a repeated file or as a copy with another name. Repeated
+    /// files were never decoded, copies have to be decoded before their contents can be compared but can still share a layer. The memory saved
+    /// is what the removed layers would have cost in the texture array, or what their mipmaps would have cost in memory with virtual textures.
+    const auto decodedCount = images.size();
+
+    util::ImageDeduplication statistics { };
+    auto layers = util::deduplicateImages (images, m_mergeSimilar, &statistics);
+
+    if (decodedCount == 0)
+    {
+        return layers;
+    }
+
+    // The texture array is RGBA32F with four mipmaps, each a quarter of the last.
+    const auto  layerSize   = images.front().second.width() * (double) images.front().second.height() * 16.0 * (1.0 + 1.0 / 4.0 + 1.0 / 16.0 + 1.0 / 64.0);
+    const auto  savedBytes  = m_resources->virtualTextures ? statistics.removedTexels * 4.0 * 4.0 / 3.0 : statistics.removedCount() * layerSize;
+    const auto  savedTime   = skippedFiles * decodeTime / decodedCount;
+
+    std::cout   << "Textures: " << decodedCount << " decoded, " << skippedFiles << " repeated files skipped saving " << savedTime << "ms of decoding, "
+                << statistics.identicalCount << " identical and " << statistics.similarCount << " similar merged saving " << savedBytes / (1024.0 * 1024.0)
+                << "MB of texture memory, hashing took " << statistics.hashTime << "ms." << std::endl;
+
+    return layers;
+}
+
+
+std::vector<MyView::Material> MyView::layoutImportedMaterials (const SceneReferences& references)
+{
+    /// Material libraries repeat the same few values under many names, and textures which were merged make even more materials equal, so
+    /// only the first of each distinct material gets a slot. Slots are handed out in material order which keeps them stable while the
+    /// materials don't change, letting hot reloads upload only the slots which did.
+    std::vector<Material>                                   bufferMaterials { };
+    std::unordered_map<Material, MaterialID, Material::Hash> slots          { };
+
+    m_resources->materialSlots.assign (m_imported->materials.size(), -1);
+
+    for (size_t i = 0; i < m_resources->materialSlots.size(); ++i)
+    {
+        if (!references.materials[i])
+        {
+            continue;
+        }
+
+        // The texture IDs of imported materials index the texture list rather than the texture array.
+        auto        material    = m_imported->materials[i];
+        const auto  texture     = static_cast<size_t> (material.textureID);
+        const auto  layer       = material.textureID >= 0.f && texture < m_resources->textureLayers.size() ? m_resources->textureLayers[texture] : -1.f;
+        material.textureID      = layer >= 0.f ? layer : -1.f;
+
+        const auto  slot        = slots.emplace (material, MaterialID (bufferMaterials.size()));
+
+        if (slot.second)
+        {
+            bufferMaterials.push_back (material);
+        }
+
+        m_resources->materialSlots[i] = slot.first->second;
+    }
+
+    m_resources->materialCount = bufferMaterials.size();
+
+    return bufferMaterials;
+}
+
+
+void MyView::groupImportedInstances()
+{
+    m_resources->importedInstances.assign (m_resources->meshes.size(), { });
+
+    for (size_t i = 0; i < m_imported->instances.size(); ++i)
+    {
+        m_resources->importedInstances[m_imported->instances[i].meshIndex].push_back (i);
+    }
+
+    // Neighbouring instances with the same material fetch the same texels, keeping the material buffer reads coherent. Instances sharing
+    // a material follow the Morton order of where they are.
+    const auto& slots       = m_resources->materialSlots;
+    const auto& instances   = m_imported->instances;
+
+    std::vector<glm::vec3> centres { };
+    centres.reserve (instances.size());
+
+    for (const auto& instance : instances)
+    {
+        centres.push_back (glm::vec3 (instance.transform * glm::vec4 (m_resources->meshes[instance.meshIndex].second->centre, 1.f)));
+    }
+
+    const auto codes = mortonCodes (centres);
+
+    const auto slotOf = [&] (const size_t instance)
+    {
+        const auto material = instances[instance].materialIndex;
+        return material < slots.size() ? slots[material] : -1;
+    };
+
+    for (auto& group : m_resources->importedInstances)
+    {
+        std::stable_sort (group.begin(), group.end(), [&] (const size_t lhs, const size_t rhs)
+        {
+            return slotOf (lhs) != slotOf (rhs) ? slotOf (lhs) < slotOf (rhs) : codes[lhs] < codes[rhs];
+        });
+    }
+}
+
+
+void MyView::uploadMaterialsAndTextures (const std::vector<Material>& bufferMaterials, const std::vector<std::pair<std::string, tygra::Image>>& images)
+{
+    // Load the materials into the GPU and link the buffers together.
+    uploadMaterials (bufferMaterials, nullptr);
+
+    // Finally load the images onto the GPU.
+    uploadTextures (images);
+}
+
+
+void MyView::uploadMaterials (const std::vector<Material>& materials, const std::vector<size_t>* const slots)
+{
+    /// Material colours are almost always between zero and one and texture IDs are small integers, both of which half floats hold with no
+    /// visible difference, halving the size of the table and the bandwidth of every fetch. A buffer texture only has one format though, so
+    /// a single material which doesn't fit, such as an HDR colour or a texture ID beyond 2048, keeps the whole table at full precision.
+    /// The shaders read the same values either way.
+    const auto half     = std::all_of (materials.begin(), materials.end(), [] (const Material& material) { return material.fitsHalfPrecision(); });
+    const auto format   = half ? GL_RGBA16F : GL_RGBA32F;
+    const auto stride   = half ? sizeof (std::uint16_t) * 8 : sizeof (Material);
+
+    std::vector<std::uint16_t> packed { };
+
+    if (half)
+    {
+        packed.resize (materials.size() * 8);
+
+        for (size_t i = 0; i < materials.size(); ++i)
+        {
+            materials[i].packHalf (&packed[i * 8]);
+        }
+    }
+
+    const auto data = half ? static_cast<const void*> (packed.data()) : materials.data();
+
+    glBindBuffer (GL_TEXTURE_BUFFER, m_resources->materials.vbo);
+
+    // Reallocate when everything changes or the buffer needs to grow or change format, the TBO must then be pointed at the new storage.
+    if (!slots || materials.size() > m_resources->materialCapacity || half != m_resources->halfMaterials)
+    {
+        glBufferData (GL_TEXTURE_BUFFER, std::max (materials.size(), size_t (1)) * stride, materials.empty() ? nullptr : data, GL_STATIC_DRAW);
+        glBindBuffer (GL_TEXTURE_BUFFER, 0);
+
+        m_resources->materialCapacity   = materials.size();
+        m_resources->halfMaterials      = half;
+
+        glBindTexture (GL_TEXTURE_BUFFER, m_resources->materials.tbo);
+        glTexBuffer (GL_TEXTURE_BUFFER, format, m_resources->materials.vbo);
+        glBindTexture (GL_TEXTURE_BUFFER, 0);
+        return;
+    }
+
+    // Upload consecutive runs of changed slots together.
+    auto sorted = *slots;
+    std::sort (sorted.begin(), sorted.end());
+    sorted.erase (std::unique (sorted.begin(), sorted.end()), sorted.end());
+
+    const auto bytes = static_cast<const char*> (data);
+
+    for (size_t i = 0; i < sorted.size(); )
+    {
+        const auto first = sorted[i];
+        auto       last  = first;
+
+        while (++i < sorted.size() && sorted[i] == last + 1)
+        {
+            ++last;
+        }
+
+        glBufferSubData (GL_TEXTURE_BUFFER, first * stride, (last - first + 1) * stride, bytes + first * stride);
+    }
+
+    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+}
+
+
+void MyView::uploadTextures (const std::vector<std::pair<std::string, tygra::Image>>& images)
+{
+    // Virtual textures are paged in as they're needed, the texture array only has to exist for the sampler.
+    if (m_resources->virtualTextures)
+    {
+        prepareTextureData (1, 1, 1);
+        m_resources->virtualTextures->setTextures (images);
+        return;
+    }
+
+    if (!images.empty())
+    {
+        prepareTextureData (images[0].second.width(), images[0].second.height(), images.size());
+    }
+
+    // Just prepare the materials.
+    else
+    {
         prepareTextureData (1, 1, 1);
     }
 
-    // Finally load the images onto the GPU.
-    loadTexturesIntoArray (images);
+    loadTexturesIntoArray (images);
+}
+
+
+void MyView::constructVAO()
+{
+    /// Here we combine all vertex attributes into a 32-byte aligned interleaved VBO. The reason for this is that being a power of two maps
+    /// perfectly with the memory bus width of many GPUs, in this particular case a 256-bit wide memory bus could load a vertex in a single segment.
+    /// It also allows us to consolidate vertex-specific information into a unique buffer so we know where everything is.
+    ///
+    /// We also use a single VBO to store the entire scene, since the vertex attributes of every mesh in the scene is static and only the transformation
+    /// matrices change, we don't need to flexibility that having multiple VBOs provides. The VBO also contains meshes which are perfectly aligned to
+    /// the order of which we draw meshes, e.g. the third mesh in the draw loop is the third mesh stored in the GPU, potentially avoiding cache misses.
+    ///
+    /// Finally we use a single VAO for the scene because it allows us to avoid the cost required to bind a different VAO each mesh. Perhaps if we
+    /// separated the scene into static and dynamic objects with a different VAO for each there would be some benefit but in this case we don't.
+
+    // Obtain the attribute pointer locations we'll be using to construct the VAO.
+    int position        { glGetAttribLocation (m_program, "position") };
+    int normal          { glGetAttribLocation (m_program, "normal") };
+    int textureCoord    { glGetAttribLocation (m_program, "textureCoord") };
+
+    int modelTransform  { glGetAttribLocation (m_program, "model") };
+
+    // Initialise the VAO.
+    glBindVertexArray (m_sceneVAO);
+
+    // Bind the element buffer to the VAO.
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    // Enable each attribute pointer.
+    glEnableVertexAttribArray (position);
+    glEnableVertexAttribArray (normal);
+    glEnableVertexAttribArray (textureCoord);
+
+    // Begin creating the vertex attribute pointer from the interleaved buffer.
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+
+    // Set the properties of each attribute pointer.
+    glVertexAttribPointer (position,        3, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (0));
+    glVertexAttribPointer (normal,          3, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (12));
+    glVertexAttribPointer (textureCoord,    2, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (24));
+
+    // Now we need to create the instanced matrices attribute pointers.
+    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+
+    // Only the model matrix is instanced, the projection and view come from the UBO.
+    util::createInstancedMatrix4 (modelTransform, sizeof (glm::mat4));
+
+    // The depth pre-pass only needs positions, which the position stream packs into 12 bytes rather than the 32 of a whole vertex. The
+    // depth shaders use the same attribute locations so anything which redirects the instanced transforms works on either VAO.
+    if (m_resources->positionVBO != 0)
+    {
+        glBindVertexArray (m_depthVAO);
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+        glBindBuffer (GL_ARRAY_BUFFER, m_resources->positionVBO);
+        glEnableVertexAttribArray (position);
+        glVertexAttribPointer (position, 3, GL_FLOAT, GL_FALSE, sizeof (glm::vec3), TGL_BUFFER_OFFSET (0));
+
+        glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+        util::createInstancedMatrix4 (modelTransform, sizeof (glm::mat4));
+    }
+
+    // The boxes of occlusion queries are built from vertex IDs, only their instances are read and each box points them at its own.
+    glBindVertexArray (m_occlusionVAO);
+    glBindBuffer (GL_ARRAY_BUFFER, m_occlusionTransforms);
+    util::createInstancedMatrix4 (modelTransform, sizeof (glm::mat4));
+
+    // Unbind all buffers.
+    glBindVertexArray (0);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+void MyView::allocatePositions (const size_t vertexCount)
+{
+    if (m_resources->positionVBO != 0)
+    {
+        util::allocateBuffer (m_resources->positionVBO, vertexCount * sizeof (glm::vec3), GL_COPY_WRITE_BUFFER, GL_STATIC_DRAW);
+    }
+}
+
+
+void MyView::uploadPositions (const Vertex* const vertices, const size_t count, const size_t verticesIndex)
+{
+    if (m_resources->positionVBO == 0 || count == 0)
+    {
+        return;
+    }
+
+    // The positions sit at the same index as their vertex so meshes use the same base vertex and elements in either VAO.
+    std::vector<glm::vec3> positions (count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        positions[i] = vertices[i].position;
+    }
+
+    // The copy target leaves whichever buffers the caller has bound alone.
+    glBindBuffer (GL_COPY_WRITE_BUFFER, m_resources->positionVBO);
+    glBufferSubData (GL_COPY_WRITE_BUFFER, verticesIndex * sizeof (glm::vec3), count * sizeof (glm::vec3), positions.data());
+    glBindBuffer (GL_COPY_WRITE_BUFFER, 0);
+}
+
+
+size_t MyView::uploadElements (Mesh& mesh, const unsigned int* const elements, const size_t count, const size_t elementIndex)
+{
+    /// Strips send roughly one index per triangle instead of three, but each break between strips costs a restart index, so meshes made of
+    /// scattered triangles can come out larger. Each mesh uses whichever is smaller and the draw calls pick the primitive per mesh.
+    const auto strips       = m_resources->stripify ? util::stripify (elements, count, &m_resources->stripStatistics) : std::vector<unsigned int> { };
+    const auto useStrips    = !strips.empty();
+    const auto written      = useStrips ? strips.size() : count;
+
+    glBufferSubData (GL_ELEMENT_ARRAY_BUFFER, elementIndex * sizeof (unsigned int), written * sizeof (unsigned int), useStrips ? strips.data() : elements);
+
+    mesh.elementsOffset = elementIndex * sizeof (unsigned int);
+    mesh.elementCount   = written;
+    mesh.strips         = useStrips;
+
+    return written;
+}
+
+
+void MyView::prepareTextureData (const GLsizei textureWidth, const GLsizei textureHeight, const GLsizei textureCount)
+{
+    // Remember the dimensions so textures can be replaced individually.
+    m_resources->textureWidth  = textureWidth;
+    m_resources->textureHeight = textureHeight;
+
+    // Activate the material TBO by pointing it to the material VBO.
+    glBindTexture (GL_TEXTURE_BUFFER, m_resources->materials.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, m_resources->halfMaterials ? GL_RGBA16F : GL_RGBA32F, m_resources->materials.vbo);
+
+    // Do the same for the material ID instance pool.
+    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_poolMaterialIDs.vbo);
+
+    // Enable the 2D texture array and prepare its storage. Use 4 mipmap levels.
+    glBindTexture (GL_TEXTURE_2D_ARRAY, m_resources->textureArray);
+    glTexStorage3D (GL_TEXTURE_2D_ARRAY, 4, GL_RGBA32F, textureWidth, textureHeight, textureCount);
+
+    // Enable standard filters.
+    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_MAG_FILTER,  GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_MIN_FILTER,  GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_WRAP_S,      GL_REPEAT);
+    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_WRAP_T,      GL_REPEAT);
+
+    // Unbind the textures.
+    glBindTexture (GL_TEXTURE_BUFFER, 0);
+    glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+}
+
+
+void MyView::loadTexturesIntoArray (const std::vector<std::pair<std::string, tygra::Image>>& images)
+{
+    /// Here we load a container of images into the GPU using a 2D texture array. The reason I've chosen this route is that it means that I can avoid binding
+    /// a different texture every time the material changes. Instead of binding the correct texture we just provide an ID in each material which links to the
+    /// texture in the array. Therefore we avoid binding calls, we store the materials in the GPU so the information is easily accessible and if a shader
+    /// decided it wanted to combine textures it can.
+
+    glBindTexture (GL_TEXTURE_2D_ARRAY, m_resources->textureArray); 
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        loadTextureIntoLayer (images[i].second, (GLsizei) i);
+    }
+    
+    // Generate the mipmaps from the loaded texture and finish.
+    glGenerateMipmap (GL_TEXTURE_2D_ARRAY);
+    glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+}
+
+
+void MyView::loadTextureIntoLayer (const tygra::Image& image, const GLsizei layer)
+{
+    // Only load the image if it contains data.
+    if (image.containsData()) 
+    {
+        // Enable each different pixel format.
+        GLenum pixel_formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+
+        glTexSubImage3D (   GL_TEXTURE_2D_ARRAY, 0, 
+                
+                            // Offsets.
+                            0, 0, layer,
+                            
+                            // Dimensions and border.
+                            image.width(), image.height(), 1,   
+                      
+                            // Format and type.
+                            pixel_formats[image.componentsPerPixel()], image.bytesPerComponent() == 1 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT,
+                      
+                            // Data.
+                            image.pixels());
+    }
+}
+
+
+size_t MyView::highestInstanceCount() const
+{
+    // We'll need a temporary variable to keep track.
+    size_t highest  { 0 };
+
+    if (m_imported)
+    {
+        for (const auto& instances : m_resources->importedInstances)
+        {
+            if (instances.size() > highest)
+            {
+                highest = instances.size();
+            }
+        }
+
+        return highest;
+    }
+   
+    // Iterate through each mesh.
+    for (const auto& instances : m_sceneInstances)
+    {
+        const auto current = instances.size();
+
+        if (current > highest)
+        {
+            highest = current;
+        }
+    }
+
+    // Return the calculated figure.
+    return highest;
+}
+
+#pragma endregion
+
+
+#pragma region Hot reloading
+
+void MyView::applySceneUpdate()
+{
+    /// Hot reloading compares the freshly imported scene with the loaded one (on the thread which imported it) and only the differences
+    /// reach the GPU. Changed data is written into the buffer ranges it already owns; meshes which outgrow their range move to the headroom
+    /// at the end of the buffers and only when that runs out are the buffers reallocated. Textures are replaced layer by layer unless the
+    /// list of textures itself has changed. Assets which weren't referenced before are loaded now if the update references them.
+    if (m_pendingContent && !m_imported)
+    {
+        applySceneContent();
+        return;
+    }
+
+    if (!m_pendingScene || !m_imported)
+    {
+        return;
+    }
+
+    const auto start        = std::chrono::steady_clock::now();
+    const auto diff         = std::move (m_pendingDiff);
+    m_imported              = std::move (m_pendingScene);
+    m_cullSource            = nullptr;
+    m_panoramaValid         = false;
+    m_cacheValid            = false;
+
+    // Meshes may be reordered so the results of their queries no longer mean anything.
+    releaseOcclusionQueries();
+
+    // Views which share resources receive the same updates, whichever applies it first uploads it for the rest.
+    auto reallocated = false;
+
+    {
+        std::lock_guard<std::mutex> lock { m_resources->mutex };
+
+        if (m_resources->imported != m_imported)
+        {
+            const auto references       = util::findReferences (*m_imported);
+
+            reallocated                 = updateImportedMeshes (*diff, references);
+            const auto layersChanged    = updateImportedTextures (*diff, references);
+            updateImportedMaterials (*diff, references, layersChanged);
+
+            // Instances only live on the CPU until they're drawn so regrouping them is cheap, the pools may need to grow though.
+            groupImportedInstances();
+            m_resources->imported = m_imported;
+        }
+    }
+
+    if (highestInstanceCount() > m_instancePoolSize)
+    {
+        allocateInstancePools();
+
+        glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+        glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_poolMaterialIDs.vbo);
+        glBindTexture (GL_TEXTURE_BUFFER, 0);
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+    std::cout   << "Scene update applied in " << milliseconds << "ms: " << diff->meshes.size() << " meshes, " << diff->materials.size() << " materials and "
+                << diff->textures.size() << " textures changed" << (reallocated ? ", geometry buffers reallocated." : ".") << std::endl;
+}
+
+
+bool MyView::updateImportedMeshes (const SceneDiff& diff, const SceneReferences& references)
+{
+    const auto& scene = *m_imported;
+
+    // Removed meshes simply abandon their buffer ranges.
+    while (m_resources->meshes.size() > scene.meshes.size())
+    {
+        delete m_resources->meshes.back().second;
+        m_resources->meshes.pop_back();
+        m_resources->meshCapacities.pop_back();
+        m_resources->residentMeshes.pop_back();
+    }
+
+    // New meshes start off without any data.
+    while (m_resources->meshes.size() < scene.meshes.size())
+    {
+        m_resources->meshes.push_back ({ static_cast<SceneModel::MeshId> (m_resources->meshes.size()), new Mesh() });
+        m_resources->meshCapacities.push_back ({ 0, 0 });
+        m_resources->residentMeshes.push_back (false);
+    }
+
+    // Removed meshes leave the draw order and new meshes are drawn last, the order is only worth recalculating when everything is laid out again.
+    auto& order = m_resources->meshOrder;
+    order.erase (std::remove_if (order.begin(), order.end(), [&scene] (const size_t index) { return index >= scene.meshes.size(); }), order.end());
+
+    for (auto index = order.size(); index < scene.meshes.size(); ++index)
+    {
+        order.push_back (index);
+    }
+
+    // Changed meshes need uploading, as do referenced meshes which have never been uploaded. Unreferenced meshes are left out.
+    std::vector<char> pending (scene.meshes.size(), 0);
+
+    for (const auto index : diff.meshes)
+    {
+        pending[index] = 1;
+    }
+
+    // Work out where every pending mesh will go before touching the buffers, if anything doesn't fit we start again with bigger buffers.
+    // Kept an aggregate so placements can be brace-initialised, VS2013 doesn't allow that with default member initialisers.
+    struct Placement final
+    {
+        size_t  mesh;           //!< The index of the mesh in the imported scene.
+        size_t  verticesIndex;  //!< The first vertex the mesh will occupy.
+        size_t  elementIndex;   //!< The first element the mesh will occupy.
+        bool    appended;       //!< Whether the mesh goes at the end of the buffers rather than over its old place.
+    };
+
+    std::vector<Placement>  placements      { };
+    auto                    vertexUsage     = m_resources->vertexUsage;
+    auto                    elementUsage    = m_resources->elementUsage;
+
+    for (size_t index = 0; index < pending.size(); ++index)
+    {
+        if (!references.meshes[index])
+        {
+            // Changed data which nothing uses isn't worth uploading, the mesh will be uploaded if it's referenced again.
+            if (pending[index])
+            {
+                m_resources->meshes[index].second->elementCount    = 0;
+                m_resources->residentMeshes[index]                 = false;
+            }
+
+            continue;
+        }
+
+        if (!pending[index] && m_resources->residentMeshes[index])
+        {
+            continue;
+        }
+
+        const auto vertexCount  = scene.vertexCountOf (index);
+        const auto elementCount = scene.meshes[index].elementCount;
+
+        // Prefer the range which the mesh already owns.
+        if (vertexCount <= m_resources->meshCapacities[index].first && elementCount <= m_resources->meshCapacities[index].second)
+        {
+            const auto& mesh = *m_resources->meshes[index].second;
+            placements.push_back ({ index, (size_t) mesh.verticesIndex, mesh.elementsOffset / sizeof (unsigned int), false });
+        }
+
+        else if (vertexUsage + vertexCount <= m_resources->vertexCapacity && elementUsage + elementCount <= m_resources->elementCapacity)
+        {
+            placements.push_back ({ index, vertexUsage, elementUsage, true });
+            vertexUsage     += vertexCount;
+            elementUsage    += elementCount;
+        }
+
+        else
+        {
+            // The scene has outgrown the buffers so lay everything out again from scratch. The resources themselves stay, other views
+            // may hold them and the caller holds their mutex.
+            m_resources->clearMeshes();
+            buildImportedMeshData();
+            return true;
+        }
+    }
+
+    m_resources->vertexUsage   = vertexUsage;
+    m_resources->elementUsage  = elementUsage;
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    for (const auto& placement : placements)
+    {
+        uploadImportedMesh (placement.mesh, placement.verticesIndex, placement.elementIndex);
+
+        if (placement.appended)
+        {
+            m_resources->meshCapacities[placement.mesh] = { scene.vertexCountOf (placement.mesh), scene.meshes[placement.mesh].elementCount };
+        }
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return false;
+}
+
+
+bool MyView::updateImportedTextures (const SceneDiff& diff, const SceneReferences& references)
+{
+    // Referenced textures which have never been loaded need a layer of their own, as do rearranged textures, which means a new texture array.
+    auto rebuild = diff.texturesMoved;
+
+    for (size_t i = 0; !rebuild && i < m_resources->textureLayers.size(); ++i)
+    {
+        rebuild = references.textures[i] && m_resources->textureLayers[i] == unloadedTexture;
+    }
+
+    // Otherwise the changed files can be written over their existing layers.
+    if (!rebuild)
+    {
+        std::vector<std::pair<GLsizei, tygra::Image>> replacements { };
+        std::vector<std::future<tygra::Image>>          decoding     { };
+
+        // Start decoding every changed texture before any are needed.
+        const auto pool = decodingPool();
+
+        for (const auto index : diff.textures)
+        {
+            const auto& file = m_imported->textures[index];
+            decoding.push_back (pool && references.textures[index] ? pool->submit ([file] () { return tygra::imageFromPNG (file); }) : std::future<tygra::Image> { });
+        }
+
+        for (size_t i = 0; i < diff.textures.size(); ++i)
+        {
+            // Unreferenced textures are reloaded if they're ever needed again.
+            const auto index = diff.textures[i];
+
+            if (!references.textures[index])
+            {
+                m_resources->textureLayers[index] = unloadedTexture;
+                continue;
+            }
+
+            auto image = decoding[i].valid() ? decoding[i].get() : tygra::imageFromPNG (m_imported->textures[index]);
+
+            // Virtual textures don't care about size, every layer of the texture array must match though.
+            const auto resized = !m_resources->virtualTextures && (image.width() != m_resources->textureWidth || image.height() != m_resources->textureHeight);
+
+            // Writing over a layer which other textures share would change them too.
+            const auto shared = std::count (m_resources->textureLayers.begin(), m_resources->textureLayers.end(), m_resources->textureLayers[index]) > 1;
+
+            if (m_resources->textureLayers[index] < 0.f || !image.containsData() || resized || shared)
+            {
+                rebuild = true;
+                break;
+            }
+
+            replacements.push_back ({ (GLsizei) m_resources->textureLayers[index], std::move (image) });
+        }
+
+        if (!rebuild)
+        {
+            if (m_resources->virtualTextures)
+            {
+                for (const auto& replacement : replacements)
+                {
+                    m_resources->virtualTextures->replaceTexture (replacement.first, replacement.second);
+                }
+            }
+
+            else if (!replacements.empty())
+            {
+                glBindTexture (GL_TEXTURE_2D_ARRAY, m_resources->textureArray);
+
+                for (const auto& replacement : replacements)
+                {
+                    loadTextureIntoLayer (replacement.second, replacement.first);
+                }
+
+                glGenerateMipmap (GL_TEXTURE_2D_ARRAY);
+                glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+            }
+
+            return false;
+        }
+    }
+
+    // The texture array has immutable storage so rearranging or resizing the textures requires a new one.
+    glDeleteTextures (1, &m_resources->textureArray);
+    glGenTextures (1, &m_resources->textureArray);
+
+    std::vector<std::pair<std::string, tygra::Image>> images { };
+    loadImportedTextures (images, references);
+    uploadTextures (images);
+
+    return true;
+}
+
+
+void MyView::updateImportedMaterials (const SceneDiff& diff, const SceneReferences& references, const bool uploadAll)
+{
+    /// Identical materials share a slot, so an edit can merge a material into another slot or split it out of a shared one, shifting
+    /// every slot after it. Laying the slots out again costs far less than uploading them so it's always done, then only the slots of
+    /// changed and newly referenced materials are uploaded unless any material moved. Moved materials leave the IDs already resolved
+    /// for host streams pointing at the wrong slots, so the version is bumped to have them resolved again.
+    const auto previous         = m_resources->materialSlots;
+    const auto bufferMaterials  = layoutImportedMaterials (references);
+
+    std::vector<size_t> slots { };
+    auto                moved = false;
+
+    for (size_t i = 0; i < m_resources->materialSlots.size(); ++i)
+    {
+        const auto before   = i < previous.size() ? previous[i] : -1;
+        const auto after    = m_resources->materialSlots[i];
+
+        if (before >= 0 && before != after)
+        {
+            moved = true;
+        }
+
+        // Newly referenced materials.
+        else if (before < 0 && after >= 0)
+        {
+            slots.push_back (after);
+        }
+    }
+
+    for (const auto index : diff.materials)
+    {
+        if (index < m_resources->materialSlots.size() && m_resources->materialSlots[index] >= 0)
+        {
+            slots.push_back (m_resources->materialSlots[index]);
+        }
+    }
+
+    if (moved)
+    {
+        ++m_resources->materialVersion;
+    }
+
+    if (uploadAll || moved || bufferMaterials.size() != m_resources->materialCapacity)
+    {
+        uploadMaterials (bufferMaterials, nullptr);
+    }
+
+    else if (!slots.empty())
+    {
+        uploadMaterials (bufferMaterials, &slots);
+    }
+}
+
+
+void MyView::loadMissingAssets()
+{
+    /// Streams and prefabs can refer to sponza meshes and materials which no instance of the scene uses, so they weren't uploaded with
+    /// the scene. Whatever they referred to since the last frame is uploaded before this frame is drawn, so they're drawn a frame late
+    /// rather than never. References to assets which the scene doesn't have at all are reported once and counted in the statistics.
+    if (!m_imported && (!m_missingMeshes.empty() || !m_missingMaterials.empty()))
+    {
+        std::lock_guard<std::mutex> lock { m_resources->mutex };
+
+        const auto lateMeshes       = m_lateMeshes;
+        const auto lateMaterials    = m_lateMaterials;
+
+        loadMissingMeshes();
+        loadMissingMaterials();
+
+        // Captured vertices and the panorama both hold material IDs which may have moved.
+        if (m_lateMeshes != lateMeshes || m_lateMaterials != lateMaterials)
+        {
+            m_panoramaValid = false;
+            m_cacheValid    = false;
+        }
+    }
+
+    // Meshes added by this view or any other sharing the resources change the meshes which the instances of this view are ordered by.
+    if (!m_imported && m_meshVersion != m_resources->meshVersion)
+    {
+        orderSceneInstances();
+        releaseOcclusionQueries();
+
+        m_cullSource    = nullptr;
+        m_panoramaValid = false;
+        m_cacheValid    = false;
+    }
+}
+
+
+void MyView::loadMissingMeshes()
+{
+    const auto& builder     = SceneModel::GeometryBuilder();
+    const auto& allMeshes   = builder.getAllMeshes();
+
+    std::vector<const SceneModel::Mesh*> meshes { };
+
+    for (const auto id : m_missingMeshes)
+    {
+        // Another view sharing the resources may have uploaded it already.
+        if (findMesh (id) || m_unknownMeshes.count (id) != 0)
+        {
+            continue;
+        }
+
+        const auto mesh = std::find_if (allMeshes.begin(), allMeshes.end(), [id] (const SceneModel::Mesh& mesh) { return mesh.getId() == id; });
+
+        if (mesh == allMeshes.end())
+        {
+            m_unknownMeshes.insert (id);
+            std::cerr << "Mesh " << id << " isn't part of the scene, streams and prefabs using it won't be drawn." << std::endl;
+            continue;
+        }
+
+        meshes.push_back (&*mesh);
+    }
+
+    m_missingMeshes.clear();
+
+    if (meshes.empty())
+    {
+        return;
+    }
+
+    // Keep the layout the same however the set was ordered.
+    std::sort (meshes.begin(), meshes.end(), [] (const SceneModel::Mesh* lhs, const SceneModel::Mesh* rhs) { return lhs->getId() < rhs->getId(); });
+
+    std::vector<std::vector<Vertex>>    vertices        (meshes.size());
+    size_t                              vertexCount     { 0 };
+    size_t                              elementCount    { 0 };
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        util::assembleVertices (vertices[i], *meshes[i]);
+
+        vertexCount     += vertices[i].size();
+        elementCount    += meshes[i]->getElementArray().size();
+
+        // Remembered so they're kept whenever the meshes are laid out again.
+        m_resources->lateMeshes.insert (meshes[i]->getId());
+    }
+
+    m_lateMeshes += meshes.size();
+    ++m_resources->meshVersion;
+
+    // Appending leaves every other mesh where it is, once the headroom runs out everything is laid out again with the new meshes included.
+    // The buffers keep their names either way so the VAOs of every view sharing them stay valid.
+    if (m_resources->vertexUsage + vertexCount > m_resources->vertexCapacity || m_resources->elementUsage + elementCount > m_resources->elementCapacity)
+    {
+        m_resources->clearMeshes();
+        buildMeshData();
+
+        std::cout << "Uploaded " << meshes.size() << " meshes when first referenced, the geometry buffers were reallocated." << std::endl;
+        return;
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const auto& elements = meshes[i]->getElementArray();
+
+        Mesh* newMesh { new Mesh() };
+        appendSceneMesh (*newMesh, vertices[i].data(), vertices[i].size(), elements.data(), elements.size());
+
+        // New meshes are drawn last, the order is only worth recalculating when everything is laid out again.
+        m_resources->meshOrder.push_back (m_resources->meshes.size());
+        m_resources->meshes.push_back ({ meshes[i]->getId(), newMesh });
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    std::cout << "Uploaded " << meshes.size() << " meshes when first referenced." << std::endl;
+}
+
+
+void MyView::loadMissingMaterials()
+{
+    const auto& allMaterials = m_content->getAllMaterials();
+
+    std::vector<SceneModel::Material>           materials   { };
+    std::unordered_set<SceneModel::MaterialId>  added       { };
+
+    for (const auto id : m_missingMaterials)
+    {
+        // Another view sharing the resources may have uploaded it already.
+        const auto materialId = static_cast<SceneModel::MaterialId> (id);
+
+        if (m_resources->materialIDs.count (materialId) != 0 || m_unknownMaterials.count (id) != 0)
+        {
+            continue;
+        }
+
+        const auto material = std::find_if (allMaterials.begin(), allMaterials.end(), [materialId] (const SceneModel::Material& material) { return material.getId() == materialId; });
+
+        if (material == allMaterials.end())
+        {
+            m_unknownMaterials.insert (id);
+            std::cerr << "Material " << id << " isn't part of the scene, instances using it are drawn with the first material." << std::endl;
+            continue;
+        }
+
+        materials.push_back (*material);
+        added.insert (materialId);
+    }
+
+    m_missingMaterials.clear();
+
+    if (materials.empty())
+    {
+        return;
+    }
+
+    // Streams resolved these materials to the first one whilst they were missing.
+    m_lateMaterials += materials.size();
+    ++m_resources->materialVersion;
+
+    const auto& layers          = m_resources->sceneTextureLayers;
+    const auto  texturesLoaded  = std::all_of (materials.begin(), materials.end(), [&layers] (const SceneModel::Material& material)
+    {
+        return material.getAmbientMap().empty() || layers.count (material.getAmbientMap()) != 0;
+    });
+
+    // Materials whose textures are already in the texture array only need slots of their own.
+    if (texturesLoaded)
+    {
+        std::vector<size_t> slots { };
+
+        for (const auto& material : materials)
+        {
+            slots.push_back (m_resources->sceneMaterials.size());
+            m_resources->sceneMaterials.push_back (createMaterial (material, layers));
+            m_resources->materialIDs.emplace (material.getId(), MaterialID (slots.back()) * 2);
+        }
+
+        m_resources->materialCount = m_resources->sceneMaterials.size();
+        uploadMaterials (m_resources->sceneMaterials, &slots);
+
+        std::cout << "Uploaded " << materials.size() << " materials when first referenced." << std::endl;
+        return;
+    }
+
+    // The texture array has immutable storage so new textures need a new one, every loaded material is laid out again along with it.
+    std::vector<SceneModel::Material> loaded { };
+
+    for (const auto& material : allMaterials)
+    {
+        if (m_resources->materialIDs.count (material.getId()) != 0 || added.count (material.getId()) != 0)
+        {
+            loaded.push_back (material);
+        }
+    }
+
+    glDeleteTextures (1, &m_resources->textureArray);
+    glGenTextures (1, &m_resources->textureArray);
+
+    loadSceneMaterials (loaded);
+
+    std::cout << "Uploaded " << materials.size() << " materials when first referenced, the textures were reloaded." << std::endl;
+}
+
+
+void MyView::requestMesh (const SceneModel::MeshId id)
+{
+    // Imported meshes are uploaded whenever the scene references them, so anything missing isn't in the scene at all.
+    if (m_imported)
+    {
+        if (m_resources && !findMesh (id) && m_unknownMeshes.insert (id).second)
+        {
+            std::cerr << "Mesh " << id << " isn't part of the imported scene, streams and prefabs using it won't be drawn." << std::endl;
+        }
+
+        return;
+    }
+
+    // Without resources the mesh is checked once they've been built.
+    if ((!m_resources || !findMesh (id)) && m_unknownMeshes.count (id) == 0)
+    {
+        m_missingMeshes.insert (id);
+    }
+}
+
+
+void MyView::applySceneContent()
+{
+    /// SceneModel reads sponza from its file whenever a context is constructed, so a change to the file is read into a fresh context and
+    /// compared with the loaded content as tables, the same way as an imported scene. The camera and lights stay with the scene so the
+    /// view doesn't jump back to where the file starts. Changed meshes are appended to the headroom of the geometry buffers, abandoning
+    /// their old ranges, and everything is laid out again once the headroom runs out. Materials are few enough to lay out again whenever
+    /// anything changes, the textures are only reloaded when a texture changed or a material needs one which isn't loaded.
+    const auto start        = std::chrono::steady_clock::now();
+    const auto diff         = std::move (m_pendingDiff);
+    const auto tables       = std::move (m_pendingTables);
+    m_content               = std::move (m_pendingContent);
+    m_cullSource            = nullptr;
+    m_panoramaValid         = false;
+    m_cacheValid            = false;
+
+    releaseOcclusionQueries();
+
+    // Views which share resources receive the same content, whichever applies it first uploads it for the rest.
+    auto reallocated = false;
+
+    {
+        std::lock_guard<std::mutex> lock { m_resources->mutex };
+
+        if (m_resources->sceneTables != tables)
+        {
+            reallocated = updateSceneMeshes (*tables, *diff);
+            updateSceneMaterials (*diff);
+
+            m_resources->sceneTables = tables;
+            ++m_resources->meshVersion;
+        }
+
+        orderSceneInstances();
+    }
+
+    if (highestInstanceCount() > m_instancePoolSize)
+    {
+        allocateInstancePools();
+
+        glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+        glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_poolMaterialIDs.vbo);
+        glBindTexture (GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Assets which weren't in the old content may be in the new one, streams ask for their meshes again.
+    m_unknownMeshes.clear();
+    m_unknownMaterials.clear();
+
+    for (const auto& pair : m_instanceStreams)
+    {
+        requestMesh (pair.first);
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+    std::cout   << "Scene content applied in " << milliseconds << "ms: " << diff->meshes.size() << " meshes, " << diff->materials.size() << " materials and "
+                << diff->textures.size() << " textures changed" << (reallocated ? ", geometry buffers reallocated." : ".") << std::endl;
+}
+
+
+bool MyView::updateSceneMeshes (const SceneModelTables& tables, const SceneDiff& diff)
+{
+    const auto& scene = tables.scene;
+
+    std::vector<char> changed (scene.meshes.size(), 0);
+
+    for (const auto index : diff.meshes)
+    {
+        changed[index] = 1;
+    }
+
+    // Changed meshes need uploading if they're drawn, as do meshes which instances use for the first time. Meshes which have left the
+    // file keep their old data until everything is laid out again, only streams and prefabs could still be drawing them.
+    std::vector<size_t> pending         { };
+    size_t              vertexCount     { 0 };
+    size_t              elementCount    { 0 };
+
+    for (size_t index = 0; index < scene.meshes.size(); ++index)
+    {
+        const auto id       = tables.meshIds[index];
+        const auto resident = findMesh (id) != nullptr;
+        const auto used     = !m_content->getInstancesByMeshId (id).empty() || m_resources->lateMeshes.count (id) != 0;
+
+        if ((changed[index] && resident) || (!resident && used))
+        {
+            pending.push_back (index);
+            vertexCount     += scene.vertexCountOf (index);
+            elementCount    += scene.meshes[index].elementCount;
+        }
+    }
+
+    if (pending.empty())
+    {
+        return false;
+    }
+
+    if (m_resources->vertexUsage + vertexCount > m_resources->vertexCapacity || m_resources->elementUsage + elementCount > m_resources->elementCapacity)
+    {
+        // The resources themselves stay, other views may hold them and the caller holds their mutex.
+        m_resources->clearMeshes();
+        buildMeshData();
+        return true;
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_resources->vertexVBO);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+
+    for (const auto index : pending)
+    {
+        const auto  id      = tables.meshIds[index];
+        const auto& source  = scene.meshes[index];
+        auto        mesh    = std::find_if (m_resources->meshes.begin(), m_resources->meshes.end(), [id] (const std::pair<SceneModel::MeshId, Mesh*>& pair) { return pair.first == id; });
+
+        // New meshes are drawn last, the order is only worth recalculating when everything is laid out again.
+        if (mesh == m_resources->meshes.end())
+        {
+            m_resources->meshOrder.push_back (m_resources->meshes.size());
+            m_resources->meshes.push_back ({ id, new Mesh() });
+            mesh = m_resources->meshes.end() - 1;
+        }
+
+        appendSceneMesh (*mesh->second, scene.vertices.data() + source.verticesIndex, scene.vertexCountOf (index), 
+                         scene.elements.data() + source.elementsOffset / sizeof (unsigned int), source.elementCount);
+    }
+
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    return false;
+}
+
+
+void MyView::updateSceneMaterials (const SceneDiff& diff)
+{
+    if (diff.materials.empty() && diff.textures.empty() && !diff.instancesChanged)
+    {
+        return;
+    }
+
+    // Keep every material which was loaded and add any which instances use for the first time, scene instances must always find theirs.
+    std::unordered_set<SceneModel::MaterialId> referenced { };
+
+    for (const auto& pair : m_resources->meshes)
+    {
+        for (const auto instance : m_content->getInstancesByMeshId (pair.first))
+        {
+            referenced.insert (m_content->getInstanceById (instance).getMaterialId());
+        }
+    }
+
+    std::vector<SceneModel::Material> materials { };
+
+    for (const auto& material : m_content->getAllMaterials())
+    {
+        if (referenced.count (material.getId()) != 0 || m_resources->materialIDs.count (material.getId()) != 0)
+        {
+            materials.push_back (material);
+        }
+    }
+
+    // Slots may have moved so streams must resolve their material IDs again.
+    ++m_resources->materialVersion;
+
+    const auto& layers          = m_resources->sceneTextureLayers;
+    const auto  texturesLoaded  = diff.textures.empty() && std::all_of (materials.begin(), materials.end(), [&layers] (const SceneModel::Material& material)
+    {
+        return material.getAmbientMap().empty() || layers.count (material.getAmbientMap()) != 0;
+    });
+
+    if (texturesLoaded)
+    {
+        layoutSceneMaterials (materials);
+        uploadMaterials (m_resources->sceneMaterials, nullptr);
+        return;
+    }
+
+    // The texture array has immutable storage so changed textures need a new one.
+    glDeleteTextures (1, &m_resources->textureArray);
+    glGenTextures (1, &m_resources->textureArray);
+
+    loadSceneMaterials (materials);
+}
+
+
+void MyView::appendSceneMesh (Mesh& mesh, const Vertex* const vertices, const size_t vertexCount, const unsigned int* const elements, const size_t elementCount)
+{
+    const auto verticesIndex = m_resources->vertexUsage;
+
+    glBufferSubData (GL_ARRAY_BUFFER, verticesIndex * sizeof (Vertex), vertexCount * sizeof (Vertex), vertices);
+    const auto written = uploadElements (mesh, elements, elementCount, m_resources->elementUsage);
+    uploadPositions (vertices, vertexCount, verticesIndex);
+
+    mesh.verticesIndex          = (GLint) verticesIndex;
+    mesh.vertexCount            = vertexCount;
+    mesh.setBounds (vertices, vertexCount);
+
+    m_resources->vertexUsage   += vertexCount;
+    m_resources->elementUsage  += written;
+}
+
+#pragma endregion
+
+
+#pragma region Clean up
+
+void MyView::windowViewDidStop (std::shared_ptr<tygra::Window> window)
+{    
+    // A pending shader rebuild would otherwise create a program after the context has gone.
+    m_shaderReload.cancel();
+
+    // Images being encoded are written into the shared block of the server, which must outlive them.
+    for (const auto& encode : m_serverEncodes)
+    {
+        encode.wait();
+    }
+
+    m_serverEncodes.clear();
+
+    // Clean up after ourselves by getting rid of the stored meshes/materials.
+    cleanMeshMaterials();
+
+    // Clean up the OpenGL side of things.
+    deleteOpenGLObjects();
+}
+
+
+void MyView::cleanMeshMaterials()
+{
+    // The meshes and materials belong to the resources, which go with the last view using them.
+    m_resources.reset();
+}
+
+
+void MyView::deleteOpenGLObjects()
+{
+    // Any frames still in flight no longer need waiting on.
+    for (auto fence : m_frameFences)
+    {
+        glDeleteSync (fence);
+    }
+
+    m_frameFences.clear();
+
+    // Delete the programs.
+    glDeleteProgram (m_program);
+    glDeleteProgram (m_panoramaProgram);
+    
+    // Delete the VAOs.
+    glDeleteVertexArrays (1, &m_sceneVAO);
+    glDeleteVertexArrays (1, &m_panoramaVAO);
+    
+    // Delete all VBOs.
+    glDeleteBuffers (1, &m_uniformUBO);
+    glDeleteBuffers (1, &m_poolMaterialIDs.vbo);
+    glDeleteBuffers (1, &m_poolTransforms);
+
+    // Delete all textures.
+    glDeleteTextures (1, &m_poolMaterialIDs.tbo);
+
+    // Host streams own buffers of their own.
+    for (auto& pair : m_instanceStreams)
+    {
+        glDeleteBuffers (1, &pair.second->transforms);
+        glDeleteBuffers (1, &pair.second->materialIDs.vbo);
+        glDeleteTextures (1, &pair.second->materialIDs.tbo);
+
+        delete pair.second;
+    }
+
+    m_instanceStreams.clear();
+
+    for (auto prefab : m_prefabs)
+    {
+        if (prefab)
+        {
+            glDeleteBuffers (1, &prefab->placements.transforms);
+            glDeleteBuffers (1, &prefab->placements.materialIDs.vbo);
+            glDeleteTextures (1, &prefab->placements.materialIDs.tbo);
+
+            delete prefab;
+        }
+    }
+
+    m_prefabs.clear();
+
+    // Delete the render server framebuffer.
+    glDeleteFramebuffers (1, &m_serverFramebuffer);
+    glDeleteRenderbuffers (1, &m_serverColour);
+    glDeleteRenderbuffers (1, &m_serverDepth);
+
+    m_serverFramebuffer = 0;
+    m_serverColour      = 0;
+    m_serverDepth       = 0;
+    m_serverWidth       = 0;
+    m_serverHeight      = 0;
+
+    // Delete the feedback pass.
+    if (m_feedbackFramebuffer != 0)
+    {
+        glDeleteFramebuffers (1, &m_feedbackFramebuffer);
+        glDeleteRenderbuffers (1, &m_feedbackTarget);
+        glDeleteRenderbuffers (1, &m_feedbackDepth);
+        glDeleteBuffers (2, m_feedbackBuffers);
+    }
+
+    m_feedbackFramebuffer   = 0;
+    m_feedbackTarget        = 0;
+    m_feedbackDepth         = 0;
+    m_feedbackWidth         = 0;
+    m_feedbackHeight        = 0;
+    m_feedbackFrame         = 0;
+
+    // Delete the transform cache.
+    releaseTransformCache();
+    glDeleteProgram (m_captureProgram);
+    m_captureProgram = 0;
+
+    // Delete the depth pre-pass.
+    glDeleteProgram (m_depthProgram);
+    glDeleteVertexArrays (1, &m_depthVAO);
+
+    m_depthProgram  = 0;
+    m_depthVAO      = 0;
+
+    // Delete the occlusion queries.
+    releaseOcclusionQueries();
+    glDeleteProgram (m_occlusionProgram);
+    glDeleteVertexArrays (1, &m_occlusionVAO);
+    glDeleteBuffers (1, &m_occlusionTransforms);
+
+    m_occlusionProgram      = 0;
+    m_occlusionVAO          = 0;
+    m_occlusionTransforms   = 0;
+
+    // Delete the wireframe overlay.
+    glDeleteProgram (m_wireframeProgram);
+    m_wireframeProgram = 0;
+
+    // Delete the panorama.
+    glDeleteFramebuffers (1, &m_panoramaFramebuffer);
+    glDeleteTextures (1, &m_panoramaColour);
+    glDeleteRenderbuffers (1, &m_panoramaDepth);
+
+    m_panoramaFramebuffer   = 0;
+    m_panoramaColour        = 0;
+    m_panoramaDepth         = 0;
+    m_panoramaSize          = 0;
+    m_panoramaValid         = false;
+}
+
+#pragma endregion
+
+
+#pragma region Rendering
+
+void MyView::windowViewDidReset (std::shared_ptr<tygra::Window> window, int width, int height)
+{
+    // Reset the viewport and recalculate the aspect ratio.
+    glViewport (0, 0, width, height);
+    m_viewportWidth     = width;
+    m_viewportHeight    = height;
+    m_aspectRatio       = width / static_cast<float> (height);
+}
+
+
+void MyView::restoreContextState()
+{
+    // Capabilities, the clear colour, the viewport and the uniform block bindings belong to the context rather than the view.
+    glEnable (GL_DEPTH_TEST);
+    glEnable (GL_CULL_FACE);
+    glEnable (GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex (util::restartIndex);
+    glClearColor (0.f, 0.1f, 0.f, 0.f);
+    glViewport (0, 0, m_viewportWidth, m_viewportHeight);
+
+    bindUniformBufferObject();
+}
+
+
+void MyView::windowViewRender (std::shared_ptr<tygra::Window> window)
+{
+    assert (m_scene != nullptr);
+
+    // Don't let the CPU queue more frames than the pacer allows.
+    waitForFrameSlot();
+
+    // Bring in any hot reloaded changes and simulation updates before drawing.
+    applySceneUpdate();
+    receiveSimulation();
+    loadMissingAssets();
+
+    // Upload whichever pages the worker has prepared since the last frame.
+    if (m_resources->virtualTextures)
+    {
+        m_resources->virtualTextures->update();
+    }
+
+    // Specify shader program to use.
+    glUseProgram (m_program);
+
+    // Define matrices.
+    const auto& camera      = m_scene->getCamera();
+    SceneView   main        { };
+    glm::vec3   direction   { };
+    getCameraPose (&main.position, &direction);
+
+    main.projection = glm::perspective (camera.getVerticalFieldOfViewInDegrees(), m_aspectRatio, camera.getNearPlaneDistance(), camera.getFarPlaneDistance());
+    main.view       = glm::lookAt (main.position, main.position + direction, m_scene->getUpDirection());
+    main.width      = m_viewportWidth;
+    main.height     = m_viewportHeight;
+    main.cull       = true;
+    main.occlusion  = m_occlusionQueries;
+    
+    // Set the uniforms, the lighting is shared with any views the render server needs this frame.
+    setUniforms (&main.projection, &main.view);
+
+    // Static instances are captured once and every pass afterwards reads them, whether it draws the window or the render server.
+    if (m_transformCache && !m_cacheValid)
+    {
+        captureStaticGeometry();
+    }
+
+    // Without a window there's nothing to present to.
+    if (window)
+    {
+        // Cull once for every pass which draws the window.
+        if (m_cullingMode != 0)
+        {
+            prepareCulling();
+            m_culler->update (main.projection, main.view, m_cullingMode == 2);
+        }
+
+        // This frame's boxes reuse the oldest query of each mesh, whatever it found is read back first.
+        if (m_occlusionQueries)
+        {
+            prepareOcclusionQueries();
+        }
+
+        // Find which pages of the virtual textures the window needs before drawing it.
+        if (m_resources->virtualTextures)
+        {
+            drawFeedback (main);
+        }
+
+        // Prepare the screen.
+        glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Anything streamed by the host may move at any moment so only static scenes are worth caching. The wireframe needs the depth of the scene.
+        if (m_panoramaMode && m_instanceStreams.empty() && m_prefabs.empty() && !m_simulation && !m_wireframeMode)
+        {
+            drawFromPanorama (main);
+        }
+
+        else if (m_depthPrepass && m_resources->positionVBO != 0)
+        {
+            drawDepthPrepass (main);
+            drawScene ({ main });
+            glDepthFunc (GL_LESS);
+        }
+
+        else
+        {
+            drawScene ({ main });
+        }
+
+        if (m_wireframeMode)
+        {
+            drawWireframeOverlay (main);
+        }
+    }
+
+    serveRenderRequests();
+
+    // Mark the end of the frame so we know when the GPU has finished with it.
+    fenceFrame();
+}
+
+
+void MyView::drawScene (const std::vector<SceneView>& views, const bool depthOnly)
+{
+    /// For the rendering of the scene I have chosen to implement instancing. A traditional approach of rendering would be looping through each instance,
+    /// assigning the correct model and PVM transforms, then drawing that one mesh before repeating the process. I don't use that method here, instead
+    /// I loop through mesh, obtain the number of instances, load in the data specific to those instances and draw them all at once, letting the shaders
+    /// obtain the correct information. I choose this method because although it doesn't help in a simple scene like sponza; scenes with particle systems,
+    /// large-scale mesh duplication and such would really benefit from reducing the overhead that bindings, uniform specification and draw calls cost.
+    ///
+    /// Several views can be drawn at once, each into its own viewport. The instances of a mesh are uploaded once and then drawn from every view, and
+    /// each view has its own scene uniform block so switching between them is a single buffer range binding.
+    assert (views.size() <= m_viewCapacity);
+
+    // Every view gets its own copy of the scene uniforms, the lighting is shared.
+    glBindBuffer (GL_UNIFORM_BUFFER, m_uniformUBO);
+
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        UniformData data { };
+        data.setProjectionMatrix (views[i].projection);
+        data.setViewMatrix (views[i].view);
+        data.setCameraPosition (views[i].position);
+        data.setAmbientColour (m_scene->getAmbientLightIntensity());
+
+        glBufferSubData (GL_UNIFORM_BUFFER, m_viewOffset + m_viewStride * i, UniformData::sceneSize(), &data);
+    }
+
+    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+    
+    // Specify the VAO to use.
+    glBindVertexArray (depthOnly ? m_depthVAO : m_sceneVAO);
+
+    // Specify the buffers to use.
+    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+    glBindBuffer (GL_TEXTURE_BUFFER, m_poolMaterialIDs.vbo);
+
+    // Specify the textures to use.
+    glActiveTexture (GL_TEXTURE0);
+    glBindTexture (GL_TEXTURE_2D_ARRAY, m_resources->textureArray);
+
+    glActiveTexture (GL_TEXTURE1);
+    glBindTexture (GL_TEXTURE_BUFFER, m_resources->materials.tbo);
+
+    glActiveTexture (GL_TEXTURE2);
+    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+
+    if (m_resources->virtualTextures)
+    {
+        m_resources->virtualTextures->bind (GL_TEXTURE3, GL_TEXTURE4, GL_TEXTURE5);
+
+        // Anything which swaps the material IDs during the draw expects their unit to be active.
+        glActiveTexture (GL_TEXTURE2);
+    }
+
+    // Use vectors for storing instancing data> This requires a material ID and a model transform. The pools may have grown after a scene update.
+    if (m_instanceMaterials.size() < m_instancePoolSize)
+    {
+        m_instanceMaterials.resize (m_instancePoolSize);
+        m_instanceMatrices.resize (m_instancePoolSize * 16);
+    }
+
+    auto&       materialIDs = m_instanceMaterials;
+    const auto  matrices    = reinterpret_cast<glm::mat4*> (m_instanceMatrices.data());
+
+    // Host streams and prefabs need to redirect the instanced attributes.
+    const auto modelAttribute = m_instanceStreams.empty() && m_prefabs.empty() ? -1 : glGetAttribLocation (m_program, "model");
+
+    // Only the window is culled, the render server draws views of every size and direction in one batch so they're drawn whole.
+    const auto culling = m_culler && m_cullingMode != 0 && views.size() == 1 && views.front().cull;
+
+    // Large meshes of the window are drawn on the condition their boxes passed the depth test last frame, the main pass queries them again.
+    const auto occlusion    = views.size() == 1 && views.front().occlusion && m_occlusion.size() == m_resources->meshes.size();
+    const auto previous     = (m_occlusionFrame + OcclusionQuery::latency - 1) % OcclusionQuery::latency;
+
+    // Static instances come from the transform cache when it's ready, leaving only the host streams for the loop below.
+    const auto cached = m_transformCache && m_cacheValid;
+
+    if (cached)
+    {
+        drawCachedGeometry (views, culling, depthOnly ? m_depthProgram : m_program);
+        glBindVertexArray (depthOnly ? m_depthVAO : m_sceneVAO);
+    }
+
+    // Iterate through each mesh using instancing to reduce GL calls, in the order which keeps consecutive draws close together.
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        // Meshes with a host stream ignore the instances of the scene.
+        const auto& pair        = m_resources->meshes[meshIndex];
+        const auto  streamed    = m_instanceStreams.find (pair.first);
+
+        if (streamed != m_instanceStreams.end())
+        {
+            drawInstanceStream (*streamed->second, *pair.second, modelAttribute, views);
+            continue;
+        }
+
+        if (cached)
+        {
+            continue;
+        }
+
+        // Obtain the instances to draw for the current mesh.
+        const auto  instances   = m_imported ? nullptr : &m_sceneInstances[meshIndex];
+        const auto  size        = m_imported ? m_resources->importedInstances[meshIndex].size() : instances->size();
+
+        // Check if we need to do any rendering at all.
+        if (size != 0)
+        {
+            // Update the instance-specific information, instances outside of the frustum are packed out of the way.
+            GLsizei count { 0 };
+
+            for (unsigned int i = 0; i < size; ++i)
+            {
+                if (culling && !m_culler->isVisible (m_cullOffsets[meshIndex] + i))
+                {
+                    continue;
+                }
+
+                // Imported instances already have their transform and material index at hand.
+                if (m_imported)
+                {
+                    const auto& instance    = m_imported->instances[m_resources->importedInstances[meshIndex][i]];
+
+                    matrices[count]         = instance.transform;
+                    materialIDs[count++]    = m_resources->materialSlots[instance.materialIndex] * 2;
+                    continue;
+                }
+
+                // Cache the current instance.
+                const auto& instance    = m_content->getInstanceById ((*instances)[i]);
+
+                // Obtain the current instances model transformation.
+                matrices[count]         = (glm::mat4) instance.getTransformationMatrix();
+
+                // Now deal with the materials.
+                materialIDs[count++]    = m_resources->materialIDs.at (instance.getMaterialId());
+            }
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            // Only overwrite the required data to speed up the buffering process. Avoid glMapBuffer because it's ridiculously slow in this case.
+            glBufferSubData (GL_ARRAY_BUFFER,   0,  sizeof (glm::mat4) * count,     matrices);
+            glBufferSubData (GL_TEXTURE_BUFFER, 0,  sizeof (MaterialID) * count,    materialIDs.data());
+            
+            // Cache access to the current mesh.
+            const auto& mesh = pair.second;
+
+            // The GPU skips the draw by itself if last frame's box was hidden, a result which isn't ready yet draws the mesh.
+            const auto  queried     = occlusion && wantsOcclusionQuery (*mesh, count, views.front());
+            const auto  conditional = queried && (m_occlusion[meshIndex].issued & (1u << previous)) != 0;
+
+            if (conditional)
+            {
+                glBeginConditionalRender (m_occlusion[meshIndex].queries[previous], GL_QUERY_NO_WAIT);
+            }
+
+            // Finally draw all instances at the same time, once for each view.
+            for (size_t view = 0; view < views.size(); ++view)
+            {
+                selectView (views[view], view);
+                glDrawElementsInstancedBaseVertex (mesh->strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh->elementCount, GL_UNSIGNED_INT, (void*) mesh->elementsOffset, count, mesh->verticesIndex);
+            }
+
+            if (conditional)
+            {
+                glEndConditionalRender();
+            }
+
+            if (queried && !depthOnly)
+            {
+                queueOcclusionQuery (meshIndex, count);
+            }
+        }
+    }
+
+    // Prefab entries are placed with uniforms of the main program so they're left to the depth test of the main pass.
+    if (!depthOnly)
+    {
+        drawPrefabs (modelAttribute, views);
+    }
+
+    // The boxes are tested once everything else is drawn so as much of the window as possible can hide them.
+    if (!m_occlusionPending.empty())
+    {
+        issueOcclusionQueries();
+    }
+
+    // UNBIND IT ALL CAPTAIN!
+    glBindVertexArray (0);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture (GL_TEXTURE1);
+    glBindTexture (GL_TEXTURE_BUFFER, 0);
+
+    glActiveTexture (GL_TEXTURE0);
+    //glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+}
+
+
+void MyView::drawDepthPrepass (const SceneView& main)
+{
+    /// Sponza has a lot of overdraw and every fragment of the main pass loops over every light, so shading only the nearest surface of each
+    /// pixel saves far more than drawing the geometry twice costs. The pre-pass reads the tightly packed position stream rather than the
+    /// interleaved vertices, fetching 12 bytes a vertex instead of 32. Both vertex shaders mark their position invariant so the main pass
+    /// produces the same depth and a less-or-equal test lets exactly the nearest fragments through. Prefabs aren't in the pre-pass but
+    /// are still depth tested against it, and depth writes stay on so they sort amongst themselves.
+    glUseProgram (m_depthProgram);
+    glColorMask (GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    drawScene ({ main }, true);
+
+    glColorMask (GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glUseProgram (m_program);
+    glDepthFunc (GL_LEQUAL);
+}
+
+
+void MyView::buildDepthProgram (const ShaderSources& sources)
+{
+    m_depthProgram              = glCreateProgram();
+
+    const auto vertexShader     = util::compileShaderFromSource (sources.at (depthVertexLocation), GL_VERTEX_SHADER);
+    const auto fragmentShader   = util::compileShaderFromSource (sources.at (depthFragmentLocation), GL_FRAGMENT_SHADER);
+
+    util::attachShader (m_depthProgram, vertexShader, { });
+    util::attachShader (m_depthProgram, fragmentShader, { });
+
+    if (!util::linkProgram (m_depthProgram))
+    {
+        std::cerr << "Unable to build the depth program, the depth pre-pass will hide everything it covers." << std::endl;
+        return;
+    }
+
+    // The pre-pass reads the same scene blocks as the main program.
+    glUniformBlockBinding (m_depthProgram, glGetUniformBlockIndex (m_depthProgram, "scene"), UniformData::sceneBlock());
+}
+
+
+void MyView::captureStaticGeometry()
+{
+    /// Every pass which draws the scene runs the vertex shader over every vertex of every instance, so with a depth pre-pass, the feedback
+    /// pass and render server views the same static vertices are transformed several times a frame. Capturing them once in world space
+    /// trades that repeated work for a copy of each mesh per instance, so it pays off when there are several passes and instances are
+    /// few enough for the copies to fit. The vertices are captured as points so each is transformed exactly once, and the elements of the
+    /// scene are reused when drawing by offsetting the base vertex to each captured instance. Culling still works per instance.
+    const auto start = std::chrono::steady_clock::now();
+
+    // Lay the captured meshes out in draw order, each instance gets a copy of every vertex of its mesh.
+    std::vector<size_t> instanceCounts (m_resources->meshes.size(), 0);
+    m_cacheBases.assign (m_resources->meshes.size(), 0);
+    m_cacheVertices = 0;
+
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        const auto& pair = m_resources->meshes[meshIndex];
+
+        if (m_instanceStreams.find (pair.first) == m_instanceStreams.end())
+        {
+            instanceCounts[meshIndex]   = m_imported ? m_resources->importedInstances[meshIndex].size() : m_sceneInstances[meshIndex].size();
+            m_cacheBases[meshIndex]     = m_cacheVertices;
+            m_cacheVertices             += instanceCounts[meshIndex] * pair.second->vertexCount;
+        }
+    }
+
+    util::allocateBuffer (m_cacheVBO, std::max<size_t> (m_cacheVertices, 1) * cachedVertexSize, GL_TRANSFORM_FEEDBACK_BUFFER, GL_STATIC_COPY);
+
+    if (m_cacheVAO == 0)
+    {
+        glGenVertexArrays (1, &m_cacheVAO);
+        glBindVertexArray (m_cacheVAO);
+
+        // The attribute locations are fixed by sponza_vs.glsl and depth_vs.glsl.
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_resources->elementVBO);
+        glBindBuffer (GL_ARRAY_BUFFER, m_cacheVBO);
+
+        glEnableVertexAttribArray (0);
+        glEnableVertexAttribArray (1);
+        glEnableVertexAttribArray (2);
+        glEnableVertexAttribArray (7);
+
+        glVertexAttribPointer (0, 3, GL_FLOAT, GL_FALSE, cachedVertexSize, TGL_BUFFER_OFFSET (0));
+        glVertexAttribPointer (1, 3, GL_FLOAT, GL_FALSE, cachedVertexSize, TGL_BUFFER_OFFSET (12));
+        glVertexAttribPointer (2, 2, GL_FLOAT, GL_FALSE, cachedVertexSize, TGL_BUFFER_OFFSET (24));
+        glVertexAttribIPointer (7, 1, GL_INT, cachedVertexSize, TGL_BUFFER_OFFSET (32));
+    }
+
+    // Capture each mesh with the instance transforms streamed in just as drawScene() would, without culling.
+    if (m_instanceMaterials.size() < m_instancePoolSize)
+    {
+        m_instanceMaterials.resize (m_instancePoolSize);
+        m_instanceMatrices.resize (m_instancePoolSize * 16);
+    }
+
+    const auto              matrices        = reinterpret_cast<glm::mat4*> (m_instanceMatrices.data());
+    const auto              firstInstance   = glGetUniformLocation (m_captureProgram, "firstInstance");
+    std::vector<MaterialID> materialIDs     { };
+
+    glUseProgram (m_captureProgram);
+    glEnable (GL_RASTERIZER_DISCARD);
+    glBindVertexArray (m_sceneVAO);
+    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        const auto& mesh    = *m_resources->meshes[meshIndex].second;
+        const auto  count   = instanceCounts[meshIndex];
+
+        if (count == 0 || mesh.vertexCount == 0)
+        {
+            continue;
+        }
+
+        glUniform1i (firstInstance, static_cast<GLint> (materialIDs.size()));
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (m_imported)
+            {
+                const auto& instance = m_imported->instances[m_resources->importedInstances[meshIndex][i]];
+
+                matrices[i] = instance.transform;
+                materialIDs.push_back (m_resources->materialSlots[instance.materialIndex] * 2);
+            }
+
+            else
+            {
+                const auto& instance = m_content->getInstanceById (m_sceneInstances[meshIndex][i]);
+
+                matrices[i] = (glm::mat4) instance.getTransformationMatrix();
+                materialIDs.push_back (m_resources->materialIDs.at (instance.getMaterialId()));
+            }
+        }
+
+        glBufferSubData (GL_ARRAY_BUFFER, 0, sizeof (glm::mat4) * count, matrices);
+
+        glBindBufferRange (GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_cacheVBO, m_cacheBases[meshIndex] * cachedVertexSize, count * mesh.vertexCount * cachedVertexSize);
+        glBeginTransformFeedback (GL_POINTS);
+        glDrawArraysInstanced (GL_POINTS, mesh.verticesIndex, static_cast<GLsizei> (mesh.vertexCount), static_cast<GLsizei> (count));
+        glEndTransformFeedback();
+    }
+
+    glBindBufferBase (GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable (GL_RASTERIZER_DISCARD);
+    glBindVertexArray (0);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glUseProgram (m_program);
+
+    // The fragment shader reads material IDs four to a texel, the same as the instance pool.
+    materialIDs.resize ((materialIDs.size() + 3) / 4 * 4 + 4, 0);
+
+    if (m_cacheMaterialIDs.tbo == 0)
+    {
+        glGenTextures (1, &m_cacheMaterialIDs.tbo);
+    }
+
+    util::allocateBuffer (m_cacheMaterialIDs.vbo, materialIDs.size() * sizeof (MaterialID), GL_TEXTURE_BUFFER, GL_STATIC_DRAW);
+
+    glBindBuffer (GL_TEXTURE_BUFFER, m_cacheMaterialIDs.vbo);
+    glBufferSubData (GL_TEXTURE_BUFFER, 0, materialIDs.size() * sizeof (MaterialID), materialIDs.data());
+    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture (GL_TEXTURE_BUFFER, m_cacheMaterialIDs.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_cacheMaterialIDs.vbo);
+    glBindTexture (GL_TEXTURE_BUFFER, 0);
+
+    m_cacheValid    = true;
+    m_cacheTime     = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+    ++m_cacheCaptures;
+
+    std::cout   << "Captured " << m_cacheVertices << " static vertices (" << m_cacheVertices * cachedVertexSize / (1024.0 * 1024.0) << " MiB) in "
+                << m_cacheTime << "ms." << std::endl;
+}
+
+
+void MyView::drawCachedGeometry (const std::vector<SceneView>& views, const bool culling, const GLuint program)
+{
+    glBindVertexArray (m_cacheVAO);
+
+    glActiveTexture (GL_TEXTURE2);
+    glBindTexture (GL_TEXTURE_BUFFER, m_cacheMaterialIDs.tbo);
+
+    glUniform1i (glGetUniformLocation (program, "preTransformed"), 1);
+
+    // Every visible instance of a mesh is one draw of the same elements offset to its captured vertices.
+    std::vector<GLsizei>        counts      { };
+    std::vector<const GLvoid*>  offsets     { };
+    std::vector<GLint>          baseVertices { };
+
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        const auto& pair = m_resources->meshes[meshIndex];
+
+        if (m_instanceStreams.find (pair.first) != m_instanceStreams.end())
+        {
+            continue;
+        }
+
+        const auto& mesh = *pair.second;
+        const auto  size = m_imported ? m_resources->importedInstances[meshIndex].size() : m_sceneInstances[meshIndex].size();
+
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (culling && !m_culler->isVisible (m_cullOffsets[meshIndex] + i))
+            {
+                continue;
+            }
+
+            counts.push_back (static_cast<GLsizei> (mesh.elementCount));
+            offsets.push_back ((const GLvoid*) mesh.elementsOffset);
+            baseVertices.push_back (static_cast<GLint> (m_cacheBases[meshIndex] + i * mesh.vertexCount));
+        }
+
+        if (counts.empty())
+        {
+            continue;
+        }
+
+        for (size_t view = 0; view < views.size(); ++view)
+        {
+            selectView (views[view], view);
+            glMultiDrawElementsBaseVertex (mesh.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                           static_cast<GLsizei> (counts.size()), baseVertices.data());
+        }
+    }
+
+    glUniform1i (glGetUniformLocation (program, "preTransformed"), 0);
+
+    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+    glActiveTexture (GL_TEXTURE0);
+}
+
+
+void MyView::releaseTransformCache()
+{
+    glDeleteBuffers (1, &m_cacheVBO);
+    glDeleteBuffers (1, &m_cacheMaterialIDs.vbo);
+    glDeleteTextures (1, &m_cacheMaterialIDs.tbo);
+
+    m_cacheVBO              = 0;
+    m_cacheMaterialIDs.vbo  = 0;
+    m_cacheMaterialIDs.tbo  = 0;
+    m_cacheVertices         = 0;
+    m_cacheValid            = false;
+
+    // The VAO refers to the deleted buffer so it's rebuilt with the next capture.
+    glDeleteVertexArrays (1, &m_cacheVAO);
+    m_cacheVAO = 0;
+}
+
+
+void MyView::buildCaptureProgram (const ShaderSources& sources)
+{
+    m_captureProgram            = glCreateProgram();
+
+    const auto vertexShader     = util::compileShaderFromSource (sources.at (captureVertexLocation), GL_VERTEX_SHADER);
+
+    util::attachShader (m_captureProgram, vertexShader, { });
+
+    // The outputs are interleaved in the order the cache VAO reads them.
+    const GLchar* varyings[] = { "cachedPosition", "cachedNormal", "cachedTextureCoord", "cachedInstance" };
+    glTransformFeedbackVaryings (m_captureProgram, 4, varyings, GL_INTERLEAVED_ATTRIBS);
+
+    if (!util::linkProgram (m_captureProgram))
+    {
+        std::cerr << "Unable to build the capture program, the transform cache will be empty." << std::endl;
+    }
+}
+
+
+void MyView::prepareOcclusionQueries()
+{
+    /// Without compute shaders the GPU can't cull for itself, but it can count whether any fragment of a bounding box passes the depth test
+    /// and skip a later draw with conditional rendering, leaving the CPU to never wait for an answer. Each mesh keeps a query for every
+    /// frame likely to be in flight. A frame draws its meshes on the condition of the previous frame's queries and writes the oldest, so
+    /// the GPU almost always has the answer by the time it's needed. By the time a query is reused its result is normally available
+    /// too, it's read back then purely to steer which meshes are worth querying and is dropped rather than waited upon if it's late.
+    const auto meshCount = m_resources->meshes.size();
+
+    if (m_occlusion.size() != meshCount)
+    {
+        releaseOcclusionQueries();
+        m_occlusion.resize (meshCount);
+
+        for (auto& occlusion : m_occlusion)
+        {
+            glGenQueries (OcclusionQuery::latency, occlusion.queries);
+        }
+    }
+
+    const auto current  = ++m_occlusionFrame % OcclusionQuery::latency;
+    const auto bit      = 1u << current;
+
+    for (auto& occlusion : m_occlusion)
+    {
+        if ((occlusion.issued & bit) == 0)
+        {
+            continue;
+        }
+
+        occlusion.issued &= ~bit;
+
+        GLuint available { 0 };
+        glGetQueryObjectuiv (occlusion.queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available == 0)
+        {
+            continue;
+        }
+
+        GLuint visible { 0 };
+        glGetQueryObjectuiv (occlusion.queries[current], GL_QUERY_RESULT, &visible);
+
+        occlusion.history = (occlusion.history << 1) | (visible != 0 ? 1u : 0u);
+        m_occlusionHidden += visible != 0 ? 0 : 1;
+        ++m_occlusionResults;
+    }
+
+    m_occlusionPending.clear();
+    m_occlusionMatrices.clear();
+}
+
+
+bool MyView::wantsOcclusionQuery (const Mesh& mesh, const GLsizei count, const SceneView& view) const
+{
+    if (mesh.radius < 0.f)
+    {
+        return false;
+    }
+
+    // Strips spend about one element on each triangle.
+    const auto triangles = mesh.strips ? mesh.elementCount : mesh.elementCount / 3;
+
+    if (triangles < occlusionMinTriangles)
+    {
+        return false;
+    }
+
+    // From inside a box its faces are hidden behind the mesh itself, which would then vanish. The near plane clipping a box is just as bad.
+    const auto  matrices    = reinterpret_cast<const glm::mat4*> (m_instanceMatrices.data());
+    const auto  radius      = glm::length (paddedExtent (mesh.extent, mesh.radius));
+    const auto  margin      = m_scene->getCamera().getNearPlaneDistance();
+
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        const auto sphere = worldSphere (matrices[i], mesh.centre, radius);
+
+        if (glm::distance (glm::vec3 (sphere), view.position) < sphere.w + margin)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void MyView::queueOcclusionQuery (const size_t meshIndex, const GLsizei count)
+{
+    // Meshes which keep being visible rarely stop being so, they only pay for a query every few frames, staggered so they don't bunch up.
+    auto& occlusion = m_occlusion[meshIndex];
+
+    if ((occlusion.history & occlusionVisibleHistory) == occlusionVisibleHistory && (m_occlusionFrame + meshIndex) % occlusionVisibleInterval != 0)
+    {
+        return;
+    }
+
+    occlusion.first = m_occlusionMatrices.size() / 16;
+    occlusion.count = count;
+
+    m_occlusionMatrices.insert (m_occlusionMatrices.end(), m_instanceMatrices.begin(), m_instanceMatrices.begin() + count * 16);
+    m_occlusionPending.push_back (meshIndex);
+}
+
+
+void MyView::issueOcclusionQueries()
+{
+    /// The boxes are tested but never drawn, so colour and depth writes are off and back faces are kept in case the front of a box is
+    /// clipped. A box is fourteen vertices of a strip made in the vertex shader, instanced over the same transforms the mesh was drawn
+    /// with. GL 3.3 has no base instance so the transforms of every box go in one buffer and each box points its attribute at its own.
+    const auto current = m_occlusionFrame % OcclusionQuery::latency;
+
+    glBindBuffer (GL_ARRAY_BUFFER, m_occlusionTransforms);
+    glBufferData (GL_ARRAY_BUFFER, sizeof (float) * m_occlusionMatrices.size(), m_occlusionMatrices.data(), GL_STREAM_DRAW);
+
+    GLint depthFunction { GL_LESS };
+    glGetIntegerv (GL_DEPTH_FUNC, &depthFunction);
+
+    glUseProgram (m_occlusionProgram);
+    glBindVertexArray (m_occlusionVAO);
+    glColorMask (GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask (GL_FALSE);
+    glDepthFunc (GL_LEQUAL);
+    glDisable (GL_CULL_FACE);
+
+    const auto boxCentre        = glGetUniformLocation (m_occlusionProgram, "boxCentre");
+    const auto boxExtent        = glGetUniformLocation (m_occlusionProgram, "boxExtent");
+    const auto modelAttribute   = glGetAttribLocation (m_occlusionProgram, "model");
+
+    for (const auto meshIndex : m_occlusionPending)
+    {
+        const auto& mesh        = *m_resources->meshes[meshIndex].second;
+        auto&       occlusion   = m_occlusion[meshIndex];
+        const auto  extent      = paddedExtent (mesh.extent, mesh.radius);
+
+        util::createInstancedMatrix4 (modelAttribute, sizeof (glm::mat4), static_cast<int> (occlusion.first * sizeof (glm::mat4)));
+        glUniform3fv (boxCentre, 1, glm::value_ptr (mesh.centre));
+        glUniform3fv (boxExtent, 1, glm::value_ptr (extent));
+
+        glBeginQuery (GL_ANY_SAMPLES_PASSED, occlusion.queries[current]);
+        glDrawArraysInstanced (GL_TRIANGLE_STRIP, 0, 14, occlusion.count);
+        glEndQuery (GL_ANY_SAMPLES_PASSED);
+
+        occlusion.issued |= 1u << current;
+    }
+
+    m_occlusionIssued += m_occlusionPending.size();
+    m_occlusionPending.clear();
+    m_occlusionMatrices.clear();
+
+    glEnable (GL_CULL_FACE);
+    glDepthFunc (depthFunction);
+    glDepthMask (GL_TRUE);
+    glColorMask (GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glUseProgram (m_program);
+}
+
+
+void MyView::releaseOcclusionQueries()
+{
+    for (auto& occlusion : m_occlusion)
+    {
+        glDeleteQueries (OcclusionQuery::latency, occlusion.queries);
+    }
+
+    m_occlusion.clear();
+    m_occlusionPending.clear();
+    m_occlusionMatrices.clear();
+}
+
+
+void MyView::buildOcclusionProgram (const ShaderSources& sources)
+{
+    m_occlusionProgram          = glCreateProgram();
+
+    const auto vertexShader     = util::compileShaderFromSource (sources.at (occlusionVertexLocation), GL_VERTEX_SHADER);
+    const auto fragmentShader   = util::compileShaderFromSource (sources.at (depthFragmentLocation), GL_FRAGMENT_SHADER);
+
+    util::attachShader (m_occlusionProgram, vertexShader, { });
+    util::attachShader (m_occlusionProgram, fragmentShader, { });
+
+    if (!util::linkProgram (m_occlusionProgram))
+    {
+        std::cerr << "Unable to build the occlusion program, queried meshes will be hidden." << std::endl;
+        return;
+    }
+
+    glUniformBlockBinding (m_occlusionProgram, glGetUniformBlockIndex (m_occlusionProgram, "scene"), UniformData::sceneBlock());
+}
+
+
+void MyView::drawWireframeOverlay (const SceneView& main)
+{
+    /// The wireframe used to be a light which every fragment of the main pass had to check for, with barycentric co-ordinates taken from
+    /// gl_VertexID % 3 in every vertex shader. Indexed meshes share vertices between triangles so those co-ordinates rarely matched the
+    /// triangles and edges went missing. Now it's a pass of its own, only drawn when the mode is on and only over instances whose bounding
+    /// sphere the light reaches before fading out. A geometry shader gives the corners of each triangle exact co-ordinates. The wire is
+    /// emissive so it's blended additively over the lit window, which is what adding it to the lighting did, and a small polygon offset
+    /// keeps it in front of the surfaces it's drawn on. Host streams move at will so they're drawn whole and prefabs are left out.
+    const auto light    = createWireframeLight();
+    const auto range    = lightRange (light, wireframeCutoff);
+
+    glUseProgram (m_wireframeProgram);
+    glUniform3fv (glGetUniformLocation (m_wireframeProgram, "light.position"), 1, glm::value_ptr (light.position));
+    glUniform1i (glGetUniformLocation (m_wireframeProgram, "light.type"), static_cast<int> (light.type));
+    glUniform3fv (glGetUniformLocation (m_wireframeProgram, "light.direction"), 1, glm::value_ptr (light.direction));
+    glUniform1f (glGetUniformLocation (m_wireframeProgram, "light.coneAngle"), light.coneAngle);
+    glUniform3fv (glGetUniformLocation (m_wireframeProgram, "light.colour"), 1, glm::value_ptr (light.colour));
+    glUniform1f (glGetUniformLocation (m_wireframeProgram, "light.concentration"), light.concentration);
+    glUniform1f (glGetUniformLocation (m_wireframeProgram, "light.aConstant"), light.aConstant);
+    glUniform1f (glGetUniformLocation (m_wireframeProgram, "light.aLinear"), light.aLinear);
+    glUniform1f (glGetUniformLocation (m_wireframeProgram, "light.aQuadratic"), light.aQuadratic);
+
+    glEnable (GL_BLEND);
+    glBlendFunc (GL_ONE, GL_ONE);
+    glEnable (GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset (-1.f, -1.f);
+    glDepthFunc (GL_LEQUAL);
+    glDepthMask (GL_FALSE);
+
+    // The scene VAO already reads the positions, normals and instance transforms the overlay needs.
+    glBindVertexArray (m_sceneVAO);
+    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+    selectView (main, 0);
+
+    const auto  matrices        = reinterpret_cast<glm::mat4*> (m_instanceMatrices.data());
+    const auto  modelAttribute  = glGetAttribLocation (m_wireframeProgram, "model");
+    const auto  culling         = m_culler && m_cullingMode != 0;
+
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        const auto& pair        = m_resources->meshes[meshIndex];
+        const auto& mesh        = *pair.second;
+        const auto  streamed    = m_instanceStreams.find (pair.first);
+
+        if (streamed != m_instanceStreams.end())
+        {
+            drawInstanceStream (*streamed->second, mesh, modelAttribute, { main });
+            continue;
+        }
+
+        // Gather the visible instances within range of the light.
+        const auto  size    = m_imported ? m_resources->importedInstances[meshIndex].size() : m_sceneInstances[meshIndex].size();
+        GLsizei     count   { 0 };
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (culling && !m_culler->isVisible (m_cullOffsets[meshIndex] + i))
+            {
+                continue;
+            }
+
+            const auto model    = m_imported ? glm::mat4 (m_imported->instances[m_resources->importedInstances[meshIndex][i]].transform)
+                                             : (glm::mat4) m_content->getInstanceById (m_sceneInstances[meshIndex][i]).getTransformationMatrix();
+            const auto sphere   = worldSphere (model, mesh.centre, mesh.radius);
+
+            if (sphere.w >= 0.f && glm::distance (glm::vec3 (sphere), light.position) - sphere.w > range)
+            {
+                continue;
+            }
+
+            matrices[count++] = model;
+        }
+
+        if (count != 0)
+        {
+            glBufferSubData (GL_ARRAY_BUFFER, 0, sizeof (glm::mat4) * count, matrices);
+            glDrawElementsInstancedBaseVertex (mesh.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh.elementCount, GL_UNSIGNED_INT, (void*) mesh.elementsOffset, count, mesh.verticesIndex);
+        }
+    }
+
+    glBindVertexArray (0);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+
+    glDepthMask (GL_TRUE);
+    glDepthFunc (GL_LESS);
+    glDisable (GL_POLYGON_OFFSET_FILL);
+    glDisable (GL_BLEND);
+    glUseProgram (m_program);
+}
+
+
+void MyView::buildWireframeProgram (const ShaderSources& sources)
+{
+    m_wireframeProgram          = glCreateProgram();
+
+    const auto vertexShader     = util::compileShaderFromSource (sources.at (wireframeVertexLocation), GL_VERTEX_SHADER);
+    const auto geometryShader   = util::compileShaderFromSource (sources.at (wireframeGeometryLocation), GL_GEOMETRY_SHADER);
+    const auto fragmentShader   = util::compileShaderFromSource (sources.at (wireframeFragmentLocation), GL_FRAGMENT_SHADER);
+
+    util::attachShader (m_wireframeProgram, vertexShader, { });
+    util::attachShader (m_wireframeProgram, geometryShader, { });
+    util::attachShader (m_wireframeProgram, fragmentShader, { });
+
+    if (!util::linkProgram (m_wireframeProgram))
+    {
+        std::cerr << "Unable to build the wireframe program, the wireframe won't be drawn." << std::endl;
+        return;
+    }
+
+    glUniformBlockBinding (m_wireframeProgram, glGetUniformBlockIndex (m_wireframeProgram, "scene"), UniformData::sceneBlock());
 }
 
 
-void MyView::constructVAO()
+void MyView::prepareCulling()
 {
-    /// Here we combine all vertex attributes into a 32-byte aligned interleaved VBO. The reason for this is that being a power of two maps
-    /// perfectly with the memory bus width of many GPUs, in this particular case a 256-bit wide memory bus could load a vertex in a single segment.
-    /// It also allows us to consolidate vertex-specific information into a unique buffer so we know where everything is.
-    ///
-    /// We also use a single VBO to store the entire scene, since the vertex attributes of every mesh in the scene is static and only the transformation
-    /// matrices change, we don't need to flexibility that having multiple VBOs provides. The VBO also contains meshes which are perfectly aligned to
-    /// the order of which we draw meshes, e.g. the third mesh in the draw loop is the third mesh stored in the GPU, potentially avoiding cache misses.
-    ///
-    /// Finally we use a single VAO for the scene because it allows us to avoid the cost required to bind a different VAO each mesh. Perhaps if we
-    /// separated the scene into static and dynamic objects with a different VAO for each there would be some benefit but in this case we don't.
+    /// The spheres are calculated in world space once and reused for as long as the scene stays the same, which is what lets the culler
+    /// skip most instances each frame. The instances of sponza never move and a hot reload replaces the imported scene entirely, so the
+    /// scene and instance count are enough to tell whether the spheres are still correct. Meshes drawn from host streams still have
+    /// spheres, they're just never asked about.
+    if (!m_culler)
+    {
+        m_culler = std::make_shared<TemporalCuller>();
+    }
 
-    // Obtain the attribute pointer locations we'll be using to construct the VAO.
-    int position        { glGetAttribLocation (m_program, "position") };
-    int normal          { glGetAttribLocation (m_program, "normal") };
-    int textureCoord    { glGetAttribLocation (m_program, "textureCoord") };
+    const auto source = m_imported ? static_cast<const void*> (m_imported.get()) : m_content.get();
+    
+    size_t instanceCount { 0 };
 
-    int modelTransform  { glGetAttribLocation (m_program, "model") };
-    int pvmTransform    { glGetAttribLocation (m_program, "pvm") };
+    for (size_t meshIndex = 0; meshIndex < m_resources->meshes.size(); ++meshIndex)
+    {
+        instanceCount += m_imported ? m_resources->importedInstances[meshIndex].size() : m_sceneInstances[meshIndex].size();
+    }
 
-    // Initialise the VAO.
-    glBindVertexArray (m_sceneVAO);
+    if (source == m_cullSource && instanceCount == m_cullInstances && m_cullOffsets.size() == m_resources->meshes.size())
+    {
+        return;
+    }
 
-    // Bind the element buffer to the VAO.
-    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, m_elementVBO);
+    std::vector<glm::vec4> spheres { };
+    spheres.reserve (instanceCount);
+    m_cullOffsets.resize (m_resources->meshes.size());
+
+    // The spheres are stored in the order the meshes are drawn so the culler reads them front to back.
+    for (const auto meshIndex : m_resources->meshOrder)
+    {
+        const auto& mesh    = *m_resources->meshes[meshIndex].second;
+        const auto  size    = m_imported ? m_resources->importedInstances[meshIndex].size() : m_sceneInstances[meshIndex].size();
+
+        m_cullOffsets[meshIndex] = spheres.size();
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            const auto model = m_imported ? glm::mat4 (m_imported->instances[m_resources->importedInstances[meshIndex][i]].transform)
+                                          : (glm::mat4) m_content->getInstanceById (m_sceneInstances[meshIndex][i]).getTransformationMatrix();
+
+            spheres.push_back (worldSphere (model, mesh.centre, mesh.radius));
+        }
+    }
+
+    m_culler->setSpheres (std::move (spheres));
+    m_cullSource    = source;
+    m_cullInstances = instanceCount;
+}
+
+
+void MyView::drawFeedback (const SceneView& main)
+{
+    /// The feedback pass draws the scene again at a small fraction of the resolution, with each fragment writing the virtual texture page
+    /// it would sample instead of shading. Sampling the screen this sparsely misses the odd page but pages are large enough that little
+    /// is lost, and the mipmap is corrected for the smaller resolution so the pages match what the window samples. Reading the requests
+    /// back straight away would stall until the GPU caught up, so they're read into one of two pixel buffers and only mapped two frames
+    /// later, by which point the frame that wrote them has long finished.
+    const auto width    = std::max (main.width / feedbackScale, 1);
+    const auto height   = std::max (main.height / feedbackScale, 1);
+    const auto index    = m_feedbackFrame % 2;
+
+    prepareFeedbackTarget (width, height);
+
+    if (m_feedbackFrame >= 2 && m_feedbackSizes[index] > 0)
+    {
+        const auto size = m_feedbackSizes[index] * sizeof (std::uint32_t);
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, m_feedbackBuffers[index]);
+
+        if (const auto requests = glMapBufferRange (GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT))
+        {
+            m_resources->virtualTextures->submitFeedback (static_cast<const std::uint32_t*> (requests), m_feedbackSizes[index]);
+            glUnmapBuffer (GL_PIXEL_PACK_BUFFER);
+        }
+
+        glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Draw the requests, pixels which see no virtual texture request nothing.
+    const GLuint noRequest[] = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_feedbackFramebuffer);
+    glClearBufferuiv (GL_COLOR, 1, noRequest);
+    glClear (GL_DEPTH_BUFFER_BIT);
+
+    glUniform1i (glGetUniformLocation (m_program, "feedbackPass"), 1);
+    glUniform1f (glGetUniformLocation (m_program, "feedbackBias"), -std::log2 (static_cast<float> (feedbackScale)));
+
+    auto view       = main;
+    view.x          = 0;
+    view.y          = 0;
+    view.width      = width;
+    view.height     = height;
+    view.occlusion  = false;
+
+    drawScene ({ view });
+
+    glUniform1i (glGetUniformLocation (m_program, "feedbackPass"), 0);
+    glUniform1f (glGetUniformLocation (m_program, "feedbackBias"), 0.f);
+
+    // Start copying the requests into a pixel buffer without waiting for them.
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, m_feedbackBuffers[index]);
+    glBufferData (GL_PIXEL_PACK_BUFFER, width * height * sizeof (std::uint32_t), nullptr, GL_STREAM_READ);
+    glReadBuffer (GL_COLOR_ATTACHMENT0);
+    glReadPixels (0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+
+    m_feedbackSizes[index] = static_cast<size_t> (width * height);
+    ++m_feedbackFrame;
+}
+
+
+void MyView::prepareFeedbackTarget (const GLsizei width, const GLsizei height)
+{
+    if (width == m_feedbackWidth && height == m_feedbackHeight)
+    {
+        return;
+    }
+
+    if (m_feedbackFramebuffer == 0)
+    {
+        glGenFramebuffers (1, &m_feedbackFramebuffer);
+        glGenRenderbuffers (1, &m_feedbackTarget);
+        glGenRenderbuffers (1, &m_feedbackDepth);
+        glGenBuffers (2, m_feedbackBuffers);
+
+        m_feedbackSizes[0] = 0;
+        m_feedbackSizes[1] = 0;
+    }
+
+    m_feedbackWidth     = width;
+    m_feedbackHeight    = height;
+
+    glBindRenderbuffer (GL_RENDERBUFFER, m_feedbackTarget);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_R32UI, width, height);
+
+    glBindRenderbuffer (GL_RENDERBUFFER, m_feedbackDepth);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer (GL_RENDERBUFFER, 0);
+
+    // The requests are the second output of the fragment shader, the colour is thrown away.
+    const GLenum drawBuffers[] = { GL_NONE, GL_COLOR_ATTACHMENT0 };
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_feedbackFramebuffer);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_feedbackTarget);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_feedbackDepth);
+    glDrawBuffers (2, drawBuffers);
+
+    if (glCheckFramebufferStatus (GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "The feedback framebuffer is incomplete." << std::endl;
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+}
+
+
+void MyView::drawFromPanorama (const SceneView& main)
+{
+    /// When the camera only turns, everything it can see was already visible from the same spot, just somewhere else on the screen. The
+    /// scene is rendered once into the six faces of a cube map around the camera, then each frame only looks up the colour in the direction
+    /// of each pixel, so a frame costs a screen of texture fetches rather than the whole scene. The faces match the pixel density of the
+    /// centre of the window. Moving the camera, changing the lighting, hot reloading or rebuilding the shaders renders the panorama again.
+    const auto faceSize = std::min (static_cast<GLsizei> (std::ceil (main.height * main.projection[1][1])), panoramaMaxSize);
+    const auto moved    = glm::length (main.position - glm::make_vec3 (m_panoramaPosition));
+
+    if (faceSize != m_panoramaSize)
+    {
+        preparePanorama (faceSize);
+    }
+
+    if (!m_panoramaValid || moved > panoramaTolerance)
+    {
+        renderPanorama (main);
+        std::copy (glm::value_ptr (main.position), glm::value_ptr (main.position) + 3, m_panoramaPosition);
+
+        m_panoramaValid = true;
+        ++m_panoramaRenders;
+    }
+
+    else
+    {
+        ++m_panoramaReuses;
+    }
+
+    // The panorama is centred on the camera so only the rotation of the view matters.
+    const auto inverseTurn = glm::inverse (main.projection * glm::mat4 (glm::mat3 (main.view)));
+
+    glViewport (main.x, main.y, main.width, main.height);
+    glUseProgram (m_panoramaProgram);
+    glUniformMatrix4fv (glGetUniformLocation (m_panoramaProgram, "inverseTurn"), 1, GL_FALSE, glm::value_ptr (inverseTurn));
+    glUniform1i (glGetUniformLocation (m_panoramaProgram, "panorama"), 0);
+
+    glActiveTexture (GL_TEXTURE0);
+    glBindTexture (GL_TEXTURE_CUBE_MAP, m_panoramaColour);
+
+    // A single triangle covers the screen, there's nothing for it to be depth tested against.
+    glDisable (GL_DEPTH_TEST);
+    glBindVertexArray (m_panoramaVAO);
+    glDrawArrays (GL_TRIANGLES, 0, 3);
+    glBindVertexArray (0);
+    glEnable (GL_DEPTH_TEST);
+
+    glBindTexture (GL_TEXTURE_CUBE_MAP, 0);
+    glUseProgram (m_program);
+}
+
+
+void MyView::buildPanoramaProgram (const ShaderSources& sources)
+{
+    m_panoramaProgram           = glCreateProgram();
+
+    const auto vertexShader     = util::compileShaderFromSource (sources.at (panoramaVertexLocation), GL_VERTEX_SHADER);
+    const auto fragmentShader   = util::compileShaderFromSource (sources.at (panoramaFragmentLocation), GL_FRAGMENT_SHADER);
+
+    util::attachShader (m_panoramaProgram, vertexShader, { });
+    util::attachShader (m_panoramaProgram, fragmentShader, { });
+
+    if (!util::linkProgram (m_panoramaProgram))
+    {
+        std::cerr << "Unable to build the panorama program, panorama reprojection will show nothing." << std::endl;
+    }
+}
+
+
+void MyView::preparePanorama (const GLsizei faceSize)
+{
+    if (m_panoramaFramebuffer == 0)
+    {
+        glGenFramebuffers (1, &m_panoramaFramebuffer);
+        glGenTextures (1, &m_panoramaColour);
+        glGenRenderbuffers (1, &m_panoramaDepth);
+    }
+
+    m_panoramaSize  = faceSize;
+    m_panoramaValid = false;
+
+    // Every face needs the same dimensions, seamless filtering hides the edges between them.
+    glEnable (GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    glBindTexture (GL_TEXTURE_CUBE_MAP, m_panoramaColour);
+
+    for (GLenum face = 0; face < 6; ++face)
+    {
+        glTexImage2D (GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, faceSize, faceSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture (GL_TEXTURE_CUBE_MAP, 0);
+
+    glBindRenderbuffer (GL_RENDERBUFFER, m_panoramaDepth);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, faceSize, faceSize);
+    glBindRenderbuffer (GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_panoramaFramebuffer);
+    glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X, m_panoramaColour, 0);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_panoramaDepth);
+
+    if (glCheckFramebufferStatus (GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "The panorama framebuffer is incomplete." << std::endl;
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+}
+
+
+void MyView::renderPanorama (const SceneView& main)
+{
+    // Each face looks along its axis with the up vector cube maps are addressed with.
+    const glm::vec3 directions[6]   = { { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f } };
+    const glm::vec3 ups[6]          = { { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }, { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f } };
+
+    const auto& camera = m_scene->getCamera();
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_panoramaFramebuffer);
+
+    for (GLenum face = 0; face < 6; ++face)
+    {
+        glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, m_panoramaColour, 0);
+        glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        SceneView view { };
+        view.projection = glm::perspective (90.f, 1.f, camera.getNearPlaneDistance(), camera.getFarPlaneDistance());
+        view.view       = glm::lookAt (main.position, main.position + directions[face], ups[face]);
+        view.position   = main.position;
+        view.width      = m_panoramaSize;
+        view.height     = m_panoramaSize;
+
+        drawScene ({ view });
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+}
+
+
+void MyView::selectView (const SceneView& view, const size_t index)
+{
+    glViewport (view.x, view.y, view.width, view.height);
+    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::sceneBlock(), m_uniformUBO, m_viewOffset + m_viewStride * index, UniformData::sceneSize());
+}
+
+
+void MyView::serveRenderRequests()
+{
+    /// Requests which share a resolution are rendered as one batch. The views are laid out in a grid in an offscreen framebuffer, drawn in a single
+    /// pass over the scene and read back together. Encoding happens on the thread pool so the render thread only pays for drawing and the read back,
+    /// and only on frames where there is something to render.
+    if (!m_server)
+    {
+        return;
+    }
+
+    // Forget about images which have been sent.
+    m_serverEncodes.erase (std::remove_if (m_serverEncodes.begin(), m_serverEncodes.end(), [] (const Task<void>& task) { return task.isReady(); }),
+                           m_serverEncodes.end());
+
+    if (!m_server->hasRequests())
+    {
+        return;
+    }
+
+    const auto batch = m_server->takeBatch();
+
+    if (batch.empty())
+    {
+        return;
+    }
+
+    const auto  start   = std::chrono::steady_clock::now();
+    const auto  width   = static_cast<GLsizei> (batch.front().request.width);
+    const auto  height  = static_cast<GLsizei> (batch.front().request.height);
+    const auto  columns = static_cast<GLsizei> (std::ceil (std::sqrt (static_cast<float> (batch.size())))); 
+    const auto  rows    = static_cast<GLsizei> ((batch.size() + columns - 1) / columns);
+
+    prepareServerTarget (columns * width, rows * height);
+
+    // Each request supplies its own camera, anything it leaves out comes from the scene camera.
+    const auto&             camera  = m_scene->getCamera();
+    std::vector<SceneView>  views   (batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const auto& request     = batch[i].request;
+        const auto  requested   = glm::make_vec3 (request.direction);
+        const auto  direction   = glm::length (requested) > 0.f ? glm::normalize (requested) : glm::vec3 (camera.getDirection());
+        const auto  fieldOfView = request.fieldOfView > 0.f ? request.fieldOfView : camera.getVerticalFieldOfViewInDegrees();
+        auto&       view        = views[i];
+
+        view.position   = glm::make_vec3 (request.position);
+        view.projection = glm::perspective (fieldOfView, width / static_cast<float> (height), camera.getNearPlaneDistance(), camera.getFarPlaneDistance());
+        view.view       = glm::lookAt (view.position, view.position + direction, m_scene->getUpDirection());
+        view.x          = static_cast<GLint> (i % columns) * width;
+        view.y          = static_cast<GLint> (i / columns) * height;
+        view.width      = width;
+        view.height     = height;
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_serverFramebuffer);
+    glViewport (0, 0, columns * width, rows * height);
+    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    drawScene (views);
+
+    // Read every view back at once.
+    const auto  stride  = static_cast<size_t> (columns * width) * 4;
+    auto        pixels  = std::make_shared<std::vector<unsigned char>> (stride * rows * height);
+
+    glPixelStorei (GL_PACK_ALIGNMENT, 1);
+    glReadPixels (0, 0, columns * width, rows * height, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+
+    // Return to the window.
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+    glViewport (0, 0, m_viewportWidth, m_viewportHeight);
+    glBindBufferRange (GL_UNIFORM_BUFFER, UniformData::sceneBlock(), m_uniformUBO, UniformData::sceneOffset(), UniformData::sceneSize());
+
+    const auto renderTime = std::chrono::duration<float, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+    // Encode each view straight into its slot of the shared block.
+    const auto server   = m_server;
+    const auto pool     = decodingPool();
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const auto job      = batch[i];
+        const auto first    = static_cast<size_t> (views[i].y) * stride + static_cast<size_t> (views[i].x) * 4;
+        const auto count    = batch.size();
+
+        auto encode = [=] ()
+        {
+            const auto encodeStart  = std::chrono::steady_clock::now();
+            const auto size         = util::encodePNG (pixels->data() + first, job.request.width, job.request.height, stride, true,
+                                                       server->slotData (job.slot), server->getSlotSize());
+            const auto encodeTime   = std::chrono::duration<float, std::milli> (std::chrono::steady_clock::now() - encodeStart).count();
+
+            server->complete (job, size, count, renderTime, encodeTime);
+        };
+
+        if (pool)
+        {
+            m_serverEncodes.push_back (util::startTask (*pool, encode));
+        }
+
+        else
+        {
+            encode();
+        }
+    }
+}
+
+
+void MyView::prepareServerTarget (const GLsizei width, const GLsizei height)
+{
+    if (width <= m_serverWidth && height <= m_serverHeight)
+    {
+        return;
+    }
+
+    // Only ever grow so alternating resolutions don't cause reallocations.
+    m_serverWidth   = std::max (width, m_serverWidth);
+    m_serverHeight  = std::max (height, m_serverHeight);
+
+    if (m_serverFramebuffer == 0)
+    {
+        glGenFramebuffers (1, &m_serverFramebuffer);
+        glGenRenderbuffers (1, &m_serverColour);
+        glGenRenderbuffers (1, &m_serverDepth);
+    }
+
+    glBindRenderbuffer (GL_RENDERBUFFER, m_serverColour);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_RGBA8, m_serverWidth, m_serverHeight);
+
+    glBindRenderbuffer (GL_RENDERBUFFER, m_serverDepth);
+    glRenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_serverWidth, m_serverHeight);
+    glBindRenderbuffer (GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer (GL_FRAMEBUFFER, m_serverFramebuffer);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_serverColour);
+    glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_serverDepth);
+
+    if (glCheckFramebufferStatus (GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "The render server framebuffer is incomplete." << std::endl;
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+}
+
+
+void MyView::receiveSimulation()
+{
+    if (!m_simulation || m_simulation->receive() == 0)
+    {
+        return;
+    }
+
+    // The arrays only move when a mesh gains instances, otherwise the version counters tell the streams what to upload.
+    for (const auto& pair : m_simulation->getMeshes())
+    {
+        const auto& instances   = pair.second;
+
+        InstanceStream stream { };
+        stream.transforms       = instances.transforms.data();
+        stream.transformStride  = sizeof (glm::mat4);
+        stream.materials        = instances.materials.data();
+        stream.materialStride   = sizeof (std::int32_t);
+        stream.count            = instances.materials.size();
+        stream.version          = &instances.version;
+
+        setInstanceStream (static_cast<SceneModel::MeshId> (pair.first), stream);
+    }
+}
+
+
+void MyView::getCameraPose (void* const position, void* const direction) const
+{
+    const auto  simulated   = m_simulation ? m_simulation->getCamera() : nullptr;
+    const auto& camera      = m_scene->getCamera();
+
+    if (position)
+    {
+        *static_cast<glm::vec3*> (position) = simulated ? glm::make_vec3 (simulated->position) : glm::vec3 (camera.getPosition());
+    }
+
+    if (direction)
+    {
+        *static_cast<glm::vec3*> (direction) = simulated ? glm::make_vec3 (simulated->direction) : glm::vec3 (camera.getDirection());
+    }
+}
+
+
+void MyView::setUniforms (const void* const projectionMatrix, const void* const viewMatrix)
+{
+    // Fix the stupid lab computers not liking how I don't specify the texture unit and how I like using both on texture unit 0.
+    const auto textures     = glGetUniformLocation (m_program, "textures");
+    const auto materials    = glGetUniformLocation (m_program, "materials");
+    const auto materialIDs  = glGetUniformLocation (m_program, "materialIDs");
+    //
+    //glUniform1i (textures, m_resources->textureArray);
+    //glUniform1i (materials, m_resources->materials.tbo);
+    //glUniform1i (materialIDs, m_poolMaterialIDs.tbo);
+    //
+    glUniform1i (textures, 0);
+    glUniform1i (materials, 1);
+    glUniform1i (materialIDs, 2);
+
+    // Virtual textures are read through three more.
+    glUniform1i (glGetUniformLocation (m_program, "virtualTexturing"), m_resources->virtualTextures ? 1 : 0);
+    glUniform1i (glGetUniformLocation (m_program, "pageCache"), 3);
+    glUniform1i (glGetUniformLocation (m_program, "pageTable"), 4);
+    glUniform1i (glGetUniformLocation (m_program, "textureInfo"), 5);
+
+    // Create data to fill.
+    UniformData data { };
+
+    // Obtain the correct data for the uniforms. We'll need to cast the pointers, this is dirty but it prevents calculating the matrices twice
+    // or including GLM in the MyView header.
+    if (projectionMatrix && viewMatrix)
+    {
+        data.setProjectionMatrix (*(glm::mat4*) projectionMatrix);
+        data.setViewMatrix (*(glm::mat4*) viewMatrix);
+    }
+
+    glm::vec3 position { };
+    getCameraPose (&position, nullptr);
+
+    data.setCameraPosition (position);
+    data.setAmbientColour (m_scene->getAmbientLightIntensity());
+
+    // Obtain the lights in the scene, unless the simulation has taken control of them.
+    size_t lightCount { 0 };
+
+    if (m_simulation && m_simulation->hasLights())
+    {
+        for (const auto& simulated : m_simulation->getLights())
+        {
+            Light light { };
+            light.position      = glm::make_vec3 (simulated.position);
+            light.type          = simulated.type;
+            light.direction     = glm::make_vec3 (simulated.direction);
+            light.coneAngle     = simulated.coneAngle;
+            light.colour        = glm::make_vec3 (simulated.colour);
+            light.aConstant     = simulated.aConstant;
+            light.aLinear       = simulated.aLinear;
+            light.aQuadratic    = simulated.aQuadratic;
+
+            data.setLight (lightCount++, light);
+        }
+    }
+
+    else
+    {
+        const auto& lights  = m_scene->getAllLights();
+        lightCount          = lights.size();
 
-    // Enable each attribute pointer.
-    glEnableVertexAttribArray (position);
-    glEnableVertexAttribArray (normal);
-    glEnableVertexAttribArray (textureCoord);
+        // Add each light to the data.
+        for (size_t i = 0; i < lights.size(); ++i)
+        {
+            data.setLight (i, lights[i], LightType::Spot);   
+        }
+    }
 
-    // Begin creating the vertex attribute pointer from the interleaved buffer.
-    glBindBuffer (GL_ARRAY_BUFFER, m_vertexVBO);
+    data.setLightCount (lightCount);
 
-    // Set the properties of each attribute pointer.
-    glVertexAttribPointer (position,        3, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (0));
-    glVertexAttribPointer (normal,          3, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (12));
-    glVertexAttribPointer (textureCoord,    2, GL_FLOAT, GL_FALSE, sizeof (Vertex), TGL_BUFFER_OFFSET (24));
+    // The panorama can't survive a change in lighting.
+    const auto lighting = reinterpret_cast<const char*> (&data) + UniformData::lightingOffset();
 
-    // Now we need to create the instanced matrices attribute pointers.
-    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+    if (m_panoramaLighting.size() != UniformData::lightingSize() || !std::equal (m_panoramaLighting.begin(), m_panoramaLighting.end(), lighting))
+    {
+        m_panoramaLighting.assign (lighting, lighting + UniformData::lightingSize());
+        m_panoramaValid = false;
+    }
 
-    // We'll combine our matrices into a single VBO so we need the stride to be double.
-    util::createInstancedMatrix4 (modelTransform, sizeof (glm::mat4) * 2);
-    util::createInstancedMatrix4 (pvmTransform,   sizeof (glm::mat4) * 2, sizeof (glm::mat4));
+    // Overwrite the current uniform data.
+    glBindBuffer (GL_UNIFORM_BUFFER, m_uniformUBO);
+    glBufferSubData (GL_UNIFORM_BUFFER, 0, sizeof (UniformData), &data);
 
-    // Unbind all buffers.
-    glBindVertexArray (0);
-    glBindBuffer (GL_ARRAY_BUFFER, 0);
-    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+    // Unbind it since for safety.
+    glBindBuffer (GL_UNIFORM_BUFFER, 0);
 }
 
 
-void MyView::prepareTextureData (const GLsizei textureWidth, const GLsizei textureHeight, const GLsizei textureCount)
+void MyView::drawInstanceStream (StreamedInstances& streamed, const Mesh& mesh, const int modelAttribute, const std::vector<SceneView>& views)
 {
-    // Activate the material TBO by pointing it to the material VBO.
-    glBindTexture (GL_TEXTURE_BUFFER, m_materials.tbo);
-    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32F, m_materials.vbo);
+    if (streamed.stream.count == 0 || !streamed.stream.transforms)
+    {
+        return;
+    }
 
-    // Do the same for the material ID instance pool.
-    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
-    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_poolMaterialIDs.vbo);
+    // The material IDs are read from unit 2, the transform cache and virtual textures leave other units active.
+    glActiveTexture (GL_TEXTURE2);
+    uploadInstanceStream (streamed);
 
-    // Enable the 2D texture array and prepare its storage. Use 4 mipmap levels.
-    glBindTexture (GL_TEXTURE_2D_ARRAY, m_textureArray);
-    glTexStorage3D (GL_TEXTURE_2D_ARRAY, 4, GL_RGBA32F, textureWidth, textureHeight, textureCount);
+    // Point the instanced attributes and material IDs at the buffers of the stream for this draw only.
+    glBindBuffer (GL_ARRAY_BUFFER, streamed.transforms);
+    util::createInstancedMatrix4 (modelAttribute, sizeof (glm::mat4));
+    glBindTexture (GL_TEXTURE_BUFFER, streamed.materialIDs.tbo);
 
-    // Enable standard filters.
-    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_MAG_FILTER,  GL_LINEAR);
-    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_MIN_FILTER,  GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_WRAP_S,      GL_REPEAT);
-    glTexParameteri (GL_TEXTURE_2D_ARRAY,   GL_TEXTURE_WRAP_T,      GL_REPEAT);
+    for (size_t view = 0; view < views.size(); ++view)
+    {
+        selectView (views[view], view);
+        glDrawElementsInstancedBaseVertex (mesh.strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh.elementCount, GL_UNSIGNED_INT, (void*) mesh.elementsOffset, streamed.stream.count, mesh.verticesIndex);
+    }
 
-    // Unbind the textures.
-    glBindTexture (GL_TEXTURE_BUFFER, 0);
-    glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+    // Restore the pools for the meshes which follow.
+    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+    util::createInstancedMatrix4 (modelAttribute, sizeof (glm::mat4));
+    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+    glBindBuffer (GL_TEXTURE_BUFFER, m_poolMaterialIDs.vbo);
 }
 
 
-void MyView::loadTexturesIntoArray (const std::vector<std::pair<std::string, tygra::Image>>& images)
+void MyView::uploadInstanceStream (StreamedInstances& streamed)
 {
-    /// Here we load a container of images into the GPU using a 2D texture array. The reason I've chosen this route is that it means that I can avoid binding
-    /// a different texture every time the material changes. Instead of binding the correct texture we just provide an ID in each material which links to the
-    /// texture in the array. Therefore we avoid binding calls, we store the materials in the GPU so the information is easily accessible and if a shader
-    /// decided it wanted to combine textures it can.
+    /// The version lets a stream which hasn't changed be drawn straight from the buffers uploaded previously, so a static host costs nothing
+    /// per frame. Without a version the arrays are uploaded every frame. Each upload orphans the old storage so the GPU can keep reading it.
+    const auto& stream  = streamed.stream;
+    const auto  version = stream.version ? stream.version->load (std::memory_order_acquire) : 0;
 
-    glBindTexture (GL_TEXTURE_2D_ARRAY, m_textureArray); 
+    // Materials which changed slot mean the whole stream must be resolved again.
+    const auto current = streamed.uploaded && streamed.materialVersion == m_resources->materialVersion;
 
-    for (size_t i = 0; i < images.size(); ++i)
+    if (current && stream.version && version == streamed.version)
     {
-        // Cache the image.
-        const auto& image = images[i].second;
+        return;
+    }
 
-        // Only load the image if it contains data.
-        if (image.containsData()) 
-        {
-            // Enable each different pixel format.
-            GLenum pixel_formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    // When the host knows which matrices moved since the last upload, those are all that need writing.
+    if (current && stream.version && stream.dirty && version == streamed.version + 1 && stream.transformStride == sizeof (glm::mat4))
+    {
+        uploadDirtyTransforms (streamed);
+        streamed.version = version;
+        return;
+    }
 
-            glTexSubImage3D (   GL_TEXTURE_2D_ARRAY, 0, 
-                
-                                // Offsets.
-                                0, 0, i,
-                            
-                                // Dimensions and border.
-                                image.width(), image.height(), 1,   
-                      
-                                // Format and type.
-                                pixel_formats[image.componentsPerPixel()], image.bytesPerComponent() == 1 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT,
-                      
-                                // Data.
-                                image.pixels());
-        }
+    if (streamed.transforms == 0)
+    {
+        glGenBuffers (1, &streamed.transforms);
+        glGenBuffers (1, &streamed.materialIDs.vbo);
+        glGenTextures (1, &streamed.materialIDs.tbo);
     }
-    
-    // Generate the mipmaps from the loaded texture and finish.
-    glGenerateMipmap (GL_TEXTURE_2D_ARRAY);
-    glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
-}
 
+    // Tightly packed matrices go straight from the host into the buffer, otherwise they're gathered directly into mapped storage.
+    const auto transformSize = stream.count * sizeof (glm::mat4);
+    glBindBuffer (GL_ARRAY_BUFFER, streamed.transforms);
 
-size_t MyView::highestInstanceCount() const
-{
-    // We'll need a temporary variable to keep track.
-    size_t highest  { 0 };
-   
-    // Iterate through each mesh ID.
-    for (const auto& pair : m_meshes)
+    if (stream.transformStride == sizeof (glm::mat4))
     {
-        const auto current = m_scene->getInstancesByMeshId (pair.first).size();
+        glBufferData (GL_ARRAY_BUFFER, transformSize, stream.transforms, GL_STREAM_DRAW);
+    }
 
-        if (current > highest)
+    else
+    {
+        glBufferData (GL_ARRAY_BUFFER, transformSize, nullptr, GL_STREAM_DRAW);
+
+        const auto source       = static_cast<const char*> (stream.transforms);
+        const auto destination  = static_cast<glm::mat4*> (glMapBufferRange (GL_ARRAY_BUFFER, 0, transformSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+        if (destination)
         {
-            highest = current;
+            for (size_t i = 0; i < stream.count; ++i)
+            {
+                std::memcpy (&destination[i], source + i * stream.transformStride, sizeof (glm::mat4));
+            }
+
+            glUnmapBuffer (GL_ARRAY_BUFFER);
         }
     }
 
-    // Return the calculated figure.
-    return highest;
-}
+    // Material IDs must be resolved to their location in the material buffer. Like the pool, the buffer is padded to whole texels.
+    // Prefab placements take their materials from the entries so they don't have a material buffer at all.
+    streamed.materialVersion = m_resources->materialVersion;
 
-#pragma endregion
+    if (!streamed.hasMaterials)
+    {
+        streamed.version    = version;
+        streamed.uploaded   = true;
+        return;
+    }
 
+    std::vector<MaterialID> materialIDs ((stream.count + 3) / 4 * 4, 0);
+    const auto              materials = static_cast<const char*> (stream.materials);
 
-#pragma region Clean up
+    for (size_t i = 0; materials && i < stream.count; ++i)
+    {
+        std::int32_t id { };
+        std::memcpy (&id, materials + i * stream.materialStride, sizeof (id));
 
-void MyView::windowViewDidStop (std::shared_ptr<tygra::Window> window)
-{    
-    // Clean up after ourselves by getting rid of the stored meshes/materials.
-    cleanMeshMaterials();
+        materialIDs[i] = resolveMaterial (id);
+    }
 
-    // Clean up the OpenGL side of things.
-    deleteOpenGLObjects();
+    util::fillBuffer (streamed.materialIDs.vbo, materialIDs, GL_TEXTURE_BUFFER, GL_STREAM_DRAW);
+
+    glBindTexture (GL_TEXTURE_BUFFER, streamed.materialIDs.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, streamed.materialIDs.vbo);
+
+    streamed.version    = version;
+    streamed.uploaded   = true;
 }
 
 
-void MyView::cleanMeshMaterials()
+void MyView::uploadDirtyTransforms (const StreamedInstances& streamed)
 {
-    // Clean the mesh vector.
-    for (auto& pair : m_meshes)
-    {
-        if (pair.second)
-        {
-            delete pair.second;
-            pair.second = nullptr;
-        }
-    }
+    const auto& stream  = streamed.stream;
+    const auto  source  = static_cast<const glm::mat4*> (stream.transforms);
 
-    m_meshes.clear();
-    m_materialIDs.clear();
-}
+    glBindBuffer (GL_ARRAY_BUFFER, streamed.transforms);
 
+    // Each contiguous run of dirty instances becomes a single write.
+    size_t index = 0;
 
-void MyView::deleteOpenGLObjects()
-{
-    // Delete the program.
-    glDeleteProgram (m_program);
-    
-    // Delete the VAO.
-    glDeleteVertexArrays (1, &m_sceneVAO);
-    
-    // Delete all VBOs.
-    glDeleteBuffers (1, &m_vertexVBO);
-    glDeleteBuffers (1, &m_elementVBO);
-    glDeleteBuffers (1, &m_uniformUBO);
-    glDeleteBuffers (1, &m_materials.vbo);
-    glDeleteBuffers (1, &m_poolMaterialIDs.vbo);
-    glDeleteBuffers (1, &m_poolTransforms);
+    while (index < stream.count)
+    {
+        const auto word = stream.dirty[index / 64] >> (index % 64);
 
-    // Delete all textures.
-    glDeleteTextures (1, &m_textureArray);
-    glDeleteTextures (1, &m_materials.tbo);
-    glDeleteTextures (1, &m_poolMaterialIDs.tbo);
-}
+        if (word == 0)
+        {
+            index = (index / 64 + 1) * 64;
+            continue;
+        }
 
-#pragma endregion
+        if ((word & 1) == 0)
+        {
+            ++index;
+            continue;
+        }
 
+        auto end = index + 1;
 
-#pragma region Rendering
+        while (end < stream.count && (stream.dirty[end / 64] >> (end % 64)) & 1)
+        {
+            ++end;
+        }
 
-void MyView::windowViewDidReset (std::shared_ptr<tygra::Window> window, int width, int height)
-{
-    // Reset the viewport and recalculate the aspect ratio.
-    glViewport (0, 0, width, height);
-    m_aspectRatio = width / static_cast<float> (height);
+        glBufferSubData (GL_ARRAY_BUFFER, index * sizeof (glm::mat4), (end - index) * sizeof (glm::mat4), source + index);
+        index = end;
+    }
 }
 
 
-void MyView::windowViewRender (std::shared_ptr<tygra::Window> window)
+void MyView::drawPrefabs (const int modelAttribute, const std::vector<SceneView>& views)
 {
-    /// For the rendering of the scene I have chosen to implement instancing. A traditional approach of rendering would be looping through each instance,
-    /// assigning the correct model and PVM transforms, then drawing that one mesh before repeating the process. I don't use that method here, instead
-    /// I loop through mesh, obtain the number of instances, load in the data specific to those instances and draw them all at once, letting the shaders
-    /// obtain the correct information. I choose this method because although it doesn't help in a simple scene like sponza; scenes with particle systems,
-    /// large-scale mesh duplication and such would really benefit from reducing the overhead that bindings, uniform specification and draw calls cost.
-    assert (m_scene != nullptr);
-
-    // Specify shader program to use.
-    glUseProgram (m_program);
+    /// Prefabs are expanded at draw time rather than on the host. The placements of a prefab are uploaded to a single buffer which is bound
+    /// as the instanced model matrix, then each entry is drawn instanced over every placement with its own transform and material given as
+    /// uniforms. The vertex shader places the mesh within the prefab before placing the prefab in the world, so the host only ever stores
+    /// and streams a matrix per placement no matter how many meshes the prefab contains.
+    if (m_prefabs.empty())
+    {
+        return;
+    }
 
-    // Prepare the screen.
-    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
-    // Define matrices.
-    const auto& camera      = m_scene->getCamera();
-    const auto  projection  = glm::perspective (camera.getVerticalFieldOfViewInDegrees(), m_aspectRatio, camera.getNearPlaneDistance(), camera.getFarPlaneDistance()),
-                view        = glm::lookAt (camera.getPosition(), camera.getPosition() + camera.getDirection(), m_scene->getUpDirection());
-    
-    // Set the uniforms.
-    setUniforms (&projection, &view);
-    
-    // Specify the VAO to use.
-    glBindVertexArray (m_sceneVAO);
+    const auto prefabTransform  = glGetUniformLocation (m_program, "prefabTransform");
+    const auto materialOverride = glGetUniformLocation (m_program, "materialOverride");
+    auto       drawn            = false;
 
-    // Specify the buffers to use.
-    glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
-    glBindBuffer (GL_TEXTURE_BUFFER, m_poolMaterialIDs.vbo);
+    for (const auto prefab : m_prefabs)
+    {
+        if (!prefab || prefab->placements.stream.count == 0 || !prefab->placements.stream.transforms)
+        {
+            continue;
+        }
 
-    // Specify the textures to use.
-    glActiveTexture (GL_TEXTURE0);
-    glBindTexture (GL_TEXTURE_2D_ARRAY, m_textureArray);
+        // Uploading rebinds the material IDs of the placements, keep that off the virtual texture units.
+        auto& placements = prefab->placements;
+        glActiveTexture (GL_TEXTURE2);
+        uploadInstanceStream (placements);
 
-    glActiveTexture (GL_TEXTURE1);
-    glBindTexture (GL_TEXTURE_BUFFER, m_materials.tbo);
+        glBindBuffer (GL_ARRAY_BUFFER, placements.transforms);
+        util::createInstancedMatrix4 (modelAttribute, sizeof (glm::mat4));
+        drawn = true;
 
-    glActiveTexture (GL_TEXTURE2);
-    glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+        for (const auto& entry : prefab->prefab.entries)
+        {
+            // Entries whose mesh hasn't been uploaded yet are skipped rather than drawing something else.
+            const auto mesh = findMesh (entry.mesh);
 
-    // Use vectors for storing instancing data> This requires a material ID, a model transform and a PVM transform.
-    static std::vector<MaterialID> materialIDs (m_instancePoolSize);
-    static std::vector<glm::mat4> matrices (m_instancePoolSize * 2);
+            if (!mesh)
+            {
+                requestMesh (entry.mesh);
+                continue;
+            }
 
-    // Iterate through each mesh using instancing to reduce GL calls.
-    for (const auto& pair : m_meshes)
-    {
-        // Obtain the instances to draw for the current mesh.
-        const auto& instances   = m_scene->getInstancesByMeshId (pair.first);
-        const auto size         = instances.size();
+            glUniformMatrix4fv (prefabTransform, 1, GL_FALSE, glm::value_ptr (entry.transform));
+            glUniform1i (materialOverride, resolveMaterial (entry.material));
 
-        // Check if we need to do any rendering at all.
-        if (size != 0)
-        {
-            // Update the instance-specific information.
-            for (unsigned int i = 0; i < size; ++i)
+            for (size_t view = 0; view < views.size(); ++view)
             {
-                // Cache the current instance.
-                const auto& instance    = m_scene->getInstanceById (instances[i]);
+                selectView (views[view], view);
+                glDrawElementsInstancedBaseVertex (mesh->strips ? GL_TRIANGLE_STRIP : GL_TRIANGLES, mesh->elementCount, GL_UNSIGNED_INT, (void*) mesh->elementsOffset, 
+                                                   placements.stream.count, mesh->verticesIndex);
+            }
+        }
+    }
 
-                // Obtain the current instances model transformation.
-                const auto model        = (glm::mat4) instance.getTransformationMatrix();
+    // Restore the defaults and the pools so the next frame draws the scene normally.
+    if (drawn)
+    {
+        glUniformMatrix4fv (prefabTransform, 1, GL_FALSE, glm::value_ptr (glm::mat4 (1.f)));
+        glUniform1i (materialOverride, -1);
 
-                // We have both the model and pvm matrices in the buffer so we need an offset.
-                const auto offset       = i * 2;
+        glBindBuffer (GL_ARRAY_BUFFER, m_poolTransforms);
+        util::createInstancedMatrix4 (modelAttribute, sizeof (glm::mat4));
+        glBindTexture (GL_TEXTURE_BUFFER, m_poolMaterialIDs.tbo);
+        glBindBuffer (GL_TEXTURE_BUFFER, m_poolMaterialIDs.vbo);
+    }
+}
 
-                matrices[offset]        = model;
-                matrices[offset + 1]    = projection * view * model;
 
-                // Now deal with the materials.
-                materialIDs[i]          = m_materialIDs.at (instance.getMaterialId());
-            }
+int MyView::resolveMaterial (const int id)
+{
+    if (m_imported)
+    {
+        const auto index = static_cast<size_t> (id);
 
-            // Only overwrite the required data to speed up the buffering process. Avoid glMapBuffer because it's ridiculously slow in this case.
-            glBufferSubData (GL_ARRAY_BUFFER,   0,  sizeof (glm::mat4) * 2 * size,  matrices.data());
-            glBufferSubData (GL_TEXTURE_BUFFER, 0,  sizeof (MaterialID) * size,     materialIDs.data());
-            
-            // Cache access to the current mesh.
-            const auto& mesh = pair.second;
+        if (index < m_resources->materialSlots.size() && m_resources->materialSlots[index] >= 0)
+        {
+            return m_resources->materialSlots[index] * 2;
+        }
 
-            // Finally draw all instances at the same time.
-            glDrawElementsInstancedBaseVertex (GL_TRIANGLES, mesh->elementCount, GL_UNSIGNED_INT, (void*) mesh->elementsOffset, size, mesh->verticesIndex);
+        // Imported materials are uploaded whenever the scene references them, so anything else isn't in the scene at all.
+        if (m_unknownMaterials.insert (id).second)
+        {
+            std::cerr << "Material " << id << " isn't part of the imported scene, instances using it are drawn with the first material." << std::endl;
         }
+
+        return 0;
     }
 
-    // UNBIND IT ALL CAPTAIN!
-    glBindVertexArray (0);
-    glBindBuffer (GL_ARRAY_BUFFER, 0);
-    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+    const auto material = m_resources->materialIDs.find (static_cast<SceneModel::MaterialId> (id));
 
-    glActiveTexture (GL_TEXTURE1);
-    glBindTexture (GL_TEXTURE_BUFFER, 0);
+    if (material != m_resources->materialIDs.end())
+    {
+        return material->second;
+    }
 
-    glActiveTexture (GL_TEXTURE0);
-    //glBindTexture (GL_TEXTURE_2D_ARRAY, 0);
+    // The first material stands in for a frame whilst the material is uploaded, after which the material version makes streams resolve it again.
+    if (m_unknownMaterials.count (id) == 0)
+    {
+        m_missingMaterials.insert (id);
+    }
+
+    return 0;
 }
 
 
-void MyView::setUniforms (const void* const projectionMatrix, const void* const viewMatrix)
+const MyView::Mesh* MyView::findMesh (const SceneModel::MeshId id) const
 {
-    // Fix the stupid lab computers not liking how I don't specify the texture unit and how I like using both on texture unit 0.
-    const auto textures     = glGetUniformLocation (m_program, "textures");
-    const auto materials    = glGetUniformLocation (m_program, "materials");
-    const auto materialIDs  = glGetUniformLocation (m_program, "materialIDs");
-    //
-    //glUniform1i (textures, m_textureArray);
-    //glUniform1i (materials, m_materials.tbo);
-    //glUniform1i (materialIDs, m_poolMaterialIDs.tbo);
-    //
-    glUniform1i (textures, 0);
-    glUniform1i (materials, 1);
-    glUniform1i (materialIDs, 2);
-
-    // Create data to fill. Avoid creating it every time by using static.
-    static UniformData data { };
-
-    // Obtain the correct data for the uniforms. We'll need to cast the pointers, this is dirty but it prevents calculating the matrices twice
-    // or including GLM in the MyView header.
-    if (projectionMatrix && viewMatrix)
+    for (const auto& pair : m_resources->meshes)
     {
-        data.setProjectionMatrix (*(glm::mat4*) projectionMatrix);
-        data.setViewMatrix (*(glm::mat4*) viewMatrix);
+        if (pair.first == id)
+        {
+            return pair.second;
+        }
     }
 
-    data.setCameraPosition (m_scene->getCamera().getPosition());
-    data.setAmbientColour (m_scene->getAmbientLightIntensity());
+    return nullptr;
+}
 
-    // Obtain the lights in the scene.
-    const auto& lights  = m_scene->getAllLights();
-    size_t lightCount   = lights.size();
 
-    // Add each light to the data.
-    for (size_t i = 0; i < lights.size(); ++i)
+void MyView::waitForFrameSlot()
+{
+    /// Without throttling the driver will happily let us queue several frames of commands ahead of the GPU. Each queued frame adds
+    /// a frame of latency between input and display, and when the queue finally fills the CPU stalls for an unpredictable amount of time
+    /// inside a swap or buffer update, which is exactly what causes uneven pacing. Waiting on our own fences makes the stall explicit,
+    /// bounded and measurable.
+    if (!m_pacer)
     {
-        data.setLight (i, lights[i], LightType::Spot);   
+        return;
     }
 
-    // Enable the wireframe light if necessary.
-    if (m_wireframeMode)
+    const auto limit = static_cast<size_t> (m_pacer->getFramesInFlight());
+    const auto start = std::chrono::steady_clock::now();
+
+    while (m_frameFences.size() >= limit)
     {
-        data.setLight (lightCount++, createWireframeLight());
+        // Flush on the first wait so the fence is guaranteed to be signalled eventually.
+        const auto  fence   = m_frameFences.front();
+        const auto  timeout = GLuint64 (1000000000);
+        GLenum      result  = glClientWaitSync (fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync (fence, 0, timeout);
+        }
+
+        // An invalid fence or a lost context says nothing about whether the GPU is done with the slot. Finishing guarantees every queued
+        // frame has completed, so every fence can go rather than trusting any of them.
+        if (result == GL_WAIT_FAILED)
+        {
+            std::cerr << "Waiting on a frame fence failed with error " << glGetError() << ", finishing every queued frame instead." << std::endl;
+            glFinish();
+
+            for (const auto queued : m_frameFences)
+            {
+                glDeleteSync (queued);
+            }
+
+            m_frameFences.clear();
+            break;
+        }
+
+        glDeleteSync (fence);
+        m_frameFences.pop_front();
     }
 
-    data.setLightCount (lightCount);
+    m_pacer->recordFenceWait (std::chrono::duration<float, std::milli> (std::chrono::steady_clock::now() - start).count());
+}
 
-    // Overwrite the current uniform data.
-    glBindBuffer (GL_UNIFORM_BUFFER, m_uniformUBO);
-    glBufferSubData (GL_UNIFORM_BUFFER, 0, sizeof (UniformData), &data);
 
-    // Unbind it since for safety.
-    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+void MyView::fenceFrame()
+{
+    if (m_pacer)
+    {
+        m_frameFences.push_back (glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
 }
 
 
@@ -760,19 +4729,16 @@ Light MyView::createWireframeLight() const
     Light wireframe { };
 
     // Fill it with the correct information.
-    const auto& camera      = m_scene->getCamera();
-    wireframe.position      = camera.getPosition();
-    wireframe.direction     = camera.getDirection();
+    getCameraPose (&wireframe.position, &wireframe.direction);
 
     // Set suitable attenuation values.
     wireframe.aConstant     = 1.0f;
     wireframe.aLinear       = 0.0f;
     wireframe.aQuadratic    = 0.002f;
 
-    // Enable the wireframe and we're done! We only have three modes so use the currently selected.
+    // We only have three modes so use the currently selected.
     const LightType type    = static_cast<LightType> (m_wireframeType);
 
-    wireframe.emitWireframe = 1;
     wireframe.setType (type);
 
     return wireframe;
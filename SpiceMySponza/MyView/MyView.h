@@ -5,8 +5,12 @@
 
 
 // STL headers.
+#include <deque>
 #include <memory>
+#include <ostream>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 
 // Engine headers.
@@ -15,21 +19,49 @@
 
 
 // Personal headers.
+#include <Misc/Task.h>
 #include <Utility/OpenGL.h>
 
 
 // Forward declarations.
 namespace tygra { class Image; }
+class AsyncFileReader;
+class FramePacer;
+class GLThreadQueue;
+class RenderServer;
+class SimulationChannel;
+class TemporalCuller;
+class ThreadPool;
+struct ImportedScene;
 struct Light;
+struct SceneDiff;
+struct SceneModelTables;
+struct SceneReferences;
 struct Vertex;
 
 
+// Using declarations.
+using GLsync = struct __GLsync*;
+
+
 /// <summary>
 /// Used in creating and rendering of a scene using the Sponza graphics data.
 /// </summary>
 class MyView final : public tygra::WindowViewDelegate
 {
     public:
+
+        #pragma region Renderer types
+
+        class ResourcePool;
+        struct InstanceStream;
+        struct Material;
+        struct Mesh;
+        struct Prefab;
+        struct SceneResources;
+        class VirtualTextures;
+
+        #pragma endregion
     
         #pragma region Constructors and destructor
 
@@ -49,43 +81,224 @@ class MyView final : public tygra::WindowViewDelegate
         /// <summary> Sets the SceneModel::Context to use for rendering. </summary>
         void setScene (std::shared_ptr<const SceneModel::Context> scene);
 
-        /// <summary> Causes the application to rebuild the shaders. </summary>
+        /// <summary> Renders the geometry and materials of an imported scene instead of those of the SceneModel::Context. Must be set before the window starts. </summary>
+        /// <param name="scene"> The imported scene, the SceneModel::Context is still used for the camera and lighting. </param>
+        void setImportedScene (std::shared_ptr<const ImportedScene> scene);
+
+        /// <summary> Queues a newer version of the imported scene. Only the differences are uploaded, at the start of the next frame. </summary>
+        /// <param name="scene"> The updated scene. </param>
+        /// <param name="diff"> The differences between the currently imported scene and the updated scene. </param>
+        void updateImportedScene (std::shared_ptr<const ImportedScene> scene, std::shared_ptr<const SceneDiff> diff);
+
+        /// <summary> Queues the sponza meshes, materials and instances of a copy of the scene read again after its file changed. Only the differences are uploaded, at the start of the next frame. </summary>
+        /// <param name="content"> The copy which instances and materials come from afterwards, the camera and lights still come from the scene. </param>
+        /// <param name="tables"> The content laid out as tables, the diff refers to these. </param>
+        /// <param name="diff"> The differences between the tables of the current content and the updated tables. </param>
+        void updateSceneContent (std::shared_ptr<const SceneModel::Context> content, std::shared_ptr<const SceneModelTables> tables, std::shared_ptr<const SceneDiff> diff);
+
+        /// <summary> Shares the geometry, materials and textures of the scene with other views using the same pool. Must be set before the window starts. </summary>
+        void setResourcePool (std::shared_ptr<ResourcePool> pool);
+
+        /// <summary> Pages textures in as a feedback pass finds them visible, rather than keeping every texture resident. Must be set before the window starts. </summary>
+        void setVirtualTexturing (const bool enabled);
+
+        /// <summary> Lets textures which look the same but aren't identical share a layer, identical textures always do. Must be set before the window starts. </summary>
+        void setSimilarTextureMerging (const bool enabled);
+
+        /// <summary> Builds a position-only vertex stream so the depth of the window can be laid down before shading. Must be set before the window starts. </summary>
+        void setDepthPrepass (const bool enabled);
+
+        /// <summary> Draws meshes as triangle strips joined by primitive restarts wherever that needs fewer indices than a list. Must be set before the window starts. </summary>
+        void setStripification (const bool enabled);
+
+        /// <summary> Draws static instances from world space vertices captured once by transform feedback instead of transforming them in every pass. </summary>
+        void setTransformCache (const bool enabled);
+
+        /// <summary> Skips drawing large meshes whose bounding boxes were hidden by the rest of the window the frame before, decided on the GPU with occlusion queries. </summary>
+        void setOcclusionQueries (const bool enabled);
+
+        /// <summary> Sets the FramePacer which controls how many frames may be in flight and receives fence timings. </summary>
+        void setFramePacer (std::shared_ptr<FramePacer> pacer);
+
+        /// <summary> Sets the reader used to load shaders and whose thread pool decodes textures, files are loaded synchronously without one. </summary>
+        void setFileReader (std::shared_ptr<AsyncFileReader> reader);
+
+        /// <summary> Sets the queue executed on the render thread, with a file reader it allows shaders to be rebuilt without stalling a frame. </summary>
+        void setGLThreadQueue (std::shared_ptr<GLThreadQueue> queue);
+
+        /// <summary> Renders the instances of a mesh from arrays owned by the host instead of the scene. Call from the render thread. </summary>
+        /// <param name="mesh"> The ID of the mesh in the SceneModel::Context, or the index of an imported mesh. </param>
+        /// <param name="stream"> Where the instance data lives, the arrays must remain valid until the stream is removed. </param>
+        void setInstanceStream (const SceneModel::MeshId mesh, const InstanceStream& stream);
+
+        /// <summary> Returns a mesh to rendering the instances of the scene. Call from the render thread. </summary>
+        void removeInstanceStream (const SceneModel::MeshId mesh);
+
+        /// <summary> Registers a group of meshes which can be placed in the scene as a whole. Call from the render thread. </summary>
+        /// <returns> The ID used to place and remove the prefab. </returns>
+        size_t addPrefab (const Prefab& prefab);
+
+        /// <summary> Places instances of a prefab from arrays owned by the host. Call from the render thread. </summary>
+        /// <param name="prefab"> The ID given by addPrefab(). </param>
+        /// <param name="stream"> The transform of each placement of the prefab, materials come from the entries so they're ignored. </param>
+        void setPrefabInstances (const size_t prefab, const InstanceStream& stream);
+
+        /// <summary> Stops drawing a prefab and frees its buffers, the ID may be given to a later prefab. Call from the render thread. </summary>
+        void removePrefab (const size_t prefab);
+
+        /// <summary> Sets a channel from another process whose instances, camera and lights are received at the start of each frame. </summary>
+        void setSimulationChannel (std::shared_ptr<SimulationChannel> channel);
+
+        /// <summary> Sets a server whose requests are rendered offscreen at the end of each frame. Must be set before the window starts. </summary>
+        void setRenderServer (std::shared_ptr<RenderServer> server);
+
+        /// <summary> Causes the application to rebuild the shaders, the current program keeps rendering until the new one is ready. </summary>
         void rebuildShaders();
 
+        /// <summary> Restores the OpenGL state the view set when it started, for when another view has drawn with the context since. Call from the render thread. </summary>
+        void restoreContextState();
+
         /// <summary> Enables a wireframe view near the camera. </summary>
         void toggleWireframeMode()  { m_wireframeMode = !m_wireframeMode; }
 
         /// <summary> Cycles through point, spot and directional wireframe mode. </summary>
         void toggleWireframeType()  { m_wireframeType = ++m_wireframeType % 3; }
 
+        /// <summary> Cycles through no culling, culling every instance each frame and temporally coherent culling. </summary>
+        void cycleCullingMode();
+
+        /// <summary> Reuses a panorama rendered around the camera for frames where the camera only turns. Only static scenes benefit, anything streamed disables it. </summary>
+        void togglePanoramaMode();
+
+        /// <summary> Turns the depth pre-pass on and off, only if the position stream was built. </summary>
+        void toggleDepthPrepass();
+
+        /// <summary> Turns the transform cache on and off, turning it off releases the captured vertices. </summary>
+        void toggleTransformCache();
+
+        /// <summary> Turns occlusion queries on and off, turning them off deletes the queries. </summary>
+        void toggleOcclusionQueries();
+
+        /// <summary> Writes the statistics of the renderer in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
         #pragma endregion
 
     private:
 
+        struct PrefabInstances;
+        struct SceneView;
+        struct StreamedInstances;
+
+        /// <summary> The source code of every shader the programs are built from, by file name. </summary>
+        using ShaderSources = std::unordered_map<std::string, std::string>;
+
         #pragma region Scene construction
 
         /// <summary> Causes the object to initialise; loading and preparing all data. </summary>
         void windowViewWillStart (std::shared_ptr<tygra::Window> window) override final;
 
-        /// <summary> Will create the program then compile, attach and link all required shaders together. </summary>
+        /// <summary> Reads every shader on this thread, or through the file reader if there is one. Shaders which can't be read are empty. </summary>
+        ShaderSources loadShaders() const;
+
+        /// <summary> Reads every shader together using the file reader. </summary>
+        Task<ShaderSources> readShaders (CancellationToken token) const;
+
+        /// <summary> Deletes every program and builds them all again from the given shaders, both when starting and reloading. </summary>
+        /// <returns> Whether the main program was compiled properly. </returns>
+        bool buildPrograms (const ShaderSources& sources);
+
+        /// <summary> Rebuilds every program and reconnects the UBO and VAOs to them, everything which reloading shaders needs. </summary>
+        /// <returns> Whether the main program was compiled properly. </returns>
+        bool replacePrograms (const ShaderSources& sources);
+
+        /// <summary> Creates the program from shader source code which has already been loaded. </summary>
         /// <returns> Whether the program was compiled properly. </returns>
-        bool buildProgram();
+        bool buildProgram (const std::string& vertexSource, const std::string& fragmentSource);
 
         /// <summary> Generates the VAO and buffers owned by the MyView class. </summary>
         void generateOpenGLObjects();
 
+        /// <summary> Obtains the resources of the scene from the pool, building them if this is the first view of the scene. </summary>
+        void acquireResources();
+
+        /// <summary> Gets what identifies the assets of the scene in the resource pool, it must not change when the scene is reloaded. </summary>
+        std::string resourceKey() const;
+
         /// <summary> Creates a mesh of every object in the scene and loads the data into VBOs. </summary>
         void buildMeshData();
 
+        /// <summary> Orders the instances of each sponza mesh in this view's scene, the meshes must have been built. </summary>
+        void orderSceneInstances();
+
         /// <summary> Creates a material for each materialID in the map, ready for rendering. </summary>
         void buildMaterialData();
 
-        /// <summary> Constructs the VAO for the scene using an interleaved vertex VBO and instanced transform matrices. </summary>
+        /// <summary> Decodes the textures of the given sponza materials and uploads them along with the materials, replacing whatever was loaded before. </summary>
+        void loadSceneMaterials (const std::vector<SceneModel::Material>& materials);
+
+        /// <summary> Gives each sponza material a slot, identical materials sharing one, using the loaded textures. Nothing is uploaded. </summary>
+        void layoutSceneMaterials (const std::vector<SceneModel::Material>& materials);
+
+        /// <summary> Creates the buffer-ready version of a sponza material. </summary>
+        /// <param name="layers"> The texture array layer of each loaded texture, the material has no texture if its texture isn't one of them. </param>
+        static Material createMaterial (const SceneModel::Material& material, const std::unordered_map<std::string, size_t>& layers);
+
+        /// <summary> Uploads the imported meshes which instances reference and groups the instances by mesh. </summary>
+        void buildImportedMeshData();
+
+        /// <summary> Uploads an imported mesh to the given location in the bound vertex and element buffers. </summary>
+        /// <param name="index"> The index of the mesh in the imported scene. </param>
+        /// <param name="verticesIndex"> The vertex to start writing to. </param>
+        /// <param name="elementIndex"> The element to start writing to. </param>
+        void uploadImportedMesh (const size_t index, const size_t verticesIndex, const size_t elementIndex);
+
+        /// <summary> Uploads the imported materials which instances reference and loads the textures those materials use. </summary>
+        void buildImportedMaterialData();
+
+        /// <summary> Loads every referenced texture of the imported scene and determines the texture array layer of each one. </summary>
+        /// <param name="images"> Receives the images which were loaded successfully. </param>
+        /// <param name="references"> Determines which textures are needed. </param>
+        void loadImportedTextures (std::vector<std::pair<std::string, tygra::Image>>& images, const SceneReferences& references);
+
+        /// <summary> Removes duplicate images by their contents and reports how much decoding and texture memory was saved. </summary>
+        /// <returns> The index of each file in the remaining images. </returns>
+        /// <param name="images"> The decoded images, duplicates are removed. </param>
+        /// <param name="skippedFiles"> How many repeated files were never decoded. </param>
+        /// <param name="decodeTime"> How long decoding took in milliseconds. </param>
+        std::unordered_map<std::string, size_t> deduplicateTextures (std::vector<std::pair<std::string, tygra::Image>>& images, const size_t skippedFiles, const double decodeTime) const;
+
+        /// <summary> Gets the thread pool of the file reader which images should be decoded on, if there is one. </summary>
+        ThreadPool* decodingPool() const;
+
+        /// <summary> Gives every referenced imported material a slot, identical materials sharing one, once each points to the texture array layer of its texture. </summary>
+        /// <returns> The buffer-ready material of each slot. </returns>
+        std::vector<Material> layoutImportedMaterials (const SceneReferences& references);
+
+        /// <summary> Groups the imported instances by mesh so they can be drawn with instancing, sorted by material within each mesh. </summary>
+        void groupImportedInstances();
+
+        /// <summary> Constructs the VAO for the scene using an interleaved vertex VBO and instanced transform matrices, and the position-only VAO if there's a position stream. </summary>
         void constructVAO();
 
+        /// <summary> Allocates the position stream to hold the given number of vertices, if there is one. </summary>
+        void allocatePositions (const size_t vertexCount);
+
+        /// <summary> Copies the positions of the given vertices into the position stream, if there is one. </summary>
+        /// <param name="verticesIndex"> The index of the first vertex in the vertex VBO. </param>
+        void uploadPositions (const Vertex* const vertices, const size_t count, const size_t verticesIndex);
+
+        /// <summary> Writes the elements of a mesh into the bound element VBO, as strips if the resources use them and they're smaller. </summary>
+        /// <returns> How many elements were written, never more than count. </returns>
+        /// <param name="elementIndex"> The index of the first element in the element VBO. </param>
+        size_t uploadElements (Mesh& mesh, const unsigned int* const elements, const size_t count, const size_t elementIndex);
+
         /// <summary> This will allocate enough memory in m_uniformVBO, m_materialPool and m_matricesPool for modification at run-time. </summary>
         void allocateExtraBuffers();
 
+        /// <summary> Allocates the instance pools so they can hold the instances of the most instanced mesh in the scene. </summary>
+        void allocateInstancePools();
+
         /// <summary> Sets up the binding of the Uniform Buffer Object used for the scene and lighting. </summary>
         void bindUniformBufferObject();
 
@@ -95,16 +308,80 @@ class MyView final : public tygra::WindowViewDelegate
         /// <param name="textureCount"> The total number of textures the array can store. </param>
         void prepareTextureData (const GLsizei textureWidth, const GLsizei textureHeight, const GLsizei textureCount);
 
+        /// <summary> Loads the images into the texture array, or hands them to the virtual textures which leave the array as a placeholder. </summary>
+        void uploadTextures (const std::vector<std::pair<std::string, tygra::Image>>& images);
+
+        /// <summary> Writes the materials to the material buffer as RGBA16F when every material fits, otherwise as RGBA32F. </summary>
+        /// <param name="materials"> The buffer-ready material of every slot. </param>
+        /// <param name="slots"> The slots which changed, nullptr uploads everything. The whole buffer is reallocated if it grows or changes format. </param>
+        void uploadMaterials (const std::vector<Material>& materials, const std::vector<size_t>* const slots);
+
+        /// <summary> Uploads the materials, allocates the texture array using the first image and loads every image into it. </summary>
+        /// <param name="materials"> The buffer-ready materials to upload. </param>
+        /// <param name="images"> The images to load into the texture array. </param>
+        void uploadMaterialsAndTextures (const std::vector<Material>& materials, const std::vector<std::pair<std::string, tygra::Image>>& images);
+
         /// <summary> Loads every given image into the 2D texture array. </summary>
         /// <param name="images"> The images to load. </param>
         void loadTexturesIntoArray (const std::vector<std::pair<std::string, tygra::Image>>& images);
 
+        /// <summary> Loads an image into a single layer of the bound 2D texture array, mipmaps must be generated afterwards. </summary>
+        /// <param name="image"> The image to load, it must match the dimensions of the array. </param>
+        /// <param name="layer"> The layer to overwrite. </param>
+        void loadTextureIntoLayer (const tygra::Image& image, const GLsizei layer);
+
         /// <summary> Obtains each group of instances for each SceneModel::MeshId and determines the maximum number of instances we'll encounter. </summary>
         /// <returns> The highest instance count of each SceneModel::MeshId in the scene. </returns>
         size_t highestInstanceCount() const;
         
         #pragma endregion
 
+        #pragma region Hot reloading
+
+        /// <summary> Applies a queued scene update, uploading only what has changed into the existing buffers. </summary>
+        void applySceneUpdate();
+
+        /// <summary> Uploads changed meshes into their existing buffer ranges, appending meshes which outgrew theirs. </summary>
+        /// <returns> Whether the geometry buffers had to be reallocated because the scene no longer fits. </returns>
+        bool updateImportedMeshes (const SceneDiff& diff, const SceneReferences& references);
+
+        /// <summary> Reloads changed textures in place, rebuilding the texture array if the textures were rearranged, resized or newly referenced. </summary>
+        /// <returns> Whether the texture array layers changed, requiring every material to be uploaded again. </returns>
+        bool updateImportedTextures (const SceneDiff& diff, const SceneReferences& references);
+
+        /// <summary> Uploads changed and newly referenced materials into the material buffer, reallocating it only when it needs to grow. </summary>
+        /// <param name="diff"> The changes to the scene. </param>
+        /// <param name="references"> Determines which materials are needed. </param>
+        /// <param name="uploadAll"> Forces every material to be uploaded. </param>
+        void updateImportedMaterials (const SceneDiff& diff, const SceneReferences& references, const bool uploadAll);
+
+        /// <summary> Applies queued sponza content, uploading only the meshes and materials which changed or are newly used. </summary>
+        void applySceneContent();
+
+        /// <summary> Appends changed and newly instanced sponza meshes to the geometry buffers, laying every mesh out again if they don't fit. </summary>
+        /// <returns> Whether the geometry buffers had to be reallocated. </returns>
+        bool updateSceneMeshes (const SceneModelTables& tables, const SceneDiff& diff);
+
+        /// <summary> Lays the sponza materials out again, reloading the textures only if one has changed or a material needs one which isn't loaded. </summary>
+        void updateSceneMaterials (const SceneDiff& diff);
+
+        /// <summary> Writes a sponza mesh after every mesh in the bound geometry buffers, which must have room for it. </summary>
+        void appendSceneMesh (Mesh& mesh, const Vertex* const vertices, const size_t vertexCount, const unsigned int* const elements, const size_t elementCount);
+
+        /// <summary> Uploads the sponza meshes and materials which streams and prefabs have referenced since the last frame. </summary>
+        void loadMissingAssets();
+
+        /// <summary> Appends the missing sponza meshes to the geometry buffers, laying every mesh out again if they don't fit. </summary>
+        void loadMissingMeshes();
+
+        /// <summary> Appends the missing sponza materials to the material buffer, reloading the textures if a material needs one which isn't loaded. </summary>
+        void loadMissingMaterials();
+
+        /// <summary> Remembers that a sponza mesh must be uploaded before the next frame if it hasn't been already. </summary>
+        void requestMesh (const SceneModel::MeshId id);
+
+        #pragma endregion
+
         #pragma region Clean up
 
         /// <summary> Causes the object to free up any resources being held. </summary>
@@ -123,24 +400,141 @@ class MyView final : public tygra::WindowViewDelegate
         /// <summary> Changes the viewport, updating the aspect ratio, etc. </summary>
         void windowViewDidReset (std::shared_ptr<tygra::Window> window, int width, int height) override final;
 
-        /// <summary> Renders the given scene, the object should be initialised before calling this. </summary>
+        /// <summary> Renders the given scene, the object should be initialised before calling this. Without a window only the render server is served. </summary>
         void windowViewRender (std::shared_ptr<tygra::Window> window) override final;
 
+        /// <summary> Draws the scene from each view into its own viewport, uploading the instances of each mesh once for every view. </summary>
+        /// <param name="views"> The views to draw, no more than the uniform buffer has room for. </param>
+        /// <param name="depthOnly"> Draws positions only with whichever program is bound, leaving out prefabs. </param>
+        void drawScene (const std::vector<SceneView>& views, const bool depthOnly = false);
+
+        /// <summary> Lays down the depth of the window with the position-only VAO, after which the window is drawn with a less-or-equal depth test. </summary>
+        void drawDepthPrepass (const SceneView& main);
+
+        /// <summary> Compiles the program which draws the depth pre-pass. </summary>
+        void buildDepthProgram (const ShaderSources& sources);
+
+        /// <summary> Transforms every instance of every mesh without a host stream into world space, capturing the vertices with transform feedback. </summary>
+        void captureStaticGeometry();
+
+        /// <summary> Draws the captured static instances with the given program, one multi-draw per mesh for each view. </summary>
+        /// <param name="culling"> Whether instances the culler can't see are skipped. </param>
+        void drawCachedGeometry (const std::vector<SceneView>& views, const bool culling, const GLuint program);
+
+        /// <summary> Deletes the captured vertices, they'll be captured again if the cache is still on. </summary>
+        void releaseTransformCache();
+
+        /// <summary> Compiles the program which captures static instances with transform feedback. </summary>
+        void buildCaptureProgram (const ShaderSources& sources);
+
+        /// <summary> Reads back the results of the queries about to be reused without waiting for any, creating queries for every mesh if needed. </summary>
+        void prepareOcclusionQueries();
+
+        /// <summary> Decides whether a mesh has enough triangles for a query on its bounding box to be worth it. </summary>
+        /// <param name="count"> How many instances are being drawn, their transforms are the first in m_instanceMatrices. The camera being inside any rules the mesh out. </param>
+        bool wantsOcclusionQuery (const Mesh& mesh, const GLsizei count, const SceneView& view) const;
+
+        /// <summary> Queues the box of a mesh to be queried once the window is drawn, unless the mesh has been visible for long enough to skip this frame. </summary>
+        /// <param name="count"> How many instances are being drawn, their transforms are the first in m_instanceMatrices. </param>
+        void queueOcclusionQuery (const size_t meshIndex, const GLsizei count);
+
+        /// <summary> Draws the bounding boxes of the meshes queued this frame within a query each, depth tested against the whole window. </summary>
+        void issueOcclusionQueries();
+
+        /// <summary> Deletes the queries of every mesh, they'll be created again at the start of the next frame if queries are still on. </summary>
+        void releaseOcclusionQueries();
+
+        /// <summary> Compiles the program which draws the bounding boxes of queried meshes. </summary>
+        void buildOcclusionProgram (const ShaderSources& sources);
+
+        /// <summary> Adds the wireframe on top of the drawn window, only instances within reach of the wireframe light are drawn again. </summary>
+        void drawWireframeOverlay (const SceneView& main);
+
+        /// <summary> Compiles the program which draws the wireframe overlay. </summary>
+        void buildWireframeProgram (const ShaderSources& sources);
+
+        /// <summary> Gives the culler a bounding sphere for every instance of the scene, unless the instances are the same as last time. </summary>
+        void prepareCulling();
+
+        /// <summary> Draws the scene at a fraction of the resolution of the window, recording which virtual texture pages each pixel needs. </summary>
+        /// <param name="main"> The view of the window. </param>
+        void drawFeedback (const SceneView& main);
+
+        /// <summary> Ensures the framebuffer of the feedback pass is the given size. </summary>
+        void prepareFeedbackTarget (const GLsizei width, const GLsizei height);
+
+        /// <summary> Draws the window by reprojecting the panorama, rendering it again first if the camera has moved or the scene has changed. </summary>
+        /// <param name="main"> The view of the window, the panorama is rendered from its position. </param>
+        void drawFromPanorama (const SceneView& main);
+
+        /// <summary> Compiles the program which reprojects the panorama. </summary>
+        void buildPanoramaProgram (const ShaderSources& sources);
+
+        /// <summary> Allocates the cube map and depth buffer of the panorama with faces of the given size. </summary>
+        void preparePanorama (const GLsizei faceSize);
+
+        /// <summary> Renders the scene into every face of the panorama from the given position. </summary>
+        void renderPanorama (const SceneView& main);
+
+        /// <summary> Switches the viewport and the scene uniform block to the given view. </summary>
+        void selectView (const SceneView& view, const size_t index);
+
+        /// <summary> Renders a batch of render server requests offscreen and hands the pixels to the thread pool for encoding. </summary>
+        void serveRenderRequests();
+
+        /// <summary> Ensures the offscreen framebuffer used by the render server is at least the given size. </summary>
+        void prepareServerTarget (const GLsizei width, const GLsizei height);
+
+        /// <summary> Receives any updates waiting in the simulation channel, streaming the instances of every mesh it mentions. </summary>
+        void receiveSimulation();
+
+        /// <summary> Gets the position and direction of the camera, preferring the camera of the simulation. Avoid including GLM by passing void*. </summary>
+        /// <param name="position"> A pointer to a glm::vec3 to receive the world-space position. </param>
+        /// <param name="direction"> A pointer to a glm::vec3 to receive the world-space direction. </param>
+        void getCameraPose (void* const position, void* const direction) const;
+
         /// <summary> Sets all uniform values for the scene. Avoid including GLM in MyView by passing void*. </summary>
         /// <param name="projectionMatrix"> A pointer to a glm::mat4 projection matrix for the scene. </param>
         /// <param name="viewMatrix"> A pointer to a glm::mat4 view matrix for the scene. </param>
         void setUniforms (const void* const projectionMatrix, const void* const viewMatrix);
 
+        /// <summary> Draws a mesh using the instances of a host stream, uploading the stream first if its version has changed. </summary>
+        /// <param name="modelAttribute"> The location of the instanced model matrix attribute. </param>
+        /// <param name="views"> Every view the mesh should be drawn from. </param>
+        void drawInstanceStream (StreamedInstances& streamed, const Mesh& mesh, const int modelAttribute, const std::vector<SceneView>& views);
+
+        /// <summary> Copies the stream into its buffers unless the version shows it hasn't changed since the last upload. </summary>
+        void uploadInstanceStream (StreamedInstances& streamed);
+
+        /// <summary> Writes only the matrices of a stream which its dirty bits mark as changed. </summary>
+        void uploadDirtyTransforms (const StreamedInstances& streamed);
+
+        /// <summary> Draws every entry of every prefab once per placement, using the placements as the instanced model matrices. </summary>
+        /// <param name="modelAttribute"> The location of the instanced model matrix attribute. </param>
+        /// <param name="views"> Every view the prefabs should be drawn from. </param>
+        void drawPrefabs (const int modelAttribute, const std::vector<SceneView>& views);
+
+        /// <summary> Finds the location in the material buffer of a SceneModel material ID or imported material index, zero if it's unknown. </summary>
+        /// <remarks> Sponza materials which haven't been uploaded are loaded at the start of the next frame, unknown materials are reported once. </remarks>
+        int resolveMaterial (const int id);
+
+        /// <summary> Finds the uploaded mesh with the given ID, nullptr if the scene doesn't draw it. </summary>
+        const Mesh* findMesh (const SceneModel::MeshId id) const;
+
+        /// <summary> Blocks until the number of frames queued on the GPU is below the frames in flight limit of the FramePacer. </summary>
+        void waitForFrameSlot();
+
+        /// <summary> Inserts a fence after the commands of the current frame so it can be waited upon later. </summary>
+        void fenceFrame();
+
         /// <summary> Creates a wireframe light based on the cameras position. </summary>
-        /// <returns> A light ready for adding to the UBO. </returns>
+        /// <returns> The light which the wireframe overlay fades out with. </returns>
         Light createWireframeLight() const;
 
         #pragma endregion
 
         #pragma region Implementation data
 
-        struct Material;
-        struct Mesh;
         class UniformData;
 
         // Using declarations.
@@ -163,29 +557,137 @@ class MyView final : public tygra::WindowViewDelegate
             SamplerBuffer& operator= (SamplerBuffer&& move);
         };        
 
+        /// <summary>
+        /// The occlusion queries of a mesh along with what their results have said about it. A query is written each frame in turn so the
+        /// one being drawn against is from the frame before and the one being read back is from as long ago as possible.
+        /// </summary>
+        struct OcclusionQuery final
+        {
+            static const unsigned int latency = 3;  //!< How many queries each mesh cycles through.
+
+            GLuint          queries[latency];       //!< The queries, one for each frame they're kept.
+            unsigned int    issued      { 0 };      //!< A bit for each query which has been issued and not read back.
+            unsigned int    history     { 0 };      //!< The latest results read back a bit each, newest lowest, set if the box was visible.
+            size_t          first       { 0 };      //!< Where the instances of the box queried this frame start in m_occlusionMatrices.
+            GLsizei         count       { 0 };      //!< How many instances the box queried this frame has.
+        };
+
         GLuint                                                  m_program           { 0 };          //!< The ID of the OpenGL program created and used to draw the scene.
 
         GLuint                                                  m_sceneVAO          { 0 };          //!< A Vertex Array Object for the entire scene.
-        GLuint                                                  m_vertexVBO         { 0 };          //!< A Vertex Buffer Object which contains the interleaved vertex data of every mesh in the scene.
-        GLuint                                                  m_elementVBO        { 0 };          //!< A Vertex Buffer Object with the elements data for every mesh in the scene.
-        
         GLuint                                                  m_uniformUBO        { 0 };          //!< A Uniform Buffer Object which contains scenes uniform data.
         
-        SamplerBuffer                                           m_materials         { };            //!< A VBO & TBO pair representing information on every material in the scene.
-        GLuint                                                  m_textureArray      { 0 };          //!< The TEXTURE_2D_ARRAY which contains each texture in the scene.
-        
         size_t                                                  m_instancePoolSize  { 0 };          //!< The current size of the instance pools, useful for optimising rendering.
         SamplerBuffer                                           m_poolMaterialIDs   { };            //!< A pool of material IDs for each instance, used for accessing the instance-specific material.
-        GLuint                                                  m_poolTransforms    { 0 };          //!< A pool of model and PVM transformation matrices, used in instanced rendering.
+        GLuint                                                  m_poolTransforms    { 0 };          //!< A pool of model transformation matrices, used in instanced rendering.
         
         float                                                   m_aspectRatio       { 0.f };        //!< The calculated aspect ratio of the foreground resolution for the application.
+        GLsizei                                                 m_viewportWidth     { 0 };          //!< The width of the window in pixels.
+        GLsizei                                                 m_viewportHeight    { 0 };          //!< The height of the window in pixels.
+        size_t                                                  m_viewOffset        { 0 };          //!< Where the scene uniform block of the first view starts in the UBO.
+        size_t                                                  m_viewStride        { 0 };          //!< The distance between the scene uniform blocks of each view.
+        size_t                                                  m_viewCapacity      { 0 };          //!< How many views the UBO has room for.
 
         std::shared_ptr<const SceneModel::Context>              m_scene             { nullptr };    //!< The sponza scene containing instance and camera information.
-        std::vector<std::pair<SceneModel::MeshId, Mesh*>>       m_meshes            { };            //!< A container of MeshId and Mesh pairs, used in instance-based rendering of meshes in the scene.
-        std::unordered_map<SceneModel::MaterialId, MaterialID>  m_materialIDs       { };            //!< A map containing each material used for rendering.
+        std::shared_ptr<const SceneModel::Context>              m_content           { nullptr };    //!< Where the sponza instances and materials come from, the scene until its file is read again.
+        std::shared_ptr<SceneResources>                         m_resources         { nullptr };    //!< The geometry, materials and textures of the scene, possibly shared with other views.
+        std::shared_ptr<ResourcePool>                           m_resourcePool      { nullptr };    //!< Where resources are shared with other views, every view has its own without one.
+        std::unordered_map<SceneModel::MeshId, StreamedInstances*>  m_instanceStreams   { };        //!< Meshes whose instances come from arrays owned by the host, with the buffers they're uploaded to.
+        std::vector<PrefabInstances*>                           m_prefabs           { };            //!< Every prefab indexed by ID with its placements, removed prefabs leave a nullptr.
+
+        std::shared_ptr<const ImportedScene>                    m_imported          { nullptr };    //!< An optional imported scene which replaces the SceneModel geometry and materials.
+        std::vector<MaterialID>                                 m_instanceMaterials { };            //!< The material IDs of the instances of the mesh being drawn.
+        std::vector<float>                                      m_instanceMatrices  { };            //!< The model matrices of the instances of the mesh being drawn, sixteen floats each.
+        std::vector<std::vector<SceneModel::InstanceId>>        m_sceneInstances    { };            //!< The instances of each sponza mesh in Morton order, in the same order as the meshes of the resources.
+        size_t                                                  m_meshVersion       { 0 };          //!< The mesh version of the resources the instances were ordered for.
+        std::unordered_set<SceneModel::MeshId>                  m_missingMeshes     { };            //!< Sponza meshes referenced since the last frame which may not have been uploaded.
+        std::unordered_set<int>                                 m_missingMaterials  { };            //!< Sponza materials referenced since the last frame which haven't been uploaded.
+        std::unordered_set<SceneModel::MeshId>                  m_unknownMeshes     { };            //!< Meshes which were referenced but the scene doesn't have, each is reported once.
+        std::unordered_set<int>                                 m_unknownMaterials  { };            //!< Materials which were referenced but the scene doesn't have, each is reported once.
+        size_t                                                  m_lateMeshes        { 0 };          //!< How many meshes this view uploaded because they were referenced after loading.
+        size_t                                                  m_lateMaterials     { 0 };          //!< How many materials this view uploaded because they were referenced after loading.
+
+        std::shared_ptr<const ImportedScene>                    m_pendingScene      { nullptr };    //!< An updated scene waiting to be applied at the start of the next frame.
+        std::shared_ptr<const SceneDiff>                        m_pendingDiff       { nullptr };    //!< The differences between the loaded scene and the pending scene or content.
+        std::shared_ptr<const SceneModel::Context>              m_pendingContent    { nullptr };    //!< Updated sponza content waiting to be applied at the start of the next frame.
+        std::shared_ptr<const SceneModelTables>                 m_pendingTables     { nullptr };    //!< The pending content laid out as tables.
+
+        std::shared_ptr<AsyncFileReader>                        m_reader            { nullptr };    //!< Reads files asynchronously, files are read on the render thread without one.
+        std::shared_ptr<GLThreadQueue>                          m_glQueue           { nullptr };    //!< Runs the final stage of asynchronous loads on the render thread.
+        CancellationToken                                       m_shaderReload      { };            //!< Cancels a shader rebuild which has been superseded.
+        std::shared_ptr<SimulationChannel>                      m_simulation        { nullptr };    //!< Provides instances, the camera and lights from another process.
+        std::shared_ptr<FramePacer>                             m_pacer             { nullptr };    //!< Determines the frames in flight limit, the view will run unthrottled without one.
+        std::deque<GLsync>                                      m_frameFences       { };            //!< A fence for each frame which the GPU may still be processing, oldest first.
+
+        std::shared_ptr<RenderServer>                           m_server            { nullptr };    //!< Provides render requests from other processes.
+        GLuint                                                  m_serverFramebuffer { 0 };          //!< The offscreen framebuffer which batches of requests are rendered into.
+        GLuint                                                  m_serverColour      { 0 };          //!< The RGBA8 colour attachment of the offscreen framebuffer.
+        GLuint                                                  m_serverDepth       { 0 };          //!< The depth attachment of the offscreen framebuffer.
+        GLsizei                                                 m_serverWidth       { 0 };          //!< The width of the offscreen framebuffer.
+        GLsizei                                                 m_serverHeight      { 0 };          //!< The height of the offscreen framebuffer.
+        std::vector<Task<void>>                                 m_serverEncodes     { };            //!< Images which are still being encoded on the thread pool.
+
+        std::shared_ptr<TemporalCuller>                         m_culler            { nullptr };    //!< Decides which instances of the scene are inside the frustum of the window.
+        std::vector<size_t>                                     m_cullOffsets       { };            //!< The sphere of the first instance of each mesh.
+        const void*                                             m_cullSource        { nullptr };    //!< The scene the spheres were calculated from.
+        size_t                                                  m_cullInstances     { 0 };          //!< How many instances the spheres were calculated from.
+        unsigned int                                            m_cullingMode       { 2 };          //!< Whether culling is off, done every frame or temporally coherent.
+
+        bool                                                    m_virtualTexturing  { false };      //!< Whether the resources should use virtual textures when they're built.
+        bool                                                    m_mergeSimilar      { false };      //!< Whether similar textures share a layer as well as identical ones.
+        bool                                                    m_stripification    { false };      //!< Whether the resources should try strips for each mesh when they're built.
+        GLuint                                                  m_feedbackFramebuffer   { 0 };      //!< The framebuffer of the feedback pass.
+        GLuint                                                  m_feedbackTarget    { 0 };          //!< The R32UI page requests of the feedback pass.
+        GLuint                                                  m_feedbackDepth     { 0 };          //!< The depth attachment of the feedback pass.
+        GLsizei                                                 m_feedbackWidth     { 0 };          //!< The width of the feedback pass.
+        GLsizei                                                 m_feedbackHeight    { 0 };          //!< The height of the feedback pass.
+        GLuint                                                  m_feedbackBuffers[2];               //!< Pixel buffers the requests are read into, read back a frame later to avoid stalling.
+        size_t                                                  m_feedbackSizes[2];                 //!< How many requests each pixel buffer holds.
+        size_t                                                  m_feedbackFrame     { 0 };          //!< How many feedback passes have been drawn.
+
+        bool                                                    m_depthPrepass      { false };      //!< Whether the depth is laid down before shading the window.
+        GLuint                                                  m_depthProgram      { 0 };          //!< Transforms positions only for the depth pre-pass.
+        GLuint                                                  m_depthVAO          { 0 };          //!< Reads the position stream and the instance transforms.
+
+        bool                                                    m_transformCache    { false };      //!< Whether static instances are drawn from vertices captured in world space.
+        bool                                                    m_cacheValid        { false };      //!< Whether the captured vertices match the current instances and host streams.
+        GLuint                                                  m_captureProgram    { 0 };          //!< Transforms static instances into world space for transform feedback.
+        GLuint                                                  m_cacheVAO          { 0 };          //!< Reads the captured vertices, the elements are shared with the scene.
+        GLuint                                                  m_cacheVBO          { 0 };          //!< A copy of every vertex of every static instance in world space.
+        SamplerBuffer                                           m_cacheMaterialIDs  { };            //!< The material ID of every captured instance.
+        std::vector<size_t>                                     m_cacheBases        { };            //!< The first captured vertex of each mesh, in the same order as the meshes.
+        size_t                                                  m_cacheVertices     { 0 };          //!< How many vertices were captured.
+        size_t                                                  m_cacheCaptures     { 0 };          //!< How many times the cache has been captured.
+        double                                                  m_cacheTime         { 0.0 };        //!< How long the last capture took to submit, in milliseconds.
+
+        bool                                                    m_occlusionQueries  { false };      //!< Whether large meshes are drawn conditionally on the queries of the previous frame.
+        GLuint                                                  m_occlusionProgram  { 0 };          //!< Draws the bounding boxes of queried meshes.
+        GLuint                                                  m_occlusionVAO      { 0 };          //!< Reads only the instance transforms, the boxes are built from vertex IDs.
+        GLuint                                                  m_occlusionTransforms   { 0 };      //!< The instances of every box queried this frame.
+        std::vector<OcclusionQuery>                             m_occlusion         { };            //!< The queries and visibility history of each mesh, in the same order as the meshes.
+        std::vector<size_t>                                     m_occlusionPending  { };            //!< The meshes whose boxes are queried at the end of this frame.
+        std::vector<float>                                      m_occlusionMatrices { };            //!< The instances of each pending box one after another, sixteen floats each.
+        size_t                                                  m_occlusionFrame    { 0 };          //!< How many frames have used queries, picks which query of each mesh is written.
+        size_t                                                  m_occlusionIssued   { 0 };          //!< How many queries have been issued.
+        size_t                                                  m_occlusionResults  { 0 };          //!< How many results have been read back.
+        size_t                                                  m_occlusionHidden   { 0 };          //!< How many results read back found the box hidden.
+
+        bool                                                    m_panoramaMode      { false };      //!< Whether frames where the camera only turns are reprojected from the panorama.
+        bool                                                    m_panoramaValid     { false };      //!< Whether the panorama shows the scene as it currently is.
+        GLuint                                                  m_panoramaProgram   { 0 };          //!< Draws the window from the panorama.
+        GLuint                                                  m_panoramaVAO       { 0 };          //!< An empty VAO, the reprojection triangle is built from vertex IDs.
+        GLuint                                                  m_panoramaFramebuffer   { 0 };      //!< The framebuffer each face of the panorama is rendered with.
+        GLuint                                                  m_panoramaColour    { 0 };          //!< The RGBA8 cube map holding the panorama.
+        GLuint                                                  m_panoramaDepth     { 0 };          //!< The depth attachment used when rendering each face.
+        GLsizei                                                 m_panoramaSize      { 0 };          //!< The width and height of each face.
+        float                                                   m_panoramaPosition[3];              //!< Where the panorama was rendered from.
+        std::vector<char>                                       m_panoramaLighting  { };            //!< The lighting block the panorama was rendered with.
+        size_t                                                  m_panoramaRenders   { 0 };          //!< How many times the panorama has been rendered.
+        size_t                                                  m_panoramaReuses    { 0 };          //!< How many frames have been drawn from an existing panorama.
 
         bool                                                    m_wireframeMode     { false };      //!< Causes the camera to show a wireframe around meshes nearby.
         unsigned int                                            m_wireframeType     { 0 };          //!< Allows the user to cycle through point, spot and directional mode.
+        GLuint                                                  m_wireframeProgram  { 0 };          //!< Draws the edges of each triangle lit by the wireframe light.
 
         #pragma endregion
 };
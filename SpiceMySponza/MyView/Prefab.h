@@ -0,0 +1,46 @@
+#pragma once
+
+#if !defined    _MY_VIEW_PREFAB_
+#define         _MY_VIEW_PREFAB_
+
+
+// STL headers.
+#include <cstdint>
+#include <vector>
+
+
+// Engine headers.
+#include <glm/gtc/type_ptr.hpp>
+
+
+// Personal headers.
+#include <MyView/MyView.h>
+
+
+/// <summary>
+/// A group of meshes which is placed in the scene as a whole, such as a column made of a base, shaft and capital. The host only keeps a
+/// transform per placement of the group; each entry is drawn once for every placement, combining the placement with the transform of
+/// the entry in the shaders. Repeated content therefore costs a matrix per group rather than a matrix per mesh.
+/// </summary>
+struct MyView::Prefab final
+{
+    #pragma region Prefab types
+
+    /// <summary> A mesh within the prefab. </summary>
+    struct Entry final
+    {
+        SceneModel::MeshId  mesh        { 0 };      //!< The ID of the mesh in the SceneModel::Context, or the index of an imported mesh.
+        glm::mat4           transform   { 1.f };    //!< Places the mesh relative to the origin of the prefab.
+        std::int32_t        material    { 0 };      //!< A SceneModel material ID or imported material index.
+    };
+
+    #pragma endregion
+
+    #pragma region Implementation data
+
+    std::vector<Entry>  entries { };    //!< Every mesh in the prefab.
+
+    #pragma endregion
+};
+
+#endif // _MY_VIEW_PREFAB_
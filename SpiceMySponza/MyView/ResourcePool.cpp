@@ -0,0 +1,56 @@
+#include "ResourcePool.h"
+
+
+
+// STL headers.
+#include <iterator>
+
+
+
+// Personal headers.
+#include <MyView/SceneResources.h>
+
+
+
+#pragma region Public interface
+
+std::shared_ptr<MyView::SceneResources> MyView::ResourcePool::acquire (const std::string& key)
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    // Forget about scenes which every view has finished with.
+    for (auto scene = m_scenes.begin(); scene != m_scenes.end();)
+    {
+        scene = scene->second.expired() ? m_scenes.erase (scene) : std::next (scene);
+    }
+
+    auto& weak      = m_scenes[key];
+    auto  resources = weak.lock();
+
+    if (!resources)
+    {
+        resources   = std::make_shared<SceneResources>();
+        weak        = resources;
+    }
+
+    return resources;
+}
+
+
+size_t MyView::ResourcePool::getSceneCount() const
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    size_t count { 0 };
+
+    for (const auto& scene : m_scenes)
+    {
+        if (!scene.second.expired())
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+#pragma endregion
@@ -0,0 +1,60 @@
+#pragma once
+
+#if !defined    _MY_VIEW_RESOURCE_POOL_
+#define         _MY_VIEW_RESOURCE_POOL_
+
+
+// STL headers.
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+// Personal headers.
+#include <MyView/MyView.h>
+
+
+/// <summary>
+/// Lets views of the same scene share its GPU resources. Each scene is identified by the file its assets come from, which survives hot
+/// reloads, and the pool only keeps weak references, so the resources of a scene are freed as soon as the last view using them stops.
+/// Give the same pool to every view which should share; views with separate pools, or none, always upload their own copy.
+/// </summary>
+class MyView::ResourcePool final
+{
+    public:
+
+        #pragma region Constructors and destructor
+
+        ResourcePool()                                      = default;
+        ~ResourcePool()                                     = default;
+
+        ResourcePool (ResourcePool&& move)                  = delete;
+        ResourcePool& operator= (ResourcePool&& move)       = delete;
+        ResourcePool (const ResourcePool& copy)             = delete;
+        ResourcePool& operator= (const ResourcePool& copy)  = delete;
+
+        #pragma endregion
+
+        #pragma region Public interface
+
+        /// <summary> Gets the resources of a scene, creating an empty set if no view currently holds them. Safe to call from any thread. </summary>
+        /// <param name="key"> The file the assets of the scene come from. </param>
+        std::shared_ptr<SceneResources> acquire (const std::string& key);
+
+        /// <summary> Counts how many scenes currently have resources which views are using. </summary>
+        size_t getSceneCount() const;
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        mutable std::mutex                                              m_mutex     { };    //!< Protects the map.
+        std::unordered_map<std::string, std::weak_ptr<SceneResources>>  m_scenes    { };    //!< The resources of each scene which may still be alive.
+
+        #pragma endregion
+};
+
+#endif // _MY_VIEW_RESOURCE_POOL_
@@ -0,0 +1,61 @@
+#include "SceneResources.h"
+
+
+
+// Engine headers.
+#include <tgl/tgl.h>
+
+
+
+// Personal headers.
+#include <MyView/Mesh.h>
+
+
+
+#pragma region Constructors and destructor
+
+MyView::SceneResources::~SceneResources()
+{
+    clearMeshes();
+
+    // Delete all VBOs.
+    glDeleteBuffers (1, &vertexVBO);
+    glDeleteBuffers (1, &elementVBO);
+    glDeleteBuffers (1, &positionVBO);
+    glDeleteBuffers (1, &materials.vbo);
+
+    // Delete all textures.
+    glDeleteTextures (1, &textureArray);
+    glDeleteTextures (1, &materials.tbo);
+}
+
+#pragma endregion
+
+
+#pragma region Public interface
+
+void MyView::SceneResources::generateOpenGLObjects()
+{
+    glGenBuffers (1, &vertexVBO);
+    glGenBuffers (1, &elementVBO);
+    glGenBuffers (1, &materials.vbo);
+
+    glGenTextures (1, &textureArray);
+    glGenTextures (1, &materials.tbo);
+}
+
+
+void MyView::SceneResources::clearMeshes()
+{
+    for (auto& pair : meshes)
+    {
+        delete pair.second;
+    }
+
+    meshes.clear();
+    meshOrder.clear();
+    meshCapacities.clear();
+    residentMeshes.clear();
+}
+
+#pragma endregion
@@ -0,0 +1,100 @@
+#pragma once
+
+#if !defined    _MY_VIEW_SCENE_RESOURCES_
+#define         _MY_VIEW_SCENE_RESOURCES_
+
+
+// STL headers.
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+// Engine headers.
+#include <SceneModel/SceneModel_fwd.hpp>
+
+
+// Personal headers.
+#include <MyView/Material.h>
+#include <MyView/MyView.h>
+#include <Utility/Stripifier.h>
+
+
+/// <summary>
+/// The geometry, materials and textures of a scene, which every view of the scene can draw from. Views keep their own program, VAO,
+/// uniforms and instance pools, so several views, each with their own camera and instances, only pay for the assets once. OpenGL
+/// shares buffers and textures between contexts which were created to share objects, but not VAOs, which is why the split lies here.
+/// The objects are deleted with the last view holding them, so that view's context must be current when it stops.
+/// </summary>
+struct MyView::SceneResources final
+{
+    #pragma region Implementation data
+
+    std::mutex                                              mutex               { };        //!< Held whilst the resources are being built or updated.
+    bool                                                    built               { false };  //!< Whether the first view has uploaded everything.
+
+    GLuint                                                  vertexVBO           { 0 };      //!< The interleaved vertex data of every mesh in the scene.
+    GLuint                                                  elementVBO          { 0 };      //!< The elements data for every mesh in the scene.
+    GLuint                                                  positionVBO         { 0 };      //!< Tightly packed positions mirroring the vertex VBO for depth-only passes, 0 if no view asked for them.
+    SamplerBuffer                                           materials           { };        //!< A VBO & TBO pair representing information on every material in the scene.
+    GLuint                                                  textureArray        { 0 };      //!< The TEXTURE_2D_ARRAY which contains each texture in the scene.
+    GLsizei                                                 textureWidth        { 0 };      //!< The width of each layer in the texture array.
+    GLsizei                                                 textureHeight       { 0 };      //!< The height of each layer in the texture array.
+
+    std::vector<std::pair<SceneModel::MeshId, Mesh*>>       meshes              { };        //!< A container of MeshId and Mesh pairs, used in instance-based rendering of meshes in the scene.
+    std::vector<size_t>                                     meshOrder           { };        //!< The order meshes are drawn and culled in, meshes drawn near each other are placed near each other.
+    std::unordered_map<SceneModel::MaterialId, MaterialID>  materialIDs         { };        //!< A map containing each material used for rendering.
+    std::unordered_set<SceneModel::MeshId>                  lateMeshes          { };        //!< Sponza meshes without instances which were uploaded because a stream or prefab referenced them.
+    std::vector<Material>                                   sceneMaterials      { };        //!< The buffer-ready sponza material of each slot, kept so late materials can be appended.
+    std::unordered_map<std::string, size_t>                 sceneTextureLayers  { };        //!< The texture array layer of each sponza texture which has been loaded.
+    size_t                                                  meshVersion         { 0 };      //!< Incremented when sponza meshes are added or the content changes, views must order their instances again.
+    std::shared_ptr<const SceneModelTables>                 sceneTables         { nullptr };    //!< The version of the sponza content which has been uploaded, nullptr until its file is read again.
+
+    std::shared_ptr<const ImportedScene>                    imported            { nullptr };    //!< The version of the imported scene which has been uploaded.
+    std::vector<std::vector<size_t>>                        importedInstances   { };        //!< The indices of the imported instances of each mesh, in the same order as meshes.
+    std::vector<std::pair<size_t, size_t>>                  meshCapacities      { };        //!< The vertex and element capacity of the buffer range owned by each imported mesh.
+    std::vector<bool>                                       residentMeshes      { };        //!< Whether the current data of each imported mesh has been uploaded.
+    std::vector<MaterialID>                                 materialSlots       { };        //!< The slot of each imported material in the material buffer, -1 if it hasn't been uploaded.
+    std::vector<float>                                      textureLayers       { };        //!< The texture array layer of each imported texture, negative if it hasn't been loaded.
+    std::shared_ptr<VirtualTextures>                        virtualTextures     { nullptr };    //!< Pages the textures in as they become visible, the texture array is a placeholder when set.
+    size_t                                                  vertexCapacity      { 0 };      //!< How many vertices the vertex VBO can hold.
+    size_t                                                  vertexUsage         { 0 };      //!< How many vertices have been allocated to meshes, including abandoned ranges.
+    size_t                                                  elementCapacity     { 0 };      //!< How many elements the element VBO can hold.
+    size_t                                                  elementUsage        { 0 };      //!< How many elements have been allocated to meshes, including abandoned ranges.
+    size_t                                                  materialCount       { 0 };      //!< How many material slots have been handed out.
+    size_t                                                  materialCapacity    { 0 };      //!< How many materials the material VBO can hold.
+    bool                                                    stripify            { false };  //!< Whether meshes are drawn as strips wherever they need fewer indices than a list.
+    util::Stripification                                    stripStatistics     { };        //!< How stripping has worked out for every mesh uploaded so far.
+    bool                                                    halfMaterials       { false };  //!< Whether the material TBO is RGBA16F rather than RGBA32F, which it is whenever every material fits.
+    size_t                                                  materialVersion     { 0 };      //!< Incremented when imported materials change slot, IDs resolved before then are stale.
+
+    #pragma endregion
+
+    #pragma region Constructors and destructor
+
+    SceneResources()                                        = default;
+    ~SceneResources();
+
+    SceneResources (SceneResources&& move)                  = delete;
+    SceneResources& operator= (SceneResources&& move)       = delete;
+    SceneResources (const SceneResources& copy)             = delete;
+    SceneResources& operator= (const SceneResources& copy)  = delete;
+
+    #pragma endregion
+
+    #pragma region Public interface
+
+    /// <summary> Generates the buffers and textures, ready to be filled by the first view. </summary>
+    void generateOpenGLObjects();
+
+    /// <summary> Deletes every mesh and forgets where they were uploaded, leaving the buffers to be laid out again. </summary>
+    void clearMeshes();
+
+    #pragma endregion
+};
+
+#endif // _MY_VIEW_SCENE_RESOURCES_
@@ -38,7 +38,7 @@ Light& Light::operator= (Light&& move)
         aConstant       = move.aConstant;
         aLinear         = move.aLinear;
         aQuadratic      = move.aQuadratic;
-        emitWireframe   = move.emitWireframe;
+        padding         = move.padding;
 
         // Reset standard data type.
         move.setType (LightType::Point);
@@ -47,7 +47,7 @@ Light& Light::operator= (Light&& move)
         move.aConstant      = 0.f;
         move.aLinear        = 0.f;
         move.aQuadratic     = 0.f;
-        move.emitWireframe  = 0;
+        move.padding        = 0.f;
     }
 
     return *this;
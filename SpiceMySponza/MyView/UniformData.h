@@ -53,7 +53,7 @@ struct Light final
     float           aConstant       { 1.f };    //!< The constant co-efficient for the attenutation formula.
     float           aLinear         { 0.f };    //!< The linear co-efficient for the attenutation formula.
     float           aQuadratic      { 1.f };    //!< The quadratic co-efficient for the attenuation formula.
-    unsigned int    emitWireframe   { 0 };      //!< Indicates whether the light should emit a wireframe onto surfaces.
+    float           padding         { 0.f };    //!< Unused, pads the light to the 64-byte array stride std140 gives it.
 
     Light()                                 = default;
     Light (const Light& copy)               = default;
@@ -0,0 +1,655 @@
+#include "VirtualTextures.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <iostream>
+
+
+
+// Engine headers.
+#include <tgl/tgl.h>
+#include <tygra/FileHelper.hpp>
+
+
+
+// The width and height of a page in texels, this must match PAGE_SIZE in the fragment shader.
+const int pageSize = 128;
+
+// The texels surrounding each page in its slot so bilinear filtering never reads a neighbouring page, this must match PAGE_BORDER.
+const int pageBorder = 4;
+
+// The width and height of a slot in the physical texture.
+const int slotSize = pageSize + pageBorder * 2;
+
+// How many RGBA32I texels of information each texture has, a header followed by one per mipmap. This must match INFO_STRIDE.
+const int infoStride = 16;
+
+// Set in page table entries whose page is resident.
+const std::uint32_t residentBit = 0x80000000;
+
+// Written by the feedback pass where no page is needed.
+const std::uint32_t noRequest = 0xFFFFFFFF;
+
+// The limits of the packed page keys: 12 bits of texture, 4 of mipmap and 8 of each page co-ordinate.
+const size_t maxTextures    = 4096;
+const int    maxMipmaps     = infoStride - 1;
+const int    maxPages       = 256;
+
+// How many prepared pages may wait for the render thread before the worker waits too.
+const size_t preparedLimit = 64;
+
+
+
+#pragma region Key packing
+
+/// <summary> Packs a page into a key exactly as the fragment shader does. </summary>
+inline MyView::VirtualTextures::PageKey packKey (const size_t texture, const int mipmap, const int x, const int y)
+{
+    return static_cast<std::uint32_t> (texture << 20) | static_cast<std::uint32_t> (mipmap << 16) | static_cast<std::uint32_t> (y << 8) | static_cast<std::uint32_t> (x);
+}
+
+inline size_t   keyTexture (const std::uint32_t key)    { return key >> 20; }
+inline int      keyMipmap (const std::uint32_t key)     { return (key >> 16) & 0xF; }
+inline int      keyY (const std::uint32_t key)          { return (key >> 8) & 0xFF; }
+inline int      keyX (const std::uint32_t key)          { return key & 0xFF; }
+
+#pragma endregion
+
+
+#pragma region Constructors and destructor
+
+MyView::VirtualTextures::VirtualTextures (const size_t slotColumns, const size_t uploadBudget)
+    : m_slotColumns (std::max<size_t> (1, std::min<size_t> (slotColumns, 4096 / slotSize))), m_uploadBudget (std::max<size_t> (1, uploadBudget))
+{
+    m_slots.resize (m_slotColumns * m_slotColumns);
+    m_worker = std::thread { &VirtualTextures::work, this };
+}
+
+
+MyView::VirtualTextures::~VirtualTextures()
+{
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_running = false;
+    }
+
+    m_condition.notify_all();
+    m_worker.join();
+
+    glDeleteTextures (1, &m_cache);
+    glDeleteTextures (1, &m_table.tbo);
+    glDeleteTextures (1, &m_info.tbo);
+    glDeleteBuffers (1, &m_table.vbo);
+    glDeleteBuffers (1, &m_info.vbo);
+}
+
+#pragma endregion
+
+
+#pragma region Paging
+
+void MyView::VirtualTextures::setTextures (const std::vector<std::pair<std::string, tygra::Image>>& images)
+{
+    if (m_cache == 0)
+    {
+        glGenTextures (1, &m_cache);
+        glGenTextures (1, &m_table.tbo);
+        glGenTextures (1, &m_info.tbo);
+        glGenBuffers (1, &m_table.vbo);
+        glGenBuffers (1, &m_info.vbo);
+
+        // The cache never needs mipmaps, each mipmap of a texture has pages of its own.
+        const auto size = static_cast<GLsizei> (m_slotColumns * slotSize);
+
+        glBindTexture (GL_TEXTURE_2D, m_cache);
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,  GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,  GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,      GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,      GL_CLAMP_TO_EDGE);
+        glBindTexture (GL_TEXTURE_2D, 0);
+    }
+
+    const auto count = std::min (images.size(), maxTextures);
+
+    if (count < images.size())
+    {
+        std::cerr << "Only " << maxTextures << " virtual textures are supported, the rest will be drawn white." << std::endl;
+    }
+
+    m_sources.resize (count);
+    m_generations.resize (count, 0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        m_sources[i] = buildSource (images[i].second);
+        ++m_generations[i];
+    }
+
+    rebuildTables();
+}
+
+
+void MyView::VirtualTextures::replaceTexture (const size_t index, const tygra::Image& image)
+{
+    if (index < m_sources.size())
+    {
+        // The texture may have changed size, so its page table entries and those of every following texture move.
+        m_sources[index] = buildSource (image);
+        ++m_generations[index];
+
+        rebuildTables();
+    }
+}
+
+
+void MyView::VirtualTextures::bind (const GLenum cacheUnit, const GLenum tableUnit, const GLenum infoUnit) const
+{
+    glActiveTexture (cacheUnit);
+    glBindTexture (GL_TEXTURE_2D, m_cache);
+
+    glActiveTexture (tableUnit);
+    glBindTexture (GL_TEXTURE_BUFFER, m_table.tbo);
+
+    glActiveTexture (infoUnit);
+    glBindTexture (GL_TEXTURE_BUFFER, m_info.tbo);
+}
+
+
+void MyView::VirtualTextures::submitFeedback (const PageKey* const requests, const size_t count)
+{
+    /// Every pixel of the feedback pass names the page it would sample. Pages are counted so the most visible are loaded first, and the
+    /// parent of every page is requested too so that while a page is missing the shader falls back to the next mipmap rather than the
+    /// coarsest. Coarse pages are requested before fine ones because they cover more of the screen and are the fallback for the rest.
+    /// Requests which haven't been started yet are dropped, so the worker is always working on what the latest frame needs.
+    std::unordered_map<PageKey, size_t> counts { };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto key = requests[i];
+
+        if (key == noRequest)
+        {
+            continue;
+        }
+
+        // Feedback can be a frame or two old, so the textures may have been replaced since.
+        const auto texture  = keyTexture (key);
+        const auto mipmap   = keyMipmap (key);
+
+        if (texture < m_sources.size() && m_sources[texture] && mipmap < static_cast<int> (m_sources[texture]->mipmaps.size()))
+        {
+            const auto& pages = m_sources[texture]->pages[mipmap];
+
+            if (keyX (key) < pages.first && keyY (key) < pages.second)
+            {
+                ++counts[key];
+            }
+        }
+    }
+
+    // Halving a mipmap halves the page co-ordinates, so the parent of a page is easy to find.
+    std::vector<std::pair<PageKey, size_t>> needed (counts.begin(), counts.end());
+
+    for (const auto& request : needed)
+    {
+        const auto  texture = keyTexture (request.first);
+        const auto  levels  = static_cast<int> (m_sources[texture]->mipmaps.size());
+        auto        x       = keyX (request.first);
+        auto        y       = keyY (request.first);
+
+        for (auto mipmap = keyMipmap (request.first) + 1; mipmap < levels; ++mipmap)
+        {
+            x /= 2;
+            y /= 2;
+            counts[packKey (texture, mipmap, x, y)] += request.second;
+        }
+    }
+
+    ++m_statistics.feedbackCount;
+    m_statistics.requestedCount += counts.size();
+
+    // Resident pages are marked as used this frame, so they're safe from eviction.
+    std::vector<std::pair<PageKey, size_t>> missing { };
+
+    for (const auto& request : counts)
+    {
+        const auto resident = m_resident.find (request.first);
+
+        if (resident != m_resident.end())
+        {
+            m_slots[resident->second].lastUsed = m_frame;
+        }
+
+        else
+        {
+            missing.push_back (request);
+        }
+    }
+
+    m_statistics.missingCount += missing.size();
+
+    std::sort (missing.begin(), missing.end(), [] (const std::pair<PageKey, size_t>& lhs, const std::pair<PageKey, size_t>& rhs)
+    {
+        const auto lhsMipmap = keyMipmap (lhs.first), rhsMipmap = keyMipmap (rhs.first);
+        return lhsMipmap != rhsMipmap ? lhsMipmap > rhsMipmap : lhs.second > rhs.second;
+    });
+
+    // There's no point asking for more than can be uploaded before the next feedback arrives.
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        for (const auto& request : m_requests)
+        {
+            m_pending.erase (request.key);
+        }
+
+        m_requests.clear();
+
+        for (size_t i = 0; i < missing.size() && m_requests.size() < m_uploadBudget * 2; ++i)
+        {
+            const auto key      = missing[i].first;
+            const auto texture  = keyTexture (key);
+            const auto pending  = m_pending.find (key);
+
+            if (pending != m_pending.end() && pending->second == m_generations[texture])
+            {
+                continue;
+            }
+
+            PageRequest request { };
+            request.key         = key;
+            request.generation  = m_generations[texture];
+            request.source      = m_sources[texture];
+
+            m_pending[key] = request.generation;
+            m_requests.push_back (std::move (request));
+        }
+    }
+
+    m_condition.notify_one();
+}
+
+
+void MyView::VirtualTextures::update()
+{
+    const auto start = Clock::now();
+
+    // Take as many prepared pages as the budget allows, the rest wait for the next frame.
+    std::vector<PreparedPage> pages { };
+
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        while (!m_prepared.empty() && pages.size() < m_uploadBudget)
+        {
+            pages.push_back (std::move (m_prepared.front()));
+            m_prepared.pop_front();
+        }
+    }
+
+    m_condition.notify_one();
+
+    for (const auto& page : pages)
+    {
+        // Pages of a texture which has since been replaced are useless.
+        const auto texture = keyTexture (page.key);
+
+        if (texture >= m_generations.size() || page.generation != m_generations[texture] || m_resident.count (page.key) != 0)
+        {
+            continue;
+        }
+
+        m_pending.erase (page.key);
+
+        const auto slot = findSlot();
+
+        if (slot == m_slots.size())
+        {
+            // Every page is needed this frame, the cache is simply too small for the view.
+            continue;
+        }
+
+        uploadPage (page, slot, false);
+    }
+
+    const auto milliseconds = std::chrono::duration<double, std::milli> (Clock::now() - start).count();
+
+    ++m_frame;
+    ++m_statistics.frameCount;
+    m_statistics.totalTime  += milliseconds;
+    m_statistics.maxTime    = std::max (m_statistics.maxTime, milliseconds);
+}
+
+#pragma endregion
+
+
+#pragma region Statistics
+
+void MyView::VirtualTextures::printStatistics (std::ostream& stream) const
+{
+    stream  << "Virtual textures: " << m_sources.size() << " textures, " << m_resident.size() << " of " << m_slots.size() << " pages resident, "
+            << m_statistics.averageRequested() << " needed and " << m_statistics.averageMissing() << " missing per feedback, "
+            << m_statistics.uploadedCount << " uploaded, " << m_statistics.evictedCount << " evicted, update " << m_statistics.averageTime()
+            << "ms average, " << m_statistics.maxTime << "ms max." << std::endl;
+}
+
+#pragma endregion
+
+
+#pragma region Implementation data
+
+std::shared_ptr<const MyView::VirtualTextures::Source> MyView::VirtualTextures::buildSource (const tygra::Image& image)
+{
+    if (!image.containsData() || image.width() <= 0 || image.height() <= 0)
+    {
+        return nullptr;
+    }
+
+    auto source = std::make_shared<Source>();
+
+    // Convert to RGBA8 the way OpenGL expands the formats the texture array accepted, keeping the high byte of 16-bit components.
+    const auto  width       = image.width();
+    const auto  height      = image.height();
+    const auto  components  = image.componentsPerPixel();
+    const auto  bytes       = image.bytesPerComponent();
+    const auto  pixels      = static_cast<const std::uint8_t*> (image.pixels());
+
+    std::vector<std::uint8_t> texels (width * height * 4);
+
+    for (int i = 0; i < width * height; ++i)
+    {
+        std::uint8_t channels[4] = { 0, 0, 0, 255 };
+
+        for (int c = 0; c < components && c < 4; ++c)
+        {
+            const auto component = pixels + (i * components + c) * bytes;
+            channels[c] = bytes == 2 ? static_cast<std::uint8_t> (*reinterpret_cast<const std::uint16_t*> (component) >> 8) : *component;
+        }
+
+        std::copy (channels, channels + 4, &texels[i * 4]);
+    }
+
+    source->mipmaps.push_back (std::move (texels));
+    source->sizes.push_back ({ width, height });
+
+    // Box filter each mipmap from the last until it fits in a single page.
+    while (source->sizes.back().first > pageSize || source->sizes.back().second > pageSize)
+    {
+        const auto& above       = source->mipmaps.back();
+        const auto  aboveWidth  = source->sizes.back().first;
+        const auto  aboveHeight = source->sizes.back().second;
+        const auto  mipWidth    = std::max (aboveWidth / 2, 1);
+        const auto  mipHeight   = std::max (aboveHeight / 2, 1);
+
+        std::vector<std::uint8_t> mipmap (mipWidth * mipHeight * 4);
+
+        for (int y = 0; y < mipHeight; ++y)
+        {
+            const auto y0 = std::min (y * 2, aboveHeight - 1), y1 = std::min (y * 2 + 1, aboveHeight - 1);
+
+            for (int x = 0; x < mipWidth; ++x)
+            {
+                const auto x0 = std::min (x * 2, aboveWidth - 1), x1 = std::min (x * 2 + 1, aboveWidth - 1);
+
+                for (int c = 0; c < 4; ++c)
+                {
+                    const auto sum =    above[(y0 * aboveWidth + x0) * 4 + c] + above[(y0 * aboveWidth + x1) * 4 + c] +
+                                        above[(y1 * aboveWidth + x0) * 4 + c] + above[(y1 * aboveWidth + x1) * 4 + c];
+
+                    mipmap[(y * mipWidth + x) * 4 + c] = static_cast<std::uint8_t> ((sum + 2) / 4);
+                }
+            }
+        }
+
+        source->mipmaps.push_back (std::move (mipmap));
+        source->sizes.push_back ({ mipWidth, mipHeight });
+    }
+
+    // Keys only have room for so many pages and mipmaps, textures beyond that lose their finest mipmaps.
+    while (source->sizes.size() > 1 && (source->sizes.size() > static_cast<size_t> (maxMipmaps) ||
+           (source->sizes.front().first + pageSize - 1) / pageSize > maxPages || (source->sizes.front().second + pageSize - 1) / pageSize > maxPages))
+    {
+        source->mipmaps.erase (source->mipmaps.begin());
+        source->sizes.erase (source->sizes.begin());
+    }
+
+    size_t offset { 0 };
+
+    for (const auto& size : source->sizes)
+    {
+        const auto across   = (size.first + pageSize - 1) / pageSize;
+        const auto down     = (size.second + pageSize - 1) / pageSize;
+
+        source->offsets.push_back (offset);
+        source->pages.push_back ({ across, down });
+        offset += across * down;
+    }
+
+    return source;
+}
+
+
+void MyView::VirtualTextures::rebuildTables()
+{
+    // Anything the worker hasn't started on refers to the old layout.
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_requests.clear();
+        m_prepared.clear();
+    }
+
+    m_pending.clear();
+    m_resident.clear();
+    std::fill (m_slots.begin(), m_slots.end(), Slot { });
+
+    // Lay the entries of every texture out one after another, then describe the layout for the shaders.
+    std::vector<std::int32_t> info (std::max<size_t> (m_sources.size(), 1) * infoStride * 4, 0);
+    size_t entryCount { 0 };
+
+    m_bases.resize (m_sources.size());
+
+    for (size_t i = 0; i < m_sources.size(); ++i)
+    {
+        m_bases[i] = entryCount;
+
+        if (!m_sources[i])
+        {
+            continue;
+        }
+
+        const auto& source  = *m_sources[i];
+        const auto  header  = &info[i * infoStride * 4];
+
+        header[0] = source.sizes.front().first;
+        header[1] = source.sizes.front().second;
+        header[2] = static_cast<std::int32_t> (source.mipmaps.size());
+
+        for (size_t mipmap = 0; mipmap < source.mipmaps.size(); ++mipmap)
+        {
+            const auto texel = header + (mipmap + 1) * 4;
+
+            texel[0] = static_cast<std::int32_t> (entryCount + source.offsets[mipmap]);
+            texel[1] = source.pages[mipmap].first;
+            texel[2] = source.pages[mipmap].second;
+        }
+
+        entryCount += source.offsets.back() + source.pages.back().first * source.pages.back().second;
+    }
+
+    m_entries.assign (std::max<size_t> (entryCount, 1), 0);
+
+    glBindBuffer (GL_TEXTURE_BUFFER, m_table.vbo);
+    glBufferData (GL_TEXTURE_BUFFER, m_entries.size() * sizeof (std::uint32_t), m_entries.data(), GL_DYNAMIC_DRAW);
+    glBindTexture (GL_TEXTURE_BUFFER, m_table.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, GL_R32UI, m_table.vbo);
+
+    glBindBuffer (GL_TEXTURE_BUFFER, m_info.vbo);
+    glBufferData (GL_TEXTURE_BUFFER, info.size() * sizeof (std::int32_t), info.data(), GL_STATIC_DRAW);
+    glBindTexture (GL_TEXTURE_BUFFER, m_info.tbo);
+    glTexBuffer (GL_TEXTURE_BUFFER, GL_RGBA32I, m_info.vbo);
+
+    glBindTexture (GL_TEXTURE_BUFFER, 0);
+    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+
+    // The coarsest mipmap of every texture is always resident, so the shaders always have something to fall back on.
+    size_t slot { 0 };
+
+    for (size_t i = 0; i < m_sources.size(); ++i)
+    {
+        if (!m_sources[i])
+        {
+            continue;
+        }
+
+        if (slot == m_slots.size())
+        {
+            std::cerr << "The virtual texture cache is too small to hold the coarsest mipmap of every texture." << std::endl;
+            break;
+        }
+
+        PreparedPage page { };
+        page.key        = packKey (i, static_cast<int> (m_sources[i]->mipmaps.size()) - 1, 0, 0);
+        page.generation = m_generations[i];
+
+        preparePage (*m_sources[i], page.key, page.texels);
+        uploadPage (page, slot++, true);
+    }
+}
+
+
+void MyView::VirtualTextures::preparePage (const Source& source, const PageKey key, std::vector<std::uint8_t>& texels)
+{
+    const auto  mipmap  = keyMipmap (key);
+    const auto& pixels  = source.mipmaps[mipmap];
+    const auto  width   = source.sizes[mipmap].first;
+    const auto  height  = source.sizes[mipmap].second;
+    const auto  left    = keyX (key) * pageSize - pageBorder;
+    const auto  bottom  = keyY (key) * pageSize - pageBorder;
+
+    texels.resize (slotSize * slotSize * 4);
+
+    // Textures repeat so the border and any part of the page beyond the edge wrap around, which keeps filtering seamless at the edges too.
+    for (int y = 0; y < slotSize; ++y)
+    {
+        const auto row = ((bottom + y) % height + height) % height;
+
+        for (int x = 0; x < slotSize; ++x)
+        {
+            const auto column   = ((left + x) % width + width) % width;
+            const auto from     = &pixels[(row * width + column) * 4];
+
+            std::copy (from, from + 4, &texels[(y * slotSize + x) * 4]);
+        }
+    }
+}
+
+
+void MyView::VirtualTextures::uploadPage (const PreparedPage& page, const size_t slot, const bool pinned)
+{
+    auto& target = m_slots[slot];
+
+    if (target.occupied)
+    {
+        writeEntry (target.key, 0);
+        m_resident.erase (target.key);
+        ++m_statistics.evictedCount;
+    }
+
+    const auto column   = static_cast<std::uint32_t> (slot % m_slotColumns);
+    const auto row      = static_cast<std::uint32_t> (slot / m_slotColumns);
+
+    glBindTexture (GL_TEXTURE_2D, m_cache);
+    glTexSubImage2D (GL_TEXTURE_2D, 0, column * slotSize, row * slotSize, slotSize, slotSize, GL_RGBA, GL_UNSIGNED_BYTE, page.texels.data());
+    glBindTexture (GL_TEXTURE_2D, 0);
+
+    writeEntry (page.key, residentBit | (row << 12) | column);
+
+    target.key      = page.key;
+    target.lastUsed = m_frame;
+    target.occupied = true;
+    target.pinned   = pinned;
+
+    m_resident[page.key] = slot;
+    ++m_statistics.uploadedCount;
+}
+
+
+size_t MyView::VirtualTextures::findSlot() const
+{
+    auto oldest = m_slots.size();
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        const auto& slot = m_slots[i];
+
+        if (!slot.occupied)
+        {
+            return i;
+        }
+
+        // Pages the latest feedback asked for are in use, evicting them would only cause them to be requested again.
+        if (!slot.pinned && slot.lastUsed < m_frame && (oldest == m_slots.size() || slot.lastUsed < m_slots[oldest].lastUsed))
+        {
+            oldest = i;
+        }
+    }
+
+    return oldest;
+}
+
+
+void MyView::VirtualTextures::writeEntry (const PageKey key, const std::uint32_t entry)
+{
+    const auto index = entryOf (key);
+    m_entries[index] = entry;
+
+    glBindBuffer (GL_TEXTURE_BUFFER, m_table.vbo);
+    glBufferSubData (GL_TEXTURE_BUFFER, index * sizeof (std::uint32_t), sizeof (std::uint32_t), &m_entries[index]);
+    glBindBuffer (GL_TEXTURE_BUFFER, 0);
+}
+
+
+size_t MyView::VirtualTextures::entryOf (const PageKey key) const
+{
+    const auto  texture = keyTexture (key);
+    const auto  mipmap  = keyMipmap (key);
+    const auto& source  = *m_sources[texture];
+
+    return m_bases[texture] + source.offsets[mipmap] + keyY (key) * source.pages[mipmap].first + keyX (key);
+}
+
+
+void MyView::VirtualTextures::work()
+{
+    std::unique_lock<std::mutex> lock { m_mutex };
+
+    while (true)
+    {
+        // Wait for something to do, without letting prepared pages pile up faster than the budget lets them be uploaded.
+        m_condition.wait (lock, [this] () { return !m_running || (!m_requests.empty() && m_prepared.size() < preparedLimit); });
+
+        if (!m_running)
+        {
+            return;
+        }
+
+        const auto request = std::move (m_requests.front());
+        m_requests.pop_front();
+
+        // Cutting the page out is the expensive part, the render thread can carry on meanwhile.
+        PreparedPage page { };
+        page.key        = request.key;
+        page.generation = request.generation;
+
+        lock.unlock();
+        preparePage (*request.source, request.key, page.texels);
+        lock.lock();
+
+        m_prepared.push_back (std::move (page));
+    }
+}
+
+#pragma endregion
@@ -0,0 +1,211 @@
+#pragma once
+
+#if !defined    _MY_VIEW_VIRTUAL_TEXTURES_
+#define         _MY_VIEW_VIRTUAL_TEXTURES_
+
+
+// STL headers.
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// Personal headers.
+#include <MyView/MyView.h>
+
+
+// Forward declarations.
+namespace tygra { class Image; }
+
+
+/// <summary>
+/// Keeps only the parts of each texture which are actually visible on the GPU. Textures are split into pages of a fixed size at every
+/// mipmap, and a fixed number of slots in a single physical texture hold whichever pages were most recently needed. A page table maps
+/// each page of each texture to its slot so the shaders can find them, falling back to coarser mipmaps for pages which aren't resident.
+/// Which pages are needed is reported by a low resolution feedback pass, a worker thread then cuts the pages out of the mipmaps kept in
+/// memory and a limited number are uploaded each frame, evicting the least recently used. The memory the GPU needs is therefore the
+/// same no matter how many textures there are, how large they are or whether they match in size.
+/// </summary>
+class MyView::VirtualTextures final
+{
+    public:
+
+        #pragma region Cache types
+
+        using Clock = std::chrono::steady_clock;
+
+        /// <summary> Identifies a page as the texture index, mipmap and page co-ordinates packed the same way the shaders write them. </summary>
+        using PageKey = std::uint32_t;
+
+        /// <summary>
+        /// How much paging is going on since the statistics were last reset. Times are in milliseconds.
+        /// </summary>
+        struct Statistics final
+        {
+            size_t  frameCount      { 0 };      //!< How many frames have been updated.
+            size_t  feedbackCount   { 0 };      //!< How many feedback buffers have been processed.
+            size_t  requestedCount  { 0 };      //!< How many distinct pages were needed across every feedback buffer.
+            size_t  missingCount    { 0 };      //!< How many needed pages weren't resident across every feedback buffer.
+            size_t  uploadedCount   { 0 };      //!< How many pages have been uploaded.
+            size_t  evictedCount    { 0 };      //!< How many resident pages were replaced by another.
+            double  totalTime       { 0.0 };    //!< The sum of the time each update took.
+            double  maxTime         { 0.0 };    //!< The longest an update took.
+
+            double averageRequested() const { return feedbackCount > 0 ? requestedCount / static_cast<double> (feedbackCount) : 0.0; }
+            double averageMissing() const   { return feedbackCount > 0 ? missingCount / static_cast<double> (feedbackCount) : 0.0; }
+            double averageTime() const      { return frameCount > 0 ? totalTime / frameCount : 0.0; }
+        };
+
+        #pragma endregion
+
+        #pragma region Constructors and destructor
+
+        /// <summary> Starts the worker thread, the OpenGL objects are created by the first call to setTextures(). </summary>
+        /// <param name="slotColumns"> The physical texture holds this many pages across and down. </param>
+        /// <param name="uploadBudget"> How many pages may be uploaded each frame. </param>
+        VirtualTextures (const size_t slotColumns = 24, const size_t uploadBudget = 16);
+
+        /// <summary> Stops the worker and deletes the OpenGL objects, a context sharing them must be current. </summary>
+        ~VirtualTextures();
+
+        VirtualTextures (VirtualTextures&& move)                    = delete;
+        VirtualTextures& operator= (VirtualTextures&& move)         = delete;
+        VirtualTextures (const VirtualTextures& copy)               = delete;
+        VirtualTextures& operator= (const VirtualTextures& copy)    = delete;
+
+        #pragma endregion
+
+        #pragma region Paging
+
+        /// <summary> Replaces every texture, emptying the cache. The coarsest mipmap of each is uploaded immediately and never evicted. Call from the render thread. </summary>
+        /// <param name="images"> The textures in the order materials refer to them, textures without data are drawn white. </param>
+        void setTextures (const std::vector<std::pair<std::string, tygra::Image>>& images);
+
+        /// <summary> Replaces the contents of a single texture, which may change size. Call from the render thread. </summary>
+        void replaceTexture (const size_t index, const tygra::Image& image);
+
+        /// <summary> Binds the page cache, page table and texture information to the given texture units. </summary>
+        void bind (const GLenum cacheUnit, const GLenum tableUnit, const GLenum infoUnit) const;
+
+        /// <summary> Reads the pages requested by a feedback pass and asks the worker for those which aren't resident, coarsest first. </summary>
+        /// <param name="requests"> A key per pixel, 0xFFFFFFFF where no page was needed. </param>
+        void submitFeedback (const PageKey* const requests, const size_t count);
+
+        /// <summary> Uploads as many prepared pages as the budget allows. Call from the render thread once a frame. </summary>
+        void update();
+
+        #pragma endregion
+
+        #pragma region Statistics
+
+        /// <summary> Gets a copy of the current statistics. </summary>
+        Statistics getStatistics() const        { return m_statistics; }
+
+        /// <summary> Writes the statistics in a human-readable format. </summary>
+        void printStatistics (std::ostream& stream) const;
+
+        /// <summary> Discards every recorded statistic. </summary>
+        void resetStatistics()                  { m_statistics = { }; }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Implementation data
+
+        /// <summary> Every mipmap of a texture converted to RGBA8, shared with the worker so replacing a texture never waits for it. </summary>
+        struct Source final
+        {
+            std::vector<std::vector<std::uint8_t>>  mipmaps     { };    //!< The texels of each mipmap, finest first.
+            std::vector<std::pair<int, int>>        sizes       { };    //!< The width and height of each mipmap.
+            std::vector<size_t>                     offsets     { };    //!< Where the page table entries of each mipmap start, relative to the first.
+            std::vector<std::pair<int, int>>        pages       { };    //!< How many pages each mipmap has across and down.
+        };
+
+        /// <summary> A page cut out of its mipmap along with the border needed for filtering, ready to upload. </summary>
+        struct PreparedPage final
+        {
+            PageKey                     key         { 0 };  //!< Which page it is.
+            std::uint64_t               generation  { 0 };  //!< The generation of the texture it was cut from.
+            std::vector<std::uint8_t>   texels      { };    //!< The RGBA8 texels of the page and its border.
+        };
+
+        /// <summary> A page the worker has been asked to prepare. </summary>
+        struct PageRequest final
+        {
+            PageKey                         key         { 0 };          //!< Which page to prepare.
+            std::uint64_t                   generation  { 0 };          //!< The generation of the texture when it was requested.
+            std::shared_ptr<const Source>   source      { nullptr };    //!< The texture to cut it from.
+        };
+
+        /// <summary> A slot of the physical texture. </summary>
+        struct Slot final
+        {
+            PageKey     key         { 0 };      //!< The page in the slot.
+            size_t      lastUsed    { 0 };      //!< The last frame the feedback asked for the page.
+            bool        occupied    { false };  //!< Whether the slot holds a page.
+            bool        pinned      { false };  //!< Whether the page is the coarsest mipmap of its texture and mustn't be evicted.
+        };
+
+        /// <summary> Converts an image to RGBA8 and builds its mipmaps down to a single page, nullptr if the image has no data. </summary>
+        static std::shared_ptr<const Source> buildSource (const tygra::Image& image);
+
+        /// <summary> Lays the page table out for every texture and empties the cache, then uploads the coarsest mipmap of each texture again. </summary>
+        void rebuildTables();
+
+        /// <summary> Cuts a page and its border out of its mipmap, wrapping around the edges as the textures repeat. </summary>
+        static void preparePage (const Source& source, const PageKey key, std::vector<std::uint8_t>& texels);
+
+        /// <summary> Copies a prepared page into a slot and points the page table at it, evicting whatever was there. </summary>
+        void uploadPage (const PreparedPage& page, const size_t slot, const bool pinned);
+
+        /// <summary> Finds a free slot or the least recently used page which wasn't needed this frame, returns the slot count if every slot is busy. </summary>
+        size_t findSlot() const;
+
+        /// <summary> Points a page table entry at a slot, or marks it missing. </summary>
+        void writeEntry (const PageKey key, const std::uint32_t entry);
+
+        /// <summary> Gets where the page table entry of a page is, assuming the key is valid. </summary>
+        size_t entryOf (const PageKey key) const;
+
+        /// <summary> Prepares the pages which have been requested until told to stop. </summary>
+        void work();
+
+        size_t                                          m_slotColumns   { 24 };         //!< How many slots the physical texture has across and down.
+        size_t                                          m_uploadBudget  { 16 };         //!< How many pages may be uploaded each frame.
+
+        GLuint                                          m_cache         { 0 };          //!< The physical RGBA8 texture holding every resident page.
+        SamplerBuffer                                   m_table         { };            //!< The R32UI page table, with the slot of each page and whether it's resident.
+        SamplerBuffer                                   m_info          { };            //!< The RGBA32I dimensions and page table layout of each texture.
+
+        std::vector<std::shared_ptr<const Source>>      m_sources       { };            //!< Every texture, nullptr for textures without data.
+        std::vector<std::uint64_t>                      m_generations   { };            //!< Incremented whenever a texture is replaced so stale pages are discarded.
+        std::vector<size_t>                             m_bases         { };            //!< Where the page table entries of each texture start.
+        std::vector<std::uint32_t>                      m_entries       { };            //!< A copy of the page table.
+        std::vector<Slot>                               m_slots         { };            //!< What each slot of the physical texture holds.
+        std::unordered_map<PageKey, size_t>             m_resident      { };            //!< The slot of each resident page.
+        std::unordered_map<PageKey, std::uint64_t>      m_pending       { };            //!< Pages the worker is preparing, with the generation they were requested for.
+        size_t                                          m_frame         { 1 };          //!< Counts the updates, used to find the least recently used page.
+
+        std::thread                                     m_worker        { };            //!< Prepares requested pages.
+        std::mutex                                      m_mutex         { };            //!< Protects the requests, prepared pages and whether the worker is running.
+        std::condition_variable                         m_condition     { };            //!< Wakes the worker when pages are requested or it must stop.
+        std::deque<PageRequest>                         m_requests      { };            //!< Pages waiting to be prepared, in priority order.
+        std::deque<PreparedPage>                        m_prepared      { };            //!< Pages waiting to be uploaded.
+        bool                                            m_running       { true };       //!< Whether the worker should keep going.
+
+        Statistics                                      m_statistics    { };            //!< How much paging is going on.
+
+        #pragma endregion
+};
+
+#endif // _MY_VIEW_VIRTUAL_TEXTURES_
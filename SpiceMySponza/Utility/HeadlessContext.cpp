@@ -0,0 +1,224 @@
+#include "HeadlessContext.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+// Platform headers.
+#if defined (_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+
+    #pragma comment (lib, "opengl32.lib")
+#else
+    #include <EGL/egl.h>
+#endif
+
+
+
+namespace util
+{
+    #pragma region Constructors and destructor
+
+    HeadlessContext::~HeadlessContext()
+    {
+        destroy();
+    }
+
+
+    HeadlessContext::HeadlessContext (HeadlessContext&& move)
+    {
+        *this = std::move (move);
+    }
+
+
+    HeadlessContext& HeadlessContext::operator= (HeadlessContext&& move)
+    {
+        if (this != &move)
+        {
+            destroy();
+
+            m_display       = move.m_display;
+            m_surface       = move.m_surface;
+            m_context       = move.m_context;
+
+            // Reset primitives.
+            move.m_display  = nullptr;
+            move.m_surface  = nullptr;
+            move.m_context  = nullptr;
+        }
+
+        return *this;
+    }
+
+    #pragma endregion
+
+
+    #pragma region Public interface
+
+    #if defined (_WIN32)
+
+    bool HeadlessContext::create()
+    {
+        destroy();
+
+        // A window is the only way to get a pixel format, it just never gets shown.
+        const auto instance     = GetModuleHandleA (nullptr);
+        const auto className    = "SpiceMySponzaHeadless";
+
+        WNDCLASSA windowClass { };
+        windowClass.style           = CS_OWNDC;
+        windowClass.lpfnWndProc     = DefWindowProcA;
+        windowClass.hInstance       = instance;
+        windowClass.lpszClassName   = className;
+        RegisterClassA (&windowClass);
+
+        const auto window = CreateWindowExA (0, className, className, WS_OVERLAPPEDWINDOW, 0, 0, 1, 1, nullptr, nullptr, instance, nullptr);
+
+        if (window == nullptr)
+        {
+            return false;
+        }
+
+        const auto device = GetDC (window);
+
+        PIXELFORMATDESCRIPTOR format { };
+        format.nSize        = sizeof (format);
+        format.nVersion     = 1;
+        format.dwFlags      = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+        format.iPixelType   = PFD_TYPE_RGBA;
+        format.cColorBits   = 32;
+        format.cDepthBits   = 24;
+        format.iLayerType   = PFD_MAIN_PLANE;
+
+        const auto chosen   = ChoosePixelFormat (device, &format);
+        const auto context  = chosen != 0 && SetPixelFormat (device, chosen, &format) ? wglCreateContext (device) : nullptr;
+
+        if (context == nullptr || !wglMakeCurrent (device, context))
+        {
+            if (context)
+            {
+                wglDeleteContext (context);
+            }
+
+            ReleaseDC (window, device);
+            DestroyWindow (window);
+            return false;
+        }
+
+        m_display   = device;
+        m_surface   = window;
+        m_context   = context;
+
+        return true;
+    }
+
+
+    void HeadlessContext::destroy()
+    {
+        if (m_context)
+        {
+            wglMakeCurrent (nullptr, nullptr);
+            wglDeleteContext (static_cast<HGLRC> (m_context));
+            ReleaseDC (static_cast<HWND> (m_surface), static_cast<HDC> (m_display));
+            DestroyWindow (static_cast<HWND> (m_surface));
+        }
+
+        m_display   = nullptr;
+        m_surface   = nullptr;
+        m_context   = nullptr;
+    }
+
+    #else
+
+    bool HeadlessContext::create()
+    {
+        destroy();
+
+        const auto display = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+
+        if (display == EGL_NO_DISPLAY || !eglInitialize (display, nullptr, nullptr) || !eglBindAPI (EGL_OPENGL_API))
+        {
+            return false;
+        }
+
+        const EGLint configAttributes[] =
+        {
+            EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE,    EGL_OPENGL_BIT,
+            EGL_RED_SIZE,           8,
+            EGL_GREEN_SIZE,         8,
+            EGL_BLUE_SIZE,          8,
+            EGL_DEPTH_SIZE,         24,
+            EGL_NONE
+        };
+
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+        const EGLint contextAttributes[] =
+        {
+            EGL_CONTEXT_MAJOR_VERSION,          3,
+            EGL_CONTEXT_MINOR_VERSION,          3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK,    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+
+        EGLConfig   config  { };
+        EGLint      count   { 0 };
+
+        if (!eglChooseConfig (display, configAttributes, &config, 1, &count) || count == 0)
+        {
+            eglTerminate (display);
+            return false;
+        }
+
+        const auto surface = eglCreatePbufferSurface (display, config, surfaceAttributes);
+        const auto context = surface != EGL_NO_SURFACE ? eglCreateContext (display, config, EGL_NO_CONTEXT, contextAttributes) : EGL_NO_CONTEXT;
+
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent (display, surface, surface, context))
+        {
+            if (context != EGL_NO_CONTEXT)
+            {
+                eglDestroyContext (display, context);
+            }
+
+            if (surface != EGL_NO_SURFACE)
+            {
+                eglDestroySurface (display, surface);
+            }
+
+            eglTerminate (display);
+            return false;
+        }
+
+        m_display   = display;
+        m_surface   = surface;
+        m_context   = context;
+
+        return true;
+    }
+
+
+    void HeadlessContext::destroy()
+    {
+        if (m_context)
+        {
+            eglMakeCurrent (m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext (m_display, m_context);
+            eglDestroySurface (m_display, m_surface);
+            eglTerminate (m_display);
+        }
+
+        m_display   = nullptr;
+        m_surface   = nullptr;
+        m_context   = nullptr;
+    }
+
+    #endif
+
+    #pragma endregion
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#if !defined    _UTIL_HEADLESS_CONTEXT_
+#define         _UTIL_HEADLESS_CONTEXT_
+
+
+namespace util
+{
+    /// <summary>
+    /// An OpenGL context which renders without a visible window, for running as a render server on a machine without a display. The default
+    /// framebuffer is a tiny placeholder so everything worth keeping must be rendered into a framebuffer object. Windows uses a hidden window
+    /// whilst other platforms use an EGL pbuffer.
+    /// </summary>
+    class HeadlessContext final
+    {
+        public:
+
+            #pragma region Constructors and destructor
+
+            HeadlessContext()                                       = default;
+            ~HeadlessContext();
+
+            HeadlessContext (HeadlessContext&& move);
+            HeadlessContext& operator= (HeadlessContext&& move);
+
+            HeadlessContext (const HeadlessContext& copy)           = delete;
+            HeadlessContext& operator= (const HeadlessContext& copy) = delete;
+
+            #pragma endregion
+
+            #pragma region Public interface
+
+            /// <summary> Creates an OpenGL 3.3 core context, or the closest the platform offers, and makes it current on the calling thread. </summary>
+            /// <returns> Whether a context could be created. </returns>
+            bool create();
+
+            /// <summary> Releases and destroys the context. </summary>
+            void destroy();
+
+            bool isValid() const    { return m_context != nullptr; }
+
+            #pragma endregion
+
+        private:
+
+            #pragma region Implementation data
+
+            void*   m_display   { nullptr };    //!< The EGL display, or the device context of the hidden window on Windows.
+            void*   m_surface   { nullptr };    //!< The EGL pbuffer surface, or the hidden window on Windows.
+            void*   m_context   { nullptr };    //!< The native OpenGL context.
+
+            #pragma endregion
+    };
+}
+
+#endif // _UTIL_HEADLESS_CONTEXT_
@@ -0,0 +1,273 @@
+#include "ImageDeduplication.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+
+
+// Engine headers.
+#include <tygra/FileHelper.hpp>
+
+
+
+namespace
+{
+    // Thumbnails are this many texels across and down, one bit of the perceptual hash per texel.
+    const size_t thumbnailSize          = 8;
+
+    // Perceptual hashes may differ by this many bits and still be considered the same picture.
+    const int    similarHashDistance    = 4;
+
+    // The luminance hash is blind to colour so thumbnails must also agree on average to within this, out of 255 per channel.
+    const int    similarColourError     = 3;
+
+
+    /// <summary> An RGB thumbnail of an image, like the smallest mipmap a texture would have before it became a single texel. </summary>
+    using Thumbnail = std::array<std::array<int, 3>, thumbnailSize * thumbnailSize>;
+
+
+    /// <summary> Gets the size of the pixel data of an image, which tygra packs tightly. </summary>
+    size_t pixelBytes (const tygra::Image& image)
+    {
+        return static_cast<size_t> (image.width()) * image.height() * image.componentsPerPixel() * image.bytesPerComponent();
+    }
+
+
+    /// <summary> Hashes the dimensions and pixels of an image with 64-bit FNV-1a. </summary>
+    std::uint64_t hashPixels (const tygra::Image& image)
+    {
+        const std::uint64_t prime   = 1099511628211ull;
+        std::uint64_t       hash    = 14695981039346656037ull;
+
+        const auto mix = [&hash, prime] (const unsigned char* bytes, const size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * prime;
+            }
+        };
+
+        const int header[] = { image.width(), image.height(), image.componentsPerPixel(), image.bytesPerComponent() };
+
+        mix (reinterpret_cast<const unsigned char*> (header), sizeof (header));
+        mix (static_cast<const unsigned char*> (image.pixels()), pixelBytes (image));
+
+        return hash;
+    }
+
+
+    /// <summary> Checks whether two images have exactly the same format and pixels. </summary>
+    bool identical (const tygra::Image& lhs, const tygra::Image& rhs)
+    {
+        return  lhs.width() == rhs.width() && lhs.height() == rhs.height() &&
+                lhs.componentsPerPixel() == rhs.componentsPerPixel() && lhs.bytesPerComponent() == rhs.bytesPerComponent() &&
+                std::memcmp (lhs.pixels(), rhs.pixels(), pixelBytes (lhs)) == 0;
+    }
+
+
+    /// <summary> Box filters an image down to a thumbnail, reading the most significant byte of each component. </summary>
+    Thumbnail shrink (const tygra::Image& image)
+    {
+        Thumbnail thumbnail { };
+
+        const auto width        = static_cast<size_t> (image.width());
+        const auto height       = static_cast<size_t> (image.height());
+        const auto components   = static_cast<size_t> (image.componentsPerPixel());
+        const auto depth        = static_cast<size_t> (image.bytesPerComponent());
+        const auto pixels       = static_cast<const unsigned char*> (image.pixels());
+
+        for (size_t ty = 0; ty < thumbnailSize; ++ty)
+        {
+            for (size_t tx = 0; tx < thumbnailSize; ++tx)
+            {
+                // Every texel of the image lands in exactly one thumbnail texel, small images repeat texels instead.
+                const auto left     = tx * width / thumbnailSize, right     = std::max ((tx + 1) * width / thumbnailSize, left + 1);
+                const auto top      = ty * height / thumbnailSize, bottom   = std::max ((ty + 1) * height / thumbnailSize, top + 1);
+
+                std::array<size_t, 3> sum { { 0, 0, 0 } };
+
+                for (size_t y = top; y < bottom; ++y)
+                {
+                    for (size_t x = left; x < right; ++x)
+                    {
+                        const auto texel = pixels + ((y * width + x) * components) * depth;
+
+                        for (size_t c = 0; c < 3; ++c)
+                        {
+                            // Greyscale images repeat their only channel, 16-bit channels are stored in native order.
+                            const auto component = c < components && components > 2 ? c : 0;
+                            const auto byte      = depth == 2 ? reinterpret_cast<const std::uint16_t*> (texel)[component] >> 8 : texel[component];
+                            sum[c] += byte;
+                        }
+                    }
+                }
+
+                const auto count = (right - left) * (bottom - top);
+
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    thumbnail[ty * thumbnailSize + tx][c] = static_cast<int> (sum[c] / count);
+                }
+            }
+        }
+
+        return thumbnail;
+    }
+
+
+    /// <summary> Sets one bit per thumbnail texel whose luminance is above the average, which survives resampling and re-encoding. </summary>
+    std::uint64_t perceptualHash (const Thumbnail& thumbnail)
+    {
+        std::array<int, thumbnailSize * thumbnailSize> luminance { };
+        int                                            mean     { 0 };
+
+        for (size_t i = 0; i < luminance.size(); ++i)
+        {
+            luminance[i] = (thumbnail[i][0] * 299 + thumbnail[i][1] * 587 + thumbnail[i][2] * 114) / 1000;
+            mean += luminance[i];
+        }
+
+        mean /= static_cast<int> (luminance.size());
+
+        std::uint64_t hash { 0 };
+
+        for (size_t i = 0; i < luminance.size(); ++i)
+        {
+            hash |= static_cast<std::uint64_t> (luminance[i] > mean ? 1 : 0) << i;
+        }
+
+        return hash;
+    }
+
+
+    /// <summary> Counts the bits which differ between two hashes. </summary>
+    int distance (std::uint64_t lhs, const std::uint64_t rhs)
+    {
+        int bits { 0 };
+
+        for (lhs ^= rhs; lhs != 0; lhs &= lhs - 1)
+        {
+            ++bits;
+        }
+
+        return bits;
+    }
+
+
+    /// <summary> Checks whether two thumbnails agree on colour on average. </summary>
+    bool similarColours (const Thumbnail& lhs, const Thumbnail& rhs)
+    {
+        int error { 0 };
+
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                error += std::abs (lhs[i][c] - rhs[i][c]);
+            }
+        }
+
+        return error <= similarColourError * static_cast<int> (lhs.size() * 3);
+    }
+}
+
+
+
+namespace util
+{
+    std::unordered_map<std::string, size_t> deduplicateImages (std::vector<std::pair<std::string, tygra::Image>>& images, const bool mergeSimilar,
+                                                               ImageDeduplication* const statistics)
+    {
+        /// Images are kept in their original order so the first of each set of duplicates survives and everything after it shuffles down. An
+        /// exact hash only narrows the search, images are always compared byte for byte before being merged. Similar images are found with an
+        /// average hash of their thumbnail, which only looks at the pattern of light and dark, so the thumbnails must also agree on colour
+        /// otherwise tinted variants of the same texture would collapse into one. Every kept image is checked, which is fine for the few
+        /// hundred textures a scene has.
+        const auto start = std::chrono::steady_clock::now();
+
+        ImageDeduplication                                  result      { };
+        std::unordered_map<std::string, size_t>             indices     { };
+        std::unordered_multimap<std::uint64_t, size_t>      exact       { };
+        std::vector<std::pair<std::uint64_t, Thumbnail>>    perceptual  { };
+        std::vector<std::pair<std::string, tygra::Image>>   kept        { };
+
+        result.imageCount = images.size();
+        kept.reserve (images.size());
+
+        for (auto& pair : images)
+        {
+            const auto& image   = pair.second;
+            const auto  hash    = hashPixels (image);
+            auto        match   = kept.size();
+
+            // Exact copies first.
+            const auto range = exact.equal_range (hash);
+
+            for (auto it = range.first; it != range.second && match == kept.size(); ++it)
+            {
+                if (identical (kept[it->second].second, image))
+                {
+                    match = it->second;
+                    ++result.identicalCount;
+                }
+            }
+
+            // Then anything which looks the same.
+            Thumbnail     thumbnail { };
+            std::uint64_t pHash   { 0 };
+
+            if (mergeSimilar && match == kept.size())
+            {
+                thumbnail   = shrink (image);
+                pHash       = perceptualHash (thumbnail);
+
+                for (size_t i = 0; i < kept.size() && match == kept.size(); ++i)
+                {
+                    const auto& other = kept[i].second;
+
+                    if (other.width() == image.width() && other.height() == image.height() &&
+                        distance (perceptual[i].first, pHash) <= similarHashDistance && similarColours (perceptual[i].second, thumbnail))
+                    {
+                        match = i;
+                        ++result.similarCount;
+                    }
+                }
+            }
+
+            if (match != kept.size())
+            {
+                result.removedTexels += static_cast<size_t> (image.width()) * image.height();
+                indices.emplace (pair.first, match);
+                continue;
+            }
+
+            exact.emplace (hash, kept.size());
+
+            if (mergeSimilar)
+            {
+                perceptual.push_back ({ pHash, thumbnail });
+            }
+
+            indices.emplace (pair.first, kept.size());
+            kept.push_back (std::move (pair));
+        }
+
+        images = std::move (kept);
+
+        result.hashTime = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+
+        if (statistics)
+        {
+            *statistics = result;
+        }
+
+        return indices;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#if !defined    _UTIL_IMAGE_DEDUPLICATION_
+#define         _UTIL_IMAGE_DEDUPLICATION_
+
+
+// STL headers.
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// Forward declarations.
+namespace tygra { class Image; }
+
+
+namespace util
+{
+    /// <summary>
+    /// What deduplicateImages() found. Texels are counted at the full size of each removed image.
+    /// </summary>
+    struct ImageDeduplication final
+    {
+        size_t  imageCount      { 0 };      //!< How many images were checked.
+        size_t  identicalCount  { 0 };      //!< How many images had exactly the same pixels as an earlier image.
+        size_t  similarCount    { 0 };      //!< How many images looked the same as an earlier image once shrunk to a thumbnail.
+        size_t  removedTexels   { 0 };      //!< How many texels the removed images had between them.
+        double  hashTime        { 0.0 };    //!< How long hashing and comparing took, in milliseconds.
+
+        size_t removedCount() const { return identicalCount + similarCount; }
+    };
+
+
+    /// <summary>
+    /// Removes every image whose pixels match an earlier image, so materials which refer to the same picture under different file names
+    /// share a texture. The pixels are hashed so only images with the same hash are compared. Optionally images which merely look the
+    /// same are merged too, which catches re-encoded copies at the risk of merging textures which differ in fine detail.
+    /// </summary>
+    /// <returns> The index in the remaining images of each file name, removed files map to the image they duplicated. </returns>
+    /// <param name="images"> The file-image pairs to deduplicate, the first of any duplicates is kept and the order is preserved. </param>
+    /// <param name="mergeSimilar"> Whether images of the same size with matching perceptual hashes and thumbnails are merged. </param>
+    /// <param name="statistics"> An optional place to describe what was removed. </param>
+    std::unordered_map<std::string, size_t> deduplicateImages (std::vector<std::pair<std::string, tygra::Image>>& images, const bool mergeSimilar,
+                                                               ImageDeduplication* const statistics = nullptr);
+}
+
+#endif // _UTIL_IMAGE_DEDUPLICATION_
@@ -0,0 +1,260 @@
+#include "ImageEncoder.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+
+
+namespace
+{
+    // The most data a stored deflate block can hold.
+    const size_t maxBlockSize       = 65535;
+
+    // The PNG signature, an IHDR chunk, the IDAT chunk framing, the zlib header and checksum then an IEND chunk.
+    const size_t fixedPNGOverhead   = 8 + 25 + 12 + 2 + 4 + 12;
+
+
+    /// <summary> Builds the table for the CRC-32 which PNG chunks end with. </summary>
+    std::array<std::uint32_t, 256> crcTable()
+    {
+        std::array<std::uint32_t, 256> table { };
+
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            auto crc = i;
+
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = crc & 1 ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+            }
+
+            table[i] = crc;
+        }
+
+        return table;
+    }
+
+
+    /// <summary> Continues a CRC-32 over the given bytes. The running value is kept inverted between calls. </summary>
+    std::uint32_t updateCRC (std::uint32_t crc, const unsigned char* data, const size_t size)
+    {
+        static const auto table = crcTable();
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+
+        return crc;
+    }
+
+
+    /// <summary> Writes a big-endian 32-bit value, as PNG and zlib expect. </summary>
+    void writeBigEndian (unsigned char* output, const std::uint32_t value)
+    {
+        output[0] = static_cast<unsigned char> (value >> 24);
+        output[1] = static_cast<unsigned char> (value >> 16);
+        output[2] = static_cast<unsigned char> (value >> 8);
+        output[3] = static_cast<unsigned char> (value);
+    }
+
+
+    /// <summary>
+    /// Writes the zlib stream of an IDAT chunk as a series of stored blocks, keeping the chunk CRC and the Adler-32 of the raw data up to date.
+    /// </summary>
+    class StoredDeflate final
+    {
+        public:
+
+            StoredDeflate (unsigned char* output, const size_t rawSize)
+                : m_output (output), m_remaining (rawSize) { }
+
+            /// <summary> Appends raw bytes, starting a new block whenever the current one is full. </summary>
+            void write (const unsigned char* data, size_t size)
+            {
+                while (size > 0)
+                {
+                    if (m_blockRemaining == 0)
+                    {
+                        beginBlock();
+                    }
+
+                    const auto count = std::min (size, m_blockRemaining);
+                    std::memcpy (m_output, data, count);
+
+                    m_crc = updateCRC (m_crc, data, count);
+                    updateAdler (data, count);
+
+                    m_output            += count;
+                    m_blockRemaining    -= count;
+                    m_remaining         -= count;
+                    data                += count;
+                    size                -= count;
+                }
+            }
+
+            /// <summary> Writes framing bytes which are part of the chunk but not the raw data. </summary>
+            void writeFraming (const unsigned char* data, const size_t size)
+            {
+                std::memcpy (m_output, data, size);
+                m_crc       = updateCRC (m_crc, data, size);
+                m_output    += size;
+            }
+
+            std::uint32_t adler() const         { return (m_adlerB << 16) | m_adlerA; }
+            std::uint32_t crc() const           { return m_crc; }
+            unsigned char* position() const     { return m_output; }
+
+            void setCRC (const std::uint32_t crc)   { m_crc = crc; }
+
+        private:
+
+            /// <summary> Starts a stored block holding as much of the remaining data as it can. </summary>
+            void beginBlock()
+            {
+                m_blockRemaining        = std::min (m_remaining, maxBlockSize);
+
+                const auto  length      = static_cast<std::uint16_t> (m_blockRemaining);
+                const auto  inverse     = static_cast<std::uint16_t> (~length);
+                const unsigned char header[5] =
+                {
+                    static_cast<unsigned char> (m_remaining == m_blockRemaining ? 1 : 0),
+                    static_cast<unsigned char> (length), static_cast<unsigned char> (length >> 8),
+                    static_cast<unsigned char> (inverse), static_cast<unsigned char> (inverse >> 8)
+                };
+
+                writeFraming (header, sizeof (header));
+            }
+
+            /// <summary> Continues the Adler-32, deferring the modulo for as long as the sums can't overflow. </summary>
+            void updateAdler (const unsigned char* data, size_t size)
+            {
+                const size_t longestRun = 5552;
+
+                while (size > 0)
+                {
+                    const auto run = std::min (size, longestRun);
+
+                    for (size_t i = 0; i < run; ++i)
+                    {
+                        m_adlerA += data[i];
+                        m_adlerB += m_adlerA;
+                    }
+
+                    m_adlerA    %= 65521;
+                    m_adlerB    %= 65521;
+                    data        += run;
+                    size        -= run;
+                }
+            }
+
+            unsigned char*  m_output            { nullptr };    //!< Where the next byte is written.
+            size_t          m_remaining         { 0 };          //!< How many raw bytes are still to be written.
+            size_t          m_blockRemaining    { 0 };          //!< How many raw bytes the current block still holds.
+            std::uint32_t   m_crc               { 0 };          //!< The running CRC of the chunk.
+            std::uint32_t   m_adlerA            { 1 };          //!< The first Adler-32 sum.
+            std::uint32_t   m_adlerB            { 0 };          //!< The second Adler-32 sum.
+    };
+
+
+    /// <summary> Writes a complete chunk, returning the position after it. </summary>
+    unsigned char* writeChunk (unsigned char* output, const char* type, const unsigned char* data, const std::uint32_t size)
+    {
+        writeBigEndian (output, size);
+        std::memcpy (output + 4, type, 4);
+
+        if (size > 0)
+        {
+            std::memcpy (output + 8, data, size);
+        }
+
+        const auto crc = updateCRC (0xFFFFFFFF, output + 4, size + 4) ^ 0xFFFFFFFF;
+        writeBigEndian (output + 8 + size, crc);
+
+        return output + 12 + size;
+    }
+}
+
+
+
+namespace util
+{
+    size_t maxEncodedPNGSize (const size_t width, const size_t height)
+    {
+        // Each row is prefixed with a filter type byte and each block adds five bytes of framing.
+        const auto rawSize  = height * (1 + width * 4);
+        const auto blocks   = std::max<size_t> (1, (rawSize + maxBlockSize - 1) / maxBlockSize);
+
+        return fixedPNGOverhead + rawSize + blocks * 5;
+    }
+
+
+    size_t encodePNG (const unsigned char* pixels, const size_t width, const size_t height, const size_t rowStride, const bool bottomUp,
+                      char* output, const size_t capacity)
+    {
+        const auto size = maxEncodedPNGSize (width, height);
+
+        if (width == 0 || height == 0 || size > capacity || size > 0xFFFFFFFF)
+        {
+            return 0;
+        }
+
+        auto out = reinterpret_cast<unsigned char*> (output);
+
+        // Signature.
+        const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        std::memcpy (out, signature, sizeof (signature));
+        out += sizeof (signature);
+
+        // Header: dimensions, 8 bits per channel, RGBA, deflate, adaptive filtering and no interlacing.
+        unsigned char header[13] = { };
+        writeBigEndian (header, static_cast<std::uint32_t> (width));
+        writeBigEndian (header + 4, static_cast<std::uint32_t> (height));
+        header[8] = 8;
+        header[9] = 6;
+
+        out = writeChunk (out, "IHDR", header, sizeof (header));
+
+        // The image data is written in place, the length is known up front since nothing is compressed.
+        const auto rawSize      = height * (1 + width * 4);
+        const auto dataSize     = size - fixedPNGOverhead + 2 + 4;
+        const auto chunkStart   = out;
+
+        writeBigEndian (out, static_cast<std::uint32_t> (dataSize));
+        std::memcpy (out + 4, "IDAT", 4);
+
+        StoredDeflate deflate { out + 8, rawSize };
+        deflate.setCRC (updateCRC (0xFFFFFFFF, chunkStart + 4, 4));
+
+        // A zlib header for deflate with a 32K window and no preset dictionary.
+        const unsigned char zlibHeader[2] = { 0x78, 0x01 };
+        deflate.writeFraming (zlibHeader, sizeof (zlibHeader));
+
+        const unsigned char filter = 0;
+
+        for (size_t row = 0; row < height; ++row)
+        {
+            const auto source = pixels + (bottomUp ? height - 1 - row : row) * rowStride;
+
+            deflate.write (&filter, 1);
+            deflate.write (source, width * 4);
+        }
+
+        unsigned char adler[4] = { };
+        writeBigEndian (adler, deflate.adler());
+        deflate.writeFraming (adler, sizeof (adler));
+
+        out = deflate.position();
+        writeBigEndian (out, deflate.crc() ^ 0xFFFFFFFF);
+        out += 4;
+
+        out = writeChunk (out, "IEND", nullptr, 0);
+
+        return static_cast<size_t> (reinterpret_cast<char*> (out) - output);
+    }
+}
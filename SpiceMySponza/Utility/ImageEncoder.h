@@ -0,0 +1,31 @@
+#pragma once
+
+#if !defined    _UTIL_IMAGE_ENCODER_
+#define         _UTIL_IMAGE_ENCODER_
+
+
+// STL headers.
+#include <cstddef>
+
+
+namespace util
+{
+    /// <summary> Calculates the largest PNG which encodePNG() can produce for an RGBA8 image of the given dimensions. </summary>
+    size_t maxEncodedPNGSize (const size_t width, const size_t height);
+
+
+    /// <summary>
+    /// Encodes RGBA8 pixels as a PNG using stored deflate blocks. The image isn't compressed, so encoding costs little more than a copy
+    /// and a checksum, which suits handing images to another process on the same machine far better than spending milliseconds on deflate.
+    /// </summary>
+    /// <returns> The size of the PNG in bytes, zero if it wouldn't fit in the output. </returns>
+    /// <param name="pixels"> Tightly packed RGBA8 rows. </param>
+    /// <param name="rowStride"> The distance in bytes between the start of each row. </param>
+    /// <param name="bottomUp"> Whether the first row is the bottom of the image, as glReadPixels provides them. </param>
+    /// <param name="output"> Where the PNG is written. </param>
+    /// <param name="capacity"> The size of the output in bytes, maxEncodedPNGSize() is always enough. </param>
+    size_t encodePNG (const unsigned char* pixels, const size_t width, const size_t height, const size_t rowStride, const bool bottomUp,
+                      char* output, const size_t capacity);
+}
+
+#endif // _UTIL_IMAGE_ENCODER_
@@ -0,0 +1,184 @@
+#include "MappedFile.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+// Platform headers.
+#if defined (_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+
+namespace util
+{
+    #pragma region Constructors and destructor
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+
+    MappedFile::MappedFile (MappedFile&& move)
+    {
+        *this = std::move (move);
+    }
+
+
+    MappedFile& MappedFile::operator= (MappedFile&& move)
+    {
+        if (this != &move)
+        {
+            close();
+
+            m_data          = move.m_data;
+            m_size          = move.m_size;
+            m_file          = move.m_file;
+            m_mapping       = move.m_mapping;
+
+            // Reset primitives.
+            move.m_data     = nullptr;
+            move.m_size     = 0;
+            move.m_file     = nullptr;
+            move.m_mapping  = nullptr;
+        }
+
+        return *this;
+    }
+
+    #pragma endregion
+
+
+    #pragma region Public interface
+
+    #if defined (_WIN32)
+
+    bool MappedFile::open (const std::string& fileLocation)
+    {
+        close();
+
+        // Hint to the OS that we'll be reading the file front to back so it can read ahead aggressively.
+        const auto file = CreateFileA (fileLocation.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER size { };
+
+        if (!GetFileSizeEx (file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle (file);
+            return false;
+        }
+
+        const auto mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mapping == nullptr)
+        {
+            CloseHandle (file);
+            return false;
+        }
+
+        const auto view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (view == nullptr)
+        {
+            CloseHandle (mapping);
+            CloseHandle (file);
+            return false;
+        }
+
+        m_data      = static_cast<const char*> (view);
+        m_size      = static_cast<size_t> (size.QuadPart);
+        m_file      = file;
+        m_mapping   = mapping;
+
+        return true;
+    }
+
+
+    void MappedFile::close()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile (m_data);
+            CloseHandle (m_mapping);
+            CloseHandle (m_file);
+        }
+
+        m_data      = nullptr;
+        m_size      = 0;
+        m_file      = nullptr;
+        m_mapping   = nullptr;
+    }
+
+    #else
+
+    bool MappedFile::open (const std::string& fileLocation)
+    {
+        close();
+
+        const auto file = ::open (fileLocation.c_str(), O_RDONLY);
+
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat status { };
+
+        if (fstat (file, &status) != 0 || status.st_size == 0)
+        {
+            ::close (file);
+            return false;
+        }
+
+        const auto size = static_cast<size_t> (status.st_size);
+        const auto view = mmap (nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        // The mapping keeps its own reference to the file.
+        ::close (file);
+
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        madvise (view, size, MADV_SEQUENTIAL);
+
+        m_data = static_cast<const char*> (view);
+        m_size = size;
+
+        return true;
+    }
+
+
+    void MappedFile::close()
+    {
+        if (m_data)
+        {
+            munmap (const_cast<char*> (m_data), m_size);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    #endif
+
+    #pragma endregion
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#if !defined    _UTIL_MAPPED_FILE_
+#define         _UTIL_MAPPED_FILE_
+
+
+// STL headers.
+#include <string>
+
+
+namespace util
+{
+    /// <summary>
+    /// A read-only view of a file which has been mapped into memory. Large assets are parsed straight out of the page cache this way
+    /// instead of being copied into a std::string first, which also lets several threads parse different parts of the file at once.
+    /// </summary>
+    class MappedFile final
+    {
+        public:
+
+            #pragma region Constructors and destructor
+
+            MappedFile()                                    = default;
+            ~MappedFile();
+
+            MappedFile (MappedFile&& move);
+            MappedFile& operator= (MappedFile&& move);
+
+            MappedFile (const MappedFile& copy)             = delete;
+            MappedFile& operator= (const MappedFile& copy)  = delete;
+
+            #pragma endregion
+
+            #pragma region Public interface
+
+            /// <summary> Maps the given file into memory, unmapping any previously mapped file. </summary>
+            /// <returns> Whether the file could be opened and mapped. Empty files are considered a failure. </returns>
+            /// <param name="fileLocation"> The location of the file to map. </param>
+            bool open (const std::string& fileLocation);
+
+            /// <summary> Unmaps the file, any pointers obtained from the object will be invalidated. </summary>
+            void close();
+
+            bool isOpen() const             { return m_data != nullptr; }
+            const char* data() const        { return m_data; }
+            const char* end() const         { return m_data + m_size; }
+            size_t size() const             { return m_size; }
+
+            #pragma endregion
+
+        private:
+
+            #pragma region Implementation data
+
+            const char* m_data      { nullptr };    //!< The start of the mapped view of the file.
+            size_t      m_size      { 0 };          //!< The size of the file in bytes.
+
+            void*       m_file      { nullptr };    //!< The native file handle, only used on Windows.
+            void*       m_mapping   { nullptr };    //!< The native file mapping handle, only used on Windows.
+
+            #pragma endregion
+    };
+}
+
+#endif // _UTIL_MAPPED_FILE_
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 // STL headers.
 #include <cmath>
+#include <cstdint>
 #include <type_traits>
 
 
@@ -89,6 +90,32 @@ namespace util
     }
 
     #pragma endregion
+
+    #pragma region Spatial ordering
+
+    /// <summary> Spreads the lowest 10 bits of a value out so that two zero bits follow each of them. </summary>
+    inline std::uint32_t spreadBits (std::uint32_t value)
+    {
+        value &= 0x000003ff;
+        value  = (value | (value << 16)) & 0xff0000ff;
+        value  = (value | (value << 8))  & 0x0300f00f;
+        value  = (value | (value << 4))  & 0x030c30c3;
+        value  = (value | (value << 2))  & 0x09249249;
+
+        return value;
+    }
+
+
+    /// <summary> Interleaves the bits of a point in the unit cube into a 30-bit Morton code, points which are close usually have close codes. </summary>
+    /// <param name="x"> The position along the x axis, clamped between 0 and 1. </param>
+    inline std::uint32_t mortonCode (const float x, const float y, const float z)
+    {
+        const auto quantise = [] (const float value) { return static_cast<std::uint32_t> (clamp (value, 0.f, 1.f) * 1023.f + 0.5f); };
+
+        return (spreadBits (quantise (x)) << 2) | (spreadBits (quantise (y)) << 1) | spreadBits (quantise (z));
+    }
+
+    #pragma endregion
 }
 
 #endif // _UTIL_MATHS_
\ No newline at end of file
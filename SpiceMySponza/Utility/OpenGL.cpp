@@ -14,6 +14,7 @@
 
 
 // Personal headers.
+#include <Misc/Vertex.h>
 #include <MyView/Material.h>
 
 
@@ -24,6 +25,9 @@ namespace util
     
     // Instant the different required templates to avoid including OpenGL in the header.
     template void fillBuffer (GLuint& vbo, const std::vector<MyView::Material>& data, const GLenum target, const GLenum usage);
+    template void fillBuffer (GLuint& vbo, const std::vector<Vertex>& data, const GLenum target, const GLenum usage);
+    template void fillBuffer (GLuint& vbo, const std::vector<unsigned int>& data, const GLenum target, const GLenum usage);
+    template void fillBuffer (GLuint& vbo, const std::vector<int>& data, const GLenum target, const GLenum usage);
 
     #pragma endregion
 
@@ -32,9 +36,15 @@ namespace util
     
     GLuint compileShaderFromFile (const std::string& fileLocation, const GLenum shader)
     {
-        // Read in the shader into a const char*.
-        const auto shaderString = tygra::stringFromFile (fileLocation);
-        auto       shaderCode   = shaderString.c_str();
+        // Read in the shader and compile it.
+        return compileShaderFromSource (tygra::stringFromFile (fileLocation), shader);
+    }
+
+
+    GLuint compileShaderFromSource (const std::string& source, const GLenum shader)
+    {
+        // OpenGL requires a const char*.
+        auto shaderCode = source.c_str();
     
         // Attempt to compile the shader.
         GLuint shaderID { };
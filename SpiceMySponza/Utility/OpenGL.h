@@ -26,6 +26,13 @@ namespace util
     GLuint compileShaderFromFile (const std::string& fileLocation, const GLenum shader);
 
 
+    /// <summary> Compiles a shader from source code which has already been loaded. </summary>
+    /// <returns> Returns the OpenGL ID of the compiled shader, 0 means an error occurred. </returns>
+    /// <param name="source"> The GLSL source code. </param>
+    /// <param name="shader"> The type of shader to compile. </param>
+    GLuint compileShaderFromSource (const std::string& source, const GLenum shader);
+
+
     /// <summary> Attaches a shader to the given program. It will also fill the shader with the attributes specified. </summary>
     /// <param name="program"> The ID of the OpenGL program to attach the shader to. </param>
     /// <param name="shader"> The ID of the OpenGL shader we will be attaching. </param>
@@ -0,0 +1,91 @@
+#pragma once
+
+#if !defined    _UTIL_PARALLEL_
+#define         _UTIL_PARALLEL_
+
+
+// STL headers.
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+
+namespace util
+{
+    /// <summary> Determines how many worker threads should be used for parallel work, always at least one. </summary>
+    inline unsigned int workerCount()
+    {
+        const auto hardware = std::thread::hardware_concurrency();
+        return hardware > 0 ? hardware : 1;
+    }
+
+
+    /// <summary>
+    /// Splits the range [0, count) into contiguous blocks and calls function (begin, end) on each block from its own thread. The calling
+    /// thread processes the first block itself. If any block throws, the first exception is rethrown once every thread has finished.
+    /// </summary>
+    /// <param name="count"> The number of items to process. </param>
+    /// <param name="function"> A callable taking a (size_t begin, size_t end) range of items. </param>
+    /// <param name="minimumBlock"> The smallest number of items worth handing to a thread. </param>
+    template <typename Function> void parallelFor (const size_t count, const Function& function, const size_t minimumBlock = 1)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        const auto blocks       = std::max<size_t> (1, std::min<size_t> (workerCount(), count / std::max<size_t> (minimumBlock, 1)));
+        const auto blockSize    = (count + blocks - 1) / blocks;
+
+        std::vector<std::thread>        threads     { };
+        std::vector<std::exception_ptr> exceptions  (blocks);
+
+        for (size_t block = 1; block < blocks; ++block)
+        {
+            const auto begin    = block * blockSize;
+            const auto end      = std::min (count, begin + blockSize);
+
+            if (begin < end)
+            {
+                threads.emplace_back ([&, block, begin, end] ()
+                {
+                    try
+                    {
+                        function (begin, end);
+                    }
+
+                    catch (...)
+                    {
+                        exceptions[block] = std::current_exception();
+                    }
+                });
+            }
+        }
+
+        try
+        {
+            function (0, std::min (count, blockSize));
+        }
+
+        catch (...)
+        {
+            exceptions[0] = std::current_exception();
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (const auto& exception : exceptions)
+        {
+            if (exception)
+            {
+                std::rethrow_exception (exception);
+            }
+        }
+    }
+}
+
+#endif // _UTIL_PARALLEL_
\ No newline at end of file
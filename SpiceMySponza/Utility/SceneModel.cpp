@@ -2,6 +2,12 @@
 
 
 
+// STL headers.
+#include <future>
+#include <unordered_set>
+
+
+
 // Engine headers.
 #include <SceneModel/Material.hpp>
 #include <SceneModel/Mesh.hpp>
@@ -10,22 +16,23 @@
 
 
 // Personal headers.
+#include <Misc/ThreadPool.h>
 #include <Misc/Vertex.h>
 
 
 
 namespace util
 {
-    void calculateVBOSize (const std::vector<SceneModel::Mesh>& meshes, size_t& vertexSize, size_t& elementSize)
+    void calculateVBOSize (const std::vector<const SceneModel::Mesh*>& meshes, size_t& vertexSize, size_t& elementSize)
     {
         // Create temporary accumlators.
         size_t vertices { 0 }, elements { 0 };  
 
         // We need to loop through each mesh adding up as we go along.
-        for (const auto& mesh : meshes)
+        for (const auto mesh : meshes)
         {
-            vertices += mesh.getPositionArray().size();
-            elements += mesh.getElementArray().size();
+            vertices += mesh->getPositionArray().size();
+            elements += mesh->getElementArray().size();
         }
 
         // Calculate the final values.
@@ -53,21 +60,68 @@ namespace util
     }
 
 
-    void loadImagesFromScene (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<SceneModel::Material>& materials)
+    size_t loadImagesFromScene (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<SceneModel::Material>& materials, ThreadPool* const pool)
+    {
+        // Each material refers to its texture by file.
+        std::vector<std::string> files { };
+        files.reserve (materials.size());
+
+        for (const auto& material : materials)
+        {
+            files.push_back (material.getAmbientMap());
+        }
+
+        return loadImagesFromFiles (images, files, pool);
+    }
+
+
+    size_t loadImagesFromFiles (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<std::string>& allFiles, ThreadPool* pool)
     {
+        // tygra can only decode a PNG from a file so reading and decoding can't be separated, instead every image is read and decoded on
+        // the pool at once and the images are collected in order as they finish. Workers decode inline to avoid waiting on themselves.
+
         // Ensure the vector is empty.
         images.clear();
 
-        for (const auto& material : materials)
+        // Materials often share a file, it only needs decoding once.
+        std::vector<std::string>        files   { };
+        std::unordered_set<std::string> seen    { };
+
+        for (const auto& file : allFiles)
         {
-            // Attempt to load each image.
-            auto filename   = material.getAmbientMap();
-            auto image      = tygra::imageFromPNG (material.getAmbientMap());
+            if (seen.insert (file).second)
+            {
+                files.push_back (file);
+            }
+        }
+
+        std::vector<std::future<tygra::Image>> decoding { };
+
+        if (pool && pool->isWorkerThread())
+        {
+            pool = nullptr;
+        }
+
+        if (pool)
+        {
+            decoding.reserve (files.size());
+
+            for (const auto& file : files)
+            {
+                decoding.push_back (pool->submit ([file] () { return tygra::imageFromPNG (file); }));
+            }
+        }
+
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            auto image = pool ? decoding[i].get() : tygra::imageFromPNG (files[i]);
 
             if (image.containsData())
             {
-                images.push_back ({ std::move (filename), std::move (image) });
+                images.push_back ({ files[i], std::move (image) });
             }
         }
+
+        return allFiles.size() - files.size();
     }
 }
\ No newline at end of file
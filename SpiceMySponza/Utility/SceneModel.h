@@ -11,6 +11,7 @@
 // Forward declarations.
 namespace SceneModel { class Material; class Mesh; }
 namespace tygra { class Image; }
+class ThreadPool;
 struct Vertex;
 
 
@@ -26,13 +27,23 @@ namespace util
     /// <param name="meshes"> A container of all meshes which will exist in a VBO. </param>
     /// <param name="vertexSize"> The calculated size that a vertex array buffer needs to be. </param>
     /// <param name="elementSize"> The calculated size that an element array buffer needs to be. </param>
-    void calculateVBOSize (const std::vector<SceneModel::Mesh>& meshes, size_t& vertexSize, size_t& elementSize);
+    void calculateVBOSize (const std::vector<const SceneModel::Mesh*>& meshes, size_t& vertexSize, size_t& elementSize);
 
 
     /// <summary> Iterates through every material in a scene and fills the given vector with image data. </summary>
+    /// <returns> How many files were skipped because an earlier material had already loaded them. </returns>
     /// <param name="images"> The vector to fill with data. This will generate filename-image pairs. </param>
     /// <param name="materials"> A container of materials to iterate through. </param>
-    void loadImagesFromScene (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<SceneModel::Material>& materials);
+    /// <param name="pool"> An optional thread pool to decode the images on in parallel. </param>
+    size_t loadImagesFromScene (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<SceneModel::Material>& materials, ThreadPool* const pool = nullptr);
+
+
+    /// <summary> Loads each of the given image files once, skipping any which can't be loaded. </summary>
+    /// <returns> How many files were skipped because they were listed more than once. </returns>
+    /// <param name="images"> The vector to fill with data. This will generate filename-image pairs. </param>
+    /// <param name="files"> The location of each image to load. </param>
+    /// <param name="pool"> An optional thread pool to decode the images on in parallel. </param>
+    size_t loadImagesFromFiles (std::vector<std::pair<std::string, tygra::Image>>& images, const std::vector<std::string>& files, ThreadPool* const pool = nullptr);
 }
 
 #endif // _UTIL_SCENE_MODEL_
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "SharedMemory.h"
+
+
+
+// STL headers.
+#include <utility>
+
+
+
+// Platform headers.
+#if defined (_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+
+namespace util
+{
+    #pragma region Constructors and destructor
+
+    SharedMemory::~SharedMemory()
+    {
+        close();
+    }
+
+
+    SharedMemory::SharedMemory (SharedMemory&& move)
+    {
+        *this = std::move (move);
+    }
+
+
+    SharedMemory& SharedMemory::operator= (SharedMemory&& move)
+    {
+        if (this != &move)
+        {
+            close();
+
+            m_data          = move.m_data;
+            m_size          = move.m_size;
+            m_owner         = move.m_owner;
+            m_name          = std::move (move.m_name);
+            m_mapping       = move.m_mapping;
+
+            // Reset primitives.
+            move.m_data     = nullptr;
+            move.m_size     = 0;
+            move.m_owner    = false;
+            move.m_mapping  = nullptr;
+        }
+
+        return *this;
+    }
+
+    #pragma endregion
+
+
+    #pragma region Public interface
+
+    #if defined (_WIN32)
+
+    bool SharedMemory::create (const std::string& name, const size_t size)
+    {
+        close();
+
+        // The paging file backs the block, it disappears once every process has closed its handle.
+        const auto platformName = "Local\\" + name;
+        const auto high         = static_cast<DWORD> (static_cast<unsigned long long> (size) >> 32);
+        const auto low          = static_cast<DWORD> (size & 0xFFFFFFFF);
+        const auto mapping      = CreateFileMappingA (INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, high, low, platformName.c_str());
+
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+
+        const auto view = MapViewOfFile (mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+        if (view == nullptr)
+        {
+            CloseHandle (mapping);
+            return false;
+        }
+
+        m_data      = static_cast<char*> (view);
+        m_size      = size;
+        m_owner     = true;
+        m_name      = platformName;
+        m_mapping   = mapping;
+
+        return true;
+    }
+
+
+    bool SharedMemory::open (const std::string& name)
+    {
+        close();
+
+        const auto platformName = "Local\\" + name;
+        const auto mapping      = OpenFileMappingA (FILE_MAP_ALL_ACCESS, FALSE, platformName.c_str());
+
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+
+        const auto view = MapViewOfFile (mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+
+        if (view == nullptr)
+        {
+            CloseHandle (mapping);
+            return false;
+        }
+
+        // The view is rounded up to whole pages but the creator decides how much of it is used.
+        MEMORY_BASIC_INFORMATION information { };
+        VirtualQuery (view, &information, sizeof (information));
+
+        m_data      = static_cast<char*> (view);
+        m_size      = static_cast<size_t> (information.RegionSize);
+        m_owner     = false;
+        m_name      = platformName;
+        m_mapping   = mapping;
+
+        return true;
+    }
+
+
+    void SharedMemory::close()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile (m_data);
+            CloseHandle (m_mapping);
+        }
+
+        m_data      = nullptr;
+        m_size      = 0;
+        m_owner     = false;
+        m_mapping   = nullptr;
+        m_name.clear();
+    }
+
+    #else
+
+    bool SharedMemory::create (const std::string& name, const size_t size)
+    {
+        close();
+
+        // A block left behind by a crashed process would have the wrong size so it's replaced.
+        const auto platformName = "/" + name;
+        shm_unlink (platformName.c_str());
+
+        const auto file = shm_open (platformName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (file < 0)
+        {
+            return false;
+        }
+
+        if (ftruncate (file, static_cast<off_t> (size)) != 0)
+        {
+            ::close (file);
+            shm_unlink (platformName.c_str());
+            return false;
+        }
+
+        const auto view = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+        // The mapping keeps its own reference to the block.
+        ::close (file);
+
+        if (view == MAP_FAILED)
+        {
+            shm_unlink (platformName.c_str());
+            return false;
+        }
+
+        m_data  = static_cast<char*> (view);
+        m_size  = size;
+        m_owner = true;
+        m_name  = platformName;
+
+        return true;
+    }
+
+
+    bool SharedMemory::open (const std::string& name)
+    {
+        close();
+
+        const auto platformName = "/" + name;
+        const auto file         = shm_open (platformName.c_str(), O_RDWR, 0600);
+
+        if (file < 0)
+        {
+            return false;
+        }
+
+        struct stat status { };
+
+        if (fstat (file, &status) != 0 || status.st_size == 0)
+        {
+            ::close (file);
+            return false;
+        }
+
+        const auto size = static_cast<size_t> (status.st_size);
+        const auto view = mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+        ::close (file);
+
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        m_data  = static_cast<char*> (view);
+        m_size  = size;
+        m_owner = false;
+        m_name  = platformName;
+
+        return true;
+    }
+
+
+    void SharedMemory::close()
+    {
+        if (m_data)
+        {
+            munmap (m_data, m_size);
+
+            if (m_owner)
+            {
+                shm_unlink (m_name.c_str());
+            }
+        }
+
+        m_data  = nullptr;
+        m_size  = 0;
+        m_owner = false;
+        m_name.clear();
+    }
+
+    #endif
+
+    #pragma endregion
+}
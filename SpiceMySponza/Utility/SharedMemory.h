@@ -0,0 +1,71 @@
+#pragma once
+
+#if !defined    _UTIL_SHARED_MEMORY_
+#define         _UTIL_SHARED_MEMORY_
+
+
+// STL headers.
+#include <string>
+
+
+namespace util
+{
+    /// <summary>
+    /// A named block of memory which several processes can map at once. Once mapped, communicating through it requires no system calls,
+    /// only the synchronisation the processes agree upon. The creator owns the name and removes it when the block is closed.
+    /// </summary>
+    class SharedMemory final
+    {
+        public:
+
+            #pragma region Constructors and destructor
+
+            SharedMemory()                                      = default;
+            ~SharedMemory();
+
+            SharedMemory (SharedMemory&& move);
+            SharedMemory& operator= (SharedMemory&& move);
+
+            SharedMemory (const SharedMemory& copy)             = delete;
+            SharedMemory& operator= (const SharedMemory& copy)  = delete;
+
+            #pragma endregion
+
+            #pragma region Public interface
+
+            /// <summary> Creates and maps a zero-filled block, replacing any stale block of the same name. </summary>
+            /// <returns> Whether the block could be created and mapped. </returns>
+            /// <param name="name"> A name without slashes which other processes use to open the block. </param>
+            /// <param name="size"> The size of the block in bytes. </param>
+            bool create (const std::string& name, const size_t size);
+
+            /// <summary> Maps a block which another process has created. </summary>
+            /// <returns> Whether the block exists and could be mapped. </returns>
+            bool open (const std::string& name);
+
+            /// <summary> Unmaps the block, removing its name if this object created it. </summary>
+            void close();
+
+            bool isOpen() const         { return m_data != nullptr; }
+            bool isOwner() const        { return m_owner; }
+            char* data() const          { return m_data; }
+            size_t size() const         { return m_size; }
+
+            #pragma endregion
+
+        private:
+
+            #pragma region Implementation data
+
+            char*       m_data      { nullptr };    //!< The start of the mapped block.
+            size_t      m_size      { 0 };          //!< The size of the block in bytes.
+            bool        m_owner     { false };      //!< Whether the block was created by this object.
+            std::string m_name      { };            //!< The platform name of the block.
+
+            void*       m_mapping   { nullptr };    //!< The native file mapping handle, only used on Windows.
+
+            #pragma endregion
+    };
+}
+
+#endif // _UTIL_SHARED_MEMORY_
@@ -0,0 +1,177 @@
+#include "Stripifier.h"
+
+
+
+// STL headers.
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+
+
+namespace
+{
+    // A small post-transform cache, GPUs have at least this many entries so the savings it shows are conservative.
+    const size_t simulatedCacheSize = 16;
+
+
+    /// <summary> Identifies the directed edge from one vertex to another. </summary>
+    std::uint64_t edgeKey (const unsigned int from, const unsigned int to)
+    {
+        return (static_cast<std::uint64_t> (from) << 32) | to;
+    }
+
+
+    /// <summary> Counts how many vertices a FIFO post-transform cache would have to shade, restart indices are skipped. </summary>
+    size_t cacheMisses (const unsigned int* const elements, const size_t count)
+    {
+        std::deque<unsigned int>    cache   { };
+        size_t                      misses  { 0 };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto element = elements[i];
+
+            if (element == util::restartIndex || std::find (cache.begin(), cache.end(), element) != cache.end())
+            {
+                continue;
+            }
+
+            ++misses;
+            cache.push_back (element);
+
+            if (cache.size() > simulatedCacheSize)
+            {
+                cache.pop_front();
+            }
+        }
+
+        return misses;
+    }
+}
+
+
+
+namespace util
+{
+    std::vector<unsigned int> stripify (const unsigned int* const elements, const size_t count, Stripification* const statistics)
+    {
+        /// Every triangle of a strip after the first shares an edge with the one before it and alternates winding, so odd triangles are
+        /// drawn as (b, a, c) rather than (a, b, c). A neighbour can only continue a strip if it holds the last edge of the strip in the
+        /// direction that parity requires, which keeps every triangle facing the way it did in the list. The first triangle of each strip
+        /// is rotated so its last edge leads to an unused neighbour where one exists. Index memory and vertex fetches only fall if the
+        /// triangles share edges, so the result is thrown away unless it's smaller than the list.
+        const auto triangleCount = count / 3;
+
+        // Map each directed edge to the triangle which holds it, non-manifold edges keep the first.
+        std::unordered_map<std::uint64_t, size_t> edges { };
+        edges.reserve (count);
+
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            const auto v = elements + t * 3;
+
+            edges.emplace (edgeKey (v[0], v[1]), t);
+            edges.emplace (edgeKey (v[1], v[2]), t);
+            edges.emplace (edgeKey (v[2], v[0]), t);
+        }
+
+        // Finds the unused triangle holding the given directed edge and the vertex opposite it, the vertex is restartIndex if there's none.
+        std::vector<char> used (triangleCount, 0);
+
+        const auto across = [&] (const unsigned int from, const unsigned int to, size_t& triangle) -> unsigned int
+        {
+            const auto edge = edges.find (edgeKey (from, to));
+
+            if (edge == edges.end() || used[edge->second])
+            {
+                return restartIndex;
+            }
+
+            triangle = edge->second;
+            const auto v = elements + triangle * 3;
+
+            return v[0] != from && v[0] != to ? v[0] : v[1] != from && v[1] != to ? v[1] : v[2];
+        };
+
+        std::vector<unsigned int> strips { };
+        strips.reserve (count);
+
+        for (size_t start = 0; start < triangleCount; ++start)
+        {
+            if (used[start])
+            {
+                continue;
+            }
+
+            // Rotate the first triangle towards a neighbour, the second triangle of a strip is odd so it needs the edge reversed.
+            const auto  v           = elements + start * 3;
+            size_t      rotation    { 0 };
+            size_t      neighbour   { 0 };
+
+            used[start] = 1;
+
+            for (size_t r = 0; r < 3; ++r)
+            {
+                if (across (v[(r + 2) % 3], v[(r + 1) % 3], neighbour) != restartIndex)
+                {
+                    rotation = r;
+                    break;
+                }
+            }
+
+            if (!strips.empty())
+            {
+                strips.push_back (restartIndex);
+            }
+
+            const auto first = strips.size();
+
+            strips.push_back (v[rotation]);
+            strips.push_back (v[(rotation + 1) % 3]);
+            strips.push_back (v[(rotation + 2) % 3]);
+
+            // Grow the strip for as long as the last edge leads somewhere new.
+            for (;;)
+            {
+                const auto  length  = strips.size() - first;
+                const auto  a       = strips[strips.size() - 2];
+                const auto  b       = strips[strips.size() - 1];
+                size_t      next    { 0 };
+
+                const auto c = (length - 2) % 2 == 0 ? across (a, b, next) : across (b, a, next);
+
+                if (c == restartIndex)
+                {
+                    break;
+                }
+
+                used[next] = 1;
+                strips.push_back (c);
+            }
+        }
+
+        const auto smaller = strips.size() < count;
+
+        if (statistics)
+        {
+            const auto listMisses = cacheMisses (elements, count);
+
+            ++statistics->meshCount;
+            statistics->stripCount      += smaller ? 1 : 0;
+            statistics->listIndices     += count;
+            statistics->chosenIndices   += smaller ? strips.size() : count;
+            statistics->listMisses      += listMisses;
+            statistics->chosenMisses    += smaller ? cacheMisses (strips.data(), strips.size()) : listMisses;
+        }
+
+        if (!smaller)
+        {
+            strips.clear();
+            strips.shrink_to_fit();
+        }
+
+        return strips;
+    }
+}
\ No newline at end of file
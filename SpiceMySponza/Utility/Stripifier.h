@@ -0,0 +1,44 @@
+#pragma once
+
+#if !defined    _UTIL_STRIPIFIER_
+#define         _UTIL_STRIPIFIER_
+
+
+// STL headers.
+#include <cstddef>
+#include <vector>
+
+
+namespace util
+{
+    /// <summary> The element which ends one triangle strip and starts another, it's compared before the base vertex is added. </summary>
+    const unsigned int restartIndex = 0xffffffff;
+
+
+    /// <summary>
+    /// What stripify() found, added to by every call so one instance can describe a whole scene. Cache misses are counted with a
+    /// simulated FIFO post-transform cache and stand in for how many times the vertex shader runs and its attributes are fetched.
+    /// </summary>
+    struct Stripification final
+    {
+        size_t  meshCount       { 0 };  //!< How many meshes were considered.
+        size_t  stripCount      { 0 };  //!< How many meshes became strips because they needed fewer indices than their list.
+        size_t  listIndices     { 0 };  //!< How many indices the meshes had as triangle lists.
+        size_t  chosenIndices   { 0 };  //!< How many indices the meshes have once each uses the smaller of its list and strips.
+        size_t  listMisses      { 0 };  //!< How many vertices the simulated cache shaded drawing every mesh as a list.
+        size_t  chosenMisses    { 0 };  //!< How many vertices the simulated cache shaded drawing the chosen primitives.
+    };
+
+
+    /// <summary>
+    /// Converts a triangle list into triangle strips joined by restartIndex. Strips start at the earliest unused triangle and grow across
+    /// shared edges, so the order of the list, and whatever vertex cache locality it had, is mostly kept.
+    /// </summary>
+    /// <returns> The strips, or nothing if the list needs no more indices, in which case the list should be drawn. </returns>
+    /// <param name="elements"> The triangle list, every three elements make a counter-clockwise triangle. </param>
+    /// <param name="count"> How many elements there are, a multiple of three. </param>
+    /// <param name="statistics"> An optional place to add a description of the mesh to. </param>
+    std::vector<unsigned int> stripify (const unsigned int* const elements, const size_t count, Stripification* const statistics = nullptr);
+}
+
+#endif // _UTIL_STRIPIFIER_
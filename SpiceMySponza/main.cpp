@@ -1,10 +1,21 @@
+#include <atomic>
 #include <crtdbg.h>
+#include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <string>
 
 #include <tygra/Window.hpp>
+#include <Misc/FramePacer.h>
 #include <Misc/MyController.h>
 
+static std::atomic<bool> running(true);
+
+static void stopRunning(int)
+{
+    running = false;
+}
+
 int main(int argc, char *argv[])
 {
     // enable debug memory checks
@@ -15,6 +26,65 @@ int main(int argc, char *argv[])
         auto controller = std::make_shared<MyController>();
         auto window = tygra::Window::mainWindow();
         window->setController(controller);
+        auto pacer = controller->getFramePacer();
+
+        // an optional .obj/.gltf/.glb file replaces the sponza geometry,
+        // --simulation <name> lets another process drive the instances,
+        // --server <name> serves render requests and --headless does so
+        // without opening a window, --animation <clip> replaces the clip
+        // which N plays on every instance, --virtual-textures pages
+        // textures in as they become visible, --merge-similar-textures
+        // shares a texture between images which only look the same,
+        // --depth-prepass lays down depth with a position-only stream,
+        // --strips draws meshes as triangle strips where they're smaller,
+        // --transform-cache transforms static instances once for every pass,
+        // --occlusion-queries skips large meshes whose bounds were hidden and
+        // --second-view adds a camera which B switches to, sharing the assets
+        bool headless = false;
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--simulation" && i + 1 < argc) {
+                if (!controller->connectSimulation(argv[++i])) {
+                    std::cerr << "Unable to create the simulation channel "
+                              << argv[i] << std::endl;
+                }
+            } else if (argument == "--server" && i + 1 < argc) {
+                if (!controller->startRenderServer(argv[++i])) {
+                    std::cerr << "Unable to start the render server "
+                              << argv[i] << std::endl;
+                }
+            } else if (argument == "--animation" && i + 1 < argc) {
+                if (!controller->loadAnimation(argv[++i])) {
+                    std::cerr << "Unable to load the animation clip "
+                              << argv[i] << std::endl;
+                }
+            } else if (argument == "--virtual-textures") {
+                controller->enableVirtualTexturing();
+            } else if (argument == "--merge-similar-textures") {
+                controller->enableSimilarTextureMerging();
+            } else if (argument == "--depth-prepass") {
+                controller->enableDepthPrepass();
+            } else if (argument == "--strips") {
+                controller->enableStripification();
+            } else if (argument == "--transform-cache") {
+                controller->enableTransformCache();
+            } else if (argument == "--occlusion-queries") {
+                controller->enableOcclusionQueries();
+            } else if (argument == "--second-view") {
+                controller->enableSecondView();
+            } else if (argument == "--headless") {
+                headless = true;
+            } else {
+                controller->importScene(argument);
+            }
+        }
+
+        if (headless) {
+            std::signal(SIGINT, stopRunning);
+            std::signal(SIGTERM, stopRunning);
+            controller->runHeadless(running);
+            return 0;
+        }
 
         const int window_width = 1280;
         const int window_height = 720;
@@ -24,6 +94,7 @@ int main(int argc, char *argv[])
                          number_of_samples, true)) {
             while (window->isVisible()) {
                 window->update();
+                pacer->framePresented();
             }
             window->close();
         }
@@ -0,0 +1,390 @@
+#include "Tests.h"
+
+
+// STL headers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+// Engine headers.
+#include <Misc/SceneEditor.h>
+
+
+
+namespace
+{
+    using InstanceID = SceneEditor::InstanceID;
+
+    const size_t        writerThreads       = 8;            //!< How many threads edit at once.
+    const size_t        editsPerWriter      = 60000;        //!< How many edits each thread attempts.
+    const size_t        liveTarget          = 256;          //!< Roughly how many instances each thread keeps alive.
+    const size_t        sharedSlots         = 64;           //!< How many of its instances each thread offers to the others to move.
+    const std::uint32_t meshCount           = 8;            //!< How many meshes the instances are spread over.
+    const std::uint32_t tokensPerWriter     = 1u << 20;     //!< How many tokens each thread may hand out, every token must be exact as a float.
+    const size_t        gracePeriod         = 1;            //!< The shortest grace period so IDs are reused as soon as the editor allows.
+    const size_t        notRemoved          = std::numeric_limits<size_t>::max();
+
+
+    /// <summary>
+    /// Every add is given a unique token which is stored as its material and as the first float of every transform written to it. The
+    /// second and third floats name the thread and edit which wrote the transform, so an edit which lands on the wrong instance is
+    /// caught by the token no longer matching the material and can be traced back to the edit responsible.
+    /// </summary>
+    void encode (float* transform, const std::uint32_t token, const size_t thread, const size_t edit)
+    {
+        std::fill (transform, transform + 16, 0.f);
+        transform[0]    = static_cast<float> (token);
+        transform[1]    = static_cast<float> (thread);
+        transform[2]    = static_cast<float> (edit);
+        transform[15]   = 1.f;
+    }
+
+
+    std::uint32_t nextRandom (std::uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+
+    /// <summary> An instance owned by a thread, only the owner removes it. </summary>
+    struct Owned final
+    {
+        InstanceID      id;     //!< The ID the editor gave the instance.
+        std::uint32_t   token;  //!< The token it was added with.
+    };
+
+
+    /// <summary> An instance whose transform doesn't carry its own token, recorded when an apply is checked. </summary>
+    struct Misplaced final
+    {
+        std::uint32_t   victim; //!< The token of the instance which received the edit.
+        std::uint32_t   target; //!< The token the edit was meant for.
+        size_t          thread; //!< The thread which published the edit.
+        size_t          edit;   //!< Which of its edits it was.
+    };
+
+
+    /// <summary> The state of one editing thread, written by that thread and read by the checks once every thread has joined. </summary>
+    struct WriterState final
+    {
+        std::vector<Owned>                              live            { };    //!< The instances the thread has added and not removed.
+        std::unique_ptr<std::atomic<std::uint64_t>[]>   shared          { };    //!< Instances the other threads may move, the ID then token, zero when empty.
+        std::vector<size_t>                             moveReturned    { };    //!< How many applies had finished when each move returned.
+        std::vector<size_t>                             removeStarted   { };    //!< How many applies had finished before each token's removal was published.
+        size_t                                          reused          { 0 };  //!< How many adds were given an ID which had been removed before.
+        size_t                                          refused         { 0 };  //!< How many edits were refused because the ring was full.
+    };
+
+
+    std::uint64_t pack (const Owned& owned)
+    {
+        return (static_cast<std::uint64_t> (owned.id) << 32) | owned.token;
+    }
+
+
+    void edit (SceneEditor& editor, WriterState* const writers, const size_t thread, const std::atomic<size_t>& applies, std::atomic<size_t>& finished)
+    {
+        auto    writer      = editor.createWriter();
+        auto&   state       = writers[thread];
+        auto    random      = static_cast<std::uint32_t> (thread * 7919 + 1);
+        auto    nextToken   = std::uint32_t { 0 };
+        auto    seen        = std::set<InstanceID> { };
+        float   transform[16];
+
+        for (size_t i = 1; writer && i <= editsPerWriter; ++i)
+        {
+            // Give the render thread a chance to apply so edits race every stage of reclamation, not just the first.
+            if (i % 32 == 0)
+            {
+                std::this_thread::yield();
+            }
+
+            const auto roll = nextRandom (random) % 100;
+
+            // Add whilst below the target, remove whilst above it and otherwise move instances around.
+            if (state.live.empty() || (roll < 35 && state.live.size() < liveTarget * 2))
+            {
+                const auto token = static_cast<std::uint32_t> (thread * tokensPerWriter + ++nextToken);
+                encode (transform, token, thread, 0);
+
+                const auto id = writer->addInstance (token % meshCount, static_cast<std::int32_t> (token), transform);
+
+                if (id == SceneEditor::invalidInstance)
+                {
+                    ++state.refused;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                state.reused += seen.insert (id).second ? 0 : 1;
+                state.live.push_back ({ id, token });
+                state.shared[token % sharedSlots].store (pack (state.live.back()));
+            }
+
+            else if (roll < 55 || (roll < 70 && state.live.size() > liveTarget))
+            {
+                // The instance is only withdrawn from the other threads after its removal is published, so their moves race it.
+                const auto  index   = nextRandom (random) % state.live.size();
+                const auto  owned   = state.live[index];
+                const auto  started = applies.load();
+
+                if (!writer->removeInstance (owned.id))
+                {
+                    ++state.refused;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                auto offered = pack (owned);
+                state.shared[owned.token % sharedSlots].compare_exchange_strong (offered, 0);
+
+                state.removeStarted[owned.token - thread * tokensPerWriter] = started;
+                state.live[index] = state.live.back();
+                state.live.pop_back();
+            }
+
+            else if (roll < 80)
+            {
+                const auto owned = state.live[nextRandom (random) % state.live.size()];
+                encode (transform, owned.token, thread, i);
+
+                if (!writer->moveInstance (owned.id, transform))
+                {
+                    ++state.refused;
+                }
+
+                state.moveReturned[i] = applies.load();
+            }
+
+            else
+            {
+                // Move an instance of another thread, which may be removing it at the same time.
+                const auto other    = (thread + 1 + nextRandom (random) % (writerThreads - 1)) % writerThreads;
+                const auto offered  = writers[other].shared[nextRandom (random) % sharedSlots].load();
+
+                if (offered == 0)
+                {
+                    continue;
+                }
+
+                const auto id       = static_cast<InstanceID> (offered >> 32);
+                const auto token    = static_cast<std::uint32_t> (offered);
+                encode (transform, token, thread, i);
+
+                if (!writer->moveInstance (id, transform))
+                {
+                    ++state.refused;
+                }
+
+                state.moveReturned[i] = applies.load();
+            }
+        }
+
+        tests::check (writer != nullptr, "every stress thread gets a writer");
+        ++finished;
+    }
+
+
+    /// <summary> Checks the arrays of every mesh after an apply and records any instance carrying another instance's transform. </summary>
+    void checkApply (const SceneEditor& editor, std::vector<Misplaced>& misplaced, std::set<std::pair<size_t, size_t>>& recorded, size_t& failures)
+    {
+        auto    ids     = std::vector<InstanceID> { };
+        size_t  count   { 0 };
+
+        for (const auto& pair : editor.getMeshes())
+        {
+            const auto& instances   = *pair.second;
+            const auto  size        = instances.materials.size();
+
+            if (size == 0 || instances.ids.size() != size || instances.transforms.size() != size * 16 || instances.dirty.size() * 64 < size)
+            {
+                ++failures;
+                continue;
+            }
+
+            for (size_t slot = 0; slot < size; ++slot)
+            {
+                const auto token    = static_cast<std::uint32_t> (instances.materials[slot]);
+                const auto written  = instances.transforms.data() + slot * 16;
+                const auto target   = static_cast<std::uint32_t> (written[0]);
+
+                if (token % meshCount != pair.first)
+                {
+                    ++failures;
+                }
+
+                if (target != token)
+                {
+                    const auto thread   = static_cast<size_t> (written[1]);
+                    const auto edit     = static_cast<size_t> (written[2]);
+
+                    if (recorded.insert (std::make_pair (thread, edit)).second)
+                    {
+                        Misplaced entry;
+                        entry.victim    = token;
+                        entry.target    = target;
+                        entry.thread    = thread;
+                        entry.edit      = edit;
+                        misplaced.push_back (entry);
+                    }
+                }
+            }
+
+            ids.insert (ids.end(), instances.ids.begin(), instances.ids.end());
+            count += size;
+        }
+
+        std::sort (ids.begin(), ids.end());
+
+        if (count != editor.getInstanceCount() || std::adjacent_find (ids.begin(), ids.end()) != ids.end())
+        {
+            ++failures;
+        }
+    }
+}
+
+
+namespace tests
+{
+    void runSceneEditorStress()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        SceneEditor editor { gracePeriod };
+
+        auto writers = std::unique_ptr<WriterState[]> (new WriterState[writerThreads]);
+
+        for (size_t i = 0; i < writerThreads; ++i)
+        {
+            auto& state = writers[i];
+            state.shared.reset (new std::atomic<std::uint64_t>[sharedSlots]);
+            state.moveReturned.resize (editsPerWriter + 1, 0);
+            state.removeStarted.resize (tokensPerWriter + 1, notRemoved);
+
+            for (size_t j = 0; j < sharedSlots; ++j)
+            {
+                state.shared[j].store (0);
+            }
+        }
+
+        std::atomic<size_t> applies     { 0 };
+        std::atomic<size_t> finished    { 0 };
+
+        auto misplaced      = std::vector<Misplaced> { };
+        auto recorded       = std::set<std::pair<size_t, size_t>> { };
+        auto inconsistent   = size_t { 0 };
+        auto threads        = std::vector<std::thread> { };
+        const auto start    = Clock::now();
+
+        for (size_t i = 0; i < writerThreads; ++i)
+        {
+            threads.emplace_back (edit, std::ref (editor), writers.get(), i, std::cref (applies), std::ref (finished));
+        }
+
+        // Keep applying like the render thread would, then long enough after the writers stop for every ID to be reclaimed.
+        auto drained = size_t { 0 };
+
+        while (drained <= gracePeriod + 1)
+        {
+            drained = finished == writerThreads ? drained + 1 : 0;
+
+            editor.apply();
+            ++applies;
+
+            checkApply (editor, misplaced, recorded, inconsistent);
+            std::this_thread::yield();
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        const auto seconds = std::chrono::duration<double> (Clock::now() - start).count();
+
+        // A move which returned before the owner started removing its target was in a ring before the removal was applied, so the
+        // epochs must have kept the ID from being reused until it was drained. Later moves used an ID after it was removed, which the
+        // editor doesn't protect against, so they're only counted.
+        size_t lateMoves    { 0 };
+        size_t reusedMoves  { 0 };
+
+        for (const auto& entry : misplaced)
+        {
+            const auto  owner   = (entry.target - 1) / tokensPerWriter;
+            const auto  removed = owner < writerThreads ? writers[owner].removeStarted[entry.target - owner * tokensPerWriter] : 0;
+            const auto  moved   = entry.thread < writerThreads && entry.edit <= editsPerWriter ? writers[entry.thread].moveReturned[entry.edit] : 0;
+
+            if (removed != notRemoved && moved > removed)
+            {
+                ++lateMoves;
+            }
+
+            else if (++reusedMoves <= 8)
+            {
+                std::cerr << "    token " << entry.target << " moved by thread " << entry.thread << " edit " << entry.edit
+                          << " landed on token " << entry.victim << std::endl;
+            }
+        }
+
+        check (reusedMoves == 0, "a move published before its instance was removed never lands on the instance which reused the ID");
+
+        check (inconsistent == 0, "every apply leaves the mesh arrays packed, in the right mesh and with unique IDs");
+
+        // Once everything is drained the editor must hold exactly the instances the threads believe are alive.
+        auto expected       = std::unordered_map<InstanceID, std::uint32_t> { };
+        auto perMesh        = std::vector<size_t> (meshCount, 0);
+        size_t reused       { 0 };
+        size_t refused      { 0 };
+
+        for (size_t i = 0; i < writerThreads; ++i)
+        {
+            const auto& state = writers[i];
+
+            for (const auto& owned : state.live)
+            {
+                expected[owned.id] = owned.token;
+                ++perMesh[owned.token % meshCount];
+            }
+
+            reused  += state.reused;
+            refused += state.refused;
+        }
+
+        auto matching = editor.getInstanceCount() == expected.size();
+
+        for (const auto& pair : editor.getMeshes())
+        {
+            const auto& instances = *pair.second;
+            matching = matching && pair.first < meshCount && instances.materials.size() == perMesh[pair.first];
+
+            for (size_t slot = 0; matching && slot < instances.ids.size(); ++slot)
+            {
+                const auto found = expected.find (instances.ids[slot]);
+                matching = found != expected.end() && found->second == static_cast<std::uint32_t> (instances.materials[slot]);
+            }
+        }
+
+        const auto statistics = editor.getStatistics();
+
+        check (matching, "the editor holds exactly the instances each writer added and didn't remove, under the IDs they were given");
+        check (reused > 0 && statistics.reclaimedCount > 0, "removed IDs are reclaimed and reused through the return rings");
+
+        std::cout << "Scene editor stress: " << writerThreads << " writers, " << writerThreads * editsPerWriter << " edits attempted in "
+                  << seconds << "s over " << applies.load() << " applies, " << reused << " IDs reused, " << refused << " edits refused, "
+                  << statistics.staleCount << " stale, " << lateMoves << " moves made after a removal." << std::endl;
+        editor.printStatistics (std::cout);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "Tests.h"
+
+
+// STL headers.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+// Engine headers.
+#include <Misc/SimulationChannel.h>
+
+
+
+namespace
+{
+    const char* const   channelName         = "SpiceMySponzaTests";     //!< The name of the shared block used by the tests.
+    const double        benchmarkSeconds    = 2.0;                      //!< How long each benchmark run pushes batches for.
+    const std::uint32_t benchmarkMeshes     = 64;                       //!< How many meshes the benchmark spreads its instances over.
+
+
+    /// <summary> Fills a batch with updates for consecutive instances, spread over the meshes. </summary>
+    void fillBatch (std::vector<SimulationChannel::InstanceUpdate>& batch, const std::uint32_t first, const std::uint32_t meshes)
+    {
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            auto&       update  = batch[i];
+            const auto  index   = first + static_cast<std::uint32_t> (i);
+
+            update.mesh         = index % meshes;
+            update.instance     = index / meshes % 1024;
+            update.material     = static_cast<std::int32_t> (index % 16);
+
+            std::fill (update.transform, update.transform + 16, 0.f);
+            update.transform[0] = update.transform[5] = update.transform[10] = update.transform[15] = 1.f;
+            update.transform[12] = static_cast<float> (index);
+        }
+    }
+
+
+    /// <summary>
+    /// Pushes full batches from a producer thread for a fixed time whilst this thread receives them, either as fast as it can or once
+    /// per frame like the renderer does, then prints what the consumer measured.
+    /// </summary>
+    void benchmark (const char* const description, const std::chrono::microseconds frame)
+    {
+        SimulationChannel consumer { };
+
+        if (!tests::check (consumer.create (channelName), "the benchmark can create its shared block"))
+        {
+            return;
+        }
+
+        std::atomic<bool>   running { true };
+        std::atomic<size_t> pushed  { 0 };
+
+        std::thread producer ([&] ()
+        {
+            SimulationChannel channel { };
+
+            if (!tests::check (channel.connect (channelName), "the benchmark producer can connect to the shared block"))
+            {
+                return;
+            }
+
+            auto            batch   = std::vector<SimulationChannel::InstanceUpdate> (channel.getCapacities().batchUpdates);
+            std::uint32_t   first   { 0 };
+
+            while (running)
+            {
+                fillBatch (batch, first, benchmarkMeshes);
+
+                if (channel.push (batch.data(), batch.size()))
+                {
+                    first += static_cast<std::uint32_t> (batch.size());
+                    ++pushed;
+                }
+
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        using Clock = std::chrono::steady_clock;
+
+        const auto start = Clock::now();
+        consumer.resetStatistics();
+
+        while (Clock::now() - start < std::chrono::duration<double> (benchmarkSeconds))
+        {
+            consumer.receive();
+
+            if (frame.count() > 0)
+            {
+                std::this_thread::sleep_for (frame);
+            }
+
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        running = false;
+        producer.join();
+        consumer.receive();
+
+        const auto statistics = consumer.getStatistics();
+
+        tests::check (statistics.batchCount == pushed, "the consumer receives every batch the producer pushed");
+        tests::check (statistics.malformedCount == 0, "well-formed batches are never discarded");
+
+        std::cout << "Simulation channel, " << description << ":" << std::endl;
+        std::cout << "    " << statistics.updatesPerSecond() << " updates/s in " << statistics.batchCount << " batches of "
+                  << consumer.getCapacities().batchUpdates << ", " << statistics.rejectedCount << " batches rejected" << std::endl;
+        std::cout << "    latency " << statistics.averageLatency() << "ms average, " << statistics.maxLatency << "ms max" << std::endl;
+    }
+}
+
+
+namespace tests
+{
+    void runSimulationTests()
+    {
+        SimulationChannel::Capacities capacities { };
+        capacities.meshes = 4;
+
+        SimulationChannel consumer { }, producer { };
+
+        if (!check (consumer.create (channelName, capacities) && producer.connect (channelName), "the channel can be created and connected to"))
+        {
+            return;
+        }
+
+        check (producer.getCapacities().meshes == 4, "the producer agrees on the capacities the block was created with");
+
+        // Two batches so the meshes of the first already exist when the second names new ones.
+        auto batch = std::vector<SimulationChannel::InstanceUpdate> (8);
+        fillBatch (batch, 0, 4);
+        producer.push (batch.data(), batch.size());
+
+        fillBatch (batch, 0, 8);
+        batch[0].instance = capacities.snapshotUpdates;
+        producer.push (batch.data(), batch.size());
+
+        consumer.receive();
+
+        const auto statistics = consumer.getStatistics();
+
+        check (consumer.getMeshes().size() == 4, "updates never create more meshes than the capacities allow");
+        check (statistics.malformedCount == 5, "updates naming an instance or mesh beyond the capacities are counted as malformed");
+
+        std::cout << "Simulation channel tests finished." << std::endl;
+    }
+
+
+    void runSimulationBenchmark()
+    {
+        benchmark ("receiving as fast as possible", std::chrono::microseconds (0));
+        benchmark ("receiving once per 60 Hz frame", std::chrono::microseconds (16667));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,336 @@
+#include "Tests.h"
+
+
+// STL headers.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// Engine headers.
+#include <Misc/AsyncFileReader.h>
+#include <Misc/Task.h>
+#include <Misc/ThreadPool.h>
+
+
+
+namespace
+{
+    const size_t    benchmarkFileCount  = 64;               //!< How many files the loader benchmark reads.
+    const size_t    benchmarkFileSize   = 1024 * 1024;      //!< The size of each benchmark file in bytes.
+    const size_t    decodePasses        = 8;                //!< How many times the stand-in decoder walks each file, roughly the cost of decoding a PNG.
+
+
+    /// <summary> Runs the function and reports whether it threw the given exception type. </summary>
+    template <typename Exception, typename Function> bool throws (Function function)
+    {
+        try
+        {
+            function();
+        }
+
+        catch (const Exception&)
+        {
+            return true;
+        }
+
+        catch (...)
+        {
+        }
+
+        return false;
+    }
+
+
+    /// <summary> Runs the function and gets the message of the exception it threw, or an empty string when it didn't throw. </summary>
+    template <typename Function> std::string errorMessage (Function function)
+    {
+        try
+        {
+            function();
+        }
+
+        catch (const std::exception& error)
+        {
+            return error.what();
+        }
+
+        return { };
+    }
+
+
+    /// <summary> A CPU-bound stand-in for decoding a file, hashing it several times so the work is comparable to reading it. </summary>
+    uint64_t decode (const std::vector<char>& contents)
+    {
+        auto hash = uint64_t { 14695981039346656037ull };
+
+        for (size_t pass = 0; pass < decodePasses; ++pass)
+        {
+            for (const auto byte : contents)
+            {
+                hash = (hash ^ static_cast<unsigned char> (byte)) * 1099511628211ull;
+            }
+        }
+
+        return hash;
+    }
+
+
+    /// <summary> Reads a whole file on the calling thread. </summary>
+    std::vector<char> readFile (const std::string& file)
+    {
+        std::ifstream stream { file, std::ios::binary | std::ios::ate };
+
+        if (!stream)
+        {
+            throw std::runtime_error ("unable to read " + file);
+        }
+
+        auto contents = std::vector<char> (static_cast<size_t> (stream.tellg()));
+        stream.seekg (0);
+        stream.read (contents.data(), contents.size());
+
+        return contents;
+    }
+
+
+    void testValues (ThreadPool& pool)
+    {
+        auto text = util::startTask (pool, [] () { return 2; })
+            .then (pool, [] (int& value) { return value * 3; })
+            .then (InlineExecutor::get(), [] (int& value) { return std::to_string (value); });
+
+        tests::check (text.get() == "6", "each stage of a chain receives the value of the previous stage");
+
+        auto ran        = std::make_shared<std::atomic<int>> (0);
+        auto finished   = util::startTask (pool, [=] () { ++*ran; })
+            .then (pool, [=] () { ++*ran; return 1; });
+
+        tests::check (finished.get() == 1 && *ran == 2, "void stages run in order and pass nothing along");
+
+        auto pending = Task<int>::pending();
+        tests::check (!pending.isReady(), "a pending task isn't ready until a value is set");
+        pending.setValue (7);
+        tests::check (pending.isReady() && pending.get() == 7, "a pending task provides the value it was given");
+    }
+
+
+    void testErrors (ThreadPool& pool)
+    {
+        auto skipped = std::make_shared<std::atomic<bool>> (false);
+
+        auto failing = util::startTask (pool, [] () -> int { throw std::runtime_error ("decode failed"); });
+        auto later   = failing.then (pool, [=] (int& value) { *skipped = true; return value; });
+
+        tests::check (errorMessage ([&] () { failing.get(); }) == "decode failed", "get() rethrows the exception thrown by a stage");
+        tests::check (errorMessage ([&] () { later.get(); }) == "decode failed", "get() rethrows an earlier stage's exception at the end of a chain");
+        tests::check (!*skipped, "stages after a failure don't run");
+
+        auto failingVoid = util::startTask (pool, [] () { throw std::logic_error ("upload failed"); });
+        tests::check (throws<std::logic_error> ([&] () { failingVoid.get(); }), "get() rethrows the exception type of a void stage");
+
+        auto pending = Task<void>::pending();
+        pending.setError (std::make_exception_ptr (std::runtime_error ("set by hand")));
+        tests::check (errorMessage ([&] () { pending.get(); }) == "set by hand", "get() rethrows an error set on a pending task");
+    }
+
+
+    void testCancellation (ThreadPool& pool)
+    {
+        // Cancelled before the first stage is queued.
+        auto ran = std::make_shared<std::atomic<int>> (0);
+
+        CancellationToken early { };
+        early.cancel();
+
+        auto skipped = util::startTask (pool, [=] () { ++*ran; return 1; }, early);
+        tests::check (throws<TaskCancelled> ([&] () { skipped.get(); }), "a task started with a cancelled token fails with TaskCancelled");
+        tests::check (*ran == 0, "a task started with a cancelled token never runs");
+
+        // Cancelled whilst a stage is waiting on its antecedent.
+        CancellationToken waiting { };
+
+        auto gate   = Task<void>::pending (waiting);
+        auto after  = gate.then (pool, [=] () { ++*ran; return 2; });
+
+        waiting.cancel();
+        gate.setValue();
+
+        tests::check (throws<TaskCancelled> ([&] () { after.get(); }), "stages queued behind a cancelled chain fail with TaskCancelled");
+        tests::check (*ran == 0, "stages queued behind a cancelled chain never run");
+
+        // Cancelled whilst a stage is running, it finishes but nothing after it starts.
+        CancellationToken running { };
+
+        auto release    = std::make_shared<std::promise<void>>();
+        auto released   = release->get_future().share();
+        auto started    = std::make_shared<std::promise<void>>();
+
+        auto current    = util::startTask (pool, [=] () { started->set_value(); released.wait(); return 3; }, running);
+        auto next       = current.then (pool, [=] (int& value) { ++*ran; return value; });
+
+        started->get_future().wait();
+        running.cancel();
+        release->set_value();
+
+        tests::check (!throws<TaskCancelled> ([&] () { current.get(); }) && current.get() == 3, "a running stage finishes when its chain is cancelled");
+        tests::check (throws<TaskCancelled> ([&] () { next.get(); }), "the stage after a cancelled running stage fails with TaskCancelled");
+        tests::check (*ran == 0, "the stage after a cancelled running stage never runs");
+    }
+
+
+    void testWhenAll (ThreadPool& pool)
+    {
+        auto values = std::vector<Task<int>> { };
+
+        for (int i = 0; i < 16; ++i)
+        {
+            values.push_back (util::startTask (pool, [=] () { return i * i; }));
+        }
+
+        auto gathered   = util::whenAll (values).get();
+        auto ordered    = gathered.size() == 16;
+
+        for (size_t i = 0; ordered && i < gathered.size(); ++i)
+        {
+            ordered = gathered[i] == static_cast<int> (i * i);
+        }
+
+        tests::check (ordered, "whenAll provides every value in the order of its tasks");
+        tests::check (util::whenAll (std::vector<Task<int>> { }).get().empty(), "whenAll of no tasks completes straight away with no values");
+
+        // The third task fails first but the error of the earliest failing task in the list is the one reported.
+        auto release    = std::make_shared<std::promise<void>>();
+        auto released   = release->get_future().share();
+
+        auto failures = std::vector<Task<int>>
+        {
+            util::startTask (pool, [] () { return 1; }),
+            util::startTask (pool, [=] () -> int { released.wait(); throw std::logic_error ("second"); }),
+            util::startTask (pool, [] () -> int { throw std::runtime_error ("third"); }),
+        };
+
+        auto combined = util::whenAll (failures);
+        failures[2].wait();
+        release->set_value();
+
+        tests::check (errorMessage ([&] () { combined.get(); }) == "second", "whenAll fails with the error of the earliest failing task");
+
+        auto cancelled = std::vector<Task<int>> { util::startTask (pool, [] () { return 1; }) };
+        CancellationToken token { };
+        token.cancel();
+        auto gate = Task<int>::pending (token);
+        cancelled.push_back (gate.then (pool, [] (int& value) { return value; }));
+        gate.setValue (2);
+
+        tests::check (throws<TaskCancelled> ([&] () { util::whenAll (cancelled).get(); }), "whenAll fails when one of its tasks was cancelled");
+    }
+
+
+    void testFileReader (const std::shared_ptr<ThreadPool>& pool)
+    {
+        AsyncFileReader reader { pool };
+
+        auto missing = reader.readTask ("this file does not exist.bin");
+        tests::check (throws<std::runtime_error> ([&] () { missing.get(); }), "reading a missing file fails the task instead of providing no data");
+
+        auto skipped = std::make_shared<std::atomic<bool>> (false);
+        auto decoded = missing.then (*pool, [=] (std::vector<char>& contents) { *skipped = true; return decode (contents); });
+        tests::check (throws<std::runtime_error> ([&] () { decoded.get(); }) && !*skipped, "a failed read skips the decode stage");
+
+        reader.wait();
+    }
+}
+
+
+namespace tests
+{
+    void runTaskTests()
+    {
+        auto pool = std::make_shared<ThreadPool> (4);
+
+        testValues (*pool);
+        testErrors (*pool);
+        testCancellation (*pool);
+        testWhenAll (*pool);
+        testFileReader (pool);
+
+        std::cout << "Task tests finished." << std::endl;
+    }
+
+
+    void runLoaderBenchmark()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Files of noise so the hash can't be shortcut.
+        auto files = std::vector<std::string> { };
+        auto noise = uint32_t { 2463534242u };
+
+        for (size_t i = 0; i < benchmarkFileCount; ++i)
+        {
+            auto contents = std::vector<char> (benchmarkFileSize);
+
+            for (auto& byte : contents)
+            {
+                noise ^= noise << 13;
+                noise ^= noise >> 17;
+                noise ^= noise << 5;
+                byte = static_cast<char> (noise);
+            }
+
+            files.push_back ("loader_benchmark_" + std::to_string (i) + ".bin");
+            std::ofstream (files.back(), std::ios::binary).write (contents.data(), contents.size());
+        }
+
+        // One after another on this thread, like loading the scene before the loader became asynchronous.
+        const auto sequentialStart = Clock::now();
+
+        auto sequential = std::vector<uint64_t> { };
+
+        for (const auto& file : files)
+        {
+            sequential.push_back (decode (readFile (file)));
+        }
+
+        const auto sequentialTime = std::chrono::duration<double, std::milli> (Clock::now() - sequentialStart).count();
+
+        // Reads through the asynchronous reader with each decode chained on to its read.
+        const auto threadedStart = Clock::now();
+
+        auto pool   = std::make_shared<ThreadPool>();
+        auto reader = std::unique_ptr<AsyncFileReader> (new AsyncFileReader (pool));
+        auto tasks  = std::vector<Task<uint64_t>> { };
+
+        for (const auto& file : files)
+        {
+            tasks.push_back (reader->readTask (file).then (*pool, [] (std::vector<char>& contents) { return decode (contents); }));
+        }
+
+        auto threaded = util::whenAll (tasks).get();
+
+        const auto threadedTime = std::chrono::duration<double, std::milli> (Clock::now() - threadedStart).count();
+
+        reader.reset();
+
+        for (const auto& file : files)
+        {
+            std::remove (file.c_str());
+        }
+
+        check (threaded == sequential, "the threaded loader decodes the same contents as the sequential one");
+
+        std::cout << "Loading " << benchmarkFileCount << " files of " << benchmarkFileSize / 1024 << " KiB:" << std::endl;
+        std::cout << "    sequential: " << sequentialTime << " ms" << std::endl;
+        std::cout << "    threaded:   " << threadedTime << " ms on " << pool->getWorkerCount() << " workers" << std::endl;
+        std::cout << "    speedup:    " << (threadedTime > 0.0 ? sequentialTime / threadedTime : 0.0) << "x" << std::endl;
+    }
+}
\ No newline at end of file
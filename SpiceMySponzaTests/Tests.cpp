@@ -0,0 +1,34 @@
+#include "Tests.h"
+
+
+// STL headers.
+#include <atomic>
+#include <iostream>
+
+
+
+namespace
+{
+    std::atomic<size_t> failures { 0 }; //!< How many checks have failed, tests may run checks from worker threads.
+}
+
+
+namespace tests
+{
+    bool check (const bool condition, const char* const description)
+    {
+        if (!condition)
+        {
+            ++failures;
+            std::cerr << "FAILED: " << description << std::endl;
+        }
+
+        return condition;
+    }
+
+
+    size_t getFailureCount()
+    {
+        return failures;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#if !defined    _TESTS_
+#define         _TESTS_
+
+
+// STL headers.
+#include <cstddef>
+
+
+/// <summary>
+/// The checks shared by every test in the project. A failed check is reported and counted rather than stopping the run so one
+/// broken system doesn't hide the state of the others.
+/// </summary>
+namespace tests
+{
+    /// <summary> Records the outcome of an expectation, printing the description when it failed. </summary>
+    /// <returns> The condition, so a test can stop early when later checks depend on it. </returns>
+    bool check (const bool condition, const char* const description);
+
+    /// <summary> Gets how many checks have failed so far. </summary>
+    size_t getFailureCount();
+
+    /// <summary> Checks that tasks pass values along, reach get() with their errors, honour cancellation and combine with whenAll. </summary>
+    void runTaskTests();
+
+    /// <summary> Has several threads add, move and remove instances whilst the scene editor applies, checking reclamation never lets an edit land on a reused ID. </summary>
+    void runSceneEditorStress();
+
+    /// <summary> Checks the simulation channel discards updates which name instances or meshes beyond its capacities. </summary>
+    void runSimulationTests();
+
+    /// <summary> Times loading a set of files through the thread pool and task chains against reading them one after another. </summary>
+    void runLoaderBenchmark();
+
+    /// <summary> Pushes batches through the simulation channel from a producer thread, printing the throughput and latency the consumer measured. </summary>
+    void runSimulationBenchmark();
+}
+
+#endif // _TESTS_
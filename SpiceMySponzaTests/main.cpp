@@ -0,0 +1,94 @@
+#include "Tests.h"
+
+
+// STL headers.
+#include <exception>
+#include <iostream>
+#include <string>
+
+
+
+/// <summary>
+/// Runs the tests of every system which doesn't need a window or GL context, then the benchmarks when asked.
+///     --tasks             Only runs the task tests.
+///     --editor            Only runs the scene editor stress test.
+///     --simulation        Only runs the simulation channel tests.
+///     --benchmark         Also times the loader and the simulation channel.
+/// </summary>
+/// <returns> The number of failed checks so the project can gate a build. </returns>
+int main (int argc, char* argv[])
+{
+    auto runAll         = true;
+    auto runTasks       = false;
+    auto runEditor      = false;
+    auto runSimulation  = false;
+    auto runBenchmarks  = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--tasks")
+        {
+            runAll      = false;
+            runTasks    = true;
+        }
+
+        else if (argument == "--editor")
+        {
+            runAll      = false;
+            runEditor   = true;
+        }
+
+        else if (argument == "--simulation")
+        {
+            runAll          = false;
+            runSimulation   = true;
+        }
+
+        else if (argument == "--benchmark")
+        {
+            runBenchmarks = true;
+        }
+
+        else
+        {
+            std::cerr << "Unknown argument " << argument << std::endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        if (runAll || runTasks)
+        {
+            tests::runTaskTests();
+        }
+
+        if (runAll || runEditor)
+        {
+            tests::runSceneEditorStress();
+        }
+
+        if (runAll || runSimulation)
+        {
+            tests::runSimulationTests();
+        }
+
+        if (runBenchmarks)
+        {
+            tests::runLoaderBenchmark();
+            tests::runSimulationBenchmark();
+        }
+    }
+
+    catch (const std::exception& error)
+    {
+        tests::check (false, error.what());
+    }
+
+    const auto failures = tests::getFailureCount();
+    std::cout << (failures == 0 ? "All checks passed." : std::to_string (failures) + " checks failed.") << std::endl;
+
+    return static_cast<int> (failures);
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 330
+
+
+layout (location = 0)   in      vec3    position;       //!< The local position of the current vertex.
+layout (location = 1)   in      vec3    normal;         //!< The local normal vector of the current vertex.
+layout (location = 2)   in      vec2    textureCoord;   //!< The texture co-ordinates for the vertex.
+
+layout (location = 3)   in      mat4    model;          //!< The model transform representing the position and rotation of the object in world space.
+
+uniform                         int     firstInstance = 0;  //!< Where the instances of this draw start amongst every cached instance.
+
+
+                        out     vec3    cachedPosition;     //!< The world position, captured by transform feedback.
+                        out     vec3    cachedNormal;       //!< The world normal, captured by transform feedback.
+                        out     vec2    cachedTextureCoord; //!< The texture co-ordinate, passed straight through.
+flat                    out     int     cachedInstance;     //!< Which cached instance the vertex belongs to, used to fetch its material.
+
+
+/// Transforms a vertex into world space as sponza_vs.glsl does, static instances have no prefab transform to apply.
+void main()
+{
+    cachedPosition      = mat4x3 (model) * vec4 (position, 1.0);
+    cachedNormal        = mat3 (model) * normal;
+    cachedTextureCoord  = textureCoord;
+    cachedInstance      = firstInstance + gl_InstanceID;
+}
@@ -0,0 +1,7 @@
+#version 330
+
+
+/// Only the depth matters, colour writes are masked off for the pre-pass and the boxes of occlusion queries.
+void main()
+{
+}
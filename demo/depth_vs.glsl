@@ -0,0 +1,32 @@
+#version 330
+
+
+/// The uniform buffer scene specific information, only the transforms are needed.
+layout (std140) uniform scene
+{
+    mat4    projection;         //!< The projection transform which establishes the perspective of the vertex.
+    mat4    view;               //!< The view transform representing where the camera is looking.
+
+    vec3    cameraPosition;     //!< Contains the position of the camera in world space.
+    vec3    ambience;           //!< The ambient lighting in the scene.
+};
+
+
+layout (location = 0)   in      vec3    position;       //!< The local position of the current vertex, read from the tightly packed position stream.
+
+layout (location = 3)   in      mat4    model;          //!< The model transform representing the position and rotation of the object in world space.
+
+uniform                         mat4    prefabTransform = mat4 (1.0);   //!< Places the mesh within a prefab, the model transform then places the prefab.
+uniform                         bool    preTransformed  = false;        //!< Whether the position was already captured in world space, the model transform is unused.
+
+
+// The depth must match the main pass exactly for its fragments to pass the depth test.
+invariant gl_Position;
+
+
+/// Transforms the vertex exactly as sponza_vs.glsl does, nothing else is needed to lay the depth down.
+void main()
+{
+    vec3 worldPosition = preTransformed ? position : mat4x3 (model) * (prefabTransform * vec4 (position, 1.0));
+    gl_Position = projection * view * vec4 (worldPosition, 1.0);
+}
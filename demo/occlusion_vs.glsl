@@ -0,0 +1,31 @@
+#version 330
+
+
+/// The uniform buffer scene specific information, only the transforms are needed.
+layout (std140) uniform scene
+{
+    mat4    projection;         //!< The projection transform which establishes the perspective of the vertex.
+    mat4    view;               //!< The view transform representing where the camera is looking.
+
+    vec3    cameraPosition;     //!< Contains the position of the camera in world space.
+    vec3    ambience;           //!< The ambient lighting in the scene.
+};
+
+
+layout (location = 3)   in      mat4    model;          //!< The model transform of the instance whose bounding box is being tested.
+
+uniform                         vec3    boxCentre;      //!< The centre of the bounding box of the mesh in model space.
+uniform                         vec3    boxExtent;      //!< Half the size of the bounding box of the mesh in model space.
+
+
+/// Builds a corner of the bounding box from the vertex ID, fourteen vertices make the whole box as a single triangle strip.
+void main()
+{
+    // Each corner index holds whether the corner is on the positive side of the X, Y and Z axes in its first three bits.
+    const int strip[14] = int[14] (0, 1, 2, 3, 7, 1, 5, 0, 4, 2, 6, 7, 4, 5);
+
+    int corner  = strip[gl_VertexID];
+    vec3 unit   = vec3 (corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+
+    gl_Position = projection * view * vec4 (mat4x3 (model) * vec4 (boxCentre + boxExtent * unit, 1.0), 1.0);
+}
@@ -0,0 +1,17 @@
+#version 330
+
+
+        uniform samplerCube     panorama;       //!< The scene rendered in every direction from the position of the camera.
+        uniform mat4            inverseTurn;    //!< The inverse of the projection and the rotation of the view, turning device co-ordinates into directions.
+
+        in      vec2            ndcPoint;       //!< The normalised device co-ordinate of the fragment.
+
+        out     vec4            fragmentColour; //!< The colour the panorama holds in the direction of the fragment.
+
+
+/// Looks up the panorama in the direction the fragment faces, which is all a camera that only turns needs.
+void main()
+{
+    vec4 farPoint       = inverseTurn * vec4 (ndcPoint, 1.0, 1.0);
+    fragmentColour      = texture (panorama, farPoint.xyz / farPoint.w);
+}
@@ -0,0 +1,12 @@
+#version 330
+
+
+                        out     vec2    ndcPoint;   //!< The normalised device co-ordinate of the fragment, used to find its view direction.
+
+
+/// Covers the screen with a single triangle built from the vertex ID, so no vertex buffers are needed.
+void main()
+{
+    ndcPoint    = vec2 ((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+    gl_Position = vec4 (ndcPoint, 0.0, 1.0);
+}
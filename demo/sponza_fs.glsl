@@ -2,6 +2,10 @@
 
 #define MAX_LIGHTS 20
 
+#define PAGE_SIZE   128     // The width and height of a virtual texture page in texels.
+#define PAGE_BORDER 4       // The texels surrounding each page in the page cache.
+#define INFO_STRIDE 16      // The texels of texture information each virtual texture has.
+
 
 /// A structure containing information regarding to a light source in the scene. Because of the std140 layout rules of being 128-bit aligned
 /// we need to be creative and combine vec3's with an additional attribute to save memory.
@@ -19,7 +23,6 @@ struct Light
     float   aConstant;      //!< The constant co-efficient for the attenutation formula.
     float   aLinear;        //!< The linear co-efficient for the attenuation formula.
     float   aQuadratic;     //!< The quadratic co-efficient for the attenuation formula.
-    bool    emitWireframe;  //!< Determines whether the light should emit a wireframe onto surfaces.
 };
 
 
@@ -45,20 +48,40 @@ layout (std140) uniform lighting
         uniform sampler2DArray  textures;       //!< The array of textures in the scene.
         uniform samplerBuffer   materials;      //!< A texture buffer filled with the required diffuse and specular properties for the material.
         uniform isamplerBuffer  materialIDs;    //!< A buffer containing the ID of the material for the instance to fetch from the materials buffer.
+        uniform int             materialOverride = -1;  //!< The material of every instance in the draw when it isn't negative, used by prefab entries.
+
+        uniform bool            virtualTexturing = false;   //!< Whether textures are paged in to the page cache rather than held in the texture array.
+        uniform sampler2D       pageCache;      //!< Every resident page of every virtual texture, each surrounded by a border for filtering.
+        uniform usamplerBuffer  pageTable;      //!< The slot in the page cache of every page, the top bit is set for resident pages.
+        uniform isamplerBuffer  textureInfo;    //!< The size and mipmap count of each virtual texture followed by the page table layout of each mipmap.
+        uniform bool            feedbackPass = false;       //!< Whether the page each fragment needs is written instead of its colour.
+        uniform float           feedbackBias = 0.0;         //!< Corrects the mipmap chosen by the smaller feedback pass to match the window.
 
         in      vec3            worldPosition;  //!< The fragments position vector in world space.
         in      vec3            worldNormal;    //!< The fragments normal vector in world space.
-        in      vec3            baryPoint;      //!< The barycentric co-ordinate of the current fragment, useful for wireframe rendering.
         in      vec2            texturePoint;   //!< The interpolated co-ordinate to use for the texture sampler.
 flat    in      int             instanceID;     //!< Used in fetching instance-specific data from the uniforms.
 
 
-        out     vec4            fragmentColour; //!< The computed output colour of this particular pixel;
+layout (location = 0)   out     vec4    fragmentColour; //!< The computed output colour of this particular pixel;
+layout (location = 1)   out     uint    pageRequest;    //!< The virtual texture page the fragment needs, only written by the feedback pass.
 
 
 /// Updates the ambient, diffuse and specular colours from the materialTBO for this fragment.
 void obtainMaterialProperties();
 
+/// Finds the virtual texture page the fragment would sample, packed as the texture, mipmap and page co-ordinates.
+/// Returns 0xFFFFFFFF if the fragment doesn't need a page.
+uint requestPage();
+
+/// Samples a virtual texture through the page table, falling back to coarser mipmaps until a resident page is found. The derivatives
+/// are those of the texture co-ordinate, taken before any branching.
+/// Returns the colour of the texture, white if the texture has no data.
+vec3 sampleVirtualTexture (const int textureIndex, const vec2 point, const vec2 dx, const vec2 dy);
+
+/// Picks the mipmap of a virtual texture whose texels best match the footprint of the fragment.
+int virtualMipmap (const ivec4 header, const vec2 dx, const vec2 dy);
+
 /// Calculates the lighting from a given light. Q should be the world position of the surface. N should be the world normal direction of the surface.
 /// V should be the direction of the surface to the viewer.
 /// Returns the attenuated lighting calculated by the material and light properties.
@@ -84,12 +107,6 @@ float spotLightConeAttenuation (const Light light, const vec3 L);
 vec3 calculateLighting (const vec3 L, const vec3 N, const vec3 V, const vec3 colour, const float lambertian);
 
 
-/// Using interpolated barycentric co-ordinates passed through by the vertex shader this function calculates the wireframe
-/// colour of the current fragment. The base colour of the wireframe is specified with wireColour.
-/// Returns a colour intensity to represent a line on the wireframe, black if the fragment isn't part of a line.
-vec3 wireframe (const vec3 wireColour);
-
-
 // Phong reflection model: I = Ia Ka + sum[0-n] Il,n (Kd (Ln.N) + Ks pow ((Rn.V), p))
 // Ia   = Ambient scene light.
 // Ka   = Ambient map.
@@ -113,6 +130,13 @@ struct Material
 
 void main()
 {
+    // The feedback pass only needs to know which pages the fragment would sample.
+    if (feedbackPass)
+    {
+        pageRequest = requestPage();
+        return;
+    }
+
     // Ensure we're using the correct colours.
     obtainMaterialProperties();
 
@@ -144,6 +168,12 @@ int obtainMaterialID()
     /// vertex attribute. However the alternative method is used here which features a samplerBuffer object and we then obtain
     /// the correct attribute using texelFetch().
 
+    // Each entry of a prefab has one material for every instance of the prefab.
+    if (materialOverride >= 0)
+    {
+        return materialOverride;
+    }
+
     // Each instance is allocated 4-bytes of data for the material ID. We calculate the row by dividing the instance ID
     // by 4 and then the column by calculating the remainder.
     ivec4 idRow = texelFetch (materialIDs, instanceID / 4);
@@ -172,6 +202,10 @@ void obtainMaterialProperties()
     // Each material is allocated 16 bytes of data for the diffuse colour and 16 bytes for the specular colour.
     vec4 diffusePart    = texelFetch (materials, materialID);
     vec4 specularPart   = texelFetch (materials, materialID + 1);
+
+    // Derivatives are undefined once the materials of neighbouring fragments can differ, so take them now.
+    vec2 dx             = dFdx (texturePoint);
+    vec2 dy             = dFdy (texturePoint);
     
     // The RGB values of the diffuse part are the diffuse colour.
     material.diffuse    = diffusePart.rgb;
@@ -179,7 +213,7 @@ void obtainMaterialProperties()
     // The alpha of the diffuse part represents the texture to use for the ambient map. -1 == no texture.
     if (diffusePart.a >= 0.0)
     {
-        material.texture    = texture (textures, vec3 (texturePoint, diffusePart.a)).rgb;
+        material.texture    = virtualTexturing ? sampleVirtualTexture (int (diffusePart.a + 0.5), texturePoint, dx, dy) : texture (textures, vec3 (texturePoint, diffusePart.a)).rgb;
         material.ambientMap = material.texture;
     }
 
@@ -198,6 +232,76 @@ void obtainMaterialProperties()
 }
 
 
+uint requestPage()
+{
+    vec2 dx             = dFdx (texturePoint);
+    vec2 dy             = dFdy (texturePoint);
+    vec4 diffusePart    = texelFetch (materials, obtainMaterialID());
+
+    if (!virtualTexturing || diffusePart.a < 0.0)
+    {
+        return 0xFFFFFFFFu;
+    }
+
+    int     textureIndex    = int (diffusePart.a + 0.5);
+    ivec4   header          = texelFetch (textureInfo, textureIndex * INFO_STRIDE);
+
+    if (header.z == 0)
+    {
+        return 0xFFFFFFFFu;
+    }
+
+    // Find the page at the mipmap the fragment would like, whether it's resident or not.
+    int     level   = virtualMipmap (header, dx, dy);
+    ivec4   mipmap  = texelFetch (textureInfo, textureIndex * INFO_STRIDE + 1 + level);
+    vec2    size    = max (floor (vec2 (header.xy) / exp2 (float (level))), vec2 (1.0));
+    ivec2   page    = clamp (ivec2 (fract (texturePoint) * size) / PAGE_SIZE, ivec2 (0), mipmap.yz - 1);
+
+    return (uint (textureIndex) << 20) | (uint (level) << 16) | (uint (page.y) << 8) | uint (page.x);
+}
+
+
+vec3 sampleVirtualTexture (const int textureIndex, const vec2 point, const vec2 dx, const vec2 dy)
+{
+    ivec4 header = texelFetch (textureInfo, textureIndex * INFO_STRIDE);
+
+    if (header.z == 0)
+    {
+        return vec3 (1.0);
+    }
+
+    // The coarsest mipmap is always resident so the search always ends.
+    for (int level = virtualMipmap (header, dx, dy); level < header.z; ++level)
+    {
+        ivec4   mipmap  = texelFetch (textureInfo, textureIndex * INFO_STRIDE + 1 + level);
+        vec2    size    = max (floor (vec2 (header.xy) / exp2 (float (level))), vec2 (1.0));
+        vec2    texel   = fract (point) * size;
+        ivec2   page    = clamp (ivec2 (texel) / PAGE_SIZE, ivec2 (0), mipmap.yz - 1);
+        uint    entry   = texelFetch (pageTable, mipmap.x + page.y * mipmap.y + page.x).r;
+
+        if (entry >= 0x80000000u)
+        {
+            // The slot is stored as a column and row of the page cache, each slot being a page with a border on every side.
+            vec2 slot   = vec2 (float (entry & 0xFFFu), float ((entry >> 12) & 0xFFFu));
+            vec2 cached = slot * float (PAGE_SIZE + PAGE_BORDER * 2) + float (PAGE_BORDER) + texel - vec2 (page * PAGE_SIZE);
+
+            return textureLod (pageCache, cached / vec2 (textureSize (pageCache, 0)), 0.0).rgb;
+        }
+    }
+
+    return vec3 (1.0);
+}
+
+
+int virtualMipmap (const ivec4 header, const vec2 dx, const vec2 dy)
+{
+    vec2    size    = vec2 (header.xy);
+    float   lod     = 0.5 * log2 (max (max (dot (dx * size, dx * size), dot (dy * size, dy * size)), 1e-8)) + feedbackBias;
+
+    return clamp (int (floor (lod)), 0, header.z - 1);
+}
+
+
 vec3 processLight (const Light light, const vec3 Q, const vec3 N, const vec3 V)
 {
     // Prepare our accumulator.
@@ -236,23 +340,11 @@ vec3 processLight (const Light light, const vec3 Q, const vec3 N, const vec3 V)
         
         if (attenuation > 0.0)
         {		
-            // Booleans don't seem to translate to the UBO accurately.
-            if (!light.emitWireframe)
-            {
-                // Calculate the final colour of the light. 
-                vec3 attenuatedColour = light.colour * attenuation;
-
-                // Increase the lighting to apply to the current fragment.
-                lighting += calculateLighting (L, N, V, attenuatedColour, lambertian);
-            }
-
-            // Enable the wireframe view!
-            else
-            {
-                // Create the wireframe and smoothstep with the calculated attenuation. This creates a really 
-				// smooth transition between the standard Phong shading and the wireframe emissive shading!
-                lighting += wireframe (light.colour) * smoothstep (0.0, 1.0, attenuation);
-            }
+            // Calculate the final colour of the light. 
+            vec3 attenuatedColour = light.colour * attenuation;
+
+            // Increase the lighting to apply to the current fragment.
+            lighting += calculateLighting (L, N, V, attenuatedColour, lambertian);
         }
     }
 
@@ -324,24 +416,4 @@ vec3 calculateLighting (const vec3 L, const vec3 N, const vec3 V, const vec3 col
     }
 
     return colour * (diffuseLighting + specularLighting);
-}
-
-
-vec3 wireframe (const vec3 wireColour)
-{
-    /// This code is taken from a very useful blog post. Credit to Florian Boesch for such simple code.
-    /// Boesch, F. (2012) Easy wireframe display with barycentric coordinates. 
-    /// Available at: http://codeflow.org/entries/2012/aug/02/easy-wireframe-display-with-barycentric-coordinates/ (Accessed: 01/02/2015).
-
-    /// I chose to implement the wireframe in this manner because it allows me to only apply the wire colour so that the normal surface/material
-    /// colour can be used to fill in the frame. This looks really nice and allows us to smoothly interpolate between wireframe and Phong shading.
-    /// This gives the scene the appearance of the wireframe and emissive light slowly fading out.
-        
-    // Determine how much of an edge exists at the interpolated barycentric point.
-    vec3 d              = fwidth (baryPoint);
-    vec3 a3             = smoothstep (vec3 (0.0), d * 1.5, baryPoint);
-    float edgeFactor    = min (min (a3.x, a3.y), a3.z);
-
-    // Mix an intense white and black colour based on how much of an edge exists.
-    return wireColour * mix (vec3 (1.0), vec3 (0.0), edgeFactor);
 }
\ No newline at end of file
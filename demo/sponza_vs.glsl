@@ -17,64 +17,41 @@ layout (location = 1)   in      vec3    normal;         //!< The local normal ve
 layout (location = 2)   in      vec2    textureCoord;   //!< The texture co-ordinates for the vertex, used for mapping a texture to the object.
 
 layout (location = 3)   in      mat4    model;          //!< The model transform representing the position and rotation of the object in world space.
-layout (location = 7)   in      mat4    pvm;            //!< A combined matrix of the project, view and model transforms.
+layout (location = 7)   in      int     cachedInstance; //!< Which cached instance a pre-transformed vertex belongs to, after the four columns of model.
+
+uniform                         mat4    prefabTransform = mat4 (1.0);   //!< Places the mesh within a prefab, the model transform then places the prefab.
+uniform                         bool    preTransformed  = false;        //!< Whether the position and normal were already captured in world space, the model transform is unused.
 
 
                         out     vec3    worldPosition;  //!< The world position to be interpolated for the fragment shader.
                         out     vec3    worldNormal;    //!< The world normal to be interpolated for the fragment shader.
-                        out     vec3    baryPoint;      //!< The barycentric co-ordinate to be interpolated for the fragment shader.
                         out     vec2    texturePoint;   //!< The texture co-ordinate for the fragment to use for texture mapping.
 flat                    out     int     instanceID;     //!< Allows the fragment shader to fetch the correct colour data.
 
 
-/// Determines the desired barycentric co-ordinate of the vertex based on its vertex ID.
-/// Returns the barycentric co-ordinate.
-vec3 barycentric();
+// The depth pre-pass in depth_vs.glsl must produce exactly the same depth.
+invariant gl_Position;
 
 
 void main()
 {
-    // Deal with the outputs first.
-    worldPosition = mat4x3 (model) * vec4 (position, 1.0);
-    worldNormal = mat3 (model) * normal;
-
-    baryPoint = barycentric();
-    texturePoint = textureCoord;
-
-    instanceID = gl_InstanceID;
-
-    // Place the vertex in the correct position on-screen.
-    gl_Position = pvm * vec4 (position, 1.0);
-}
-
+    // Deal with the outputs first, cached vertices were transformed by capture_vs.glsl and know their instance.
+    if (preTransformed)
+    {
+        worldPosition = position;
+        worldNormal = normal;
+        instanceID = cachedInstance;
+    }
 
-vec3 barycentric()
-{
-    /// For the implementation of the wireframe toggle I chose to make it completely shader based using barycentric co-ordinates. Using the 
-    /// ID assigned to each vertex by OpenGL I can pass a barycentric co-ordinate to the fragment shader which represents each point on the triangle. 
-    /// This is interpolated by the GPU and can be used to determine if the current fragment represents part of the wireframe. We can then decide
-    /// whether to colour the fragment using Phong or colour it white to visually represent the wireframe.
-    /// 
-    /// I chose this route for multiple reasons; firstly I use the vertex ID because it has the same effect as assigning each vertex an extra
-    /// attribute for little run-time cost. This reduces memory consumption and means the GPU can process more vertices due to more bandwidth being 
-    /// available. Secondly, it is very easy to implement and although it can miss some lines, the end result is a very convincing wireframe around objects.
-    /// Thirdly, it allows me to have wireframe functionality without performing a second pass through the rendering process which performing the task
-    /// on the OpenGL side would require. Finally if I had access to the geometry shader I would manage the barycentric co-ordinates there so that I'm not
-    /// doing a division for every vertex. Unfortunately I don't so I have to use the Vertex ID instead.
-    ///
-    /// Some basic testing shows this method rendering speed by ~3% which is fairly negligible.
-
-    
-    // Unfortunately the lab GPUs require the co-ordinates be weighted in a special way for the effect to be correct.
-    // My AMD card at home works fine with (1, 0, 0), (0, 1, 0) and (0, 0, 1) and this way.
-    const float weight = 100;
-    switch (gl_VertexID % 3)
+    else
     {
-        case 0:
-            return vec3 (weight, 1, 0);
-        case 1:
-            return vec3 (0, weight, 1);
-        case 2:
-            return vec3 (1, 0, weight);
+        worldPosition = mat4x3 (model) * (prefabTransform * vec4 (position, 1.0));
+        worldNormal = mat3 (model) * (mat3 (prefabTransform) * normal);
+        instanceID = gl_InstanceID;
     }
+
+    texturePoint = textureCoord;
+
+    // Place the vertex in the correct position on-screen. Combining the transforms here means only the model matrix is streamed per instance.
+    gl_Position = projection * view * vec4 (worldPosition, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#version 330
+
+
+/// The wireframe light, it follows the camera and the wire fades out with its attenuation.
+struct Light
+{
+    vec3    position;       //!< The world position of the light in the scene.
+    int     type;           //!< The type of attenuation to use. 0 means point light, 1 means spot light and 2 means directional light.
+
+    vec3    direction;      //!< The direction of the light.
+    float   coneAngle;      //!< The angle of the light in degrees.
+
+    vec3    colour;         //!< The colour of the wire.
+    float   concentration;  //!< How concentrated spot lights are, this effects distance attenuation.
+
+    float   aConstant;      //!< The constant co-efficient for the attenutation formula.
+    float   aLinear;        //!< The linear co-efficient for the attenuation formula.
+    float   aQuadratic;     //!< The quadratic co-efficient for the attenuation formula.
+};
+
+
+        uniform Light   light;          //!< The light which decides how brightly the wire is drawn.
+
+        in      vec3    worldPosition;  //!< The fragments position vector in world space.
+        in      vec3    worldNormal;    //!< The fragments normal vector in world space.
+        in      vec3    baryPoint;      //!< The barycentric co-ordinate of the fragment within its triangle.
+
+
+layout (location = 0)   out     vec4    fragmentColour; //!< The colour added to the window, black away from edges.
+
+
+/// Calculates the attenuation of the light at the fragment in the same way sponza_fs.glsl would for a light of the same type.
+/// Returns zero if the surface faces away from the light.
+float attenuate (const vec3 Q, const vec3 N);
+
+/// Calculates how much of an edge the fragment is on using the interpolated barycentric co-ordinates.
+/// Returns 1 on an edge, fading to 0 a pixel and a half away from it.
+float edge();
+
+
+void main()
+{
+    // Fragments away from the edges or out of the light add nothing so don't bother blending them.
+    float intensity = edge() * smoothstep (0.0, 1.0, attenuate (worldPosition, normalize (worldNormal)));
+
+    if (intensity <= 0.0)
+    {
+        discard;
+    }
+
+    fragmentColour = vec4 (light.colour * intensity, 1.0);
+}
+
+
+float attenuate (const vec3 Q, const vec3 N)
+{
+    float dist      = length (light.position - Q);
+    vec3 L          = (light.position - Q) / dist;
+
+    if (dot (L, N) <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // Directional lights don't have attenuation.
+    if (light.type == 2)
+    {
+        return 1.0;
+    }
+
+    // We need to construct Ci *= 1 / (Kc + Kl * d + Kq * d * d), spot lights also narrow it to a beam.
+    float attenuation = 1.0 / (light.aConstant + light.aLinear * dist + light.aQuadratic * dist * dist);
+
+    if (light.type == 1)
+    {
+        float lightAngle    = degrees (acos (max (dot (-L, light.direction), 0)));
+        float halfAngle     = light.coneAngle / 2;
+
+        attenuation *= pow (max (dot (-light.direction, L), 0), light.concentration);
+        attenuation *= lightAngle <= halfAngle ? smoothstep (1.0, 0.75, lightAngle / halfAngle) : 0;
+    }
+
+    return attenuation;
+}
+
+
+float edge()
+{
+    /// This code is taken from a very useful blog post. Credit to Florian Boesch for such simple code.
+    /// Boesch, F. (2012) Easy wireframe display with barycentric coordinates. 
+    /// Available at: http://codeflow.org/entries/2012/aug/02/easy-wireframe-display-with-barycentric-coordinates/ (Accessed: 01/02/2015).
+
+    // Determine how much of an edge exists at the interpolated barycentric point.
+    vec3 d              = fwidth (baryPoint);
+    vec3 a3             = smoothstep (vec3 (0.0), d * 1.5, baryPoint);
+    float edgeFactor    = min (min (a3.x, a3.y), a3.z);
+
+    return 1.0 - edgeFactor;
+}
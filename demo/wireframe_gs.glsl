@@ -0,0 +1,33 @@
+#version 330
+
+
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+
+                        in      vec3    vertexPosition[];   //!< The world position of each corner of the triangle.
+                        in      vec3    vertexNormal[];     //!< The world normal of each corner of the triangle.
+
+                        out     vec3    worldPosition;      //!< The world position to be interpolated for the fragment shader.
+                        out     vec3    worldNormal;        //!< The world normal to be interpolated for the fragment shader.
+                        out     vec3    baryPoint;          //!< The barycentric co-ordinate to be interpolated for the fragment shader.
+
+
+/// Gives each corner of the triangle its own barycentric co-ordinate. Strips and indexed lists arrive as whole triangles here, so unlike
+/// gl_VertexID % 3 every triangle gets (1, 0, 0), (0, 1, 0) and (0, 0, 1) however its vertices are shared.
+void main()
+{
+    const vec3 corners[3] = vec3[3] (vec3 (1.0, 0.0, 0.0), vec3 (0.0, 1.0, 0.0), vec3 (0.0, 0.0, 1.0));
+
+    for (int i = 0; i < 3; ++i)
+    {
+        worldPosition = vertexPosition[i];
+        worldNormal = vertexNormal[i];
+        baryPoint = corners[i];
+        gl_Position = gl_in[i].gl_Position;
+
+        EmitVertex();
+    }
+
+    EndPrimitive();
+}
@@ -0,0 +1,36 @@
+#version 330
+
+
+/// The uniform buffer scene specific information, only the transforms are needed.
+layout (std140) uniform scene
+{
+    mat4    projection;         //!< The projection transform which establishes the perspective of the vertex.
+    mat4    view;               //!< The view transform representing where the camera is looking.
+
+    vec3    cameraPosition;     //!< Contains the position of the camera in world space.
+    vec3    ambience;           //!< The ambient lighting in the scene.
+};
+
+
+layout (location = 0)   in      vec3    position;       //!< The local position of the current vertex.
+layout (location = 1)   in      vec3    normal;         //!< The local normal vector of the current vertex.
+
+layout (location = 3)   in      mat4    model;          //!< The model transform representing the position and rotation of the object in world space.
+
+
+                        out     vec3    vertexPosition; //!< The world position of the vertex, passed through the geometry shader.
+                        out     vec3    vertexNormal;   //!< The world normal of the vertex, passed through the geometry shader.
+
+
+// The overlay is depth tested against the main pass so it should land on the same depth.
+invariant gl_Position;
+
+
+/// Transforms the vertex the same way sponza_vs.glsl does, the geometry shader adds the barycentric co-ordinates.
+void main()
+{
+    vertexPosition = mat4x3 (model) * vec4 (position, 1.0);
+    vertexNormal = mat3 (model) * normal;
+
+    gl_Position = projection * view * vec4 (vertexPosition, 1.0);
+}